@@ -0,0 +1,279 @@
+#include <BusinessCalendar.hpp>
+
+#include <stdexcept>
+#include <string>
+
+#include <DateRange.hpp>
+#include <bits.hpp>
+#include <calendar_system/CalendarTraits.hpp>
+#include <calendar_system/DateStatus.hpp>
+
+namespace {
+
+const int kWordBits = 64;
+
+bool has_day(toolbox::CalendarSystem cal_sys,
+    const toolbox::CivilDate& civil, int day);
+
+}  // namespace
+
+namespace toolbox {
+
+BusinessCalendar::BusinessCalendar(const Date& first, const Date& last,
+        unsigned weekend)
+        : _first(first.get_raw_date()), _size(0), _words() {
+    if (last < first) {
+        throw std::invalid_argument("BusinessCalendar::BusinessCalendar "
+            "failed: last is before first");
+    }
+    _size = last - first;
+    _words.assign((static_cast<std::size_t>(_size) + kWordBits - 1)
+        / kWordBits, 0);
+    int weekday = first.get_weekday(GREGORIAN);
+    for (int i = 0; i < _size; ++i) {
+        if (!(weekend & (1u << weekday))) {
+            _words[i / kWordBits] |= std::uint64_t(1) << (i % kWordBits);
+        }
+        if (++weekday == 7) {
+            weekday = 0;
+        }
+    }
+}
+
+BusinessCalendar::BusinessCalendar(const BusinessCalendar& other)
+        : _first(other._first), _size(other._size), _words(other._words) {
+}
+
+BusinessCalendar& BusinessCalendar::operator=(const BusinessCalendar& other) {
+    if (this != &other) {
+        _first = other._first;
+        _size = other._size;
+        _words = other._words;
+    }
+    return *this;
+}
+
+BusinessCalendar::~BusinessCalendar() {
+}
+
+Date BusinessCalendar::first() const {
+    return Date(_first);
+}
+
+Date BusinessCalendar::last() const {
+    return Date(_first + _size);
+}
+
+bool BusinessCalendar::contains(const Date& date) const {
+    const long long index =
+        static_cast<long long>(date.get_raw_date()) - _first;
+    return index >= 0 && index < _size;
+}
+
+void BusinessCalendar::add_holiday(const Date& date) {
+    const int index = index_of(date, false, "add_holiday");
+    _words[index / kWordBits] &= ~(std::uint64_t(1) << (index % kWordBits));
+}
+
+void BusinessCalendar::add_annual_holiday(CalendarSystem cal_sys, int month,
+        int day) {
+    const DateRange days(first(), last(), 1, DateRange::DAYS, cal_sys);
+    for (DateRange::iterator it = days.begin(); it != days.end(); ++it) {
+        const CivilDate& civil = it.civil();
+        if (civil.month == month && civil.day == day) {
+            add_holiday(*it);
+        }
+    }
+}
+
+void BusinessCalendar::add_nth_weekday_holiday(CalendarSystem cal_sys,
+        int month, int weekday, int nth) {
+    if (nth == 0) {
+        throw std::invalid_argument("BusinessCalendar::"
+            "add_nth_weekday_holiday failed: nth must not be 0");
+    }
+    const int per_week = days_per_week(cal_sys);
+    const DateRange days(first(), last(), 1, DateRange::DAYS, cal_sys);
+    for (DateRange::iterator it = days.begin(); it != days.end(); ++it) {
+        const CivilDate& civil = it.civil();
+        if (civil.month != month || civil.weekday != weekday) {
+            continue;
+        }
+        // The nth from the end is followed by -nth - 1 more in its month.
+        const bool hit = nth > 0 ? (civil.day - 1) / per_week == nth - 1
+            : (nth == -1 || has_day(cal_sys, civil,
+                civil.day + (-nth - 1) * per_week))
+                && !has_day(cal_sys, civil, civil.day - nth * per_week);
+        if (hit) {
+            add_holiday(*it);
+        }
+    }
+}
+
+bool BusinessCalendar::is_business_day(const Date& date) const {
+    const int index = index_of(date, false, "is_business_day");
+    return (_words[index / kWordBits] >> (index % kWordBits)) & 1;
+}
+
+Date BusinessCalendar::next_business_day(const Date& date) const {
+    const int index = index_of(date, false, "next_business_day");
+    return date_at(find_next(index + 1), "next_business_day");
+}
+
+Date BusinessCalendar::previous_business_day(const Date& date) const {
+    const int index = index_of(date, false, "previous_business_day");
+    return date_at(find_previous(index - 1), "previous_business_day");
+}
+
+Date BusinessCalendar::add_business_days(const Date& date, int days) const {
+    const int index = index_of(date, false, "add_business_days");
+    if (days == 0) {
+        return date_at(find_next(index), "add_business_days");
+    }
+    // Whole words are skipped by their popcount; the word that holds the
+    // target is then cleared bit by bit from the near end.
+    if (days > 0) {
+        long long rest = days;
+        const long long begin = static_cast<long long>(index) + 1;
+        if (begin >= _size) {
+            return date_at(-1, "add_business_days");
+        }
+        std::size_t w = static_cast<std::size_t>(begin / kWordBits);
+        std::uint64_t word = _words[w] & (~std::uint64_t(0)
+            << (begin % kWordBits));
+        for (int bits = popcount(word); bits < rest;
+                bits = popcount(word)) {
+            rest -= bits;
+            if (++w == _words.size()) {
+                return date_at(-1, "add_business_days");
+            }
+            word = _words[w];
+        }
+        while (--rest > 0) {
+            word &= word - 1;
+        }
+        return date_at(static_cast<long long>(w) * kWordBits
+            + lowest_bit(word), "add_business_days");
+    }
+    long long rest = -static_cast<long long>(days);
+    const long long end = static_cast<long long>(index) - 1;
+    if (end < 0) {
+        return date_at(-1, "add_business_days");
+    }
+    std::size_t w = static_cast<std::size_t>(end / kWordBits);
+    std::uint64_t word = _words[w] & (~std::uint64_t(0)
+        >> (kWordBits - 1 - end % kWordBits));
+    for (int bits = popcount(word); bits < rest; bits = popcount(word)) {
+        rest -= bits;
+        if (w-- == 0) {
+            return date_at(-1, "add_business_days");
+        }
+        word = _words[w];
+    }
+    while (--rest > 0) {
+        word &= ~(std::uint64_t(1) << highest_bit(word));
+    }
+    return date_at(static_cast<long long>(w) * kWordBits
+        + highest_bit(word), "add_business_days");
+}
+
+int BusinessCalendar::business_days_between(const Date& first,
+        const Date& last) const {
+    const int begin = index_of(first, true, "business_days_between");
+    const int end = index_of(last, true, "business_days_between");
+    if (end < begin) {
+        return -static_cast<int>(count(end, begin));
+    }
+    return static_cast<int>(count(begin, end));
+}
+
+// The bit of date; allow_end also accepts last(), one past the last bit.
+int BusinessCalendar::index_of(const Date& date, bool allow_end,
+        const char* func) const {
+    const long long index =
+        static_cast<long long>(date.get_raw_date()) - _first;
+    if (index < 0 || index > _size || (index == _size && !allow_end)) {
+        throw std::out_of_range(std::string("BusinessCalendar::") + func
+            + " failed: date is out of the calendar's range");
+    }
+    return static_cast<int>(index);
+}
+
+Date BusinessCalendar::date_at(long long index, const char* func) const {
+    if (index < 0 || index >= _size) {
+        throw std::out_of_range(std::string("BusinessCalendar::") + func
+            + " failed: no such business day in the calendar's range");
+    }
+    return Date(_first + static_cast<int>(index));
+}
+
+// The first business day at or after index, or -1.
+long long BusinessCalendar::find_next(long long index) const {
+    if (index >= _size) {
+        return -1;
+    }
+    std::size_t w = static_cast<std::size_t>(index / kWordBits);
+    std::uint64_t word = _words[w] & (~std::uint64_t(0)
+        << (index % kWordBits));
+    while (word == 0) {
+        if (++w == _words.size()) {
+            return -1;
+        }
+        word = _words[w];
+    }
+    return static_cast<long long>(w) * kWordBits + lowest_bit(word);
+}
+
+// The last business day at or before index, or -1.
+long long BusinessCalendar::find_previous(long long index) const {
+    if (index < 0) {
+        return -1;
+    }
+    std::size_t w = static_cast<std::size_t>(index / kWordBits);
+    std::uint64_t word = _words[w] & (~std::uint64_t(0)
+        >> (kWordBits - 1 - index % kWordBits));
+    while (word == 0) {
+        if (w-- == 0) {
+            return -1;
+        }
+        word = _words[w];
+    }
+    return static_cast<long long>(w) * kWordBits + highest_bit(word);
+}
+
+// The number of business days in begin..end (half open), begin <= end.
+long long BusinessCalendar::count(long long begin, long long end) const {
+    if (begin >= end) {
+        return 0;
+    }
+    const std::size_t first_word = static_cast<std::size_t>(begin / kWordBits);
+    const std::size_t last_word = static_cast<std::size_t>(end / kWordBits);
+    const std::uint64_t head = ~std::uint64_t(0) << (begin % kWordBits);
+    const std::uint64_t tail =
+        (std::uint64_t(1) << (end % kWordBits)) - 1;
+    if (first_word == last_word) {
+        return popcount(_words[first_word] & head & tail);
+    }
+    long long days = popcount(_words[first_word] & head);
+    for (std::size_t w = first_word + 1; w < last_word; ++w) {
+        days += popcount(_words[w]);
+    }
+    if (end % kWordBits != 0) {
+        days += popcount(_words[last_word] & tail);
+    }
+    return days;
+}
+
+}  // namespace toolbox
+
+namespace {
+
+// Whether the month of civil has a day numbered day.
+bool has_day(toolbox::CalendarSystem cal_sys,
+        const toolbox::CivilDate& civil, int day) {
+    toolbox::Date date;
+    return toolbox::Date::try_make(cal_sys, civil.era, civil.year,
+        civil.month, day, date) == toolbox::DATE_OK;
+}
+
+}  // namespace
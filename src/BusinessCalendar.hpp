@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <Date.hpp>
+#include <calendar_system/CalendarSystem.hpp>
+
+namespace toolbox {
+
+// Business days over the dates first..last (half open), stored as one bit per
+// day in 64-bit words: a set bit is a business day. Every day starts as a
+// business day unless its weekday is in the weekend mask, and holidays clear
+// their bits, either one by one or by rules in any calendar system:
+//
+//     BusinessCalendar tokyo(first, last);
+//     tokyo.add_annual_holiday(GREGORIAN, 1, 1);
+//     tokyo.add_nth_weekday_holiday(GREGORIAN, 1, 1, 2);  // 2nd Mon of Jan
+//     const Date settlement = tokyo.add_business_days(trade, 2);
+//
+// Counting and skipping business days goes a word at a time with popcount,
+// so business_days_between and add_business_days cost O(n / 64) for a span
+// of n days. Dates outside the range throw std::out_of_range.
+class BusinessCalendar {
+ public:
+    // Weekend masks by Gregorian weekday; the week of seven days is the same
+    // in every calendar system but the French Republican one.
+    enum Weekday {
+        SUNDAY = 1 << 0,
+        MONDAY = 1 << 1,
+        TUESDAY = 1 << 2,
+        WEDNESDAY = 1 << 3,
+        THURSDAY = 1 << 4,
+        FRIDAY = 1 << 5,
+        SATURDAY = 1 << 6
+    };
+
+    // Throws std::invalid_argument if last is before first.
+    BusinessCalendar(const Date& first, const Date& last,
+        unsigned weekend = SATURDAY | SUNDAY);
+    BusinessCalendar(const BusinessCalendar& other);
+    BusinessCalendar& operator=(const BusinessCalendar& other);
+    ~BusinessCalendar();
+
+    Date first() const;
+    Date last() const;
+    bool contains(const Date& date) const;
+
+    void add_holiday(const Date& date);
+    // Rules: every day month/day of cal_sys within the range, and the nth
+    // weekday of month, counting from the end for a negative nth (-1 is the
+    // last one). weekday is numbered as Date::get_weekday(cal_sys) does.
+    // Years without such a day are skipped. Throw std::out_of_range if
+    // cal_sys cannot represent a date of the range.
+    void add_annual_holiday(CalendarSystem cal_sys, int month, int day);
+    void add_nth_weekday_holiday(CalendarSystem cal_sys, int month,
+        int weekday, int nth);
+
+    bool is_business_day(const Date& date) const;
+    // The nearest business day strictly after or before date.
+    Date next_business_day(const Date& date) const;
+    Date previous_business_day(const Date& date) const;
+    // The days-th business day after date, or before it if days is negative.
+    // 0 gives date itself if it is a business day and the next one if not.
+    Date add_business_days(const Date& date, int days) const;
+    // The number of business days in first..last (half open), negated if
+    // last is before first. Either may also be last() of the calendar.
+    int business_days_between(const Date& first, const Date& last) const;
+
+ private:
+    int index_of(const Date& date, bool allow_end, const char* func) const;
+    Date date_at(long long index, const char* func) const;
+    long long find_next(long long index) const;
+    long long find_previous(long long index) const;
+    long long count(long long begin, long long end) const;
+
+    int _first;  // the serial date of bit 0
+    int _size;   // the number of days
+    std::vector<std::uint64_t> _words;
+};
+
+}  // namespace toolbox
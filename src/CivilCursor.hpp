@@ -0,0 +1,207 @@
+#pragma once
+
+#include <Date.hpp>
+#include <calendar_system/CalendarSystem.hpp>
+#include <calendar_system/CalendarTraits.hpp>
+
+namespace toolbox {
+
+// Walks dates in the calendar Cal while keeping their fields up to date
+// incrementally. A step within a month adds to the day and the weekday; a
+// step past the end of a month moves to the next month and takes its length
+// from Cal::last_day_of_month. Only jumps over more than a few month ends
+// and backward steps convert from scratch, so walking day by day costs a
+// compare and a few additions per date instead of a full conversion:
+//
+//     for (CivilCursor<GREGORIAN> cur(first); cur.date() < last; ++cur) {
+//         const CivilDate& civil = cur.civil();
+//         ...
+//     }
+//
+// civil() is what Date::decompose<Cal>() gives for date(). A conversion from
+// scratch throws std::out_of_range like from_serial_date when Cal cannot
+// represent the date; stepping with the month tables does not check the end
+// of a calendar with a limited range such as FRENCH_REPUBLICAN. Calendars
+// that are not regular_months (see CalendarTraits.hpp) convert at every
+// month boundary and probe where the run of days of the month ends.
+template <CalendarSystem Cal>
+class CivilCursor {
+ public:
+    explicit CivilCursor(const Date& date);
+    CivilCursor(const CivilCursor& other);
+    CivilCursor& operator=(const CivilCursor& other);
+    ~CivilCursor();
+
+    Date date() const;
+    const CivilDate& civil() const;
+
+    CivilCursor& operator++();
+    CivilCursor& operator+=(int days);
+    void seek(const Date& date);
+
+ private:
+    typedef typename CalendarTraits<Cal>::calendar_type Calendar;
+
+    // How many month ends operator+= crosses with the month tables before
+    // it converts from scratch instead.
+    static const int kMaxMonthSteps = 3;
+
+    void load(int serial_date);
+    void next_month();
+    void find_month_end();
+    bool continues_month(int serial_date) const;
+
+    int _serial_date;
+    CivilDate _civil;
+    // The serial date of the last day that follows _serial_date in the same
+    // era, year and month without a gap.
+    int _month_end;
+};
+
+template <CalendarSystem Cal>
+CivilCursor<Cal>::CivilCursor(const Date& date)
+        : _serial_date(0), _civil(), _month_end(0) {
+    load(date.get_raw_date());
+}
+
+template <CalendarSystem Cal>
+CivilCursor<Cal>::CivilCursor(const CivilCursor& other)
+        : _serial_date(other._serial_date), _civil(other._civil),
+          _month_end(other._month_end) {
+}
+
+template <CalendarSystem Cal>
+CivilCursor<Cal>& CivilCursor<Cal>::operator=(const CivilCursor& other) {
+    _serial_date = other._serial_date;
+    _civil = other._civil;
+    _month_end = other._month_end;
+    return *this;
+}
+
+template <CalendarSystem Cal>
+CivilCursor<Cal>::~CivilCursor() {
+}
+
+template <CalendarSystem Cal>
+inline Date CivilCursor<Cal>::date() const {
+    return Date(_serial_date);
+}
+
+template <CalendarSystem Cal>
+inline const CivilDate& CivilCursor<Cal>::civil() const {
+    return _civil;
+}
+
+template <CalendarSystem Cal>
+inline CivilCursor<Cal>& CivilCursor<Cal>::operator++() {
+    if (_serial_date < _month_end) {
+        ++_serial_date;
+        ++_civil.day;
+        if (++_civil.weekday == CalendarTraits<Cal>::days_per_week) {
+            _civil.weekday = 0;
+        }
+    } else {
+        next_month();
+    }
+    return *this;
+}
+
+template <CalendarSystem Cal>
+CivilCursor<Cal>& CivilCursor<Cal>::operator+=(int days) {
+    if (days < 0) {
+        load(_serial_date + days);
+        return *this;
+    }
+    for (int i = 0; i < kMaxMonthSteps; ++i) {
+        const int rest = _month_end - _serial_date;
+        if (days <= rest) {
+            _serial_date += days;
+            _civil.day += days;
+            _civil.weekday = (_civil.weekday + days)
+                % CalendarTraits<Cal>::days_per_week;
+            return *this;
+        }
+        days -= rest + 1;
+        next_month();
+    }
+    load(_serial_date + days);
+    return *this;
+}
+
+template <CalendarSystem Cal>
+void CivilCursor<Cal>::seek(const Date& date) {
+    load(date.get_raw_date());
+}
+
+template <CalendarSystem Cal>
+void CivilCursor<Cal>::load(int serial_date) {
+    const Calendar& calendar = calendar_instance<Cal>();
+    calendar.Calendar::from_serial_date(serial_date, _civil.era, _civil.year,
+        _civil.month, _civil.day);
+    calendar.Calendar::from_serial_date(serial_date, _civil.weekday);
+    _serial_date = serial_date;
+    find_month_end();
+}
+
+// Moves to the day after _month_end, the first of the next month.
+template <CalendarSystem Cal>
+void CivilCursor<Cal>::next_month() {
+    if (!CalendarTraits<Cal>::regular_months) {
+        load(_month_end + 1);
+        return;
+    }
+    _serial_date = _month_end + 1;
+    if (_civil.month < CalendarTraits<Cal>::months_per_year) {
+        ++_civil.month;
+    } else if (_civil.era != CalendarTraits<Cal>::bc_era) {
+        _civil.month = 1;
+        ++_civil.year;
+    } else if (_civil.year > 1) {
+        _civil.month = 1;
+        --_civil.year;
+    } else {
+        // The era changes; once in the calendar's history.
+        load(_serial_date);
+        return;
+    }
+    _civil.day = 1;
+    const Calendar& calendar = calendar_instance<Cal>();
+    calendar.Calendar::from_serial_date(_serial_date, _civil.weekday);
+    _month_end = _serial_date + calendar.Calendar::last_day_of_month(
+        _civil.era, _civil.year, _civil.month) - 1;
+}
+
+template <CalendarSystem Cal>
+void CivilCursor<Cal>::find_month_end() {
+    const int last_day = calendar_instance<Cal>().Calendar::last_day_of_month(
+        _civil.era, _civil.year, _civil.month);
+    _month_end = _serial_date + (last_day - _civil.day);
+    if (CalendarTraits<Cal>::regular_months || _month_end <= _serial_date
+        || continues_month(_month_end)) {
+        return;
+    }
+    // The month is cut short by an era or the Gregorian reform: bisect for
+    // the last day that still continues it.
+    int good = _serial_date;
+    int bad = _month_end;
+    while (bad - good > 1) {
+        const int mid = good + (bad - good) / 2;
+        if (continues_month(mid)) {
+            good = mid;
+        } else {
+            bad = mid;
+        }
+    }
+    _month_end = good;
+}
+
+template <CalendarSystem Cal>
+bool CivilCursor<Cal>::continues_month(int serial_date) const {
+    int era, year, month, day;
+    calendar_instance<Cal>().Calendar::from_serial_date(serial_date, era,
+        year, month, day);
+    return era == _civil.era && year == _civil.year && month == _civil.month
+        && day == _civil.day + (serial_date - _serial_date);
+}
+
+}  // namespace toolbox
@@ -3,6 +3,7 @@
 #include <stdexcept>
 #include <string>
 #include <ctime>
+#include <climits>
 
 #include <calendar_system/GregorianCalendar.hpp>
 #include <calendar_system/NonProlepticGregorianCalendar.hpp>
@@ -12,12 +13,18 @@
 #include <calendar_system/FrenchRepublicanCalendar.hpp>
 
 namespace {
-toolbox::GregorianCalendar gregorian_calendar;
-toolbox::NonProlepticGregorianCalendar non_proleptic_gregorian_calendar;
-toolbox::JulianCalendar julian_calendar;
-toolbox::EthiopianCalendar ethiopian_calendar;
-toolbox::FrenchRepublicanCalendar french_republican_calendar;
-toolbox::JapaneseWarekiCalendar japanese_wareki_calendar;
+// The last date decomposed on this thread. The weekday is filled in only
+// once it is asked for, so that get_year and friends do not pay for it.
+struct DecomposeCache {
+    bool valid;
+    bool has_weekday;
+    int serial_date;
+    toolbox::CalendarSystem cal_sys;
+    toolbox::CivilDate civil;
+};
+thread_local DecomposeCache decompose_cache = {
+    false, false, 0, toolbox::GREGORIAN, {0, 0, 0, 0, 0}
+};
 }
 
 toolbox::Date::Date() : _serial_date(0) {}
@@ -80,6 +87,73 @@ toolbox::Date::Date(toolbox::CalendarSystem cal_sys,
     _serial_date = convert_to_serial_date(cal_sys, date_str, format, strict);
 }
 
+toolbox::DateStatus toolbox::Date::try_make(toolbox::CalendarSystem cal_sys,
+        int era, int year, int month, int day, Date& date) {
+    int serial_date;
+    const DateStatus status = get_calendar_system(cal_sys).try_to_serial_date(
+        era, year, month, day, serial_date);
+    if (status == DATE_OK) {
+        date._serial_date = serial_date;
+    }
+    return status;
+}
+
+toolbox::DateStatus toolbox::Date::try_parse(toolbox::CalendarSystem cal_sys,
+        const std::string& date_str, const char* format, bool strict,
+        Date& date) {
+    int serial_date;
+    const DateStatus status = get_calendar_system(cal_sys).try_parse(
+        date_str, format, strict, serial_date);
+    if (status == DATE_OK) {
+        date._serial_date = serial_date;
+    }
+    return status;
+}
+
+toolbox::DateStatus toolbox::Date::try_parse(toolbox::CalendarSystem cal_sys,
+        const char* begin, const char* end, const char* format, bool strict,
+        Date& date) {
+    int serial_date;
+    const DateStatus status = get_calendar_system(cal_sys).try_parse(begin,
+        end, format, strict, serial_date);
+    if (status == DATE_OK) {
+        date._serial_date = serial_date;
+    }
+    return status;
+}
+
+toolbox::DateStatus toolbox::Date::try_parse(toolbox::CalendarSystem cal_sys,
+        const char* begin, const char* end, const char* format, bool strict,
+        Date& date, std::size_t& consumed) {
+    int serial_date;
+    const DateStatus status = get_calendar_system(cal_sys).try_parse(begin,
+        end, format, strict, serial_date, consumed);
+    if (status == DATE_OK) {
+        date._serial_date = serial_date;
+    }
+    return status;
+}
+
+toolbox::Date toolbox::Date::parse(toolbox::CalendarSystem cal_sys,
+        const char* begin, const char* end, const char* format,
+        bool strict) {
+    if (!format) {
+        throw std::invalid_argument("Date::parse failed: format is null");
+    }
+    return Date(get_calendar_system(cal_sys).to_serial_date(begin, end,
+        format, strict));
+}
+
+toolbox::Date toolbox::Date::parse(toolbox::CalendarSystem cal_sys,
+        const char* begin, const char* end, const char* format, bool strict,
+        std::size_t& consumed) {
+    if (!format) {
+        throw std::invalid_argument("Date::parse failed: format is null");
+    }
+    return Date(get_calendar_system(cal_sys).to_serial_date(begin, end,
+        format, strict, consumed));
+}
+
 std::string toolbox::Date::to_string(CalendarSystem cal_sys,
         const char* format) const {
     if (!format) {
@@ -90,28 +164,75 @@ std::string toolbox::Date::to_string(CalendarSystem cal_sys,
     return date_str;
 }
 
+std::string toolbox::Date::to_string(CalendarSystem cal_sys,
+        const DateFormat& format) const {
+    std::string date_str;
+    convert_from_serial_date(cal_sys, date_str, format);
+    return date_str;
+}
+
+std::size_t toolbox::Date::format_to(char* buf, std::size_t cap,
+        CalendarSystem cal_sys, const DateFormat& format) const {
+    const ICalendarSystem& calendar_system = get_calendar_system(cal_sys);
+    return calendar_system.format_to(_serial_date, buf, cap, format);
+}
+
+toolbox::Date toolbox::Date::from_iso8601(const std::string& date_str) {
+    int serial_date;
+    if (!iso8601_to_serial_date(date_str.data(),
+            date_str.data() + date_str.size(), serial_date)) {
+        throw std::invalid_argument("Date::from_iso8601 failed: "
+            "Invalid ISO 8601 date: '" + date_str + "'");
+    }
+    return Date(serial_date);
+}
+
+std::string toolbox::Date::to_iso8601(Iso8601Form form) const {
+    char buf[16];
+    const std::size_t len = iso8601_format_to(_serial_date, buf,
+        sizeof(buf), form);
+    return std::string(buf, len);
+}
+
+void toolbox::Date::to_serial_dates(toolbox::CalendarSystem cal_sys,
+        const int* eras, const int* years, const int* months,
+        const int* days, std::size_t count, int* serial_dates) {
+    const ICalendarSystem& calendar_system = get_calendar_system(cal_sys);
+    calendar_system.to_serial_dates(eras, years, months, days, count,
+        serial_dates);
+}
+
+void toolbox::Date::from_serial_dates(toolbox::CalendarSystem cal_sys,
+        const int* serial_dates, std::size_t count,
+        int* eras, int* years, int* months, int* days) {
+    const ICalendarSystem& calendar_system = get_calendar_system(cal_sys);
+    calendar_system.from_serial_dates(serial_dates, count,
+        eras, years, months, days);
+}
+
 int toolbox::Date::get_raw_date() const {
     return _serial_date;
 }
 
+toolbox::CivilDate toolbox::Date::decompose(
+        toolbox::CalendarSystem cal_sys) const {
+    return cached_civil_date(cal_sys, true);
+}
+
 int toolbox::Date::get_day(toolbox::CalendarSystem cal_sys) const {
-    int era, year, month, day;
-    convert_form_serial_date(cal_sys, era, year, month, day);
-    return day;
+    return cached_civil_date(cal_sys, false).day;
 }
 
 int toolbox::Date::get_month(toolbox::CalendarSystem cal_sys) const {
-    int era, year, month, day;
-    convert_form_serial_date(cal_sys, era, year, month, day);
-    return month;
+    return cached_civil_date(cal_sys, false).month;
 }
 
 int toolbox::Date::get_year(toolbox::CalendarSystem cal_sys) const {
-    int era, year, month, day;
-    convert_form_serial_date(cal_sys, era, year, month, day);
-    return year;
+    return cached_civil_date(cal_sys, false).year;
 }
 
+// The weekday alone does not need the full conversion, which may also throw
+// where the weekday does not (wareki dates before the first era).
 int toolbox::Date::get_weekday(toolbox::CalendarSystem cal_sys) const {
     int day_of_week;
     convert_from_serial_date(cal_sys, day_of_week);
@@ -162,6 +283,144 @@ toolbox::Date& toolbox::Date::operator-=(const int delta) {
     return *this;
 }
 
+toolbox::Date toolbox::Date::add_months(toolbox::CalendarSystem cal_sys,
+        int months, toolbox::MonthPolicy policy) const {
+    int serial_date;
+    const DateStatus status = get_calendar_system(cal_sys).try_add_months(
+        _serial_date, months, policy, serial_date);
+    if (status != DATE_OK) {
+        throw std::out_of_range(std::string("Date::add_months failed: ")
+            + date_status_message(status));
+    }
+    return Date(serial_date);
+}
+
+toolbox::Date toolbox::Date::add_years(toolbox::CalendarSystem cal_sys,
+        int years, toolbox::MonthPolicy policy) const {
+    int serial_date;
+    const DateStatus status = get_calendar_system(cal_sys).try_add_years(
+        _serial_date, years, policy, serial_date);
+    if (status != DATE_OK) {
+        throw std::out_of_range(std::string("Date::add_years failed: ")
+            + date_status_message(status));
+    }
+    return Date(serial_date);
+}
+
+void toolbox::Date::add_months(toolbox::CalendarSystem cal_sys,
+        const int* serial_dates, std::size_t count, int months,
+        toolbox::MonthPolicy policy, int* results) {
+    const ICalendarSystem& calendar_system = get_calendar_system(cal_sys);
+    calendar_system.add_months(serial_dates, count, months, policy, results);
+}
+
+void toolbox::Date::add_years(toolbox::CalendarSystem cal_sys,
+        const int* serial_dates, std::size_t count, int years,
+        toolbox::MonthPolicy policy, int* results) {
+    const ICalendarSystem& calendar_system = get_calendar_system(cal_sys);
+    calendar_system.add_years(serial_dates, count, years, policy, results);
+}
+
+int toolbox::Date::last_day_of_month(toolbox::CalendarSystem cal_sys,
+        int era, int year, int month) {
+    return get_calendar_system(cal_sys).last_day_of_month(era, year, month);
+}
+
+toolbox::Date toolbox::Date::nth_weekday_of_month(
+        toolbox::CalendarSystem cal_sys, int era, int year, int month,
+        int weekday, int nth) {
+    Date date;
+    const DateStatus status = try_nth_weekday_of_month(cal_sys, era, year,
+        month, weekday, nth, date);
+    if (status != DATE_OK) {
+        throw std::out_of_range(
+            std::string("Date::nth_weekday_of_month failed: ")
+            + date_status_message(status));
+    }
+    return date;
+}
+
+toolbox::Date toolbox::Date::last_weekday_of_month(
+        toolbox::CalendarSystem cal_sys, int era, int year, int month,
+        int weekday) {
+    Date date;
+    const DateStatus status = try_nth_weekday_of_month(cal_sys, era, year,
+        month, weekday, -1, date);
+    if (status != DATE_OK) {
+        throw std::out_of_range(
+            std::string("Date::last_weekday_of_month failed: ")
+            + date_status_message(status));
+    }
+    return date;
+}
+
+toolbox::DateStatus toolbox::Date::try_nth_weekday_of_month(
+        toolbox::CalendarSystem cal_sys, int era, int year, int month,
+        int weekday, int nth, Date& date) {
+    int serial_date;
+    const DateStatus status = get_calendar_system(cal_sys)
+        .try_nth_weekday_of_month(era, year, month, weekday, nth,
+            serial_date);
+    if (status == DATE_OK) {
+        date._serial_date = serial_date;
+    }
+    return status;
+}
+
+toolbox::Date toolbox::Date::next_weekday(toolbox::CalendarSystem cal_sys,
+        int weekday) const {
+    int serial_date;
+    const DateStatus status = _serial_date == INT_MAX ? DATE_OUT_OF_RANGE
+        : get_calendar_system(cal_sys)
+            .try_weekday_on_or_after(_serial_date + 1, weekday, serial_date);
+    if (status != DATE_OK) {
+        throw std::out_of_range(
+            std::string("Date::next_weekday failed: ")
+            + date_status_message(status));
+    }
+    return Date(serial_date);
+}
+
+toolbox::Date toolbox::Date::next_weekday_on_or_after(
+        toolbox::CalendarSystem cal_sys, int weekday) const {
+    int serial_date;
+    const DateStatus status = get_calendar_system(cal_sys)
+        .try_weekday_on_or_after(_serial_date, weekday, serial_date);
+    if (status != DATE_OK) {
+        throw std::out_of_range(
+            std::string("Date::next_weekday_on_or_after failed: ")
+            + date_status_message(status));
+    }
+    return Date(serial_date);
+}
+
+toolbox::Date toolbox::Date::previous_weekday(toolbox::CalendarSystem cal_sys,
+        int weekday) const {
+    int serial_date;
+    const DateStatus status = _serial_date == INT_MIN ? DATE_OUT_OF_RANGE
+        : get_calendar_system(cal_sys)
+            .try_weekday_on_or_before(_serial_date - 1, weekday, serial_date);
+    if (status != DATE_OK) {
+        throw std::out_of_range(
+            std::string("Date::previous_weekday failed: ")
+            + date_status_message(status));
+    }
+    return Date(serial_date);
+}
+
+toolbox::Date toolbox::Date::previous_weekday_on_or_before(
+        toolbox::CalendarSystem cal_sys, int weekday) const {
+    int serial_date;
+    const DateStatus status = get_calendar_system(cal_sys)
+        .try_weekday_on_or_before(_serial_date, weekday, serial_date);
+    if (status != DATE_OK) {
+        throw std::out_of_range(
+            std::string("Date::previous_weekday_on_or_before failed: ")
+            + date_status_message(status));
+    }
+    return Date(serial_date);
+}
+
 bool toolbox::Date::operator==(const Date& other) const {
     return _serial_date == other._serial_date;
 }
@@ -188,29 +447,56 @@ bool toolbox::Date::operator>=(const Date& other) const {
 
 void toolbox::Date::convert_form_serial_date(toolbox::CalendarSystem cal_sys,
         int& era, int& year, int& month, int& day) const {
-    ICalendarSystem& calendar_system = get_calendar_system(cal_sys);
+    const ICalendarSystem& calendar_system = get_calendar_system(cal_sys);
     calendar_system.from_serial_date(_serial_date, era, year, month, day);
 }
 
+const toolbox::CivilDate& toolbox::Date::cached_civil_date(
+        toolbox::CalendarSystem cal_sys, bool with_weekday) const {
+    DecomposeCache& cache = decompose_cache;
+    if (!cache.valid || cache.serial_date != _serial_date
+            || cache.cal_sys != cal_sys) {
+        // Stays invalid if the conversion throws.
+        cache.valid = false;
+        convert_form_serial_date(cal_sys, cache.civil.era, cache.civil.year,
+            cache.civil.month, cache.civil.day);
+        cache.valid = true;
+        cache.has_weekday = false;
+        cache.serial_date = _serial_date;
+        cache.cal_sys = cal_sys;
+    }
+    if (with_weekday && !cache.has_weekday) {
+        convert_from_serial_date(cal_sys, cache.civil.weekday);
+        cache.has_weekday = true;
+    }
+    return cache.civil;
+}
+
 void toolbox::Date::convert_from_serial_date(toolbox::CalendarSystem cal_sys,
         std::string& date_str, const char* format) const {
     if (!format) {
         throw std::invalid_argument(
             "Date::convert_from_serial_date failed: format is null");
     }
-    ICalendarSystem& calendar_system = get_calendar_system(cal_sys);
+    const ICalendarSystem& calendar_system = get_calendar_system(cal_sys);
+    calendar_system.from_serial_date(_serial_date, date_str, format);
+}
+
+void toolbox::Date::convert_from_serial_date(toolbox::CalendarSystem cal_sys,
+        std::string& date_str, const DateFormat& format) const {
+    const ICalendarSystem& calendar_system = get_calendar_system(cal_sys);
     calendar_system.from_serial_date(_serial_date, date_str, format);
 }
 
 void toolbox::Date::convert_from_serial_date(toolbox::CalendarSystem cal_sys,
         int& day_of_week) const {
-    ICalendarSystem& calendar_system = get_calendar_system(cal_sys);
+    const ICalendarSystem& calendar_system = get_calendar_system(cal_sys);
     calendar_system.from_serial_date(_serial_date, day_of_week);
 }
 
 int toolbox::Date::convert_to_serial_date(toolbox::CalendarSystem cal_sys,
         int era, int year, int month, int day) const {
-    ICalendarSystem& calendar_system = get_calendar_system(cal_sys);
+    const ICalendarSystem& calendar_system = get_calendar_system(cal_sys);
     return calendar_system.to_serial_date(era, year, month, day);
 }
 
@@ -220,28 +506,28 @@ int toolbox::Date::convert_to_serial_date(toolbox::CalendarSystem cal_sys,
         throw std::invalid_argument(
             "Date::convert_to_serial_date failed: format is null");
     }
-    ICalendarSystem& calendar_system = get_calendar_system(cal_sys);
+    const ICalendarSystem& calendar_system = get_calendar_system(cal_sys);
     return calendar_system.to_serial_date(date_str, format, strict);
 }
 
 // When adding a new calendar system, add it here.
-toolbox::ICalendarSystem& toolbox::Date::get_calendar_system(
-        toolbox::CalendarSystem cal_sys) const {
+// The instances are the const ones of calendar_instance, built on first use
+// (thread-safe as function-local statics) and only read after that.
+const toolbox::ICalendarSystem& toolbox::Date::get_calendar_system(
+        toolbox::CalendarSystem cal_sys) {
     switch (cal_sys) {
         case toolbox::GREGORIAN:
-            return gregorian_calendar;
+            return calendar_instance<GREGORIAN>();
         case toolbox::NON_PROLEPTIC_GREGORIAN:
-            return non_proleptic_gregorian_calendar;
+            return calendar_instance<NON_PROLEPTIC_GREGORIAN>();
         case toolbox::JULIAN:
-            return julian_calendar;
+            return calendar_instance<JULIAN>();
         case toolbox::ETHIOPIAN:
-            return ethiopian_calendar;
+            return calendar_instance<ETHIOPIAN>();
         case toolbox::FRENCH_REPUBLICAN:
-            return french_republican_calendar;
+            return calendar_instance<FRENCH_REPUBLICAN>();
         case toolbox::JAPANESE_WAREKI:
-            return japanese_wareki_calendar;
-        // case toolbox::JAPANESE_WAREKI:
-        //     return japanese_wareki_calendar;
+            return calendar_instance<JAPANESE_WAREKI>();
         default:
             throw std::invalid_argument("Invalid calendar system");
     }
@@ -29,6 +29,16 @@
  *      bool strict) const`:
  *      Parses a date string according to the format and converts it
  *      to the serial date.
+ * - `try_to_serial_date(...)` / `try_parse(...)`:
+ *      Non-throwing versions of the two functions above that return a
+ *      `DateStatus`. Implement the conversion here and make the throwing
+ *      overloads thin wrappers; `parse_date` in `DateParser.hpp` does the
+ *      parsing given a `DateParserSpec` of the calendar's names.
+ *      `to_serial_date` and `try_parse` also have
+ *      `(const char* begin, const char* end, ...)` overloads, which the
+ *      `std::string` ones forward to, and overloads of those with a
+ *      trailing `std::size_t& consumed` that read a date from the start of
+ *      the range; `parse_date_prefix` does the parsing for them.
  * - `from_serial_date(int serial_date, int& era, int& year,
  *      int& month, int& day) const`:
  *      Converts the common serial date back to the new calendar's
@@ -37,36 +47,88 @@
  *      const char* format) const`:
  *      Formats the serial date into a string according to the specified
  *      format rules for the new calendar.
+ * - `from_serial_date(int serial_date, std::string& date_str,
+ *      const DateFormat& format) const`:
+ *      Same as above with a pre-compiled format; the `const char*` overload
+ *      usually just compiles its format and forwards here.
+ * - `format_to(int serial_date, char* buf, std::size_t cap,
+ *      const DateFormat& format) const`:
+ *      Allocation-free formatting into a caller-provided buffer with
+ *      snprintf-like truncation, using `FormatBuffer`. The `DateFormat`
+ *      overload above can be built on it with `format_to_string`.
  * - `from_serial_date(int serial_date, int& day_of_week) const`:
  *      Calculates the day of the week (usually based on the serial date
  *      modulo 7, but depends on the calendar's week definition if different).
+ * - `last_day_of_month(int era, int year, int month) const`:
+ *      The length of a month, which `CivilCursor` uses to step from one
+ *      month to the next without converting.
+ * - `try_add_months(...)` / `try_add_years(...)` and their batch versions
+ *      `add_months(...)` / `add_years(...)`:
+ *      Month arithmetic in the calendar's own fields. `shift_month` and
+ *      `apply_month_policy` in `MonthPolicy.hpp` do the common part.
+ * - `try_nth_weekday_of_month(...)` / `try_weekday_on_or_after(...)` /
+ *      `try_weekday_on_or_before(...)`:
+ *      Weekday arithmetic without walking the days. `nth_weekday_offset`,
+ *      `weekday_on_or_after` and `weekday_on_or_before` in
+ *      `CalendarArithmetic.hpp` do it for weeks of 7 days and more.
+ * - `to_serial_dates(...)` / `from_serial_dates(...)`:
+ *      Batch versions of the conversions above over arrays of `count`
+ *      elements. Loop over qualified calls to the scalar functions (e.g.
+ *      `NewCalendar::from_serial_date(...)`) so they bind statically.
  *
  * 3.  **Add to CalendarSystem Enum:**
  * In `calendar_system/CalendarSystem.hpp`, add a new identifier for your
  * calendar to the `enum CalendarSystem`.
  *
  * 4.  **Register in Date Class:**
- * - In `Date.cpp`, include the header for your new calendar system
- * (`NewCalendar.hpp`).
- * - Create a static instance of your new calendar class within the anonymous
- * namespace (similar to `gregorian_calendar`, `julian_calendar`, etc.).
+ * - In `calendar_system/CalendarTraits.hpp`, specialize `CalendarTraits`
+ * for the new enum value so that the templated accessors (e.g.
+ * `date.get_year<NEW_CALENDAR>()`) can use it, and fill in the constants
+ * that describe its months and weeks.
  * - In the `Date::get_calendar_system` method, add a new `case` to the
- * `switch` statement that returns the static instance of your `NewCalendar`
- * class when the corresponding `CalendarSystem` enum value is passed.
+ * `switch` statement that returns `calendar_instance<NEW_CALENDAR>()`, the
+ * instance shared with the templated accessors.
+ *
+ * ## Thread Safety
+ *
+ * `Date` is a value type, and every calendar is used through a single
+ * `const` instance that is never modified once built, so any number of
+ * threads may convert, parse and format concurrently without locking. Keep
+ * a new calendar that way: its member functions must not write to shared
+ * state, and tables it builds lazily belong in function-local `static
+ * const` variables, whose initialization C++11 makes thread-safe. The only
+ * other state is per thread (the `decompose` cache). Objects that carry a
+ * position, like `DateRange::iterator`, `CivilCursor` and `Recurrence`,
+ * must not be shared between threads without synchronization.
  *
  * Remember to handle potential errors (e.g., invalid dates, out-of-range
- * serial dates for the specific calendar) by throwing appropriate
- * exceptions (like `std::out_of_range` or `std::invalid_argument`).
+ * serial dates for the specific calendar) by returning the matching
+ * `DateStatus` from the `try_` functions and by throwing appropriate
+ * exceptions (like `std::out_of_range` or `std::invalid_argument`) elsewhere.
  */
 #pragma once
 
+#include <cstddef>
 #include <string>
 #include <iostream>
 #include <calendar_system/CalendarSystem.hpp>
+#include <calendar_system/CalendarTraits.hpp>
+#include <calendar_system/DateFormat.hpp>
 #include <calendar_system/ICalendarSystem.hpp>
+#include <calendar_system/Iso8601.hpp>
+#include <calendar_system/MonthPolicy.hpp>
 
 namespace toolbox {
 
+// The fields of a date in one calendar, as returned by Date::decompose.
+struct CivilDate {
+    int era;
+    int year;
+    int month;
+    int day;
+    int weekday;  // 0=Sun, 1=Mon, ..., 6=Sat
+};
+
 class Date {
  public:
     Date();
@@ -81,15 +143,85 @@ class Date {
     Date(CalendarSystem cal_sys, const std::string& date_str,
         const char* format = "%y-%m-%d", bool strict = true);
 
+    // Non-throwing counterparts of the constructors above for input that is
+    // expected to be invalid now and then. date is assigned only on DATE_OK;
+    // an unknown cal_sys still throws std::invalid_argument.
+    static DateStatus try_make(CalendarSystem cal_sys, int era, int year,
+        int month, int day, Date& date);
+    static DateStatus try_parse(CalendarSystem cal_sys,
+        const std::string& date_str, const char* format, bool strict,
+        Date& date);
+    // Parses the characters [begin, end) in place, e.g. a field of a larger
+    // buffer.
+    static DateStatus try_parse(CalendarSystem cal_sys, const char* begin,
+        const char* end, const char* format, bool strict, Date& date);
+    // Reads a date from the start of [begin, end), e.g. one embedded in a
+    // record, and stores the number of characters it took in consumed (on
+    // DATE_OK only). See parse_date_prefix for where a date ends.
+    static DateStatus try_parse(CalendarSystem cal_sys, const char* begin,
+        const char* end, const char* format, bool strict, Date& date,
+        std::size_t& consumed);
+    // Throwing counterparts of the two above, which throw
+    // std::invalid_argument like the constructor from a string.
+    static Date parse(CalendarSystem cal_sys, const char* begin,
+        const char* end, const char* format, bool strict = true);
+    static Date parse(CalendarSystem cal_sys, const char* begin,
+        const char* end, const char* format, bool strict,
+        std::size_t& consumed);
+
     std::string to_string(CalendarSystem cal_sys,
         const char* format = "%Y-%M-%D") const;
+    // Formats with a pattern compiled once, for formatting many dates.
+    std::string to_string(CalendarSystem cal_sys,
+        const DateFormat& format) const;
+    // Writes the formatted date into buf without allocating; see
+    // ICalendarSystem::format_to for the truncation rules.
+    std::size_t format_to(char* buf, std::size_t cap,
+        CalendarSystem cal_sys, const DateFormat& format) const;
+
+    // Fast paths for fixed-width ISO 8601 Gregorian dates; see Iso8601.hpp.
+    static Date from_iso8601(const std::string& date_str);
+    std::string to_iso8601(Iso8601Form form = ISO8601_CALENDAR) const;
+
+    // Converts whole columns of dates with a single calendar dispatch.
+    static void to_serial_dates(CalendarSystem cal_sys,
+        const int* eras, const int* years, const int* months,
+        const int* days, std::size_t count, int* serial_dates);
+    static void from_serial_dates(CalendarSystem cal_sys,
+        const int* serial_dates, std::size_t count,
+        int* eras, int* years, int* months, int* days);
 
     int get_raw_date() const;
+    // Converts once to every field of the date in cal_sys. The last result
+    // is cached per thread, so reading several fields of the same date
+    // through the accessors below converts only once.
+    CivilDate decompose(CalendarSystem cal_sys) const;
     int get_day(CalendarSystem cal_sys) const;
     int get_month(CalendarSystem cal_sys) const;
     int get_year(CalendarSystem cal_sys) const;
     int get_weekday(CalendarSystem cal_sys) const;  // 0=Sun, 1=Mon, ..., 6=Sat
 
+    // Compile-time counterparts of the functions above for a calendar known
+    // at compile time, e.g. date.get_year<GREGORIAN>(). They call the
+    // calendar class directly (see CalendarTraits.hpp) instead of switching
+    // on cal_sys and dispatching through ICalendarSystem.
+    template <CalendarSystem Cal>
+    static Date make(int era, int year, int month, int day);
+    template <CalendarSystem Cal>
+    CivilDate decompose() const;
+    template <CalendarSystem Cal>
+    int get_day() const;
+    template <CalendarSystem Cal>
+    int get_month() const;
+    template <CalendarSystem Cal>
+    int get_year() const;
+    template <CalendarSystem Cal>
+    int get_weekday() const;  // 0=Sun, 1=Mon, ..., 6=Sat
+    template <CalendarSystem Cal>
+    std::string to_string(const char* format = "%Y-%M-%D") const;
+    template <CalendarSystem Cal>
+    std::string to_string(const DateFormat& format) const;
+
     Date& operator++();  // 前置インクリメント
     Date operator++(int);  // 後置インクリメント
     Date& operator--();  // 前置デクリメント
@@ -101,6 +233,44 @@ class Date {
     Date& operator+=(const int delta);
     Date& operator-=(const int delta);
 
+    // Calendar arithmetic in cal_sys: moves by whole months or years of that
+    // calendar and keeps the day of the month, resolving a day that the
+    // target month lacks by policy (see MonthPolicy.hpp). Throws
+    // std::out_of_range if the date or the result is outside cal_sys or if
+    // MONTH_ERROR refuses the day.
+    Date add_months(CalendarSystem cal_sys, int months,
+        MonthPolicy policy = MONTH_CLAMP) const;
+    Date add_years(CalendarSystem cal_sys, int years,
+        MonthPolicy policy = MONTH_CLAMP) const;
+    // The same over count serial dates with a single calendar dispatch.
+    static void add_months(CalendarSystem cal_sys, const int* serial_dates,
+        std::size_t count, int months, MonthPolicy policy, int* results);
+    static void add_years(CalendarSystem cal_sys, const int* serial_dates,
+        std::size_t count, int years, MonthPolicy policy, int* results);
+    // The number of days of the month in cal_sys, its last valid day. Throws
+    // std::out_of_range if era, year or month is invalid.
+    static int last_day_of_month(CalendarSystem cal_sys, int era, int year,
+        int month);
+    // Weekdays in cal_sys in closed form from the serial date, numbered as
+    // get_weekday(cal_sys) numbers them (décadi is 9 in the 10-day weeks of
+    // FRENCH_REPUBLICAN). The nth weekday of the month counts from the end
+    // for a negative nth, -1 being the last one. The throwing functions
+    // throw std::out_of_range if there is no such day, including nth 0 and
+    // an invalid weekday, or if it is outside cal_sys.
+    static Date nth_weekday_of_month(CalendarSystem cal_sys, int era,
+        int year, int month, int weekday, int nth);
+    static Date last_weekday_of_month(CalendarSystem cal_sys, int era,
+        int year, int month, int weekday);
+    static DateStatus try_nth_weekday_of_month(CalendarSystem cal_sys,
+        int era, int year, int month, int weekday, int nth, Date& date);
+    // The nearest weekday strictly after (before) the date, or on or after
+    // (before) it.
+    Date next_weekday(CalendarSystem cal_sys, int weekday) const;
+    Date next_weekday_on_or_after(CalendarSystem cal_sys, int weekday) const;
+    Date previous_weekday(CalendarSystem cal_sys, int weekday) const;
+    Date previous_weekday_on_or_before(CalendarSystem cal_sys,
+        int weekday) const;
+
     bool operator==(const Date& other) const;
     bool operator!=(const Date& other) const;
     bool operator<(const Date& other) const;
@@ -109,10 +279,16 @@ class Date {
     bool operator>=(const Date& other) const;
 
  private:
+    // The fields of the date in cal_sys from this thread's cache, converting
+    // on a miss. The weekday is valid only if with_weekday is set.
+    const CivilDate& cached_civil_date(CalendarSystem cal_sys,
+        bool with_weekday) const;
     void convert_form_serial_date(CalendarSystem cal_sys,
         int& era, int& year, int& month, int& day) const;
     void convert_from_serial_date(CalendarSystem cal_sys,
         std::string& date_str, const char* format) const;
+    void convert_from_serial_date(CalendarSystem cal_sys,
+        std::string& date_str, const DateFormat& format) const;
     void convert_from_serial_date(CalendarSystem cal_sys,
         int& day_of_week) const;
     int convert_to_serial_date(CalendarSystem cal_sys,
@@ -120,9 +296,81 @@ class Date {
     int convert_to_serial_date(CalendarSystem cal_sys,
         const std::string& date_str,
         const char* format, bool strict) const;
-    ICalendarSystem& get_calendar_system(CalendarSystem cal_sys) const;
+    static const ICalendarSystem& get_calendar_system(CalendarSystem cal_sys);
 
     int _serial_date;  // 0 mean 1970-01-01 (Unix epoch)
 };
 
+template <CalendarSystem Cal>
+Date Date::make(int era, int year, int month, int day) {
+    typedef typename CalendarTraits<Cal>::calendar_type Calendar;
+    return Date(calendar_instance<Cal>().Calendar::to_serial_date(era, year,
+        month, day));
+}
+
+template <CalendarSystem Cal>
+CivilDate Date::decompose() const {
+    typedef typename CalendarTraits<Cal>::calendar_type Calendar;
+    const Calendar& calendar = calendar_instance<Cal>();
+    CivilDate civil;
+    calendar.Calendar::from_serial_date(_serial_date, civil.era, civil.year,
+        civil.month, civil.day);
+    calendar.Calendar::from_serial_date(_serial_date, civil.weekday);
+    return civil;
+}
+
+template <CalendarSystem Cal>
+int Date::get_day() const {
+    typedef typename CalendarTraits<Cal>::calendar_type Calendar;
+    int era, year, month, day;
+    calendar_instance<Cal>().Calendar::from_serial_date(_serial_date,
+        era, year, month, day);
+    return day;
+}
+
+template <CalendarSystem Cal>
+int Date::get_month() const {
+    typedef typename CalendarTraits<Cal>::calendar_type Calendar;
+    int era, year, month, day;
+    calendar_instance<Cal>().Calendar::from_serial_date(_serial_date,
+        era, year, month, day);
+    return month;
+}
+
+template <CalendarSystem Cal>
+int Date::get_year() const {
+    typedef typename CalendarTraits<Cal>::calendar_type Calendar;
+    int era, year, month, day;
+    calendar_instance<Cal>().Calendar::from_serial_date(_serial_date,
+        era, year, month, day);
+    return year;
+}
+
+template <CalendarSystem Cal>
+int Date::get_weekday() const {
+    typedef typename CalendarTraits<Cal>::calendar_type Calendar;
+    int day_of_week;
+    calendar_instance<Cal>().Calendar::from_serial_date(_serial_date,
+        day_of_week);
+    return day_of_week;
+}
+
+template <CalendarSystem Cal>
+std::string Date::to_string(const char* format) const {
+    typedef typename CalendarTraits<Cal>::calendar_type Calendar;
+    std::string date_str;
+    calendar_instance<Cal>().Calendar::from_serial_date(_serial_date,
+        date_str, format);
+    return date_str;
+}
+
+template <CalendarSystem Cal>
+std::string Date::to_string(const DateFormat& format) const {
+    typedef typename CalendarTraits<Cal>::calendar_type Calendar;
+    std::string date_str;
+    calendar_instance<Cal>().Calendar::from_serial_date(_serial_date,
+        date_str, format);
+    return date_str;
+}
+
 }  // namespace toolbox
@@ -0,0 +1,316 @@
+#include <DateColumnConverter.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <Date.hpp>
+
+namespace {
+
+// Room kept for a formatted date before formatting into the output block;
+// longer dates take a second pass.
+const std::size_t kDateRoom = 64;
+
+const char* field_end(const char* begin, const char* end, char delimiter);
+bool by_offset(const toolbox::FixedDateField& a,
+    const toolbox::FixedDateField& b);
+
+}  // namespace
+
+namespace toolbox {
+
+const std::size_t DateColumnConverter::kBlockSize;
+
+DateColumnSpec::DateColumnSpec()
+        : columns(1, 1), fixed_fields(), delimiter(','), header(false),
+          keep_invalid(false), from_cal(GREGORIAN), from_format(),
+          strict(true), to_cal(GREGORIAN), to_format(),
+          to_iso_form(ISO8601_CALENDAR) {
+}
+
+DateColumnConverter::DateColumnConverter(const DateColumnSpec& spec)
+        : _spec(spec), _is_date(), _fixed_fields(spec.fixed_fields),
+          _to_format(), _long_date(),
+          _copy_calendar_dates(spec.from_format.empty()
+              && spec.to_format.empty()
+              && spec.to_iso_form == ISO8601_CALENDAR),
+          _out(NULL), _buf(kBlockSize), _size(0), _pending(NULL), _line(0) {
+    for (std::size_t i = 0; i < spec.columns.size(); ++i) {
+        const int column = spec.columns[i];
+        if (column < 1) {
+            throw std::invalid_argument("DateColumnConverter::"
+                "DateColumnConverter failed: columns are numbered from 1");
+        }
+        if (_is_date.size() < static_cast<std::size_t>(column)) {
+            _is_date.resize(column, false);
+        }
+        _is_date[column - 1] = true;
+    }
+    std::sort(_fixed_fields.begin(), _fixed_fields.end(), by_offset);
+    for (std::size_t i = 0; i < _fixed_fields.size(); ++i) {
+        if (_fixed_fields[i].width == 0 || (i > 0
+                && _fixed_fields[i].offset < _fixed_fields[i - 1].offset
+                    + _fixed_fields[i - 1].width)) {
+            throw std::invalid_argument("DateColumnConverter::"
+                "DateColumnConverter failed: fixed fields are empty or "
+                "overlap");
+        }
+    }
+    if (!spec.from_format.empty()) {
+        // Compiled only to reject invalid specifiers before any input.
+        const DateFormat from_format(spec.from_format.c_str());
+    }
+    if (!spec.to_format.empty()) {
+        _to_format = DateFormat(spec.to_format.c_str());
+    }
+}
+
+DateColumnConverter::~DateColumnConverter() {
+}
+
+void DateColumnConverter::convert(std::FILE* in, std::FILE* out) {
+    start(out);
+    std::vector<char> in_buf(kBlockSize);
+    std::size_t used = 0;
+    for (;;) {
+        if (used == in_buf.size()) {
+            // A line longer than the block: read on until its end.
+            in_buf.resize(in_buf.size() * 2);
+        }
+        const std::size_t read = std::fread(&in_buf[used], 1,
+            in_buf.size() - used, in);
+        if (read == 0 && std::ferror(in)) {
+            throw std::runtime_error(
+                "DateColumnConverter::convert failed: read error");
+        }
+        used += read;
+        const bool at_end = read == 0;
+        const char* begin = &in_buf[0];
+        const char* rest = convert_lines(begin, begin + used, at_end);
+        used -= rest - begin;
+        std::memmove(&in_buf[0], rest, used);
+        if (at_end) {
+            break;
+        }
+    }
+    flush();
+}
+
+void DateColumnConverter::convert(const char* begin, const char* end,
+        std::FILE* out) {
+    start(out);
+    convert_lines(begin, end, true);
+    flush();
+}
+
+void DateColumnConverter::start(std::FILE* out) {
+    _out = out;
+    _size = 0;
+    _line = 0;
+}
+
+// Converts the complete lines of [begin, end), and the rest as the last line
+// if at_end, and returns the start of what is left.
+const char* DateColumnConverter::convert_lines(const char* begin,
+        const char* end, bool at_end) {
+    _pending = begin;
+    while (begin != end) {
+        const char* line_end = static_cast<const char*>(
+            std::memchr(begin, '\n', end - begin));
+        if (!line_end) {
+            if (!at_end) {
+                break;
+            }
+            line_end = end;
+        }
+        if (++_line > 1 || !_spec.header) {
+            try {
+                convert_line(begin, line_end);
+            } catch (const std::invalid_argument&) {
+                if (_pending < begin) {
+                    write(_pending, begin);
+                }
+                flush();
+                throw;
+            }
+        }
+        begin = line_end == end ? end : line_end + 1;
+    }
+    write(_pending, begin);
+    return begin;
+}
+
+void DateColumnConverter::convert_line(const char* begin, const char* end) {
+    if (end != begin && end[-1] == '\r') {
+        --end;
+    }
+    if (!_fixed_fields.empty()) {
+        const std::size_t length = end - begin;
+        for (std::size_t i = 0; i < _fixed_fields.size(); ++i) {
+            const FixedDateField& field = _fixed_fields[i];
+            if (field.offset + field.width > length) {
+                return;
+            }
+            convert_field(begin + field.offset,
+                begin + field.offset + field.width,
+                static_cast<int>(field.offset + 1));
+        }
+        return;
+    }
+    if (_is_date.empty()) {
+        return;
+    }
+    const int last = static_cast<int>(_is_date.size());
+    for (int column = 1; ; ++column) {
+        const char* next = field_end(begin, end, _spec.delimiter);
+        if (_is_date[column - 1]) {
+            convert_field(begin, next, column);
+        }
+        if (column == last || next == end) {
+            return;
+        }
+        begin = next + 1;
+    }
+}
+
+void DateColumnConverter::convert_field(const char* begin, const char* end,
+        int column) {
+    if (end - begin >= 2 && *begin == '"' && end[-1] == '"') {
+        ++begin;
+        --end;
+    }
+    if (begin == end) {
+        return;
+    }
+    int serial_date;
+    if (!parse(begin, end, serial_date)) {
+        fail(begin, end, column);
+        return;
+    }
+    if (_copy_calendar_dates && end - begin == 10 && begin[4] == '-'
+            && begin[7] == '-') {
+        // A valid YYYY-MM-DD, unlike the 10 bytes of YYYY-Www-D, is its own
+        // output: leave it in the span.
+        return;
+    }
+    write(_pending, begin);
+    _pending = begin;
+    if (kBlockSize - _size < kDateRoom) {
+        flush();
+    }
+    std::size_t len;
+    try {
+        len = format(serial_date, &_buf[_size], kBlockSize - _size);
+        if (len >= kBlockSize - _size) {
+            _long_date.assign(len + 1, '\0');
+            format(serial_date, &_long_date[0], _long_date.size());
+        }
+    } catch (const std::out_of_range&) {
+        fail(begin, end, column);
+        return;
+    }
+    if (len < kBlockSize - _size) {
+        _size += len;
+    } else {
+        write(_long_date.data(), _long_date.data() + len);
+    }
+    _pending = end;
+}
+
+bool DateColumnConverter::parse(const char* begin, const char* end,
+        int& serial_date) const {
+    if (_spec.from_format.empty()) {
+        return iso8601_to_serial_date(begin, end, serial_date);
+    }
+    Date date;
+    if (Date::try_parse(_spec.from_cal, begin, end,
+            _spec.from_format.c_str(), _spec.strict, date) != DATE_OK) {
+        return false;
+    }
+    serial_date = date.get_raw_date();
+    return true;
+}
+
+std::size_t DateColumnConverter::format(int serial_date, char* buf,
+        std::size_t cap) const {
+    if (_spec.to_format.empty()) {
+        return iso8601_format_to(serial_date, buf, cap, _spec.to_iso_form);
+    }
+    return Date(serial_date).format_to(buf, cap, _spec.to_cal, _to_format);
+}
+
+// Leaves the field [begin, end) as it is if keep_invalid, or throws.
+void DateColumnConverter::fail(const char* begin, const char* end,
+        int column) const {
+    if (_spec.keep_invalid) {
+        return;
+    }
+    std::ostringstream message;
+    message << "DateColumnConverter::convert failed: line " << _line
+        << ", column " << column << ": '" << std::string(begin, end)
+        << "' is not a date that converts";
+    throw std::invalid_argument(message.str());
+}
+
+void DateColumnConverter::write(const char* begin, const char* end) {
+    const std::size_t len = end - begin;
+    if (len == 0) {
+        return;
+    }
+    if (len > kBlockSize - _size) {
+        flush();
+        if (len > kBlockSize) {
+            if (std::fwrite(begin, 1, len, _out) != len) {
+                throw std::runtime_error(
+                    "DateColumnConverter::convert failed: write error");
+            }
+            return;
+        }
+    }
+    std::memcpy(&_buf[_size], begin, len);
+    _size += len;
+}
+
+void DateColumnConverter::flush() {
+    if (_size && std::fwrite(&_buf[0], 1, _size, _out) != _size) {
+        throw std::runtime_error(
+            "DateColumnConverter::convert failed: write error");
+    }
+    _size = 0;
+}
+
+}  // namespace toolbox
+
+namespace {
+
+// The end of the field that starts at begin: the next delimiter, skipping
+// those inside a quoted field ("" is an escaped quote), or end.
+const char* field_end(const char* begin, const char* end, char delimiter) {
+    if (begin != end && *begin == '"') {
+        const char* quote = begin + 1;
+        for (;;) {
+            quote = static_cast<const char*>(
+                std::memchr(quote, '"', end - quote));
+            if (!quote) {
+                return end;
+            }
+            if (++quote == end || *quote != '"') {
+                break;
+            }
+            ++quote;
+        }
+        begin = quote;
+    }
+    const char* delim = static_cast<const char*>(
+        std::memchr(begin, delimiter, end - begin));
+    return delim ? delim : end;
+}
+
+bool by_offset(const toolbox::FixedDateField& a,
+        const toolbox::FixedDateField& b) {
+    return a.offset < b.offset;
+}
+
+}  // namespace
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <calendar_system/CalendarSystem.hpp>
+#include <calendar_system/DateFormat.hpp>
+#include <calendar_system/Iso8601.hpp>
+
+namespace toolbox {
+
+// A date at a fixed position of every line, as in fixed-width records and
+// logs: width bytes from offset bytes after the start of the line.
+struct FixedDateField {
+    std::size_t offset;
+    std::size_t width;
+};
+
+// What DateColumnConverter rewrites: the date columns of delimited text (CSV
+// or TSV) from one calendar and format to another. A format of "" stands
+// for ISO 8601, which is proleptic Gregorian whatever the calendar: input in
+// any of the forms of Iso8601Form, output in to_iso_form.
+//
+// Dates are found by column, or at fixed positions if fixed_fields is not
+// empty; delimiters then play no part.
+struct DateColumnSpec {
+    DateColumnSpec();  // column 1, ',', ISO 8601 in and out
+
+    std::vector<int> columns;  // numbered from 1, as cut(1) numbers fields
+    std::vector<FixedDateField> fixed_fields;  // must not overlap
+    char delimiter;
+    bool header;        // copy the first line as it is
+    bool keep_invalid;  // copy fields that are not dates instead of failing
+    CalendarSystem from_cal;
+    std::string from_format;
+    bool strict;  // see Date::try_parse
+    CalendarSystem to_cal;
+    std::string to_format;
+    Iso8601Form to_iso_form;
+};
+
+// Streams delimited text through, rewriting the date columns of each line
+// and copying everything else byte for byte. Input is read and output
+// written in blocks of kBlockSize; the bytes between date fields are copied
+// a span at a time and dates are formatted straight into the output block,
+// so lines cost no allocation and ISO 8601 to ISO 8601 runs at memory speed.
+//
+// Lines end with '\n' (a '\r' before it stays with the line), the last one
+// possibly without it. A field that starts with '"' runs to its closing
+// quote, so quoted fields may contain the delimiter but not line breaks; a
+// quoted date is converted inside its quotes. Empty date fields, and lines
+// that are short of a date column or fixed field, are copied as they are.
+// Fields are parsed where they lie, without copying them out of the input.
+class DateColumnConverter {
+ public:
+    static const std::size_t kBlockSize = 1 << 20;
+
+    // Throws std::invalid_argument for a column below 1, empty or
+    // overlapping fixed fields, or an invalid format.
+    explicit DateColumnConverter(const DateColumnSpec& spec);
+    ~DateColumnConverter();
+
+    // Converts all of in to out. A field that is not a valid date in the
+    // input format, or cannot be written in the output one, throws
+    // std::invalid_argument naming its line and column (the byte position,
+    // from 1, for a fixed field) unless keep_invalid is set; read and write
+    // errors throw std::runtime_error. The lines before the failing one have
+    // then been written, possibly followed by the start of it.
+    void convert(std::FILE* in, std::FILE* out);
+    // The same for input already in memory, e.g. a MappedFile.
+    void convert(const char* begin, const char* end, std::FILE* out);
+
+ private:
+    DateColumnConverter(const DateColumnConverter& other);
+    DateColumnConverter& operator=(const DateColumnConverter& other);
+
+    void start(std::FILE* out);
+    const char* convert_lines(const char* begin, const char* end,
+        bool at_end);
+    void convert_line(const char* begin, const char* end);
+    void convert_field(const char* begin, const char* end, int column);
+    bool parse(const char* begin, const char* end, int& serial_date) const;
+    std::size_t format(int serial_date, char* buf, std::size_t cap) const;
+    void fail(const char* begin, const char* end, int column) const;
+    void write(const char* begin, const char* end);
+    void flush();
+
+    DateColumnSpec _spec;
+    std::vector<bool> _is_date;  // by column - 1, up to the last date column
+    std::vector<FixedDateField> _fixed_fields;  // by offset
+    DateFormat _to_format;
+    std::string _long_date;  // a formatted date too long for the block
+    // ISO 8601 in, YYYY-MM-DD out: such input dates need validating only.
+    bool _copy_calendar_dates;
+    std::FILE* _out;
+    std::vector<char> _buf;  // the output block
+    std::size_t _size;
+    const char* _pending;  // the start of the input not yet copied
+    unsigned long _line;
+};
+
+}  // namespace toolbox
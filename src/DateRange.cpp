@@ -0,0 +1,371 @@
+#include <DateRange.hpp>
+
+#include <stdexcept>
+#include <string>
+
+#include <calendar_system/CalendarArithmetic.hpp>
+#include <calendar_system/CalendarTraits.hpp>
+#include <calendar_system/DateStatus.hpp>
+#include <calendar_system/FrenchRepublicanCalendar.hpp>
+#include <calendar_system/GregorianCalendar.hpp>
+
+namespace {
+
+toolbox::CalendarSystem month_calendar(toolbox::CalendarSystem cal_sys);
+long long month_of(toolbox::CalendarSystem cal_sys,
+    const toolbox::CivilDate& civil);
+toolbox::Date month_day(toolbox::CalendarSystem cal_sys, long long month,
+    int day);
+bool continues_month(toolbox::CalendarSystem cal_sys,
+    const toolbox::CivilDate& civil, int start_serial, int serial_date);
+int last_serial_of_month(toolbox::CalendarSystem cal_sys,
+    const toolbox::CivilDate& civil, int serial_date);
+
+}  // namespace
+
+namespace toolbox {
+
+DateRange::DateRange(const Date& first, const Date& last, int step,
+        Unit unit, CalendarSystem cal_sys)
+        : _first(first), _step(step), _unit(unit), _cal_sys(cal_sys),
+        _size(0), _first_month(0), _first_day(0) {
+    if (step <= 0) {
+        throw std::invalid_argument(
+            "DateRange::DateRange failed: step must be positive");
+    }
+    if (unit == DAYS || unit == WEEKS) {
+        if (unit == WEEKS) {
+            _step *= 7;
+        }
+        const long long span = static_cast<long long>(last.get_raw_date())
+            - first.get_raw_date();
+        if (span > 0) {
+            _size = static_cast<std::size_t>((span + _step - 1) / _step);
+        }
+        return;
+    }
+    if (unit != MONTHS && unit != YEARS) {
+        throw std::invalid_argument(
+            "DateRange::DateRange failed: Invalid unit");
+    }
+    if (cal_sys == JAPANESE_WAREKI && first.get_raw_date() < kBeginGregorian) {
+        throw std::out_of_range("DateRange::DateRange failed: "
+            "wareki calendar steps start on or after 1582-10-15");
+    }
+    const CalendarSystem month_cal = month_calendar(cal_sys);
+    if (unit == YEARS) {
+        _step *= months_per_year(month_cal);
+    }
+    const CivilDate first_civil = first.decompose(month_cal);
+    _first_month = month_of(month_cal, first_civil);
+    _first_day = first_civil.day;
+    if (last <= first) {
+        return;
+    }
+    // Element k is before last if its month is, or if it falls in the month
+    // of last on an earlier day; clamping cannot move it past last's day.
+    const CivilDate last_civil = last.decompose(month_cal);
+    const long long months = month_of(month_cal, last_civil) - _first_month;
+    long long count = (months + _step - 1) / _step;
+    if (months % _step == 0 && _first_day < last_civil.day) {
+        ++count;
+    }
+    _size = static_cast<std::size_t>(count);
+}
+
+DateRange::DateRange(const DateRange& other)
+        : _first(other._first), _step(other._step), _unit(other._unit),
+        _cal_sys(other._cal_sys), _size(other._size),
+        _first_month(other._first_month), _first_day(other._first_day) {
+}
+
+DateRange& DateRange::operator=(const DateRange& other) {
+    if (this != &other) {
+        _first = other._first;
+        _step = other._step;
+        _unit = other._unit;
+        _cal_sys = other._cal_sys;
+        _size = other._size;
+        _first_month = other._first_month;
+        _first_day = other._first_day;
+    }
+    return *this;
+}
+
+DateRange::~DateRange() {
+}
+
+DateRange::iterator DateRange::begin() const {
+    return iterator(this, 0);
+}
+
+DateRange::iterator DateRange::end() const {
+    return iterator(this, static_cast<std::ptrdiff_t>(_size));
+}
+
+std::size_t DateRange::size() const {
+    return _size;
+}
+
+bool DateRange::empty() const {
+    return _size == 0;
+}
+
+Date DateRange::operator[](std::size_t index) const {
+    return at(static_cast<std::ptrdiff_t>(index));
+}
+
+CalendarSystem DateRange::calendar_system() const {
+    return _cal_sys;
+}
+
+Date DateRange::at(std::ptrdiff_t index) const {
+    if (_unit == DAYS || _unit == WEEKS) {
+        return _first + static_cast<int>(index * _step);
+    }
+    return month_day(month_calendar(_cal_sys), _first_month + index * _step,
+        _first_day);
+}
+
+DateRange::iterator::iterator()
+        : _range(NULL), _index(0), _date(), _month_end(0),
+        _has_civil(false) {
+    const CivilDate civil = {0, 0, 0, 0, 0};
+    _civil = civil;
+}
+
+DateRange::iterator::iterator(const DateRange* range, difference_type index)
+        : _range(range), _index(index), _date(), _month_end(0),
+        _has_civil(false) {
+    const CivilDate civil = {0, 0, 0, 0, 0};
+    _civil = civil;
+    if (_index >= 0 && static_cast<std::size_t>(_index) < _range->_size) {
+        _date = _range->at(_index);
+    }
+}
+
+DateRange::iterator::iterator(const iterator& other)
+        : _range(other._range), _index(other._index), _date(other._date),
+        _civil(other._civil), _month_end(other._month_end),
+        _has_civil(other._has_civil) {
+}
+
+DateRange::iterator& DateRange::iterator::operator=(const iterator& other) {
+    if (this != &other) {
+        _range = other._range;
+        _index = other._index;
+        _date = other._date;
+        _civil = other._civil;
+        _month_end = other._month_end;
+        _has_civil = other._has_civil;
+    }
+    return *this;
+}
+
+DateRange::iterator::~iterator() {
+}
+
+Date DateRange::iterator::operator[](difference_type n) const {
+    return _range->at(_index + n);
+}
+
+void DateRange::iterator::load_civil() const {
+    _civil = _date.decompose(_range->_cal_sys);
+    _month_end = last_serial_of_month(_range->_cal_sys, _civil,
+        _date.get_raw_date());
+    _has_civil = true;
+}
+
+DateRange::iterator& DateRange::iterator::operator++() {
+    return *this += 1;
+}
+
+DateRange::iterator DateRange::iterator::operator++(int) {
+    iterator old(*this);
+    *this += 1;
+    return old;
+}
+
+DateRange::iterator& DateRange::iterator::operator--() {
+    return *this -= 1;
+}
+
+DateRange::iterator DateRange::iterator::operator--(int) {
+    iterator old(*this);
+    *this -= 1;
+    return old;
+}
+
+DateRange::iterator& DateRange::iterator::operator+=(difference_type n) {
+    const bool had_date = _index >= 0
+        && static_cast<std::size_t>(_index) < _range->_size;
+    _index += n;
+    if (_index < 0 || static_cast<std::size_t>(_index) >= _range->_size) {
+        _has_civil = false;
+        return *this;
+    }
+    if (!had_date || (_range->_unit != DAYS && _range->_unit != WEEKS)) {
+        _date = _range->at(_index);
+        _has_civil = false;
+        return *this;
+    }
+    const int delta = static_cast<int>(n * _range->_step);
+    _date += delta;
+    if (_has_civil && delta > 0 && _date.get_raw_date() <= _month_end) {
+        _civil.day += delta;
+        _civil.weekday = (_civil.weekday + delta)
+            % days_per_week(_range->_cal_sys);
+    } else {
+        _has_civil = false;
+    }
+    return *this;
+}
+
+DateRange::iterator& DateRange::iterator::operator-=(difference_type n) {
+    return *this += -n;
+}
+
+DateRange::iterator DateRange::iterator::operator+(difference_type n) const {
+    iterator it(*this);
+    it += n;
+    return it;
+}
+
+DateRange::iterator DateRange::iterator::operator-(difference_type n) const {
+    iterator it(*this);
+    it -= n;
+    return it;
+}
+
+DateRange::iterator::difference_type DateRange::iterator::operator-(
+        const iterator& other) const {
+    return _index - other._index;
+}
+
+bool DateRange::iterator::operator<(const iterator& other) const {
+    return _index < other._index;
+}
+
+bool DateRange::iterator::operator<=(const iterator& other) const {
+    return _index <= other._index;
+}
+
+bool DateRange::iterator::operator>(const iterator& other) const {
+    return _index > other._index;
+}
+
+bool DateRange::iterator::operator>=(const iterator& other) const {
+    return _index >= other._index;
+}
+
+DateRange::iterator operator+(DateRange::iterator::difference_type n,
+        const DateRange::iterator& it) {
+    return it + n;
+}
+
+}  // namespace toolbox
+
+namespace {
+
+toolbox::CalendarSystem month_calendar(toolbox::CalendarSystem cal_sys) {
+    return cal_sys == toolbox::JAPANESE_WAREKI ? toolbox::GREGORIAN : cal_sys;
+}
+
+// Counts months from the start of year 0 (1 B.C.). The calendars other
+// than the French Republican one share the values of GregorianCalendar::Era.
+long long month_of(toolbox::CalendarSystem cal_sys,
+        const toolbox::CivilDate& civil) {
+    long long year = civil.year;
+    if (cal_sys != toolbox::FRENCH_REPUBLICAN
+            && civil.era == toolbox::GregorianCalendar::BC) {
+        year = 1 - year;
+    }
+    return year * months_per_year(cal_sys) + civil.month - 1;
+}
+
+// The date on day of month, or on the last day of month if it is shorter.
+toolbox::Date month_day(toolbox::CalendarSystem cal_sys, long long month,
+        int day) {
+    const int per_year = months_per_year(cal_sys);
+    long long year = month / per_year;
+    if (month % per_year < 0) {
+        --year;
+    }
+    const int month_of_year = static_cast<int>(month - year * per_year) + 1;
+    int era = toolbox::GregorianCalendar::AD;
+    if (cal_sys == toolbox::FRENCH_REPUBLICAN) {
+        era = toolbox::FrenchRepublicanCalendar::AD;
+    } else if (year <= 0) {
+        era = toolbox::GregorianCalendar::BC;
+        year = 1 - year;
+    }
+    toolbox::Date date;
+    toolbox::DateStatus status = toolbox::Date::try_make(cal_sys, era,
+        static_cast<int>(year), month_of_year, day, date);
+    if (status == toolbox::DATE_INVALID_DAY) {
+        // The last valid day, by bisection: day 1 always exists.
+        int valid = 1;
+        int invalid = day;
+        while (invalid - valid > 1) {
+            const int mid = valid + (invalid - valid) / 2;
+            toolbox::Date probe;
+            if (toolbox::Date::try_make(cal_sys, era, static_cast<int>(year),
+                    month_of_year, mid, probe) == toolbox::DATE_OK) {
+                valid = mid;
+            } else {
+                invalid = mid;
+            }
+        }
+        status = toolbox::Date::try_make(cal_sys, era,
+            static_cast<int>(year), month_of_year, valid, date);
+    }
+    if (status != toolbox::DATE_OK) {
+        throw std::out_of_range(std::string("DateRange failed: ")
+            + toolbox::date_status_message(status));
+    }
+    return date;
+}
+
+// Whether serial_date continues the month of civil, which starts at
+// start_serial on day civil.day.
+bool continues_month(toolbox::CalendarSystem cal_sys,
+        const toolbox::CivilDate& civil, int start_serial, int serial_date) {
+    toolbox::CivilDate next;
+    try {
+        next = toolbox::Date(serial_date).decompose(cal_sys);
+    } catch (const std::out_of_range& e) {
+        (void)e;
+        return false;
+    }
+    return next.era == civil.era && next.year == civil.year
+        && next.month == civil.month
+        && next.day == civil.day + (serial_date - start_serial);
+}
+
+// The last serial date whose fields follow on from civil day by day. The
+// day number is checked too, so that the wareki month of the Gregorian
+// reform (1582-10-04 followed by 10-15) counts as two. Usual month lengths
+// are tried first, longest first, so that most months take one or two
+// conversions.
+int last_serial_of_month(toolbox::CalendarSystem cal_sys,
+        const toolbox::CivilDate& civil, int serial_date) {
+    for (int length = 31; length >= 28 && length >= civil.day; --length) {
+        const int candidate = serial_date + length - civil.day;
+        if (continues_month(cal_sys, civil, serial_date, candidate)) {
+            return candidate;
+        }
+    }
+    int valid = serial_date;
+    int invalid = serial_date + 28 - civil.day;
+    while (invalid - valid > 1) {
+        const int mid = valid + (invalid - valid) / 2;
+        if (continues_month(cal_sys, civil, serial_date, mid)) {
+            valid = mid;
+        } else {
+            invalid = mid;
+        }
+    }
+    return valid;
+}
+
+}  // namespace
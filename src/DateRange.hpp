@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+
+#include <Date.hpp>
+#include <calendar_system/CalendarSystem.hpp>
+
+namespace toolbox {
+
+// The dates first, first + step, first + 2 * step, ... before last (half
+// open). Elements are computed from their index, so size(), operator[] and
+// iterator arithmetic are O(1) and nothing is stored.
+//
+// DAYS and WEEKS step by a fixed number of days. MONTHS and YEARS step in
+// cal_sys, keeping the day of the month of first and clamping it to the last
+// day of shorter months, e.g. monthly from Jan 31 gives Feb 28 (or 29), Mar
+// 31, ... Each element is computed from first, so clamping never drifts.
+// JAPANESE_WAREKI steps with the Gregorian months its dates are made of and
+// must start on or after 1582-10-15.
+class DateRange {
+ public:
+    enum Unit {
+        DAYS,
+        WEEKS,
+        MONTHS,
+        YEARS
+    };
+
+    class iterator;
+
+    // Throws std::invalid_argument if step is not positive and
+    // std::out_of_range if a calendar step cannot represent first or last in
+    // cal_sys.
+    DateRange(const Date& first, const Date& last, int step = 1,
+        Unit unit = DAYS, CalendarSystem cal_sys = GREGORIAN);
+    DateRange(const DateRange& other);
+    DateRange& operator=(const DateRange& other);
+    ~DateRange();
+
+    iterator begin() const;
+    iterator end() const;
+    std::size_t size() const;
+    bool empty() const;
+    Date operator[](std::size_t index) const;
+
+    CalendarSystem calendar_system() const;
+
+ private:
+    Date at(std::ptrdiff_t index) const;
+
+    Date _first;
+    long long _step;  // in days for DAYS and WEEKS, in months otherwise
+    Unit _unit;
+    CalendarSystem _cal_sys;
+    std::size_t _size;
+    // Calendar steps only: first as a count of months and its day.
+    long long _first_month;
+    int _first_day;
+};
+
+// A random-access iterator over a DateRange. Besides the date, civil()
+// gives its fields in the range's calendar. They are computed on first use
+// and then kept up to date incrementally while the iterator moves forward
+// by days within a month, so walking a year day by day converts about once
+// a month instead of once a day.
+class DateRange::iterator {
+ public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef Date value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const Date* pointer;
+    typedef const Date& reference;
+
+    iterator();
+    iterator(const iterator& other);
+    iterator& operator=(const iterator& other);
+    ~iterator();
+
+    reference operator*() const;
+    pointer operator->() const;
+    Date operator[](difference_type n) const;
+    const CivilDate& civil() const;
+
+    iterator& operator++();
+    iterator operator++(int);
+    iterator& operator--();
+    iterator operator--(int);
+    iterator& operator+=(difference_type n);
+    iterator& operator-=(difference_type n);
+    iterator operator+(difference_type n) const;
+    iterator operator-(difference_type n) const;
+    difference_type operator-(const iterator& other) const;
+
+    bool operator==(const iterator& other) const;
+    bool operator!=(const iterator& other) const;
+    bool operator<(const iterator& other) const;
+    bool operator<=(const iterator& other) const;
+    bool operator>(const iterator& other) const;
+    bool operator>=(const iterator& other) const;
+
+ private:
+    friend class DateRange;
+
+    iterator(const DateRange* range, difference_type index);
+    void load_civil() const;
+
+    const DateRange* _range;
+    difference_type _index;
+    Date _date;
+    // civil() of _date, valid if _has_civil. _month_end is the serial date
+    // of the last day that has the same era, year and month.
+    mutable CivilDate _civil;
+    mutable int _month_end;
+    mutable bool _has_civil;
+};
+
+DateRange::iterator operator+(DateRange::iterator::difference_type n,
+    const DateRange::iterator& it);
+
+// Defined here so that a loop over a range compiles down to a few compares
+// per step.
+inline DateRange::iterator::reference DateRange::iterator::operator*() const {
+    return _date;
+}
+
+inline DateRange::iterator::pointer DateRange::iterator::operator->() const {
+    return &_date;
+}
+
+inline const CivilDate& DateRange::iterator::civil() const {
+    if (!_has_civil) {
+        load_civil();
+    }
+    return _civil;
+}
+
+inline bool DateRange::iterator::operator==(const iterator& other) const {
+    return _index == other._index;
+}
+
+inline bool DateRange::iterator::operator!=(const iterator& other) const {
+    return _index != other._index;
+}
+
+}  // namespace toolbox
@@ -0,0 +1,100 @@
+#include <MappedFile.hpp>
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TOOLBOX_HAS_MMAP 1
+#endif
+
+namespace {
+
+std::runtime_error open_error(const char* path, const char* what);
+
+}  // namespace
+
+namespace toolbox {
+
+#if defined(TOOLBOX_HAS_MMAP)
+MappedFile::MappedFile(const char* path)
+        : _data(NULL), _size(0), _copy() {
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        throw open_error(path, "cannot open");
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        throw open_error(path, "not a regular file");
+    }
+    _size = static_cast<std::size_t>(st.st_size);
+    if (_size > 0) {
+        void* data = ::mmap(NULL, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            throw open_error(path, "cannot map");
+        }
+        ::madvise(data, _size, MADV_SEQUENTIAL);
+        _data = static_cast<const char*>(data);
+    }
+    // The mapping stays valid after the descriptor is closed.
+    ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (_data) {
+        ::munmap(const_cast<char*>(_data), _size);
+    }
+}
+#else
+MappedFile::MappedFile(const char* path)
+        : _data(NULL), _size(0), _copy() {
+    std::FILE* file = std::fopen(path, "rb");
+    if (!file) {
+        throw open_error(path, "cannot open");
+    }
+    char buf[65536];
+    for (std::size_t len;
+            (len = std::fread(buf, 1, sizeof(buf), file)) > 0; ) {
+        _copy.insert(_copy.end(), buf, buf + len);
+    }
+    const bool failed = std::ferror(file) != 0;
+    std::fclose(file);
+    if (failed) {
+        throw open_error(path, "cannot read");
+    }
+    _size = _copy.size();
+    _data = _size ? &_copy[0] : NULL;
+}
+
+MappedFile::~MappedFile() {
+}
+#endif
+
+const char* MappedFile::begin() const {
+    return _data;
+}
+
+const char* MappedFile::end() const {
+    return _data + _size;
+}
+
+std::size_t MappedFile::size() const {
+    return _size;
+}
+
+}  // namespace toolbox
+
+namespace {
+
+std::runtime_error open_error(const char* path, const char* what) {
+    return std::runtime_error(std::string("MappedFile::MappedFile failed: ")
+        + what + " " + path);
+}
+
+}  // namespace
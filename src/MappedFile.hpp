@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace toolbox {
+
+// The whole contents of a file as read-only memory: mapped with mmap where
+// the platform has it, so that pages are read in on demand (and ahead, as
+// access is declared sequential) without copying, and read into memory
+// elsewhere.
+class MappedFile {
+ public:
+    // Throws std::runtime_error if the file cannot be opened or mapped.
+    explicit MappedFile(const char* path);
+    ~MappedFile();
+
+    const char* begin() const;
+    const char* end() const;
+    std::size_t size() const;
+
+ private:
+    MappedFile(const MappedFile& other);
+    MappedFile& operator=(const MappedFile& other);
+
+    const char* _data;
+    std::size_t _size;
+    std::vector<char> _copy;  // the contents where there is no mmap
+};
+
+}  // namespace toolbox
@@ -0,0 +1,324 @@
+#include <Parallel.hpp>
+
+#include <algorithm>
+#include <limits>
+
+#include <Date.hpp>
+
+namespace {
+
+unsigned thread_count(unsigned threads);
+std::size_t chunk_count(std::size_t count);
+std::size_t chunk_end(std::size_t begin, std::size_t count);
+
+class ToSerialJob : public toolbox::parallel::Job {
+ public:
+    ToSerialJob(toolbox::CalendarSystem cal_sys, const int* eras,
+        const int* years, const int* months, const int* days,
+        std::size_t count, int* serial_dates);
+    void run(std::size_t task) const;
+
+ private:
+    toolbox::CalendarSystem _cal_sys;
+    const int* _eras;
+    const int* _years;
+    const int* _months;
+    const int* _days;
+    std::size_t _count;
+    int* _serial_dates;
+};
+
+class FromSerialJob : public toolbox::parallel::Job {
+ public:
+    FromSerialJob(toolbox::CalendarSystem cal_sys, const int* serial_dates,
+        std::size_t count, int* eras, int* years, int* months, int* days);
+    void run(std::size_t task) const;
+
+ private:
+    toolbox::CalendarSystem _cal_sys;
+    const int* _serial_dates;
+    std::size_t _count;
+    int* _eras;
+    int* _years;
+    int* _months;
+    int* _days;
+};
+
+class ParseJob : public toolbox::parallel::Job {
+ public:
+    ParseJob(toolbox::CalendarSystem cal_sys, const std::string* date_strs,
+        std::size_t count, const char* format, bool strict,
+        int* serial_dates);
+    void run(std::size_t task) const;
+
+ private:
+    toolbox::CalendarSystem _cal_sys;
+    const std::string* _date_strs;
+    std::size_t _count;
+    const char* _format;
+    bool _strict;
+    int* _serial_dates;
+};
+
+class FormatJob : public toolbox::parallel::Job {
+ public:
+    FormatJob(toolbox::CalendarSystem cal_sys, const int* serial_dates,
+        std::size_t count, const toolbox::DateFormat& format,
+        std::string* date_strs);
+    void run(std::size_t task) const;
+
+ private:
+    toolbox::CalendarSystem _cal_sys;
+    const int* _serial_dates;
+    std::size_t _count;
+    const toolbox::DateFormat& _format;
+    std::string* _date_strs;
+};
+
+}  // namespace
+
+namespace toolbox {
+namespace parallel {
+
+ThreadPool::ThreadPool(unsigned threads)
+        : _threads(), _queues(thread_count(threads)), _mutex(), _wake(),
+          _done(), _job(NULL), _generation(0), _pending(0), _stop(false),
+          _error_task(0), _error() {
+    _threads.reserve(_queues.size() - 1);
+    for (unsigned i = 1; i < _queues.size(); ++i) {
+        _threads.push_back(std::thread(&ThreadPool::work, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (std::size_t i = 0; i < _threads.size(); ++i) {
+        _threads[i].join();
+    }
+}
+
+unsigned ThreadPool::size() const {
+    return static_cast<unsigned>(_queues.size());
+}
+
+void ThreadPool::run(const Job& job, std::size_t count) {
+    const std::size_t threads = _queues.size();
+    if (threads == 1 || count <= 1) {
+        for (std::size_t task = 0; task < count; ++task) {
+            job.run(task);
+        }
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        for (std::size_t i = 0; i < threads; ++i) {
+            std::lock_guard<std::mutex> queue_lock(_queues[i].mutex);
+            _queues[i].next = count * i / threads;
+            _queues[i].end = count * (i + 1) / threads;
+        }
+        _job = &job;
+        _pending = static_cast<unsigned>(threads - 1);
+        _error_task = std::numeric_limits<std::size_t>::max();
+        _error = std::exception_ptr();
+        ++_generation;
+    }
+    _wake.notify_all();
+    run_tasks(0);
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_pending > 0) {
+        _done.wait(lock);
+    }
+    _job = NULL;
+    if (_error) {
+        std::exception_ptr error = _error;
+        _error = std::exception_ptr();
+        std::rethrow_exception(error);
+    }
+}
+
+// The loop of the worker thread index, which runs a job per generation.
+void ThreadPool::work(unsigned index) {
+    unsigned long generation = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (!_stop && _generation == generation) {
+                _wake.wait(lock);
+            }
+            if (_stop) {
+                return;
+            }
+            generation = _generation;
+        }
+        run_tasks(index);
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (--_pending == 0) {
+            _done.notify_one();
+        }
+    }
+}
+
+void ThreadPool::run_tasks(unsigned index) {
+    std::size_t task = 0;
+    while (next_task(index, task)) {
+        try {
+            _job->run(task);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (task < _error_task) {
+                _error_task = task;
+                _error = std::current_exception();
+            }
+        }
+    }
+}
+
+// Takes the front task of the thread's own range, or else steals the back
+// half of the first other range that has tasks left.
+bool ThreadPool::next_task(unsigned index, std::size_t& task) {
+    Queue& own = _queues[index];
+    {
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.next < own.end) {
+            task = own.next++;
+            return true;
+        }
+    }
+    const std::size_t threads = _queues.size();
+    for (std::size_t i = 1; i < threads; ++i) {
+        Queue& victim = _queues[(index + i) % threads];
+        std::size_t begin = 0;
+        std::size_t end = 0;
+        {
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (victim.next >= victim.end) {
+                continue;
+            }
+            begin = victim.next + (victim.end - victim.next) / 2;
+            end = victim.end;
+            victim.end = begin;
+        }
+        task = begin;
+        std::lock_guard<std::mutex> lock(own.mutex);
+        own.next = begin + 1;
+        own.end = end;
+        return true;
+    }
+    return false;
+}
+
+void convert(ThreadPool& pool, CalendarSystem cal_sys, const int* eras,
+        const int* years, const int* months, const int* days,
+        std::size_t count, int* serial_dates) {
+    pool.run(ToSerialJob(cal_sys, eras, years, months, days, count,
+        serial_dates), chunk_count(count));
+}
+
+void convert(ThreadPool& pool, CalendarSystem cal_sys,
+        const int* serial_dates, std::size_t count, int* eras, int* years,
+        int* months, int* days) {
+    pool.run(FromSerialJob(cal_sys, serial_dates, count, eras, years,
+        months, days), chunk_count(count));
+}
+
+void convert(ThreadPool& pool, CalendarSystem cal_sys,
+        const std::string* date_strs, std::size_t count, const char* format,
+        bool strict, int* serial_dates) {
+    pool.run(ParseJob(cal_sys, date_strs, count, format, strict,
+        serial_dates), chunk_count(count));
+}
+
+void convert(ThreadPool& pool, CalendarSystem cal_sys,
+        const int* serial_dates, std::size_t count, const DateFormat& format,
+        std::string* date_strs) {
+    pool.run(FormatJob(cal_sys, serial_dates, count, format, date_strs),
+        chunk_count(count));
+}
+
+}  // namespace parallel
+}  // namespace toolbox
+
+namespace {
+
+unsigned thread_count(unsigned threads) {
+    if (threads == 0) {
+        return std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    return threads;
+}
+
+std::size_t chunk_count(std::size_t count) {
+    return (count + toolbox::parallel::kChunkSize - 1)
+        / toolbox::parallel::kChunkSize;
+}
+
+// The end of the chunk that starts at begin.
+std::size_t chunk_end(std::size_t begin, std::size_t count) {
+    return std::min(begin + toolbox::parallel::kChunkSize, count);
+}
+
+ToSerialJob::ToSerialJob(toolbox::CalendarSystem cal_sys, const int* eras,
+        const int* years, const int* months, const int* days,
+        std::size_t count, int* serial_dates)
+        : _cal_sys(cal_sys), _eras(eras), _years(years), _months(months),
+          _days(days), _count(count), _serial_dates(serial_dates) {
+}
+
+void ToSerialJob::run(std::size_t task) const {
+    const std::size_t begin = task * toolbox::parallel::kChunkSize;
+    toolbox::Date::to_serial_dates(_cal_sys, _eras + begin, _years + begin,
+        _months + begin, _days + begin, chunk_end(begin, _count) - begin,
+        _serial_dates + begin);
+}
+
+FromSerialJob::FromSerialJob(toolbox::CalendarSystem cal_sys,
+        const int* serial_dates, std::size_t count, int* eras, int* years,
+        int* months, int* days)
+        : _cal_sys(cal_sys), _serial_dates(serial_dates), _count(count),
+          _eras(eras), _years(years), _months(months), _days(days) {
+}
+
+void FromSerialJob::run(std::size_t task) const {
+    const std::size_t begin = task * toolbox::parallel::kChunkSize;
+    toolbox::Date::from_serial_dates(_cal_sys, _serial_dates + begin,
+        chunk_end(begin, _count) - begin, _eras + begin, _years + begin,
+        _months + begin, _days + begin);
+}
+
+ParseJob::ParseJob(toolbox::CalendarSystem cal_sys,
+        const std::string* date_strs, std::size_t count, const char* format,
+        bool strict, int* serial_dates)
+        : _cal_sys(cal_sys), _date_strs(date_strs), _count(count),
+          _format(format), _strict(strict), _serial_dates(serial_dates) {
+}
+
+void ParseJob::run(std::size_t task) const {
+    const std::size_t begin = task * toolbox::parallel::kChunkSize;
+    const std::size_t end = chunk_end(begin, _count);
+    for (std::size_t i = begin; i < end; ++i) {
+        _serial_dates[i] = toolbox::Date(_cal_sys, _date_strs[i], _format,
+            _strict).get_raw_date();
+    }
+}
+
+FormatJob::FormatJob(toolbox::CalendarSystem cal_sys,
+        const int* serial_dates, std::size_t count,
+        const toolbox::DateFormat& format, std::string* date_strs)
+        : _cal_sys(cal_sys), _serial_dates(serial_dates), _count(count),
+          _format(format), _date_strs(date_strs) {
+}
+
+void FormatJob::run(std::size_t task) const {
+    const std::size_t begin = task * toolbox::parallel::kChunkSize;
+    const std::size_t end = chunk_end(begin, _count);
+    for (std::size_t i = begin; i < end; ++i) {
+        _date_strs[i] = toolbox::Date(_serial_dates[i]).to_string(_cal_sys,
+            _format);
+    }
+}
+
+}  // namespace
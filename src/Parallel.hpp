@@ -0,0 +1,100 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <calendar_system/CalendarSystem.hpp>
+#include <calendar_system/DateFormat.hpp>
+
+namespace toolbox {
+namespace parallel {
+
+// The number of dates converted as one task: a chunk of serial dates and its
+// four field columns take 160 KiB, which stays within a core's L2 cache.
+const std::size_t kChunkSize = 8192;
+
+// Work split into tasks numbered 0..count-1 that may run concurrently.
+class Job {
+ public:
+    virtual ~Job() {}
+    virtual void run(std::size_t task) const = 0;
+};
+
+// A fixed set of worker threads running the tasks of one Job at a time. The
+// tasks are dealt out to the threads as contiguous ranges, and a thread that
+// runs out steals the back half of another thread's range, so uneven tasks
+// still keep every thread busy. The calling thread works as one of them.
+class ThreadPool {
+ public:
+    // threads counts the calling thread; 0 uses every hardware thread.
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    unsigned size() const;
+
+    // Runs job.run(task) for every task in 0..count-1 and returns when all
+    // of them have finished. If tasks throw, the exception of the lowest
+    // numbered one is rethrown after the others have finished. Not to be
+    // called from several threads at once.
+    void run(const Job& job, std::size_t count);
+
+ private:
+    // The tasks next..end (half open) dealt to one thread.
+    struct Queue {
+        std::mutex mutex;
+        std::size_t next;
+        std::size_t end;
+    };
+
+    ThreadPool(const ThreadPool& other);
+    ThreadPool& operator=(const ThreadPool& other);
+
+    void work(unsigned index);
+    void run_tasks(unsigned index);
+    bool next_task(unsigned index, std::size_t& task);
+
+    std::vector<std::thread> _threads;
+    std::vector<Queue> _queues;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    const Job* _job;
+    unsigned long _generation;
+    unsigned _pending;  // workers still running the current job
+    bool _stop;
+    std::size_t _error_task;
+    std::exception_ptr _error;
+};
+
+// Bulk conversions of count dates split into kChunkSize chunks across the
+// threads of pool. Each element is written to the same index of the output
+// as by the single-threaded equivalent, so the output does not depend on the
+// number of threads or on scheduling. Invalid elements throw the exception
+// that the single-threaded conversion throws for the first of them; outputs
+// of other elements are then unspecified.
+//
+// Fields to serial dates and back, like Date::to_serial_dates and
+// Date::from_serial_dates.
+void convert(ThreadPool& pool, CalendarSystem cal_sys, const int* eras,
+    const int* years, const int* months, const int* days, std::size_t count,
+    int* serial_dates);
+void convert(ThreadPool& pool, CalendarSystem cal_sys,
+    const int* serial_dates, std::size_t count, int* eras, int* years,
+    int* months, int* days);
+// Strings to serial dates and back, like the Date constructor from a string
+// and Date::to_string. Converting between calendars or formats is a parse
+// in one followed by a format in the other.
+void convert(ThreadPool& pool, CalendarSystem cal_sys,
+    const std::string* date_strs, std::size_t count, const char* format,
+    bool strict, int* serial_dates);
+void convert(ThreadPool& pool, CalendarSystem cal_sys,
+    const int* serial_dates, std::size_t count, const DateFormat& format,
+    std::string* date_strs);
+
+}  // namespace parallel
+}  // namespace toolbox
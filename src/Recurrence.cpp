@@ -0,0 +1,528 @@
+#include <Recurrence.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <stdexcept>
+
+#include <bits.hpp>
+#include <calendar_system/CalendarArithmetic.hpp>
+#include <calendar_system/CalendarTraits.hpp>
+#include <calendar_system/DateStatus.hpp>
+#include <calendar_system/FrenchRepublicanCalendar.hpp>
+#include <calendar_system/GregorianCalendar.hpp>
+#include <calendar_system/MonthPolicy.hpp>
+
+namespace {
+
+// A period is at most a year, which no calendar makes longer than 384 days.
+const int kMaxPeriodDays = 384;
+const int kPeriodWords = kMaxPeriodDays / 64;
+
+// A rule that selects nothing for 400 Gregorian years never will.
+const int kMaxGapDays = 146097;
+
+toolbox::CalendarSystem month_calendar(toolbox::CalendarSystem cal_sys);
+long long year_of(toolbox::CalendarSystem cal_sys,
+    const toolbox::CivilDate& civil);
+void split_year(toolbox::CalendarSystem cal_sys, long long year, int& era,
+    int& era_year);
+bool contains(const std::vector<int>& values, int value);
+
+}  // namespace
+
+namespace toolbox {
+
+RecurrenceRule::RecurrenceRule(Frequency frequency, CalendarSystem cal_sys)
+        : frequency(frequency), cal_sys(cal_sys), interval(1),
+        week_start(cal_sys == FRENCH_REPUBLICAN ? 0 : 1), by_month(),
+        by_month_day(), by_weekday(), by_set_pos(), count(0),
+        until(INT_MAX) {
+}
+
+Recurrence::Recurrence(const Date& start, const RecurrenceRule& rule)
+        : _rule(rule), _start(start.get_raw_date()),
+        _month_cal(month_calendar(rule.cal_sys)),
+        _months_per_year(months_per_year(rule.cal_sys)),
+        _days_per_week(days_per_week(rule.cal_sys)), _start_month(0),
+        _start_day(0), _start_weekday(0), _first_period(0), _period(0),
+        _pending(), _pos(0), _emitted(0), _last_found(0), _done(false) {
+    const bool daily = rule.frequency == RecurrenceRule::DAILY
+        || rule.frequency == RecurrenceRule::WEEKLY;
+    if (rule.frequency < RecurrenceRule::DAILY
+            || rule.frequency > RecurrenceRule::YEARLY) {
+        throw std::invalid_argument(
+            "Recurrence::Recurrence failed: Invalid frequency");
+    }
+    if (rule.interval <= 0 || rule.count < 0) {
+        throw std::invalid_argument("Recurrence::Recurrence failed: "
+            "interval must be positive and count must not be negative");
+    }
+    if (rule.week_start < 0 || rule.week_start >= _days_per_week) {
+        throw std::invalid_argument(
+            "Recurrence::Recurrence failed: Invalid week_start");
+    }
+    for (std::size_t i = 0; i < rule.by_month.size(); ++i) {
+        if (rule.by_month[i] < 1 || rule.by_month[i] > _months_per_year) {
+            throw std::invalid_argument(
+                "Recurrence::Recurrence failed: Invalid by_month");
+        }
+    }
+    for (std::size_t i = 0; i < rule.by_month_day.size(); ++i) {
+        const int day = rule.by_month_day[i];
+        if (day == 0 || day < -31 || day > 31) {
+            throw std::invalid_argument(
+                "Recurrence::Recurrence failed: Invalid by_month_day");
+        }
+    }
+    for (std::size_t i = 0; i < rule.by_weekday.size(); ++i) {
+        const WeekdayNth& weekday = rule.by_weekday[i];
+        const int max_nth = daily ? 0
+            : rule.frequency == RecurrenceRule::MONTHLY ? 5 : 53;
+        if (weekday.weekday < 0 || weekday.weekday >= _days_per_week
+                || weekday.nth < -max_nth || weekday.nth > max_nth) {
+            throw std::invalid_argument(
+                "Recurrence::Recurrence failed: Invalid by_weekday");
+        }
+    }
+    for (std::size_t i = 0; i < rule.by_set_pos.size(); ++i) {
+        const int pos = rule.by_set_pos[i];
+        if (pos == 0 || pos < -kMaxPeriodDays || pos > kMaxPeriodDays) {
+            throw std::invalid_argument(
+                "Recurrence::Recurrence failed: Invalid by_set_pos");
+        }
+    }
+    if (rule.cal_sys == JAPANESE_WAREKI && _start < kBeginGregorian) {
+        throw std::out_of_range("Recurrence::Recurrence failed: "
+            "wareki rules start on or after 1582-10-15");
+    }
+    const CivilDate civil = start.decompose(_month_cal);
+    _start_month = civil.month;
+    _start_day = civil.day;
+    _start_weekday = civil.weekday;
+    switch (rule.frequency) {
+        case RecurrenceRule::DAILY:
+            _first_period = _start;
+            break;
+        case RecurrenceRule::WEEKLY:
+            _first_period = _start - (civil.weekday - rule.week_start
+                + _days_per_week) % _days_per_week;
+            break;
+        case RecurrenceRule::MONTHLY:
+            _first_period = year_of(_month_cal, civil) * _months_per_year
+                + civil.month - 1;
+            break;
+        default:
+            _first_period = year_of(_month_cal, civil);
+            break;
+    }
+    _pending.reserve(kMaxPeriodDays);
+    reset();
+}
+
+Recurrence::Recurrence(const Recurrence& other)
+        : _rule(other._rule), _start(other._start),
+        _month_cal(other._month_cal),
+        _months_per_year(other._months_per_year),
+        _days_per_week(other._days_per_week),
+        _start_month(other._start_month), _start_day(other._start_day),
+        _start_weekday(other._start_weekday),
+        _first_period(other._first_period), _period(other._period),
+        _pending(other._pending), _pos(other._pos),
+        _emitted(other._emitted), _last_found(other._last_found),
+        _done(other._done) {
+}
+
+Recurrence& Recurrence::operator=(const Recurrence& other) {
+    if (this != &other) {
+        _rule = other._rule;
+        _start = other._start;
+        _month_cal = other._month_cal;
+        _months_per_year = other._months_per_year;
+        _days_per_week = other._days_per_week;
+        _start_month = other._start_month;
+        _start_day = other._start_day;
+        _start_weekday = other._start_weekday;
+        _first_period = other._first_period;
+        _period = other._period;
+        _pending = other._pending;
+        _pos = other._pos;
+        _emitted = other._emitted;
+        _last_found = other._last_found;
+        _done = other._done;
+    }
+    return *this;
+}
+
+Recurrence::~Recurrence() {
+}
+
+bool Recurrence::next(Date& date) {
+    if (!fill()) {
+        return false;
+    }
+    date = Date(_pending[_pos++]);
+    ++_emitted;
+    return true;
+}
+
+std::size_t Recurrence::next(Date* dates, std::size_t capacity) {
+    std::size_t size = 0;
+    while (size < capacity && fill()) {
+        std::size_t end = _pending.size();
+        if (end - _pos > capacity - size) {
+            end = _pos + (capacity - size);
+        }
+        if (_rule.count > 0
+                && end - _pos > static_cast<std::size_t>(_rule.count
+                    - _emitted)) {
+            end = _pos + (_rule.count - _emitted);
+        }
+        for (; _pos < end; ++_pos) {
+            dates[size++] = Date(_pending[_pos]);
+            ++_emitted;
+        }
+    }
+    return size;
+}
+
+void Recurrence::expand(const Date& last, std::vector<Date>& dates) {
+    while (fill() && _pending[_pos] < last.get_raw_date()) {
+        dates.push_back(Date(_pending[_pos++]));
+        ++_emitted;
+    }
+}
+
+void Recurrence::reset() {
+    _period = _first_period;
+    _pending.clear();
+    _pos = 0;
+    _emitted = 0;
+    _last_found = _start;
+    _done = false;
+}
+
+// Makes _pending[_pos] the next date, loading periods as needed; false at
+// the end of the expansion.
+bool Recurrence::fill() {
+    if (_rule.count > 0 && _emitted >= _rule.count) {
+        return false;
+    }
+    while (_pos == _pending.size()) {
+        if (_done) {
+            return false;
+        }
+        _pending.clear();
+        _pos = 0;
+        load_period();
+    }
+    return true;
+}
+
+// Appends the selected dates of _period on or after the start to _pending
+// and moves _period to the next period, or sets _done at the end.
+void Recurrence::load_period() {
+    std::uint64_t bits[kPeriodWords] = {};
+    int first = 0;
+    int days = 0;
+    if (!select_days(first, days, bits) || first > _rule.until.get_raw_date()
+            || first - _last_found > kMaxGapDays) {
+        _done = true;
+        return;
+    }
+    int found[kMaxPeriodDays];
+    int size = 0;
+    for (int w = 0; w < kPeriodWords; ++w) {
+        for (std::uint64_t word = bits[w]; word != 0; word &= word - 1) {
+            found[size++] = first + w * 64 + lowest_bit(word);
+        }
+    }
+    bool picked[kMaxPeriodDays];
+    std::fill(picked, picked + size, false);
+    for (std::size_t i = 0; i < _rule.by_set_pos.size(); ++i) {
+        const int pos = _rule.by_set_pos[i];
+        const int index = pos > 0 ? pos - 1 : size + pos;
+        if (index >= 0 && index < size) {
+            picked[index] = true;
+        }
+    }
+    for (int i = 0; i < size; ++i) {
+        if (!_rule.by_set_pos.empty() && !picked[i]) {
+            continue;
+        }
+        // Only dates that survive by_set_pos count as found, or a position
+        // that no period has would scan to the end of the calendar.
+        _last_found = first;
+        if (found[i] > _rule.until.get_raw_date()) {
+            _done = true;
+            break;
+        }
+        if (found[i] >= _start) {
+            _pending.push_back(found[i]);
+        }
+    }
+    if (_rule.frequency == RecurrenceRule::WEEKLY) {
+        _period += static_cast<long long>(_rule.interval) * _days_per_week;
+    } else {
+        _period += _rule.interval;
+    }
+}
+
+// Sets in bits the selected days of _period, which starts at first and is
+// days long. False if the period is past the end of the calendar.
+bool Recurrence::select_days(int& first, int& days,
+        std::uint64_t* bits) const {
+    switch (_rule.frequency) {
+        case RecurrenceRule::DAILY:
+        case RecurrenceRule::WEEKLY: {
+            if (_period > INT_MAX - kMaxPeriodDays) {
+                return false;
+            }
+            first = static_cast<int>(_period);
+            days = _rule.frequency == RecurrenceRule::DAILY ? 1
+                : _days_per_week;
+            for (int i = 0; i < days; ++i) {
+                // Days before the start are dropped anyway.
+                if (first + i < _start
+                        || (_rule.frequency == RecurrenceRule::WEEKLY
+                            && !weekday_listed((_rule.week_start + i)
+                                % _days_per_week))) {
+                    continue;
+                }
+                try {
+                    if (passes(first + i)) {
+                        bits[i / 64] |= std::uint64_t(1) << (i % 64);
+                    }
+                } catch (const std::out_of_range& e) {
+                    (void)e;
+                    return false;
+                }
+            }
+            return true;
+        }
+        case RecurrenceRule::MONTHLY: {
+            int weekday;
+            if (!month_span(_period, first, days, weekday)) {
+                return false;
+            }
+            const int month = static_cast<int>((_period % _months_per_year
+                + _months_per_year) % _months_per_year) + 1;
+            select_month(month, days, weekday, true, 0, bits);
+            return true;
+        }
+        default:
+            break;
+    }
+    // YEARLY: the months of the year one after another.
+    if (_period < -kMaxShiftedYear || _period > kMaxShiftedYear) {
+        return false;
+    }
+    const bool month_weekdays = !_rule.by_month.empty();
+    const bool start_month_only = _rule.by_month.empty()
+        && _rule.by_month_day.empty() && _rule.by_weekday.empty();
+    int year_weekday = 0;
+    days = 0;
+    for (int month = 1; month <= _months_per_year; ++month) {
+        int month_first;
+        int month_days;
+        int weekday;
+        if (!month_span(_period * _months_per_year + month - 1, month_first,
+                month_days, weekday)) {
+            return false;
+        }
+        if (month == 1) {
+            first = month_first;
+            year_weekday = weekday;
+        }
+        if (!start_month_only || month == _start_month) {
+            select_month(month, month_days, weekday, month_weekdays, days,
+                bits);
+        }
+        days += month_days;
+    }
+    if (!month_weekdays && !_rule.by_weekday.empty()) {
+        std::uint64_t weekdays[kPeriodWords] = {};
+        add_weekdays(days, year_weekday, 0, weekdays);
+        for (int w = 0; w < kPeriodWords; ++w) {
+            bits[w] &= weekdays[w];
+        }
+    }
+    return true;
+}
+
+// The first day, the length and the weekday of the first day of the month
+// month_index, counted from the start of year 0. False if the calendar
+// cannot represent it.
+bool Recurrence::month_span(long long month_index, int& first, int& days,
+        int& weekday) const {
+    long long year = month_index / _months_per_year;
+    if (month_index % _months_per_year < 0) {
+        --year;
+    }
+    if (year < -kMaxShiftedYear || year > kMaxShiftedYear) {
+        return false;
+    }
+    const int month = static_cast<int>(month_index - year * _months_per_year)
+        + 1;
+    int era;
+    int era_year;
+    split_year(_month_cal, year, era, era_year);
+    Date date;
+    if (Date::try_make(_month_cal, era, era_year, month, 1, date)
+            != DATE_OK) {
+        return false;
+    }
+    first = date.get_raw_date();
+    days = Date::last_day_of_month(_month_cal, era, era_year, month);
+    weekday = date.get_weekday(_month_cal);
+    return true;
+}
+
+// Sets in bits, from offset on, the selected days of a month of days days
+// whose first day falls on weekday. month_weekdays applies by_weekday
+// within the month; otherwise the caller applies it to the whole year.
+void Recurrence::select_month(int month, int days, int weekday,
+        bool month_weekdays, int offset, std::uint64_t* bits) const {
+    if (!_rule.by_month.empty() && !contains(_rule.by_month, month)) {
+        return;
+    }
+    // Bit d - 1 stands for day d; months have at most 31 days.
+    std::uint64_t selected = (std::uint64_t(1) << days) - 1;
+    if (!_rule.by_month_day.empty()) {
+        std::uint64_t month_days = 0;
+        for (std::size_t i = 0; i < _rule.by_month_day.size(); ++i) {
+            const int day = _rule.by_month_day[i] > 0 ? _rule.by_month_day[i]
+                : days + 1 + _rule.by_month_day[i];
+            if (day >= 1 && day <= days) {
+                month_days |= std::uint64_t(1) << (day - 1);
+            }
+        }
+        selected &= month_days;
+    }
+    if (!_rule.by_weekday.empty()) {
+        if (month_weekdays) {
+            std::uint64_t weekdays[kPeriodWords] = {};
+            add_weekdays(days, weekday, 0, weekdays);
+            selected &= weekdays[0];
+        }
+    } else if (_rule.by_month_day.empty()) {
+        selected = _start_day <= days
+            ? std::uint64_t(1) << (_start_day - 1) : 0;
+    }
+    bits[offset / 64] |= selected << (offset % 64);
+    if (offset % 64 + days > 64) {
+        bits[offset / 64 + 1] |= selected >> (64 - offset % 64);
+    }
+}
+
+// Sets in bits the days of by_weekday in a span of days days whose first
+// day falls on weekday.
+void Recurrence::add_weekdays(int days, int weekday, int offset,
+        std::uint64_t* bits) const {
+    for (std::size_t i = 0; i < _rule.by_weekday.size(); ++i) {
+        const WeekdayNth& entry = _rule.by_weekday[i];
+        // The first and the last day of the span on that weekday.
+        const int first = (entry.weekday - weekday + _days_per_week)
+            % _days_per_week;
+        if (first >= days) {
+            continue;
+        }
+        const int last = first + (days - 1 - first) / _days_per_week
+            * _days_per_week;
+        int begin = first;
+        int end = last;
+        if (entry.nth > 0) {
+            begin = end = first + (entry.nth - 1) * _days_per_week;
+        } else if (entry.nth < 0) {
+            begin = end = last + (entry.nth + 1) * _days_per_week;
+        }
+        for (int day = begin; day <= end; day += _days_per_week) {
+            if (day >= 0 && day < days) {
+                const int bit = offset + day;
+                bits[bit / 64] |= std::uint64_t(1) << (bit % 64);
+            }
+        }
+    }
+}
+
+// Whether the day serial_date passes the BY lists of a DAILY or WEEKLY
+// rule, apart from the weekdays of a WEEKLY one. Throws std::out_of_range
+// past the end of the calendar.
+bool Recurrence::passes(int serial_date) const {
+    const Date date(serial_date);
+    if (_rule.frequency == RecurrenceRule::DAILY) {
+        if (!_rule.by_weekday.empty() && !weekday_listed(
+                date.get_weekday(_month_cal))) {
+            return false;
+        }
+    }
+    if (_rule.by_month.empty() && _rule.by_month_day.empty()) {
+        return true;
+    }
+    const CivilDate civil = date.decompose(_month_cal);
+    if (!_rule.by_month.empty() && !contains(_rule.by_month, civil.month)) {
+        return false;
+    }
+    if (_rule.by_month_day.empty()) {
+        return true;
+    }
+    const int days = Date::last_day_of_month(_month_cal, civil.era,
+        civil.year, civil.month);
+    return contains(_rule.by_month_day, civil.day)
+        || contains(_rule.by_month_day, civil.day - days - 1);
+}
+
+// Whether by_weekday lists weekday, or weekday is that of the start for a
+// WEEKLY rule without by_weekday.
+bool Recurrence::weekday_listed(int weekday) const {
+    for (std::size_t i = 0; i < _rule.by_weekday.size(); ++i) {
+        if (_rule.by_weekday[i].weekday == weekday) {
+            return true;
+        }
+    }
+    return _rule.by_weekday.empty() && weekday == _start_weekday;
+}
+
+}  // namespace toolbox
+
+namespace {
+
+toolbox::CalendarSystem month_calendar(toolbox::CalendarSystem cal_sys) {
+    return cal_sys == toolbox::JAPANESE_WAREKI ? toolbox::GREGORIAN : cal_sys;
+}
+
+// Counts years from year 0 (1 B.C.). The calendars other than the French
+// Republican one share the values of GregorianCalendar::Era.
+long long year_of(toolbox::CalendarSystem cal_sys,
+        const toolbox::CivilDate& civil) {
+    if (cal_sys != toolbox::FRENCH_REPUBLICAN
+            && civil.era == toolbox::GregorianCalendar::BC) {
+        return 1 - static_cast<long long>(civil.year);
+    }
+    return civil.year;
+}
+
+void split_year(toolbox::CalendarSystem cal_sys, long long year, int& era,
+        int& era_year) {
+    if (cal_sys == toolbox::FRENCH_REPUBLICAN) {
+        era = toolbox::FrenchRepublicanCalendar::AD;
+        era_year = static_cast<int>(year);
+    } else if (year <= 0) {
+        era = toolbox::GregorianCalendar::BC;
+        era_year = static_cast<int>(1 - year);
+    } else {
+        era = toolbox::GregorianCalendar::AD;
+        era_year = static_cast<int>(year);
+    }
+}
+
+bool contains(const std::vector<int>& values, int value) {
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        if (values[i] == value) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
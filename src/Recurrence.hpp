@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <Date.hpp>
+#include <calendar_system/CalendarSystem.hpp>
+
+namespace toolbox {
+
+// An entry of RecurrenceRule::by_weekday: every such weekday of the period
+// if nth is 0, otherwise the nth one, counting from the end if negative.
+struct WeekdayNth {
+    int weekday;  // as Date::get_weekday(cal_sys) numbers it
+    int nth;
+};
+
+// A recurrence rule after RFC 5545 (iCalendar RRULE) in the calendar system
+// cal_sys. Every interval-th day, week, month or year is a period; the BY
+// lists select days of each period and by_set_pos then picks from the days
+// selected in a period, e.g. the last Friday of each month is
+//
+//     RecurrenceRule rule(RecurrenceRule::MONTHLY);
+//     const WeekdayNth last_friday = {5, -1};
+//     rule.by_weekday.push_back(last_friday);
+//
+// Without by_month_day and by_weekday, MONTHLY and YEARLY rules keep the day
+// of the month of the start date and skip months that lack it, and WEEKLY
+// rules keep its weekday. nth counts within the month for MONTHLY rules and
+// for YEARLY rules with by_month, and within the year for other YEARLY
+// rules; DAILY and WEEKLY rules take nth 0 only. JAPANESE_WAREKI counts the
+// Gregorian months and years its dates are made of.
+struct RecurrenceRule {
+    enum Frequency {
+        DAILY,
+        WEEKLY,
+        MONTHLY,
+        YEARLY
+    };
+
+    explicit RecurrenceRule(Frequency frequency,
+        CalendarSystem cal_sys = GREGORIAN);
+
+    Frequency frequency;
+    CalendarSystem cal_sys;
+    int interval;  // every interval-th period
+    // The weekday weeks start on (WKST): Monday, or primidi for the French
+    // Republican decades.
+    int week_start;
+    std::vector<int> by_month;      // 1..months of the year
+    std::vector<int> by_month_day;  // negative from the end of the month
+    std::vector<WeekdayNth> by_weekday;
+    std::vector<int> by_set_pos;    // negative from the end of the period
+    int count;   // at most count dates if positive
+    Date until;  // no dates after until; no limit by default
+};
+
+// Expands a RecurrenceRule from a start date into the dates on or after it,
+// in order. Dates are computed a period at a time, straight from the month
+// lengths and the weekday of the period's first day, so a monthly rule costs
+// a conversion or two per month however many BY lists it has.
+//
+// next(date) generates them one by one; the other overloads write many at
+// once. The expansion ends with count, until, the end of the calendar, or
+// after 400 years without a date (e.g. February 30).
+class Recurrence {
+ public:
+    // Throws std::invalid_argument for an invalid rule and std::out_of_range
+    // if rule.cal_sys cannot represent start (wareki rules start on or after
+    // 1582-10-15).
+    Recurrence(const Date& start, const RecurrenceRule& rule);
+    Recurrence(const Recurrence& other);
+    Recurrence& operator=(const Recurrence& other);
+    ~Recurrence();
+
+    // Stores the next date and returns true, or returns false at the end.
+    bool next(Date& date);
+    // Writes up to capacity next dates and returns how many were written;
+    // fewer than capacity means the end was reached.
+    std::size_t next(Date* dates, std::size_t capacity);
+    // Appends the next dates before last to dates. Reserve dates in advance
+    // to expand without allocating.
+    void expand(const Date& last, std::vector<Date>& dates);
+    // Starts over from the start date.
+    void reset();
+
+ private:
+    bool fill();
+    void load_period();
+    bool select_days(int& first, int& days, std::uint64_t* bits) const;
+    bool month_span(long long month_index, int& first, int& days,
+        int& weekday) const;
+    void select_month(int month, int days, int weekday, bool month_weekdays,
+        int offset, std::uint64_t* bits) const;
+    void add_weekdays(int days, int weekday, int offset,
+        std::uint64_t* bits) const;
+    bool passes(int serial_date) const;
+    bool weekday_listed(int weekday) const;
+
+    RecurrenceRule _rule;
+    int _start;
+    CalendarSystem _month_cal;
+    int _months_per_year;
+    int _days_per_week;
+    int _start_month;
+    int _start_day;
+    int _start_weekday;
+    // The current period: a serial date for DAILY and WEEKLY, a count of
+    // months or years from year 0 for MONTHLY and YEARLY.
+    long long _first_period;
+    long long _period;
+    std::vector<int> _pending;  // the dates of the current period
+    std::size_t _pos;
+    int _emitted;
+    int _last_found;  // the first day of the last period with a date
+    bool _done;
+};
+
+}  // namespace toolbox
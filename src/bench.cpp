@@ -0,0 +1,934 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <BusinessCalendar.hpp>
+#include <CivilCursor.hpp>
+#include <Date.hpp>
+#include <DateColumnConverter.hpp>
+#include <DateRange.hpp>
+#include <Parallel.hpp>
+#include <Recurrence.hpp>
+#include <calendar_system/EthiopianCalendar.hpp>
+#include <calendar_system/FrenchRepublicanCalendar.hpp>
+#include <calendar_system/GregorianBatch.hpp>
+#include <calendar_system/GregorianCalendar.hpp>
+#include <calendar_system/Iso8601.hpp>
+#include <calendar_system/JapaneseEra.hpp>
+#include <calendar_system/JapaneseWarekiCalendar.hpp>
+#include <calendar_system/JulianCalendar.hpp>
+#include <calendar_system/NonProlepticGregorianCalendar.hpp>
+#include <string.hpp>
+
+namespace {
+
+// Prevents the optimizer from discarding benchmarked results.
+volatile int bench_sink = 0;
+
+typedef std::chrono::steady_clock bench_clock;
+
+void report(const char* name, bench_clock::time_point begin,
+        bench_clock::time_point end, long iterations) {
+    const double total_ns = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            end - begin).count());
+    std::cout << std::left << std::setw(40) << name
+              << std::right << std::setw(12) << std::fixed
+              << std::setprecision(1) << total_ns / iterations
+              << " ns/call" << std::endl;
+}
+
+void bench_wareki_from_serial() {
+    const toolbox::JapaneseWarekiCalendar wareki;
+    const toolbox::GregorianCalendar greg;
+    const int first = greg.to_serial_date(
+        toolbox::GregorianCalendar::AD, 1900, 1, 1);
+    const long iterations = 200000;
+    int era, year, month, day;
+    bench_clock::time_point begin = bench_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        wareki.from_serial_date(first + static_cast<int>(i % 45000),
+            era, year, month, day);
+        bench_sink += day;
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report("wareki from_serial_date", begin, end, iterations);
+}
+
+void bench_wareki_from_serial_current_era() {
+    const toolbox::JapaneseWarekiCalendar wareki;
+    const toolbox::GregorianCalendar greg;
+    const int first = greg.to_serial_date(
+        toolbox::GregorianCalendar::AD, 2020, 1, 1);
+    const long iterations = 200000;
+    int era, year, month, day;
+    bench_clock::time_point begin = bench_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        wareki.from_serial_date(first + static_cast<int>(i % 3000),
+            era, year, month, day);
+        bench_sink += day;
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report("wareki from_serial_date (Reiwa)", begin, end, iterations);
+}
+
+void bench_wareki_to_serial() {
+    const toolbox::JapaneseWarekiCalendar wareki;
+    const long iterations = 200000;
+    bench_clock::time_point begin = bench_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        bench_sink += wareki.to_serial_date(toolbox::REIWA,
+            2 + static_cast<int>(i % 5), 1 + static_cast<int>(i % 12),
+            1 + static_cast<int>(i % 28));
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report("wareki to_serial_date", begin, end, iterations);
+}
+
+// Round trips the dates of [first, first + span) through cal, so that
+// calendars anchored on a fixed epoch show what the epoch costs per call.
+// Dates that do not round trip (Ethiopian Pagume 6) are replaced by first.
+void bench_calendar_throughput(const char* to_name, const char* from_name,
+        const toolbox::ICalendarSystem& cal, int first, int span) {
+    const std::size_t count = 1000000;
+    std::vector<int> serials(count);
+    std::vector<int> eras(count), years(count), months(count), days(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        serials[i] = first + static_cast<int>(i * 7 % span);
+        cal.from_serial_date(serials[i], eras[i], years[i], months[i],
+            days[i]);
+        int back;
+        if (cal.try_to_serial_date(eras[i], years[i], months[i], days[i],
+                back) != toolbox::DATE_OK || back != serials[i]) {
+            serials[i] = first;
+            cal.from_serial_date(first, eras[i], years[i], months[i],
+                days[i]);
+        }
+    }
+
+    bench_clock::time_point begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        bench_sink += cal.to_serial_date(eras[i], years[i], months[i],
+            days[i]);
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report(to_name, begin, end, count);
+
+    begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        int era, year, month, day;
+        cal.from_serial_date(serials[i], era, year, month, day);
+        bench_sink += day;
+    }
+    end = bench_clock::now();
+    report(from_name, begin, end, count);
+}
+
+void bench_calendars() {
+    const toolbox::GregorianCalendar gregorian;
+    const int ad_1582 = gregorian.to_serial_date(
+        toolbox::GregorianCalendar::AD, 1582, 10, 15);
+    const int ad_1792 = gregorian.to_serial_date(
+        toolbox::GregorianCalendar::AD, 1792, 9, 22);
+    const int ad_1900 = gregorian.to_serial_date(
+        toolbox::GregorianCalendar::AD, 1900, 1, 1);
+
+    bench_calendar_throughput("gregorian to_serial_date",
+        "gregorian from_serial_date", gregorian, -100000, 200000);
+    bench_calendar_throughput("non-proleptic to_serial_date",
+        "non-proleptic from_serial_date",
+        toolbox::NonProlepticGregorianCalendar(), ad_1582, 200000);
+    bench_calendar_throughput("julian to_serial_date",
+        "julian from_serial_date", toolbox::JulianCalendar(), -100000,
+        200000);
+    bench_calendar_throughput("ethiopian to_serial_date",
+        "ethiopian from_serial_date", toolbox::EthiopianCalendar(), 0,
+        200000);
+    bench_calendar_throughput("french to_serial_date",
+        "french from_serial_date", toolbox::FrenchRepublicanCalendar(),
+        ad_1792, 5000);
+    bench_calendar_throughput("wareki to_serial_date (1582-)",
+        "wareki from_serial_date (1582-)",
+        toolbox::JapaneseWarekiCalendar(), ad_1582, ad_1900 - ad_1582);
+}
+
+void bench_gregorian_scalar_vs_batch() {
+    const std::size_t count = 1000000;
+    std::vector<int> serials(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        serials[i] = static_cast<int>(i * 7 % 200000) - 100000;
+    }
+    std::vector<int> eras(count), years(count), months(count), days(count);
+
+    bench_clock::time_point begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        const toolbox::Date date(serials[i]);
+        bench_sink += date.get_month(toolbox::GREGORIAN);
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report("gregorian Date::get_month per date", begin, end, count);
+
+    begin = bench_clock::now();
+    toolbox::Date::from_serial_dates(toolbox::GREGORIAN, &serials[0], count,
+        &eras[0], &years[0], &months[0], &days[0]);
+    end = bench_clock::now();
+    bench_sink += months[count / 2];
+    report("gregorian Date::from_serial_dates", begin, end, count);
+
+    begin = bench_clock::now();
+    toolbox::Date::to_serial_dates(toolbox::GREGORIAN, &eras[0], &years[0],
+        &months[0], &days[0], count, &serials[0]);
+    end = bench_clock::now();
+    bench_sink += serials[count / 2];
+    report("gregorian Date::to_serial_dates", begin, end, count);
+}
+
+void bench_calendar_tag() {
+    const std::size_t count = 1000000;
+    std::vector<int> serials(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        serials[i] = static_cast<int>(i * 7 % 200000) - 100000;
+    }
+
+    bench_clock::time_point begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        bench_sink += toolbox::Date(serials[i]).get_year(toolbox::GREGORIAN);
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report("get_year(GREGORIAN)", begin, end, count);
+
+    begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        bench_sink += toolbox::Date(serials[i]).get_year<toolbox::GREGORIAN>();
+    }
+    end = bench_clock::now();
+    report("get_year<GREGORIAN>()", begin, end, count);
+}
+
+void bench_decompose() {
+    const std::size_t count = 1000000;
+    std::vector<int> serials(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        serials[i] = static_cast<int>(i * 7 % 200000) - 100000;
+    }
+
+    // What get_year/get_month/get_day used to cost: one conversion each.
+    const toolbox::GregorianCalendar gregorian;
+    bench_clock::time_point begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        int era, year, month, day;
+        for (int field = 0; field < 3; ++field) {
+            gregorian.from_serial_date(serials[i], era, year, month, day);
+        }
+        bench_sink += year + month + day;
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report("3 conversions per date", begin, end, count);
+
+    begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        const toolbox::Date date(serials[i]);
+        bench_sink += date.get_year(toolbox::GREGORIAN)
+            + date.get_month(toolbox::GREGORIAN)
+            + date.get_day(toolbox::GREGORIAN);
+    }
+    end = bench_clock::now();
+    report("get_year+get_month+get_day (cached)", begin, end, count);
+
+    begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        const toolbox::CivilDate civil
+            = toolbox::Date(serials[i]).decompose(toolbox::GREGORIAN);
+        bench_sink += civil.year + civil.month + civil.day;
+    }
+    end = bench_clock::now();
+    report("decompose(GREGORIAN)", begin, end, count);
+}
+
+// Walks 1000 years day by day, reading the civil fields of every date.
+void bench_date_range(const char* decompose_name, const char* civil_name,
+        toolbox::CalendarSystem cal_sys) {
+    const toolbox::Date first(toolbox::GREGORIAN,
+        toolbox::GregorianCalendar::AD, 1900, 1, 1);
+    const toolbox::DateRange range(first, first + 365243, 1,
+        toolbox::DateRange::DAYS, cal_sys);
+
+    bench_clock::time_point begin = bench_clock::now();
+    for (toolbox::Date date = first; date < first + 365243; ++date) {
+        const toolbox::CivilDate civil = date.decompose(cal_sys);
+        bench_sink += civil.year + civil.month + civil.day;
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report(decompose_name, begin, end, range.size());
+
+    begin = bench_clock::now();
+    for (toolbox::DateRange::iterator it = range.begin(); it != range.end();
+            ++it) {
+        const toolbox::CivilDate& civil = it.civil();
+        bench_sink += civil.year + civil.month + civil.day;
+    }
+    end = bench_clock::now();
+    report(civil_name, begin, end, range.size());
+}
+
+void bench_date_ranges() {
+    bench_date_range("gregorian decompose per day",
+        "gregorian DateRange civil() per day", toolbox::GREGORIAN);
+    bench_date_range("wareki decompose per day",
+        "wareki DateRange civil() per day", toolbox::JAPANESE_WAREKI);
+}
+
+// Reads the civil fields of days consecutive dates from first, rounds times
+// over, by converting every date and by stepping a CivilCursor.
+template <toolbox::CalendarSystem Cal>
+void bench_civil_cursor(const char* decompose_name, const char* cursor_name,
+        int first, int days, int rounds) {
+    bench_clock::time_point begin = bench_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        for (int serial = first; serial < first + days; ++serial) {
+            const toolbox::CivilDate civil
+                = toolbox::Date(serial).decompose<Cal>();
+            bench_sink += civil.year + civil.month + civil.day;
+        }
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report(decompose_name, begin, end, static_cast<long>(days) * rounds);
+
+    begin = bench_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        toolbox::CivilCursor<Cal> cursor((toolbox::Date(first)));
+        for (int i = 0; i < days; ++i, ++cursor) {
+            const toolbox::CivilDate& civil = cursor.civil();
+            bench_sink += civil.year + civil.month + civil.day;
+        }
+    }
+    end = bench_clock::now();
+    report(cursor_name, begin, end, static_cast<long>(days) * rounds);
+}
+
+void bench_civil_cursors() {
+    const int ad_1792 = toolbox::Date(toolbox::GREGORIAN,
+        toolbox::GregorianCalendar::AD, 1792, 9, 22).get_raw_date();
+    const int ad_1900 = toolbox::Date(toolbox::GREGORIAN,
+        toolbox::GregorianCalendar::AD, 1900, 1, 1).get_raw_date();
+    bench_civil_cursor<toolbox::GREGORIAN>("gregorian decompose<> per day",
+        "gregorian CivilCursor per day", ad_1900, 365243, 1);
+    bench_civil_cursor<toolbox::JULIAN>("julian decompose<> per day",
+        "julian CivilCursor per day", ad_1900, 365243, 1);
+    bench_civil_cursor<toolbox::FRENCH_REPUBLICAN>(
+        "french decompose<> per day", "french CivilCursor per day",
+        ad_1792, 5000, 70);
+    bench_civil_cursor<toolbox::JAPANESE_WAREKI>("wareki decompose<> per day",
+        "wareki CivilCursor per day", ad_1900, 365243, 1);
+}
+
+// Billing-style "same day next month": by hand through the Gregorian fields
+// of Date, converting each way plus retrying short months, against
+// Date::add_months and its batch version.
+void bench_add_months() {
+    const std::size_t count = 1000000;
+    std::vector<int> serials(count);
+    std::vector<int> results(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        serials[i] = static_cast<int>(i * 7 % 40000);
+    }
+
+    bench_clock::time_point begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        toolbox::CivilDate civil
+            = toolbox::Date(serials[i]).decompose(toolbox::GREGORIAN);
+        if (++civil.month > 12) {
+            civil.month = 1;
+            ++civil.year;
+        }
+        toolbox::Date date;
+        while (toolbox::Date::try_make(toolbox::GREGORIAN, civil.era,
+                civil.year, civil.month, civil.day, date)
+                == toolbox::DATE_INVALID_DAY) {
+            --civil.day;
+        }
+        bench_sink += date.get_raw_date();
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report("+1 month via fields", begin, end, count);
+
+    begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        bench_sink += toolbox::Date(serials[i]).add_months(toolbox::GREGORIAN,
+            1).get_raw_date();
+    }
+    end = bench_clock::now();
+    report("+1 month Date::add_months", begin, end, count);
+
+    begin = bench_clock::now();
+    toolbox::Date::add_months(toolbox::GREGORIAN, &serials[0], count, 1,
+        toolbox::MONTH_CLAMP, &results[0]);
+    end = bench_clock::now();
+    bench_sink += results[count - 1];
+    report("+1 month Date::add_months batch", begin, end, count);
+}
+
+// Settlement-style queries over 30 years with a holiday every few weeks:
+// counting and skipping by words against a day-by-day walk.
+void bench_business_calendar() {
+    const toolbox::Date first(toolbox::GREGORIAN,
+        toolbox::GregorianCalendar::AD, 2000, 1, 1);
+    const int size = 10958;
+    toolbox::BusinessCalendar calendar(first, first + size);
+    for (int i = 0; i < size; i += 23) {
+        calendar.add_holiday(first + i);
+    }
+    const std::size_t count = 100000;
+
+    bench_clock::time_point begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        const toolbox::Date from = first + static_cast<int>(i * 7 % 3000);
+        const toolbox::Date to = from + 365;
+        int days = 0;
+        for (toolbox::Date date = from; date < to; ++date) {
+            days += calendar.is_business_day(date) ? 1 : 0;
+        }
+        bench_sink += days;
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report("1 year business days by day walk", begin, end, count);
+
+    begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        const toolbox::Date from = first + static_cast<int>(i * 7 % 3000);
+        bench_sink += calendar.business_days_between(from, from + 365);
+    }
+    end = bench_clock::now();
+    report("1 year business_days_between", begin, end, count);
+
+    begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        const toolbox::Date from = first + static_cast<int>(i * 7 % 3000);
+        bench_sink += calendar.add_business_days(from, 2).get_raw_date();
+    }
+    end = bench_clock::now();
+    report("T+2 add_business_days", begin, end, count);
+
+    begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        const toolbox::Date from = first + static_cast<int>(i * 7 % 3000);
+        bench_sink += calendar.add_business_days(from, 250).get_raw_date();
+    }
+    end = bench_clock::now();
+    report("+250 add_business_days", begin, end, count);
+}
+
+toolbox::RecurrenceRule bench_weekday_rule(
+        toolbox::RecurrenceRule::Frequency frequency, int weekday, int nth) {
+    toolbox::RecurrenceRule rule(frequency);
+    const toolbox::WeekdayNth entry = {weekday, nth};
+    rule.by_weekday.push_back(entry);
+    return rule;
+}
+
+// Expands a rule over 10 years from staggered start dates, as for many
+// subscriptions, and reports the time per 10-year expansion.
+void bench_recurrence(const char* name, const toolbox::RecurrenceRule& rule) {
+    const toolbox::Date first(toolbox::GREGORIAN,
+        toolbox::GregorianCalendar::AD, 2020, 1, 1);
+    const long iterations = 2000;
+    std::vector<toolbox::Date> dates;
+    dates.reserve(4096);
+    bench_clock::time_point begin = bench_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        const toolbox::Date start = first + static_cast<int>(i % 365);
+        toolbox::Recurrence recurrence(start, rule);
+        dates.clear();
+        recurrence.expand(start + 3653, dates);
+        bench_sink += static_cast<int>(dates.size());
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report(name, begin, end, iterations);
+}
+
+void bench_recurrences() {
+    const toolbox::Date first(toolbox::GREGORIAN,
+        toolbox::GregorianCalendar::AD, 2020, 1, 1);
+    const long iterations = 2000;
+
+    // The last Friday of each month by testing every day.
+    bench_clock::time_point begin = bench_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        const toolbox::Date start = first + static_cast<int>(i % 365);
+        int dates = 0;
+        for (toolbox::Date date = start; date < start + 3653; ++date) {
+            const toolbox::CivilDate civil = date.decompose(
+                toolbox::GREGORIAN);
+            dates += civil.weekday == 5 && (date + 7).get_month(
+                toolbox::GREGORIAN) != civil.month;
+        }
+        bench_sink += dates;
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report("10y last Friday by day walk", begin, end, iterations);
+
+    bench_recurrence("10y last Friday", bench_weekday_rule(
+        toolbox::RecurrenceRule::MONTHLY, 5, -1));
+    bench_recurrence("10y 2nd Tuesday", bench_weekday_rule(
+        toolbox::RecurrenceRule::MONTHLY, 2, 2));
+    toolbox::RecurrenceRule biweekly = bench_weekday_rule(
+        toolbox::RecurrenceRule::WEEKLY, 2, 0);
+    biweekly.interval = 2;
+    bench_recurrence("10y every other Tuesday", biweekly);
+    toolbox::RecurrenceRule last_weekday(toolbox::RecurrenceRule::MONTHLY);
+    for (int weekday = 1; weekday <= 5; ++weekday) {
+        const toolbox::WeekdayNth entry = {weekday, 0};
+        last_weekday.by_weekday.push_back(entry);
+    }
+    last_weekday.by_set_pos.push_back(-1);
+    bench_recurrence("10y last weekday of month", last_weekday);
+    toolbox::RecurrenceRule thanksgiving = bench_weekday_rule(
+        toolbox::RecurrenceRule::YEARLY, 4, 4);
+    thanksgiving.by_month.push_back(11);
+    bench_recurrence("10y 4th Thursday of November", thanksgiving);
+    toolbox::RecurrenceRule ethiopian(toolbox::RecurrenceRule::MONTHLY,
+        toolbox::ETHIOPIAN);
+    ethiopian.by_month_day.push_back(1);
+    bench_recurrence("10y 1st of Ethiopian months", ethiopian);
+}
+
+void bench_nth_weekdays() {
+    const int ad = toolbox::GregorianCalendar::AD;
+    const long iterations = 1000000;
+
+    // The 4th Thursday and the last Friday of each month.
+    bench_clock::time_point begin = bench_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        const int year = 2000 + static_cast<int>(i / 12 % 100);
+        const int month = static_cast<int>(i % 12) + 1;
+        toolbox::Date date(toolbox::GREGORIAN, ad, year, month, 1);
+        for (int found = 0; ; ++date) {
+            if (date.get_weekday(toolbox::GREGORIAN) == 4 && ++found == 4) {
+                break;
+            }
+        }
+        toolbox::Date last(toolbox::GREGORIAN, ad, year, month,
+            toolbox::Date::last_day_of_month(toolbox::GREGORIAN, ad, year,
+                month));
+        while (last.get_weekday(toolbox::GREGORIAN) != 5) {
+            --last;
+        }
+        bench_sink += date.get_raw_date() + last.get_raw_date();
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report("nth weekday of month by day walk", begin, end, iterations);
+
+    begin = bench_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        const int year = 2000 + static_cast<int>(i / 12 % 100);
+        const int month = static_cast<int>(i % 12) + 1;
+        const toolbox::Date date = toolbox::Date::nth_weekday_of_month(
+            toolbox::GREGORIAN, ad, year, month, 4, 4);
+        const toolbox::Date last = toolbox::Date::last_weekday_of_month(
+            toolbox::GREGORIAN, ad, year, month, 5);
+        bench_sink += date.get_raw_date() + last.get_raw_date();
+    }
+    end = bench_clock::now();
+    report("nth weekday of month closed form", begin, end, iterations);
+
+    const toolbox::Date first(toolbox::GREGORIAN, ad, 2000, 1, 1);
+    begin = bench_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        toolbox::Date date = first + static_cast<int>(i % 36525) + 1;
+        while (date.get_weekday(toolbox::GREGORIAN) != 1) {
+            ++date;
+        }
+        bench_sink += date.get_raw_date();
+    }
+    end = bench_clock::now();
+    report("next Monday by day walk", begin, end, iterations);
+
+    begin = bench_clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        const toolbox::Date date = (first + static_cast<int>(i % 36525))
+            .next_weekday(toolbox::GREGORIAN, 1);
+        bench_sink += date.get_raw_date();
+    }
+    end = bench_clock::now();
+    report("next Monday closed form", begin, end, iterations);
+}
+
+// 100M Gregorian dates through pools of 1 to 64 threads, converted in
+// windows of 16M so that the buffers stay at 320 MB.
+void bench_parallel_convert() {
+    const long total = 100000000;
+    const std::size_t window = std::size_t(1) << 24;
+    std::vector<int> serials(window);
+    for (std::size_t i = 0; i < window; ++i) {
+        serials[i] = static_cast<int>(i % 146097) - 719468;
+    }
+    std::vector<int> eras(window), years(window), months(window),
+        days(window);
+    for (unsigned threads = 1; threads <= 64; threads *= 2) {
+        toolbox::parallel::ThreadPool pool(threads);
+        bench_clock::time_point begin = bench_clock::now();
+        for (long done = 0; done < total; ) {
+            const std::size_t count = static_cast<std::size_t>(
+                std::min<long>(total - done, static_cast<long>(window)));
+            toolbox::parallel::convert(pool, toolbox::GREGORIAN, &serials[0],
+                count, &eras[0], &years[0], &months[0], &days[0]);
+            done += static_cast<long>(count);
+        }
+        bench_clock::time_point end = bench_clock::now();
+        bench_sink += years[window - 1];
+        std::ostringstream name;
+        name << "parallel from_serial 100M, " << threads << " threads";
+        report(name.str().c_str(), begin, end, total);
+    }
+}
+
+void bench_gregorian_kernels() {
+    const struct {
+        toolbox::GregorianBatchKernel kernel;
+        const char* from_name;
+        const char* to_name;
+    } kernels[] = {
+        {toolbox::GREGORIAN_BATCH_SCALAR,
+            "gregorian from_serial_dates scalar",
+            "gregorian to_serial_dates scalar"},
+        {toolbox::GREGORIAN_BATCH_SSE41,
+            "gregorian from_serial_dates SSE4.1",
+            "gregorian to_serial_dates SSE4.1"},
+        {toolbox::GREGORIAN_BATCH_AVX2,
+            "gregorian from_serial_dates AVX2",
+            "gregorian to_serial_dates AVX2"},
+    };
+    const std::size_t count = 1000000;
+    std::vector<int> serials(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        serials[i] = static_cast<int>(i * 7 % 200000) - 100000;
+    }
+    std::vector<int> eras(count), years(count), months(count), days(count);
+    std::vector<int> back(count);
+
+    for (std::size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); ++k) {
+        if (!toolbox::gregorian_batch_kernel_supported(kernels[k].kernel)) {
+            std::cout << kernels[k].from_name << ": not supported"
+                      << std::endl;
+            continue;
+        }
+        bench_clock::time_point begin = bench_clock::now();
+        toolbox::gregorian_from_serial_dates(&serials[0], count, &eras[0],
+            &years[0], &months[0], &days[0], kernels[k].kernel);
+        bench_clock::time_point end = bench_clock::now();
+        bench_sink += months[count / 2];
+        report(kernels[k].from_name, begin, end, count);
+
+        begin = bench_clock::now();
+        toolbox::gregorian_to_serial_dates(&eras[0], &years[0], &months[0],
+            &days[0], count, &back[0], kernels[k].kernel);
+        end = bench_clock::now();
+        bench_sink += back[count / 2];
+        report(kernels[k].to_name, begin, end, count);
+    }
+}
+
+void bench_gregorian_format() {
+    const std::size_t count = 200000;
+    const toolbox::DateFormat format("%Y-%m-%d");
+
+    bench_clock::time_point begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        const toolbox::Date date(static_cast<int>(i));
+        bench_sink += date.to_string(toolbox::GREGORIAN, "%Y-%m-%d").size();
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report("gregorian to_string format string", begin, end, count);
+
+    begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        const toolbox::Date date(static_cast<int>(i));
+        bench_sink += date.to_string(toolbox::GREGORIAN, format).size();
+    }
+    end = bench_clock::now();
+    report("gregorian to_string DateFormat", begin, end, count);
+
+    char buf[32];
+    begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        const toolbox::Date date(static_cast<int>(i));
+        bench_sink += date.format_to(buf, sizeof(buf), toolbox::GREGORIAN,
+            format);
+    }
+    end = bench_clock::now();
+    report("gregorian format_to", begin, end, count);
+}
+
+void bench_parse(const char* name, const toolbox::ICalendarSystem& cal,
+        const char* format, int first, bool strict) {
+    const std::size_t count = 100000;
+    std::vector<std::string> date_strs(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        cal.from_serial_date(first + static_cast<int>(i % 5000),
+            date_strs[i], format);
+    }
+
+    bench_clock::time_point begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        bench_sink += cal.to_serial_date(date_strs[i], format, strict);
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report(name, begin, end, count);
+}
+
+void bench_parsers() {
+    const toolbox::GregorianCalendar gregorian;
+    const toolbox::FrenchRepublicanCalendar french;
+    const int ad_1792 = gregorian.to_serial_date(
+        toolbox::GregorianCalendar::AD, 1792, 9, 22);
+
+    bench_parse("gregorian parse %Y-%m-%d", gregorian, "%Y-%m-%d", 0, true);
+    bench_parse("gregorian parse %E%Y-%M-%D", gregorian, "%E%Y-%M-%D", 0,
+        true);
+    bench_parse("gregorian parse %Y%M%D non-strict", gregorian, "%Y%M%D", 0,
+        false);
+    bench_parse("french parse %Y %m %d", french, "%Y %m %d", ad_1792, true);
+}
+
+void bench_iso8601() {
+    const std::size_t count = 1000000;
+    const toolbox::Iso8601Form forms[] = {
+        toolbox::ISO8601_CALENDAR, toolbox::ISO8601_BASIC,
+        toolbox::ISO8601_ORDINAL, toolbox::ISO8601_WEEK
+    };
+    const char* const names[][2] = {
+        {"iso8601 parse YYYY-MM-DD", "iso8601 format YYYY-MM-DD"},
+        {"iso8601 parse YYYYMMDD", "iso8601 format YYYYMMDD"},
+        {"iso8601 parse YYYY-DDD", "iso8601 format YYYY-DDD"},
+        {"iso8601 parse YYYY-Www-D", "iso8601 format YYYY-Www-D"},
+    };
+    std::vector<char> strs(count * 16);
+    for (std::size_t f = 0; f < 4; ++f) {
+        for (std::size_t i = 0; i < count; ++i) {
+            toolbox::iso8601_format_to(static_cast<int>(i % 40000),
+                &strs[i * 16], 16, forms[f]);
+        }
+        const std::size_t len = std::strlen(&strs[0]);
+
+        bench_clock::time_point begin = bench_clock::now();
+        for (std::size_t i = 0; i < count; ++i) {
+            int serial;
+            toolbox::iso8601_to_serial_date(&strs[i * 16],
+                &strs[i * 16] + len, serial);
+            bench_sink += serial;
+        }
+        bench_clock::time_point end = bench_clock::now();
+        report(names[f][0], begin, end, count);
+
+        char buf[16];
+        begin = bench_clock::now();
+        for (std::size_t i = 0; i < count; ++i) {
+            bench_sink += toolbox::iso8601_format_to(
+                static_cast<int>(i % 40000), buf, sizeof(buf), forms[f]);
+        }
+        end = bench_clock::now();
+        report(names[f][1], begin, end, count);
+    }
+}
+
+// The stringstream conversions toolbox::stoi and toolbox::to_string used to
+// be built on.
+int stream_stoi(const std::string& s) {
+    std::stringstream ss(s);
+    int num;
+    ss >> num;
+    if (ss.fail() || !ss.eof()) {
+        throw std::invalid_argument("Invalid integer: '" + s + "'");
+    }
+    return num;
+}
+
+std::string stream_to_string(int value) {
+    std::ostringstream oss;
+    oss << value;
+    return oss.str();
+}
+
+void bench_int_codecs() {
+    const std::size_t count = 200000;
+    std::vector<std::string> strs(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        strs[i] = toolbox::to_string(static_cast<int>(i * 7919) - 700000000);
+    }
+
+    bench_clock::time_point begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        bench_sink += stream_stoi(strs[i]);
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report("int parse stringstream", begin, end, count);
+
+    begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        bench_sink += toolbox::stoi(strs[i]);
+    }
+    end = bench_clock::now();
+    report("int parse toolbox::stoi", begin, end, count);
+
+    begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        int value = 0;
+        toolbox::parse_int(strs[i].data(), strs[i].data() + strs[i].size(),
+            value);
+        bench_sink += value;
+    }
+    end = bench_clock::now();
+    report("int parse toolbox::parse_int", begin, end, count);
+
+    begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        bench_sink += stream_to_string(static_cast<int>(i * 7919)).size();
+    }
+    end = bench_clock::now();
+    report("int format ostringstream", begin, end, count);
+
+    begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        bench_sink += toolbox::to_string(static_cast<int>(i * 7919)).size();
+    }
+    end = bench_clock::now();
+    report("int format toolbox::to_string", begin, end, count);
+
+    char buf[16];
+    begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        bench_sink += toolbox::format_int(buf, buf + sizeof(buf),
+            static_cast<int>(i * 7919)) - buf;
+    }
+    end = bench_clock::now();
+    report("int format toolbox::format_int", begin, end, count);
+}
+
+// A feed of Gregorian dates of which every 20th row (5%) does not exist.
+void bench_dirty_feed() {
+    const toolbox::GregorianCalendar gregorian;
+    const std::size_t count = 200000;
+    std::vector<std::string> rows(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        const int day = i % 20 == 0 ? 30 : static_cast<int>(i % 28) + 1;
+        rows[i] = "2023-2-" + toolbox::to_string(day);
+    }
+
+    bench_clock::time_point begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        try {
+            bench_sink += gregorian.to_serial_date(rows[i], "%Y-%M-%D", true);
+        } catch (const std::invalid_argument& e) {
+            (void)e;
+            ++bench_sink;
+        }
+    }
+    bench_clock::time_point end = bench_clock::now();
+    report("dirty feed to_serial_date + catch", begin, end, count);
+
+    begin = bench_clock::now();
+    for (std::size_t i = 0; i < count; ++i) {
+        int serial = 0;
+        if (gregorian.try_parse(rows[i], "%Y-%M-%D", true, serial)
+                == toolbox::DATE_OK) {
+            bench_sink += serial;
+        } else {
+            ++bench_sink;
+        }
+    }
+    end = bench_clock::now();
+    report("dirty feed try_parse", begin, end, count);
+}
+
+
+// Converts a CSV of 2M lines like "123,2024-01-15,user45,678" held in memory
+// and written to /dev/null, in MB of input per second.
+void bench_date_column_convert() {
+    const int lines = 2000000;
+    std::string csv;
+    csv.reserve(lines * 32);
+    for (int i = 0; i < lines; ++i) {
+        char line[64];
+        char* p = line + toolbox::format_int(line, i);
+        *p++ = ',';
+        p += toolbox::iso8601_format_to(i % 30000 * 7 % 30000, p, 11,
+            toolbox::ISO8601_CALENDAR);
+        std::memcpy(p, ",user", 5);
+        p += 5;
+        p += toolbox::format_int(p, i % 977);
+        *p++ = ',';
+        p += toolbox::format_int(p, i * 31 % 100000);
+        *p++ = '\n';
+        csv.append(line, p);
+    }
+    std::FILE* null = std::fopen("/dev/null", "wb");
+    if (!null) {
+        return;
+    }
+    const struct {
+        const char* name;
+        const char* to_format;
+        toolbox::Iso8601Form to_iso_form;
+        toolbox::CalendarSystem to_cal;
+    } cases[] = {
+        {"date column YYYY-MM-DD to itself", "", toolbox::ISO8601_CALENDAR,
+            toolbox::GREGORIAN},
+        {"date column YYYY-MM-DD to YYYYMMDD", "", toolbox::ISO8601_BASIC,
+            toolbox::GREGORIAN},
+        {"date column YYYY-MM-DD to wareki", "%E%Y-%m-%d",
+            toolbox::ISO8601_CALENDAR, toolbox::JAPANESE_WAREKI},
+    };
+    for (std::size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); ++c) {
+        toolbox::DateColumnSpec spec;
+        spec.columns.assign(1, 2);
+        spec.to_format = cases[c].to_format;
+        spec.to_iso_form = cases[c].to_iso_form;
+        spec.to_cal = cases[c].to_cal;
+        toolbox::DateColumnConverter converter(spec);
+        const bench_clock::time_point begin = bench_clock::now();
+        converter.convert(csv.data(), csv.data() + csv.size(), null);
+        const bench_clock::time_point end = bench_clock::now();
+        const double seconds = std::chrono::duration<double>(
+            end - begin).count();
+        std::cout << std::left << std::setw(40) << cases[c].name
+                  << std::right << std::setw(12) << std::fixed
+                  << std::setprecision(1) << csv.size() / seconds / 1e6
+                  << " MB/s" << std::endl;
+    }
+    std::fclose(null);
+}
+
+}  // namespace
+
+int main() {
+    bench_wareki_from_serial();
+    bench_wareki_from_serial_current_era();
+    bench_wareki_to_serial();
+    bench_calendars();
+    bench_gregorian_scalar_vs_batch();
+    bench_calendar_tag();
+    bench_decompose();
+    bench_date_ranges();
+    bench_civil_cursors();
+    bench_add_months();
+    bench_business_calendar();
+    bench_recurrences();
+    bench_nth_weekdays();
+    bench_parallel_convert();
+    bench_gregorian_kernels();
+    bench_gregorian_format();
+    bench_parsers();
+    bench_iso8601();
+    bench_int_codecs();
+    bench_dirty_feed();
+    bench_date_column_convert();
+    return 0;
+}
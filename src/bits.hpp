@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+namespace toolbox {
+
+// Bit scans over 64-bit words of day bitmaps. lowest_bit and highest_bit
+// number bits from 0 at the least significant end; word must not be 0.
+#if defined(__GNUC__)
+inline int popcount(std::uint64_t word) {
+    return __builtin_popcountll(word);
+}
+
+inline int lowest_bit(std::uint64_t word) {
+    return __builtin_ctzll(word);
+}
+
+inline int highest_bit(std::uint64_t word) {
+    return 63 - __builtin_clzll(word);
+}
+#else
+inline int popcount(std::uint64_t word) {
+    word -= (word >> 1) & 0x5555555555555555ULL;
+    word = (word & 0x3333333333333333ULL)
+        + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((word * 0x0101010101010101ULL) >> 56);
+}
+
+inline int lowest_bit(std::uint64_t word) {
+    return popcount((word & (0 - word)) - 1);
+}
+
+inline int highest_bit(std::uint64_t word) {
+    int bit = 0;
+    while (word >>= 1) {
+        ++bit;
+    }
+    return bit;
+}
+#endif
+
+}  // namespace toolbox
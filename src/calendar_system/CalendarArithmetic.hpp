@@ -0,0 +1,193 @@
+#pragma once
+
+namespace toolbox {
+
+// Pure integer arithmetic of the Gregorian and Julian calendars, usable in
+// constant expressions so that fixed dates (calendar epochs, the Gregorian
+// reform) and user tables of dates can be computed at compile time. The
+// calendar classes add era handling and validation on top of it.
+//
+// Years are astronomical (0 is 1 B.C., -1 is 2 B.C.) and serial dates count
+// days from 1970-01-01 as in Date. The *_days_from_civil functions do not
+// validate their input.
+
+struct YearMonthDay {
+    int year;
+    int month;
+    int day;
+};
+
+constexpr bool gregorian_is_leap(int year) {
+    return year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+}
+
+constexpr int gregorian_last_day_of_month(int year, int month) {
+    const int last_day[12] = {
+        31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+    };
+    if (month == 2 && gregorian_is_leap(year)) {
+        return 29;
+    }
+    return last_day[month - 1];
+}
+
+// Hinnant's days_from_civil.
+constexpr int gregorian_days_from_civil(int year, int month, int day) {
+    year -= !!(month <= 2);
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned int yoe = static_cast<unsigned int>(year - era * 400);
+    const unsigned int doy = (153 * (month > 2 ? month - 3 : month + 9) + 2)
+        / 5 + day - 1;
+    const unsigned int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int>(doe) - 719468;
+}
+
+// The first day of the Gregorian calendar, 1582-10-15 (-141427). Dates
+// before it are Julian in NON_PROLEPTIC_GREGORIAN and JAPANESE_WAREKI.
+constexpr int kBeginGregorian = gregorian_days_from_civil(1582, 10, 15);
+
+// Hinnant's civil_from_days.
+constexpr YearMonthDay gregorian_civil_from_days(int serial_date) {
+    const int z = serial_date + 719468;
+    const int era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned int doe = static_cast<unsigned int>(z - era * 146097);
+    const unsigned int yoe = (doe - doe / 1460 + doe / 36524
+        - doe / 146096) / 365;
+    const unsigned int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned int mp = (5 * doy + 2) / 153;
+    const int month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    const YearMonthDay ymd = {
+        static_cast<int>(yoe) + era * 400 + !!(month <= 2),
+        month,
+        static_cast<int>(doy - (153 * mp + 2) / 5 + 1)
+    };
+    return ymd;
+}
+
+// The Julian calendar as actually observed: leap years every three years
+// from 42 B.C. to 9 B.C., none from 8 B.C. to A.D. 4 and every four years
+// otherwise, proleptically before 45 B.C.
+constexpr bool julian_is_leap(int year) {
+    return ((year >= 8 || year <= -44) && year % 4 == 0)
+        || (year >= -43 && year <= -7 && (year - 2) % 3 == 0);
+}
+
+constexpr int julian_last_day_of_month(int year, int month) {
+    const int last_day[12] = {
+        31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
+    };
+    if (month == 2 && julian_is_leap(year)) {
+        return 29;
+    }
+    return last_day[month - 1];
+}
+
+constexpr int julian_days_from_civil(int year, int month, int day) {
+    const int julian_bc45_1_1_serial = -735601;
+    const int days_before_month[] = {
+        0,    // dummy
+        0,    // January
+        31,   // February
+        59,   // March
+        90,   // April
+        120,  // May
+        151,  // June
+        181,  // July
+        212,  // August
+        243,  // September
+        273,  // October
+        304,  // November
+        334,  // December
+    };
+    int count_leaps = 0;
+    if (year >= 8) {
+        count_leaps = 12 + (year - 1) / 4;
+    } else if (year <= -44) {
+        count_leaps = (year + 44) / 4;
+    } else if (year >= -43 && year <= -7) {
+        count_leaps = (year + 45) / 3;
+    } else {
+        count_leaps = 13;
+    }
+    int total_days = (year + 44) * 365 + count_leaps;
+    total_days += days_before_month[month]
+        + !!(month > 2 && julian_is_leap(year));
+    total_days += day - 1;
+    return total_days + julian_bc45_1_1_serial;
+}
+
+constexpr YearMonthDay julian_civil_from_days(int serial_date) {
+    const int julian_bc45_3_1_serial = -735541;  // BC45/3/1(Julian)
+    const int julian_bc7_3_1_serial = -721659;  // BC7/3/1(Julian)
+    const int julian_ad4_3_1_serial = -717279;  // AD4/3/1(Julian)
+    // Every branch counts years from March 1 so that the leap day is last.
+    int year = 0;
+    unsigned int doy = 0;
+    if (serial_date < julian_bc45_3_1_serial
+        || serial_date > julian_ad4_3_1_serial) {
+        const int z = serial_date - julian_bc45_3_1_serial;
+        const int era = (z >= 0 ? z : z - 1460) / 1461;
+        const unsigned int doe = static_cast<unsigned int>(z - era * 1461);
+        const unsigned int yoe = (doe - doe / 1460) / 365;
+        year = era * 4 + static_cast<int>(yoe) - 44;
+        doy = doe - yoe * 365;
+    } else if (serial_date >= julian_bc7_3_1_serial) {
+        const int z = serial_date - julian_bc7_3_1_serial;
+        const unsigned int yoe = static_cast<unsigned int>(z) / 365;
+        year = static_cast<int>(yoe) - 7;
+        doy = static_cast<unsigned int>(z) - yoe * 365;
+    } else {
+        const int z = serial_date - julian_bc45_3_1_serial;
+        const int era = (z >= 0 ? z : z - 1095) / 1096;
+        const unsigned int doe = static_cast<unsigned int>(z - era * 1096);
+        const unsigned int yoe = doe / 365;
+        year = era * 3 + static_cast<int>(yoe) - 45;
+        doy = doe - yoe * 365;
+    }
+    const unsigned int mp = (5 * doy + 2) / 153;
+    const int month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+    const YearMonthDay ymd = {
+        year + !!(month <= 2),
+        month,
+        static_cast<int>(doy - (153 * mp + 2) / 5 + 1)
+    };
+    return ymd;
+}
+
+// The weekday of a serial date, 0 (Sunday) to 6 (Saturday) as in every
+// calendar of 7-day weeks; 1970-01-01 (serial date 0) was a Thursday.
+constexpr int weekday_from_days(int serial_date) {
+    return (serial_date % 7 + 11) % 7;
+}
+
+// The nearest serial date on or after (before) serial_date that falls on
+// weekday. They do not check for overflow near the ends of int.
+constexpr int weekday_on_or_after(int serial_date, int weekday) {
+    return serial_date
+        + (weekday - weekday_from_days(serial_date) + 7) % 7;
+}
+
+constexpr int weekday_on_or_before(int serial_date, int weekday) {
+    return serial_date
+        - (weekday_from_days(serial_date) - weekday + 7) % 7;
+}
+
+// The day of the nth weekday of a month of days days, as an offset from its
+// first day, whose weekday is first_weekday, in weeks of days_per_week days.
+// A negative nth counts from the end (-1 is the last one). Returns -1 if
+// the month has no such day, nth is 0 or weekday is not in the week.
+constexpr int nth_weekday_offset(int first_weekday, int days, int weekday,
+        int nth, int days_per_week = 7) {
+    if (weekday < 0 || weekday >= days_per_week || nth == 0
+        || nth > days || nth < -days) {
+        return -1;
+    }
+    const int offset = nth > 0
+        ? (weekday - first_weekday + days_per_week) % days_per_week
+            + (nth - 1) * days_per_week
+        : days - 1 - ((first_weekday + days - 1) % days_per_week - weekday
+            + days_per_week) % days_per_week + (nth + 1) * days_per_week;
+    return offset >= 0 && offset < days ? offset : -1;
+}
+
+}  // namespace toolbox
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <stdexcept>
+
+#include <calendar_system/CalendarSystem.hpp>
+#include <calendar_system/EthiopianCalendar.hpp>
+#include <calendar_system/FrenchRepublicanCalendar.hpp>
+#include <calendar_system/GregorianCalendar.hpp>
+#include <calendar_system/JapaneseWarekiCalendar.hpp>
+#include <calendar_system/JulianCalendar.hpp>
+#include <calendar_system/NonProlepticGregorianCalendar.hpp>
+
+namespace toolbox {
+
+// Maps a CalendarSystem known at compile time to its calendar class. Code
+// templated on the calendar calls calendar_type's members by qualified name,
+// which binds them statically instead of going through the switch in
+// Date::get_calendar_system and the ICalendarSystem vtable.
+//
+// The constants describe the shape of the calendar for code that walks it
+// without converting every date (see CivilCursor.hpp):
+// - months_per_year and days_per_week: the months of a year are numbered
+//   1..months_per_year and weekdays 0..days_per_week - 1.
+// - bc_era: the era whose years count down towards the one after it (1 B.C.
+//   is followed by A.D. 1), or -1 if there is none.
+// - regular_months: whether every month runs without gaps from its first day
+//   to last_day_of_month and is followed by the next month of the same era,
+//   or by month 1 of the next year after the last month. JAPANESE_WAREKI
+//   is not, as its eras begin and end within months.
+//
+// When adding a new calendar system, add a specialization here.
+template <CalendarSystem Cal>
+struct CalendarTraits;
+
+template <>
+struct CalendarTraits<GREGORIAN> {
+    typedef GregorianCalendar calendar_type;
+    static const int months_per_year = 12;
+    static const int days_per_week = 7;
+    static const int bc_era = GregorianCalendar::BC;
+    static const bool regular_months = true;
+};
+
+template <>
+struct CalendarTraits<NON_PROLEPTIC_GREGORIAN> {
+    typedef NonProlepticGregorianCalendar calendar_type;
+    static const int months_per_year = 12;
+    static const int days_per_week = 7;
+    static const int bc_era = NonProlepticGregorianCalendar::BC;
+    static const bool regular_months = true;
+};
+
+template <>
+struct CalendarTraits<JULIAN> {
+    typedef JulianCalendar calendar_type;
+    static const int months_per_year = 12;
+    static const int days_per_week = 7;
+    static const int bc_era = JulianCalendar::BC;
+    static const bool regular_months = true;
+};
+
+template <>
+struct CalendarTraits<ETHIOPIAN> {
+    typedef EthiopianCalendar calendar_type;
+    static const int months_per_year = 13;
+    static const int days_per_week = 7;
+    static const int bc_era = EthiopianCalendar::BC;
+    static const bool regular_months = true;
+};
+
+template <>
+struct CalendarTraits<FRENCH_REPUBLICAN> {
+    typedef FrenchRepublicanCalendar calendar_type;
+    static const int months_per_year = 13;
+    static const int days_per_week = 10;
+    static const int bc_era = -1;
+    static const bool regular_months = true;
+};
+
+template <>
+struct CalendarTraits<JAPANESE_WAREKI> {
+    typedef JapaneseWarekiCalendar calendar_type;
+    static const int months_per_year = 12;
+    static const int days_per_week = 7;
+    static const int bc_era = -1;
+    static const bool regular_months = false;
+};
+
+// CalendarTraits<Cal>::months_per_year and days_per_week for a calendar
+// chosen at run time. Throw std::invalid_argument for an unknown cal_sys.
+inline int months_per_year(CalendarSystem cal_sys) {
+    switch (cal_sys) {
+        case GREGORIAN:
+            return CalendarTraits<GREGORIAN>::months_per_year;
+        case NON_PROLEPTIC_GREGORIAN:
+            return CalendarTraits<NON_PROLEPTIC_GREGORIAN>::months_per_year;
+        case JULIAN:
+            return CalendarTraits<JULIAN>::months_per_year;
+        case ETHIOPIAN:
+            return CalendarTraits<ETHIOPIAN>::months_per_year;
+        case FRENCH_REPUBLICAN:
+            return CalendarTraits<FRENCH_REPUBLICAN>::months_per_year;
+        case JAPANESE_WAREKI:
+            return CalendarTraits<JAPANESE_WAREKI>::months_per_year;
+        default:
+            throw std::invalid_argument(
+                "months_per_year failed: unknown calendar system");
+    }
+}
+
+inline int days_per_week(CalendarSystem cal_sys) {
+    switch (cal_sys) {
+        case GREGORIAN:
+            return CalendarTraits<GREGORIAN>::days_per_week;
+        case NON_PROLEPTIC_GREGORIAN:
+            return CalendarTraits<NON_PROLEPTIC_GREGORIAN>::days_per_week;
+        case JULIAN:
+            return CalendarTraits<JULIAN>::days_per_week;
+        case ETHIOPIAN:
+            return CalendarTraits<ETHIOPIAN>::days_per_week;
+        case FRENCH_REPUBLICAN:
+            return CalendarTraits<FRENCH_REPUBLICAN>::days_per_week;
+        case JAPANESE_WAREKI:
+            return CalendarTraits<JAPANESE_WAREKI>::days_per_week;
+        default:
+            throw std::invalid_argument(
+                "days_per_week failed: unknown calendar system");
+    }
+}
+
+// The shared instance of the calendar of Cal. Calendars are stateless, so
+// one instance serves every caller.
+template <CalendarSystem Cal>
+const typename CalendarTraits<Cal>::calendar_type& calendar_instance() {
+    static const typename CalendarTraits<Cal>::calendar_type instance;
+    return instance;
+}
+
+}  // namespace toolbox
@@ -0,0 +1,118 @@
+#include <calendar_system/DateFormat.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace toolbox {
+
+DateFormat::DateFormat() : _pattern("%Y-%M-%D"), _used_kinds(0) {
+    compile();
+}
+
+DateFormat::DateFormat(const char* pattern) : _used_kinds(0) {
+    if (!pattern) {
+        throw std::invalid_argument(
+            "DateFormat::DateFormat failed: pattern is null");
+    }
+    _pattern = pattern;
+    compile();
+}
+
+DateFormat::DateFormat(const DateFormat& other)
+    : _pattern(other._pattern),
+      _literals(other._literals),
+      _tokens(other._tokens),
+      _used_kinds(other._used_kinds) {
+}
+
+DateFormat& DateFormat::operator=(const DateFormat& other) {
+    if (this != &other) {
+        _pattern = other._pattern;
+        _literals = other._literals;
+        _tokens = other._tokens;
+        _used_kinds = other._used_kinds;
+    }
+    return *this;
+}
+
+DateFormat::~DateFormat() {
+}
+
+const std::string& DateFormat::pattern() const {
+    return _pattern;
+}
+
+const std::vector<DateFormat::Token>& DateFormat::tokens() const {
+    return _tokens;
+}
+
+const std::string& DateFormat::literals() const {
+    return _literals;
+}
+
+bool DateFormat::uses(TokenKind kind) const {
+    return (_used_kinds & (1u << kind)) != 0;
+}
+
+void DateFormat::compile() {
+    for (std::size_t i = 0; i < _pattern.size(); ++i) {
+        Token token;
+        token.uppercase = false;
+        token.offset = 0;
+        token.length = 0;
+        if (_pattern[i] != '%' || (i + 1 < _pattern.size()
+                && _pattern[i + 1] == '%')) {
+            // Consecutive literal characters share a single token.
+            if (_pattern[i] == '%') {
+                ++i;
+            }
+            if (_tokens.empty() || _tokens.back().kind != LITERAL) {
+                token.kind = LITERAL;
+                token.offset = _literals.size();
+                _tokens.push_back(token);
+            }
+            _literals += _pattern[i];
+            ++_tokens.back().length;
+            continue;
+        }
+        if (i + 1 == _pattern.size()) {
+            throw std::invalid_argument("DateFormat::DateFormat failed: "
+                "incomplete format specifier at the end of \""
+                + _pattern + "\"");
+        }
+        const char spec = _pattern[++i];
+        switch (spec) {
+            case 'E':
+            case 'e':
+                token.kind = ERA;
+                break;
+            case 'Y':
+            case 'y':
+                token.kind = YEAR;
+                break;
+            case 'M':
+            case 'm':
+                token.kind = MONTH;
+                break;
+            case 'D':
+            case 'd':
+                token.kind = DAY;
+                break;
+            case 'W':
+            case 'w':
+                token.kind = WEEKDAY;
+                break;
+            default:
+                throw std::invalid_argument("DateFormat::DateFormat failed: "
+                    "Invalid format specifier: %" + std::string(1, spec));
+        }
+        token.uppercase = (spec >= 'A' && spec <= 'Z');
+        _tokens.push_back(token);
+    }
+    for (std::size_t i = 0; i < _tokens.size(); ++i) {
+        _used_kinds |= 1u << _tokens[i].kind;
+    }
+}
+
+}  // namespace toolbox
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace toolbox {
+
+// A format string compiled once into a sequence of tokens, so that formatting
+// many dates does not re-interpret the pattern for each of them.
+//
+// The pattern uses the specifiers shared by every calendar system:
+// %E/%e (era), %Y/%y (year), %M/%m (month), %D/%d (day), %W/%w (day of the
+// week) and %% (a literal '%'). Uppercase and lowercase specifiers select the
+// calendar's long and short representations. Unknown or incomplete
+// specifiers are rejected by the constructor with std::invalid_argument.
+class DateFormat {
+ public:
+    enum TokenKind {
+        LITERAL,
+        ERA,
+        YEAR,
+        MONTH,
+        DAY,
+        WEEKDAY
+    };
+
+    struct Token {
+        TokenKind kind;
+        bool uppercase;
+        // Position of the text of a LITERAL token in literals()
+        std::size_t offset;
+        std::size_t length;
+    };
+
+    DateFormat();  // "%Y-%M-%D"
+    explicit DateFormat(const char* pattern);
+    DateFormat(const DateFormat& other);
+    DateFormat& operator=(const DateFormat& other);
+    ~DateFormat();
+
+    const std::string& pattern() const;
+    const std::vector<Token>& tokens() const;
+    // Unescaped text of all LITERAL tokens, concatenated
+    const std::string& literals() const;
+    bool uses(TokenKind kind) const;
+
+ private:
+    void compile();
+
+    std::string _pattern;
+    std::string _literals;
+    std::vector<Token> _tokens;
+    unsigned int _used_kinds;  // bit (1 << kind) for each kind in _tokens
+};
+
+}  // namespace toolbox
@@ -0,0 +1,413 @@
+#include <calendar_system/DateParser.hpp>
+
+#include <climits>
+#include <cstddef>
+#include <cstring>
+
+#include <string.hpp>
+
+namespace {
+
+enum TokenKind {
+    TOKEN_END,
+    TOKEN_LITERAL,
+    TOKEN_ERA,
+    TOKEN_YEAR,
+    TOKEN_MONTH,
+    TOKEN_DAY,
+    TOKEN_INVALID
+};
+
+struct FormatToken {
+    TokenKind kind;
+    bool uppercase;
+    char literal;
+};
+
+// A partial reading of the input: the fields parsed so far and the position
+// of the next character.
+struct Reading {
+    const char* pos;
+    int era;
+    int year;
+    int month;
+    int day;
+    int named_month;  // month implied by a day name, 0 if none
+};
+
+// Every field occurs once and branches into at most 10 readings (%Y), 2
+// (%M, %D) or the few names that are prefixes of one another, so the number
+// of live readings stays far below this.
+const int kMaxReadings = 128;
+
+// Reads the token at format and advances format past it.
+FormatToken next_token(const char*& format) {
+    FormatToken token = {TOKEN_END, false, '\0'};
+    if (*format == '\0') {
+        return token;
+    }
+    if (*format != '%') {
+        token.kind = TOKEN_LITERAL;
+        token.literal = *format++;
+        return token;
+    }
+    const char spec = format[1];
+    if (spec == '\0') {
+        token.kind = TOKEN_INVALID;
+        return token;
+    }
+    format += 2;
+    switch (spec) {
+        case '%':
+            token.kind = TOKEN_LITERAL;
+            token.literal = '%';
+            return token;
+        case 'E': case 'e':
+            token.kind = TOKEN_ERA;
+            break;
+        case 'Y': case 'y':
+            token.kind = TOKEN_YEAR;
+            break;
+        case 'M': case 'm':
+            token.kind = TOKEN_MONTH;
+            break;
+        case 'D': case 'd':
+            token.kind = TOKEN_DAY;
+            break;
+        default:
+            token.kind = TOKEN_INVALID;
+            return token;
+    }
+    token.uppercase = spec >= 'A' && spec <= 'Z';
+    return token;
+}
+
+toolbox::DateStatus check_format(const char* format) {
+    bool seen[TOKEN_INVALID] = {false};
+    for (;;) {
+        const FormatToken token = next_token(format);
+        if (token.kind == TOKEN_END) {
+            break;
+        }
+        if (token.kind == TOKEN_INVALID) {
+            return toolbox::DATE_INVALID_FORMAT;
+        }
+        if (token.kind == TOKEN_LITERAL) {
+            continue;
+        }
+        if (seen[token.kind]) {
+            return toolbox::DATE_DUPLICATE_FIELD;
+        }
+        seen[token.kind] = true;
+    }
+    if (!seen[TOKEN_YEAR] || !seen[TOKEN_MONTH] || !seen[TOKEN_DAY]) {
+        return toolbox::DATE_NO_MATCH;
+    }
+    return toolbox::DATE_OK;
+}
+
+bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool is_numeric(const FormatToken& token, const toolbox::DateParserSpec& spec) {
+    switch (token.kind) {
+        case TOKEN_YEAR:
+            return true;
+        case TOKEN_MONTH:
+            return token.uppercase || !spec.month_names;
+        case TOKEN_DAY:
+            return token.uppercase || !spec.day_names;
+        default:
+            return false;
+    }
+}
+
+bool matches(const char* pos, const char* end, const char* name,
+        std::size_t& len) {
+    len = std::strlen(name);
+    return len > 0 && static_cast<std::size_t>(end - pos) >= len
+        && std::memcmp(pos, name, len) == 0;
+}
+
+// Stores value into the field of kind, refusing a month that disagrees with
+// the one implied by a day name.
+bool set_field(Reading& reading, TokenKind kind, int value) {
+    switch (kind) {
+        case TOKEN_YEAR:
+            reading.year = value;
+            return true;
+        case TOKEN_MONTH:
+            reading.month = value;
+            return !reading.named_month || reading.named_month == value;
+        default:
+            reading.day = value;
+            return true;
+    }
+}
+
+// The readings alive after a token. push() applies the one-character
+// lookahead: a reading is kept only if its next character can start the
+// following token, or, after the last one, if it is at the end of the input
+// or the parse takes a prefix.
+class ReadingSet {
+ public:
+    ReadingSet()
+            : _count(0), _overflow(false), _end(NULL), _prefix(false),
+              _spec(NULL) {
+        _next.kind = TOKEN_END;
+        _next.uppercase = false;
+        _next.literal = '\0';
+    }
+
+    void reset(const char* end, bool prefix, const FormatToken& next,
+            const toolbox::DateParserSpec& spec) {
+        _count = 0;
+        _end = end;
+        _prefix = prefix;
+        _next = next;
+        _spec = &spec;
+    }
+
+    void push(const Reading& reading) {
+        if (!can_continue(reading.pos)) {
+            return;
+        }
+        if (_count == kMaxReadings) {
+            _overflow = true;
+            return;
+        }
+        _readings[_count++] = reading;
+    }
+
+    int size() const {
+        return _count;
+    }
+
+    const Reading& operator[](int index) const {
+        return _readings[index];
+    }
+
+    bool overflow() const {
+        return _overflow;
+    }
+
+ private:
+    ReadingSet(const ReadingSet& other);
+    ReadingSet& operator=(const ReadingSet& other);
+
+    bool can_continue(const char* pos) const {
+        if (_next.kind == TOKEN_END) {
+            return _prefix || pos == _end;
+        }
+        if (pos == _end) {
+            return false;
+        }
+        if (_next.kind == TOKEN_LITERAL) {
+            return *pos == _next.literal;
+        }
+        if (is_numeric(_next, *_spec)) {
+            return _next.uppercase ? (*pos >= '1' && *pos <= '9')
+                : is_digit(*pos);
+        }
+        return true;
+    }
+
+    Reading _readings[kMaxReadings];
+    int _count;
+    bool _overflow;
+    const char* _end;
+    bool _prefix;
+    FormatToken _next;
+    const toolbox::DateParserSpec* _spec;
+};
+
+// Pushes every reading of a numeric field at reading.pos, narrowest first.
+void advance_number(const Reading& reading, const FormatToken& token,
+        const char* end, ReadingSet& out) {
+    const char* pos = reading.pos;
+    if (!token.uppercase) {
+        // The lookahead has checked that pos[0] is a digit, ruling out '-'.
+        int value;
+        if (end - pos < 2
+                || toolbox::parse_int(pos, pos + 2, value) != pos + 2) {
+            return;
+        }
+        Reading next = reading;
+        next.pos = pos + 2;
+        if (set_field(next, token.kind, value)) {
+            out.push(next);
+        }
+        return;
+    }
+    if (pos == end || *pos == '0') {
+        return;
+    }
+    const int max_width = token.kind == TOKEN_YEAR ? 10 : 2;
+    int value = 0;
+    for (int width = 1; width <= max_width && pos < end && is_digit(*pos);
+            ++width, ++pos) {
+        const int digit = *pos - '0';
+        if (value > (INT_MAX - digit) / 10) {
+            return;
+        }
+        value = value * 10 + digit;
+        Reading next = reading;
+        next.pos = pos + 1;
+        if (set_field(next, token.kind, value)) {
+            out.push(next);
+        }
+    }
+}
+
+// Pushes the readings that follow reading after token, in the order the
+// results are ranked: narrower fields and earlier names first.
+void advance(const Reading& reading, const FormatToken& token,
+        const char* end, const toolbox::DateParserSpec& spec,
+        ReadingSet& out) {
+    std::size_t len;
+    if (token.kind == TOKEN_LITERAL) {
+        Reading next = reading;
+        ++next.pos;  // checked by the lookahead of the previous token
+        out.push(next);
+    } else if (is_numeric(token, spec)) {
+        advance_number(reading, token, end, out);
+    } else if (token.kind == TOKEN_ERA) {
+        const char* const* names = token.uppercase ? spec.era_names_upper
+            : spec.era_names_lower;
+        for (int era = 0; era < spec.era_count; ++era) {
+            if (matches(reading.pos, end, names[era], len)) {
+                Reading next = reading;
+                next.pos += len;
+                next.era = era;
+                out.push(next);
+            }
+        }
+    } else if (token.kind == TOKEN_MONTH) {
+        for (int i = 0; i < spec.month_name_count; ++i) {
+            if (matches(reading.pos, end, spec.month_names[i], len)) {
+                Reading next = reading;
+                next.pos += len;
+                if (set_field(next, TOKEN_MONTH, i + 1)) {
+                    out.push(next);
+                }
+            }
+        }
+    } else {
+        // Once the month is known, only its names can match.
+        int first = 0;
+        int last = spec.day_name_count;
+        if (reading.month) {
+            first = (reading.month - 1) * spec.days_per_named_month;
+            if (first + spec.days_per_named_month < last) {
+                last = first + spec.days_per_named_month;
+            }
+        }
+        for (int i = first; i < last; ++i) {
+            const int month = i / spec.days_per_named_month + 1;
+            if (matches(reading.pos, end, spec.day_names[i], len)) {
+                Reading next = reading;
+                next.pos += len;
+                next.day = i % spec.days_per_named_month + 1;
+                next.named_month = month;
+                out.push(next);
+            }
+        }
+    }
+}
+
+// parse_date, or parse_date_prefix if prefix. The results are the readings
+// that reach the end of the format furthest into the input, which is end
+// unless prefix; stop is set to where they end on DATE_OK.
+toolbox::DateStatus parse(const char* begin, const char* end,
+        const char* format, const toolbox::DateParserSpec& spec, bool strict,
+        bool prefix, int& serial_date, const char*& stop) {
+    const toolbox::DateStatus format_status = check_format(format);
+    if (format_status != toolbox::DATE_OK) {
+        return format_status;
+    }
+
+    // Two generations of readings: the live one and the one being built.
+    ReadingSet sets[2];
+    ReadingSet* current = &sets[0];
+    ReadingSet* next = &sets[1];
+
+    const Reading initial = {begin, spec.default_era, 0, 0, 0, 0};
+    const char* rest = format;
+    FormatToken token = next_token(rest);
+    current->reset(end, prefix, token, spec);
+    current->push(initial);
+    while (token.kind != TOKEN_END && current->size() > 0) {
+        const FormatToken following = next_token(rest);
+        next->reset(end, prefix, following, spec);
+        for (int i = 0; i < current->size(); ++i) {
+            advance((*current)[i], token, end, spec, *next);
+        }
+        ReadingSet* const done = current;
+        current = next;
+        next = done;
+        token = following;
+    }
+    if (sets[0].overflow() || sets[1].overflow()) {
+        // Unreachable with the calendars' names; refuse rather than guess.
+        return toolbox::DATE_AMBIGUOUS;
+    }
+
+    const char* furthest = begin;
+    for (int i = 0; i < current->size(); ++i) {
+        if ((*current)[i].pos > furthest) {
+            furthest = (*current)[i].pos;
+        }
+    }
+    bool found = false;
+    int result = 0;
+    toolbox::DateStatus first_error = toolbox::DATE_NO_MATCH;
+    for (int i = 0; i < current->size(); ++i) {
+        const Reading& reading = (*current)[i];
+        if (reading.pos != furthest) {
+            continue;
+        }
+        int serial;
+        const toolbox::DateStatus status = spec.to_serial_date(reading.era,
+            reading.year, reading.month, reading.day, serial);
+        if (status != toolbox::DATE_OK) {
+            if (first_error == toolbox::DATE_NO_MATCH) {
+                first_error = status;
+            }
+            continue;
+        }
+        if (found) {
+            return toolbox::DATE_AMBIGUOUS;
+        }
+        result = serial;
+        found = true;
+        if (!strict) {
+            break;
+        }
+    }
+    if (!found) {
+        return first_error;
+    }
+    serial_date = result;
+    stop = furthest;
+    return toolbox::DATE_OK;
+}
+
+}  // namespace
+
+namespace toolbox {
+
+DateStatus parse_date(const char* begin, const char* end,
+        const char* format, const DateParserSpec& spec, bool strict,
+        int& serial_date) {
+    const char* stop;
+    return parse(begin, end, format, spec, strict, false, serial_date, stop);
+}
+
+DateStatus parse_date_prefix(const char* begin, const char* end,
+        const char* format, const DateParserSpec& spec, bool strict,
+        int& serial_date, const char*& stop) {
+    return parse(begin, end, format, spec, strict, true, serial_date, stop);
+}
+
+}  // namespace toolbox
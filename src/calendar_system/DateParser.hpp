@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+
+#include <calendar_system/DateStatus.hpp>
+
+namespace toolbox {
+
+// Describes how a calendar spells its fields for parse_date.
+struct DateParserSpec {
+    // Names accepted by %E and %e, indexed by era value.
+    const char* const* era_names_upper;
+    const char* const* era_names_lower;
+    int era_count;
+    int default_era;  // era used when the format has no %E/%e
+    // Names accepted by %m, indexed by month - 1; NULL for two digits.
+    const char* const* month_names;
+    int month_name_count;
+    // Names accepted by %d in day-of-year order, days_per_named_month per
+    // month (the last month may be shorter); NULL for two digits. A day name
+    // also determines the month, which has to agree with %M/%m.
+    const char* const* day_names;
+    int day_name_count;
+    int days_per_named_month;
+    // Converts a parsed combination without throwing, usually the
+    // calendar's try_to_serial_date.
+    DateStatus (*to_serial_date)(int era, int year, int month, int day,
+        int& serial_date);
+};
+
+// Parses [begin, end) according to format, which must contain %Y/%y, %M/%m
+// and %D/%d once each and may contain %E/%e, %% and literal characters.
+//
+// %Y reads 1 to 10 digits, %M and %D 1 or 2 digits, all without a leading
+// zero; the lowercase forms read exactly 2 digits unless the spec gives
+// names. Variable-width fields make several readings possible, so the
+// parser advances every reading through the format at once, one token at a
+// time, and drops a reading as soon as the character after a field cannot
+// start the next token. As each field occurs once, at most a few dozen
+// readings are alive at a time and the parse runs in linear time without
+// recursion, allocation or exceptions.
+//
+// Readings that consume the whole input and form a valid date are results,
+// ordered by shorter widths first. With strict, a second result makes the
+// input DATE_AMBIGUOUS; otherwise the first result is taken. If readings
+// consume the whole input but none is a valid date, the status of the first
+// one (DATE_INVALID_DAY and the like) is returned. serial_date is written
+// only on DATE_OK.
+DateStatus parse_date(const char* begin, const char* end,
+    const char* format, const DateParserSpec& spec, bool strict,
+    int& serial_date);
+
+// parse_date for a date at the start of [begin, end) that may be followed by
+// anything: the input is cut after the longest prefix that the format
+// matches, and that prefix is parsed as parse_date parses a whole input. On
+// DATE_OK, stop is set to the end of the date. A variable-width field last
+// in the format takes every digit it can, so "2024-1-15" followed by "7"
+// reads as day 15 of %Y-%M-%D; end such formats with a literal or use the
+// fixed-width fields where more digits may follow.
+DateStatus parse_date_prefix(const char* begin, const char* end,
+    const char* format, const DateParserSpec& spec, bool strict,
+    int& serial_date, const char*& stop);
+
+}  // namespace toolbox
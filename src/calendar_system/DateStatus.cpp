@@ -0,0 +1,31 @@
+#include <calendar_system/DateStatus.hpp>
+
+namespace toolbox {
+
+const char* date_status_message(DateStatus status) {
+    switch (status) {
+        case DATE_OK:
+            return "success";
+        case DATE_INVALID_ERA:
+            return "Invalid era";
+        case DATE_INVALID_YEAR:
+            return "year is out of range";
+        case DATE_INVALID_MONTH:
+            return "month is out of range";
+        case DATE_INVALID_DAY:
+            return "day is out of range for the month";
+        case DATE_OUT_OF_RANGE:
+            return "date is out of the range of the calendar";
+        case DATE_INVALID_FORMAT:
+            return "Invalid format specifier or null format";
+        case DATE_DUPLICATE_FIELD:
+            return "A field is specified more than once";
+        case DATE_NO_MATCH:
+            return "date_str does not match format";
+        case DATE_AMBIGUOUS:
+            return "date_str is ambiguous";
+    }
+    return "unknown status";
+}
+
+}  // namespace toolbox
@@ -0,0 +1,24 @@
+#pragma once
+
+namespace toolbox {
+
+// Result of the non-throwing conversions (ICalendarSystem::try_to_serial_date
+// and try_parse). The throwing API reports the same conditions as
+// exceptions whose message is date_status_message(status).
+enum DateStatus {
+    DATE_OK,
+    DATE_INVALID_ERA,
+    DATE_INVALID_YEAR,
+    DATE_INVALID_MONTH,
+    DATE_INVALID_DAY,
+    DATE_OUT_OF_RANGE,     // valid fields outside the calendar's span
+    DATE_INVALID_FORMAT,   // null format or invalid format specifier
+    DATE_DUPLICATE_FIELD,  // a field occurs more than once in the format
+    DATE_NO_MATCH,         // date_str does not follow the format
+    DATE_AMBIGUOUS         // date_str reads as several dates (strict only)
+};
+
+// Describes a status for exception messages.
+const char* date_status_message(DateStatus status);
+
+}  // namespace toolbox
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+#include <string.hpp>
+
+namespace toolbox {
+
+// Bounded output of the format_to functions. Like snprintf, it stores at most
+// cap - 1 characters followed by '\0' and keeps counting past the end, so
+// that finish() returns the length of the complete output.
+class FormatBuffer {
+ public:
+    FormatBuffer(char* buf, std::size_t cap)
+        : _buf(buf), _limit(cap ? cap - 1 : 0), _cap(cap), _size(0) {
+    }
+
+    void append(const char* str, std::size_t len) {
+        if (_size < _limit) {
+            const std::size_t room = _limit - _size;
+            std::memcpy(_buf + _size, str, len < room ? len : room);
+        }
+        _size += len;
+    }
+
+    void append(const char* str) {
+        append(str, std::strlen(str));
+    }
+
+    void append_int(int value, int min_width = 0) {
+        char digits[16];
+        append(digits, format_int(digits, value, min_width));
+    }
+
+    // Terminates the output and returns its untruncated length.
+    std::size_t finish() {
+        if (_cap) {
+            _buf[_size < _limit ? _size : _limit] = '\0';
+        }
+        return _size;
+    }
+
+ private:
+    FormatBuffer(const FormatBuffer& other);
+    FormatBuffer& operator=(const FormatBuffer& other);
+
+    char* _buf;
+    std::size_t _limit;
+    std::size_t _cap;
+    std::size_t _size;
+};
+
+// Stores the output of format_to(buf, cap) in str, formatting into a stack
+// buffer first and retrying with the exact size only if it did not fit.
+template <class FormatTo>
+void format_to_string(std::string& str, FormatTo format_to) {
+    char buf[64];
+    const std::size_t len = format_to(buf, sizeof(buf));
+    if (len < sizeof(buf)) {
+        str.assign(buf, len);
+        return;
+    }
+    str.assign(len + 1, '\0');
+    format_to(&str[0], str.size());
+    str.resize(len);
+}
+
+}  // namespace toolbox
@@ -2,29 +2,179 @@
 
 #include <iostream>
 #include <iomanip>
-#include <sstream>
 #include <string>
 #include <stdexcept>
 #include <cstring>
+#include <climits>
+#include <vector>
 
 #include <string.hpp>
-#include <calendar_system/GregorianCalendar.hpp>
+#include <calendar_system/CalendarArithmetic.hpp>
+#include <calendar_system/DateParser.hpp>
+#include <calendar_system/FormatBuffer.hpp>
 
 namespace {
 bool is_leap(int year);
 int last_day_of_month(int year, int month);
+int first_of_month(int year, int month);
+toolbox::DateStatus parsed_to_serial(int era, int year, int month, int day,
+    int& serial_date);
 
-std::string get_month_name(int month);
-std::string get_day_name(int month, int day);
-std::string get_day_of_week_name(int day_of_week);
+const char* get_month_name(int month);
+const char* get_day_name(int month, int day);
+const char* get_day_of_week_name(int day_of_week);
 
-std::string to_string_Ee(int era, bool uppercase);
-std::string to_string_Yy(int year, bool uppercase);
-std::string to_string_Mm(int month, bool uppercase);
-std::string to_string_Dd(int month, int day, bool uppercase);
-std::string to_string_Ww(int day_of_week, bool uppercase);
+void write_Ee(toolbox::FormatBuffer& out, int era, bool uppercase);
+void write_Yy(toolbox::FormatBuffer& out, int year, bool uppercase);
+void write_Mm(toolbox::FormatBuffer& out, int month, bool uppercase);
+void write_Dd(toolbox::FormatBuffer& out, int month, int day, bool uppercase);
+void write_Ww(toolbox::FormatBuffer& out, int day_of_week, bool uppercase);
 
-toolbox::GregorianCalendar gregorian;
+// The French Republican Calendar started on 22 September 1792 (Gregorian).
+// Serial dates are converted up to 31 December 1806, kRepublicEnd.
+constexpr int kRepublicEpoch = toolbox::gregorian_days_from_civil(1792, 9, 22);
+constexpr int kRepublicEnd = toolbox::gregorian_days_from_civil(1806, 12, 31);
+
+// This implementation uses only ASCII characters.
+// In a real implementation, accented characters should be used.
+const char* const kMonthNames[] = {
+    /* 1  = */ "Vendemiaire",
+    /* 2  = */ "Brumaire",
+    /* 3  = */ "Frimaire",
+    /* 4  = */ "Nivose",
+    /* 5  = */ "Pluviose",
+    /* 6  = */ "Ventose",
+    /* 7  = */ "Germinal",
+    /* 8  = */ "Floreal",
+    /* 9  = */ "Prairial",
+    /* 10 = */ "Messidor",
+    /* 11 = */ "Thermidor",
+    /* 12 = */ "Fructidor",
+    /* 13 = */ "Sansculottides",
+};
+
+// One name per day of the year, 30 per month and 6 complementary days.
+const char* const kDayNames[] = {
+    /* Vendemiaire (1) */
+    "Raisin", "Safran", "Chataigne", "Colchique", "Cheval",
+    "Balsamine", "Carotte", "Amaranthe", "Panais", "Cuve",
+    "Pomme de terre", "Immortelle", "Potiron", "Reseda", "Ane",
+    "Belle de nuit", "Citrouille", "Sarrasin", "Tournesol", "Pressoir",
+    "Chanvre", "Peche", "Navet", "Amarillis", "Boeuf",
+    "Aubergine", "Piment", "Tomate", "Orge", "Tonneau",
+
+    /* Brumaire (2) */
+    "Pomme", "Celeri", "Poire", "Betterave", "Oie",
+    "Heliotrope", "Figue", "Scorsonere", "Alisier", "Charrue",
+    "Salsifis", "Macre", "Topinambour", "Endive", "Dindon",
+    "Chervis", "Cresson", "Dentelaire", "Grebade", "Herse",
+    "Bacchante", "Azerole", "Garance", "Orange", "Faisan",
+    "Pistache", "Mahjonc", "Coing", "Cormier", "Rouleau",
+
+    /* Frimaire (3) */
+    "Raiponce", "Turneps", "Chicoree", "Nefle", "Cochon",
+    "Mache", "Chou-fleur", "Miel", "Genièvre", "Pioche",
+    "Cire", "Raifort", "Cedre", "Sapin", "Chevreuil",
+    "Ajonc", "Cypres", "Lierre", "Sabine", "Hoyau",
+    "Erable sucre", "Bruyere", "Roseau", "Oseille", "Grillon",
+    "Pignon", "Liege", "Truffe", "Olive", "Pelle",
+
+    /* Nivose (4) */
+    "Tourbe", "Houille", "Bitume", "Soufre", "Chien",
+    "Lave", "Terre vegetale", "Fumier", "Salpetre", "Fleau",
+    "Granit", "Argile", "Ardoise", "Gres", "Lapin",
+    "Silex", "Marne", "Pierre a chaux", "Marbre", "Van",
+    "Pierre a platre", "Sel", "Fer", "Cuivre", "Chat",
+    "Etain", "Plomb", "Zinc", "Mercure", "Crible",
+
+    /* Pluviose (5) */
+    "Laureole", "Mousse", "Fragon", "Perce-neige", "Taureau",
+    "Laurier-tin", "Amadouvier", "Mezereon", "Peuplier", "Coignee",
+    "Ellebore", "Brocoli", "Laurier", "Avelinier", "Vache",
+    "Buis", "Lichen", "If", "Pulmonaire", "Serpette",
+    "Thlaspi", "Thimele", "Chiendent", "Trainel", "Lievre",
+    "Guede", "Noisetier", "Cyclamen", "Chelidoine", "Traineau",
+
+    /* Ventose (6) */
+    "Tussilage", "Cornouiller", "Violier", "Troene", "Bouc",
+    "Asaret", "Alaterne", "Violette", "Marceau", "Beche",
+    "Narcisse", "Orme", "Fumeterre", "Velar", "Chevre",
+    "Epinard", "Doronic", "Mouron", "Cerfeuil", "Cordeau",
+    "Mandragore", "Persil", "Cochlearia", "Paquerette", "Thon",
+    "Pissenlit", "Sylvie", "Capillaire", "Frene", "Plantoir",
+
+    /* Germinal (7) */
+    "Primevere", "Platane", "Asperge", "Tulipe", "Poule",
+    "Bette", "Bouleau", "Jonquille", "Aulne", "Greffoir",
+    "Pervenche", "Charme", "Morille", "Hetre", "Abeille",
+    "Laitue", "Meleze", "Cigue", "Radis", "Ruche",
+    "Gainier", "Romaine", "Marronnier", "Roquette", "Pigeon",
+    "Lilas", "Anemone", "Pensee", "Myrtille", "Couvoir",
+
+    /* Floreal (8) */
+    "Rose", "Chene", "Fougere", "Aubepine", "Rossignol",
+    "Ancolie", "Muguet", "Champignon", "Hyacinthe", "Rateau",
+    "Rhubarbe", "Sainfoin", "Baton-d'or", "Chamerops", "Ver a soie",
+    "Consoude", "Pimprenelle", "Corbeille d'or", "Arroche", "Sarcloir",
+    "Statice", "Fritillaire", "Bourrache", "Valeriane", "Carpe",
+    "Fusain", "Civette", "Buglosse", "Seneve", "Houlette",
+
+    /* Prairial (9) */
+    "Luzerne", "Hemerocalle", "Trefle", "Angelique", "Canard",
+    "Melisse", "Fromental", "Martagon", "Serpolet", "Faux",
+    "Fraise", "Betoine", "Pois", "Acacia", "Caille",
+    "Oeillet", "Sureau", "Pavot", "Tilleul", "Fourche",
+    "Barbeau", "Camomille", "Chevrefeuille", "Caille-lait", "Tanche",
+    "Jasmin", "Verveine", "Thym", "Pivoine", "Chariot",
+
+    /* Messidor (10) */
+    "Seigle", "Avoine", "Oignon", "Veronique", "Mulet",
+    "Romarin", "Concombre", "Echalote", "Absinthe", "Faucille",
+    "Coriandre", "Artichaut", "Girofle", "Lavande", "Chamois",
+    "Tabac", "Groseille", "Gesse", "Cerise", "Parc",
+    "Menthe", "Cumin", "Haricot", "Orcanete", "Dindette",
+    "Sauge", "Ail", "Vesce", "Ble", "Chalemie",
+
+    /* Thermidor (11) */
+    "Epeautre", "Bouillon-blanc", "Melon", "Ivraie", "Belier",
+    "Prele", "Armoise", "Carthame", "Mure", "Arrosoir",
+    "Panis", "Salicorne", "Abricot", "Basilic", "Brebis",
+    "Guimauve", "Lin", "Amande", "Gentiane", "Ecluse",
+    "Carline", "Caprier", "Lentille", "Aunee", "Loutre",
+    "Myrte", "Colza", "Lupin", "Coton", "Moulin",
+
+    /* Fructidor (12) */
+    "Prune", "Millet", "Lycoperdon", "Escourgeon", "Saumon",
+    "Tubereuse", "Sucrion", "Apocyn", "Reglisse", "Echelle",
+    "Pasteque", "Fenouil", "Epine vinette", "Noix", "Truite",
+    "Citron", "Cardere", "Nerprun", "Tagette", "Hotte",
+    "Eglantier", "Noisette", "Houblon", "Sorgho", "Ecrevisse",
+    "Bigarade", "Verge d'or", "Mais", "Marron", "Panier",
+
+    /* Jours complementaires (13) */
+    "Jour de la Vertu",
+    "Jour du Genie",
+    "Jour du Travail",
+    "Jour de l'Opinion",
+    "Jour des Recompenses",
+    "Jour de la Revolution"
+};
+
+const char* const kEraNamesUpper[] = {
+    /* [toolbox::FrenchRepublicanCalendar::AD] = */ "A.D.",
+};
+const char* const kEraNamesLower[] = {
+    /* [toolbox::FrenchRepublicanCalendar::AD] = */ "AD",
+};
+
+const toolbox::DateParserSpec kParserSpec = {
+    kEraNamesUpper, kEraNamesLower,
+    toolbox::FrenchRepublicanCalendar::END_OF_ERA,
+    toolbox::FrenchRepublicanCalendar::AD,
+    kMonthNames, sizeof(kMonthNames) / sizeof(kMonthNames[0]),
+    kDayNames, sizeof(kDayNames) / sizeof(kDayNames[0]), 30,
+    parsed_to_serial,
+};
 
 }  // namespace
 
@@ -48,80 +198,115 @@ FrenchRepublicanCalendar::~FrenchRepublicanCalendar() {
 
 int FrenchRepublicanCalendar::to_serial_date(int era,
         int year, int month, int day) const {
+    int serial_date = 0;
+    const DateStatus status = FrenchRepublicanCalendar::try_to_serial_date(era,
+        year, month, day, serial_date);
+    if (status != DATE_OK) {
+        throw std::out_of_range(
+            std::string("FrenchRepublicanCalendar::to_serial_date failed: ")
+            + date_status_message(status));
+    }
+    return serial_date;
+}
+
+int FrenchRepublicanCalendar::to_serial_date(const std::string& date_str,
+        const char* format, bool strict) const {
+    int serial_date = 0;
+    const DateStatus status = FrenchRepublicanCalendar::try_parse(date_str,
+        format, strict, serial_date);
+    if (status != DATE_OK) {
+        throw std::invalid_argument(
+            std::string("FrenchRepublicanCalendar::to_serial_date failed: ")
+            + date_status_message(status));
+    }
+    return serial_date;
+}
+
+int FrenchRepublicanCalendar::to_serial_date(const char* begin, const char* end,
+        const char* format, bool strict) const {
+    int serial_date = 0;
+    const DateStatus status = FrenchRepublicanCalendar::try_parse(begin, end,
+        format, strict, serial_date);
+    if (status != DATE_OK) {
+        throw std::invalid_argument(
+            std::string("FrenchRepublicanCalendar::to_serial_date failed: ")
+            + date_status_message(status));
+    }
+    return serial_date;
+}
+
+int FrenchRepublicanCalendar::to_serial_date(const char* begin, const char* end,
+        const char* format, bool strict, std::size_t& consumed) const {
+    int serial_date = 0;
+    const DateStatus status = FrenchRepublicanCalendar::try_parse(begin, end,
+        format, strict, serial_date, consumed);
+    if (status != DATE_OK) {
+        throw std::invalid_argument(
+            std::string("FrenchRepublicanCalendar::to_serial_date failed: ")
+            + date_status_message(status));
+    }
+    return serial_date;
+}
+
+DateStatus FrenchRepublicanCalendar::try_to_serial_date(int era,
+        int year, int month, int day, int& serial_date) const {
     const int start_year = 1;
     const int end_year = 14;
     if (era < 0 || era >= END_OF_ERA) {
-        throw std::out_of_range(
-            "FrenchRepublicanCalendar::to_serial_date failed: "
-            "Invalid era: " + toolbox::to_string(era));
+        return DATE_INVALID_ERA;
     }
     if (year < start_year || year > end_year) {
-        throw std::out_of_range(
-            "FrenchRepublicanCalendar::to_serial_date failed: "
-            "year must be in " + toolbox::to_string(start_year)
-            + ".." + toolbox::to_string(end_year));
+        return DATE_INVALID_YEAR;
     }
     if (month < 1 || month > 13) {
-        throw std::out_of_range(
-            "FrenchRepublicanCalendar::to_serial_date failed: "
-            "month must be in 1..13");
+        return DATE_INVALID_MONTH;
     }
-    if (day < 1 || day > last_day_of_month(year, month)) {
-        throw std::out_of_range(
-            "FrenchRepublicanCalendar::to_serial_date failed: "
-            "day is out of range for month " + toolbox::to_string(month));
+    if (day < 1 || day > ::last_day_of_month(year, month)) {
+        return DATE_INVALID_DAY;
     }
 
-    // The French Republican Calendar started on 22 September 1792 (Gregorian).
-    const int start_serial = gregorian.to_serial_date(
-        GregorianCalendar::AD, 1792, 9, 22);
-    const int serial = start_serial
-        + (year - 1) * 365
-        + year / 4  // Leap year every 4 years (3, 7, 11)
-        + (month - 1) * 30
-        + (day - 1);
-    return serial;
+    serial_date = first_of_month(year, month) + (day - 1);
+    return DATE_OK;
 }
 
-int FrenchRepublicanCalendar::to_serial_date(const std::string& date_str,
-        const char* format, bool strict) const {
+DateStatus FrenchRepublicanCalendar::try_parse(const std::string& date_str,
+        const char* format, bool strict, int& serial_date) const {
+    return FrenchRepublicanCalendar::try_parse(date_str.data(),
+        date_str.data() + date_str.size(), format, strict, serial_date);
+}
+
+DateStatus FrenchRepublicanCalendar::try_parse(const char* begin,
+        const char* end, const char* format, bool strict,
+        int& serial_date) const {
     if (!format) {
-        throw std::invalid_argument(
-            "FrenchRepublicanCalendar::to_serial_date failed: "
-            "format is null");
+        return DATE_INVALID_FORMAT;
     }
-    int era = FrenchRepublicanCalendar::AD;
-    int year = 0, month = 0, day = 0;
-    bool all_found = false;
-    int serial = 0;
-    parse_formatted_date(date_str, 0, format,
-        era, false,
-        year, false,
-        month, false,
-        day, false,
-        all_found,
-        serial,
-        strict);
-    if (!all_found) {
-        throw std::invalid_argument(
-            "FrenchRepublicanCalendar::to_serial_date failed: "
-            "date_str does not match format");
+    return parse_date(begin, end, format, kParserSpec, strict, serial_date);
+}
+
+DateStatus FrenchRepublicanCalendar::try_parse(const char* begin,
+        const char* end, const char* format, bool strict, int& serial_date,
+        std::size_t& consumed) const {
+    if (!format) {
+        return DATE_INVALID_FORMAT;
     }
-    return serial;
+    const char* stop;
+    const DateStatus status = parse_date_prefix(begin, end, format,
+        kParserSpec, strict, serial_date, stop);
+    if (status == DATE_OK) {
+        consumed = stop - begin;
+    }
+    return status;
 }
 
 void FrenchRepublicanCalendar::from_serial_date(int serial_date,
         int& era, int& year, int& month, int& day) const {
-    const int start_serial = gregorian.to_serial_date(
-        GregorianCalendar::AD, 1792, 9, 22);
-    const int end_serial = gregorian.to_serial_date(
-        GregorianCalendar::AD, 1806, 12, 31);
-    if (serial_date < start_serial || serial_date > end_serial) {
+    if (serial_date < kRepublicEpoch || serial_date > kRepublicEnd) {
         throw std::out_of_range(
             "FrenchRepublicanCalendar::from_serial_date failed: "
             "serial_date is out of range");
     }
-    const int z = serial_date - start_serial;
+    const int z = serial_date - kRepublicEpoch;
     const int era_year = z / 1461;  // 4 years
     const int doe = z - era_year * 1461;
     const int yoe = (doe - doe / 1095) / 365;  // Leap year (3, 7, 11)
@@ -139,48 +324,54 @@ void FrenchRepublicanCalendar::from_serial_date(int serial_date,
             "FrenchRepublicanCalendar::from_serial_date failed: "
             "format is null");
     }
+    FrenchRepublicanCalendar::from_serial_date(serial_date, date_str,
+        DateFormat(format));
+}
+
+void FrenchRepublicanCalendar::from_serial_date(int serial_date,
+        std::string& date_str, const DateFormat& format) const {
+    format_to_string(date_str, [&](char* buf, std::size_t cap) {
+        return FrenchRepublicanCalendar::format_to(serial_date, buf, cap,
+            format);
+    });
+}
+
+std::size_t FrenchRepublicanCalendar::format_to(int serial_date, char* buf,
+        std::size_t cap, const DateFormat& format) const {
     int era, year, month, day;
-    from_serial_date(serial_date, era, year, month, day);
-    int day_of_week;
-    from_serial_date(serial_date, day_of_week);
-    std::ostringstream ss;
-    for (std::size_t i = 0; format[i]; ++i) {
-        if (format[i] == '%') {
-            switch (format[++i]) {
-                case 'E':
-                case 'e':
-                    ss << to_string_Ee(era, std::isupper(format[i]));
-                    break;
-                case 'Y':
-                case 'y':
-                    ss << to_string_Yy(year, std::isupper(format[i]));
-                    break;
-                case 'M':
-                case 'm':
-                    ss << to_string_Mm(month, std::isupper(format[i]));
-                    break;
-                case 'D':
-                case 'd':
-                    ss << to_string_Dd(month, day, std::isupper(format[i]));
-                    break;
-                case 'W':
-                case 'w':
-                    ss << to_string_Ww(day_of_week, std::isupper(format[i]));
-                    break;
-                case '%':
-                    ss << '%';
-                    break;
-                default:
-                    throw std::invalid_argument(
-                        "FrenchRepublicanCalendar::from_serial_date failed: "
-                        "Invalid format specifier: %"
-                        + toolbox::to_string(format[i]));
-            }
-        } else {
-            ss << format[i];
+    FrenchRepublicanCalendar::from_serial_date(serial_date, era, year, month,
+        day);
+    int day_of_week = 0;
+    if (format.uses(DateFormat::WEEKDAY)) {
+        FrenchRepublicanCalendar::from_serial_date(serial_date, day_of_week);
+    }
+    const std::vector<DateFormat::Token>& tokens = format.tokens();
+    FormatBuffer out(buf, cap);
+    for (std::size_t i = 0; i < tokens.size(); ++i) {
+        const DateFormat::Token& token = tokens[i];
+        switch (token.kind) {
+            case DateFormat::LITERAL:
+                out.append(format.literals().data() + token.offset,
+                    token.length);
+                break;
+            case DateFormat::ERA:
+                write_Ee(out, era, token.uppercase);
+                break;
+            case DateFormat::YEAR:
+                write_Yy(out, year, token.uppercase);
+                break;
+            case DateFormat::MONTH:
+                write_Mm(out, month, token.uppercase);
+                break;
+            case DateFormat::DAY:
+                write_Dd(out, month, day, token.uppercase);
+                break;
+            case DateFormat::WEEKDAY:
+                write_Ww(out, day_of_week, token.uppercase);
+                break;
         }
     }
-    date_str = ss.str();
+    return out.finish();
 }
 
 void FrenchRepublicanCalendar::from_serial_date(int serial_date,
@@ -190,390 +381,190 @@ void FrenchRepublicanCalendar::from_serial_date(int serial_date,
     day_of_week = (day - 1) % 10;  // 10-day week
 }
 
-void FrenchRepublicanCalendar::parse_formatted_date(const std::string& date_str,
-    std::size_t pos,
-    const char* format,
-    int& era, bool era_found,
-    int& year, bool year_found,
-    int& month, bool month_found,
-    int& day, bool day_found,
-    bool& all_found,
-    int& serial,
-    bool strict) const {
-    if (pos >= date_str.size() && !*format) {
-        if (year_found && month_found && day_found) {
-            try {
-                int ret = to_serial_date(era, year, month, day);
-                if (!all_found) {
-                    serial = ret;
-                }
-            } catch (std::exception &e) {
-                return;
-            }
-            if (all_found) {
-                throw std::invalid_argument(
-                    "FrenchRepublicanCalendar::parse_formatted_date failed: "
-                    "date_str is ambiguous");
-            }
-            all_found = true;
-        }
-        return;
-    }
-    if (pos >= date_str.size() || !*format) {
-        return;
-    }
-    if (date_str[pos] == format[0] && format[0] != '%') {
-        parse_formatted_date(date_str, pos + 1, format + 1,
-            era, era_found,
-            year, year_found,
-            month, month_found,
-            day, day_found,
-            all_found,
-            serial,
-            strict);
-        return;
-    }
-    if (format[0] != '%') {
-        return;
-    }
-    switch (format[1]) {
-        case 'E':
-        case 'e': {
-            if (era_found) {
-                throw std::invalid_argument(
-                    "FrenchRepublicanCalendar::parse_formatted_date failed: "
-                    "era is specified multiple times");
-            }
-            parse_Ee(date_str, pos, format,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
-        case 'Y':
-        case 'y': {
-            if (year_found) {
-                throw std::invalid_argument(
-                    "FrenchRepublicanCalendar::parse_formatted_date failed: "
-                    "year is specified multiple times");
-            }
-            parse_Yy(date_str, pos, format,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
-        case 'M':
-        case 'm': {
-            if (month_found) {
-                throw std::invalid_argument(
-                    "FrenchRepublicanCalendar::parse_formatted_date failed: "
-                    "month is specified multiple times");
-            }
-            parse_Mm(date_str, pos, format,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
-        case 'D':
-        case 'd': {
-            if (day_found) {
-                throw std::invalid_argument(
-                    "FrenchRepublicanCalendar::parse_formatted_date failed: "
-                    "day is specified multiple times");
-            }
-            parse_Dd(date_str, pos, format,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
-        case '%': {
-            if (date_str[pos] != '%') {
-                return;
-            }
-            parse_formatted_date(date_str, pos + 1, format + 2,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
-        default:
-            throw std::invalid_argument(
-                "FrenchRepublicanCalendar::parse_formatted_date failed: "
-                "Invalid format specifier: %" + toolbox::to_string(format[1]));
-    }
-}
-
-void FrenchRepublicanCalendar::parse_Ee(const std::string& date_str,
-    std::size_t pos,
-    const char* format,
-    int& era, bool era_found,
-    int& year, bool year_found,
-    int& month, bool month_found,
-    int& day, bool day_found,
-    bool& all_found,
-    int& serial,
-    bool strict
-) const {
-    (void)era_found;
-    const char* era_str_E[] = {
-        /* [toolbox::FrenchRepublicanCalendar::AD] = */ "A.D.",
-    };
-    const char* era_str_e[] = {
-        /* [toolbox::FrenchRepublicanCalendar::AD] = */ "AD",
-    };
-    for (int i = 0; i < toolbox::FrenchRepublicanCalendar::END_OF_ERA; ++i) {
-        const char* s = std::isupper(format[1]) ? era_str_E[i] : era_str_e[i];
-        const std::size_t len = std::strlen(s);
-        if (date_str.compare(pos, len, s) == 0) {
-            era = i;
-            parse_formatted_date(date_str, pos + len, format + 2,
-                era, true,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
+// Follows the leap rule past year 14, which to_serial_date refuses, so that
+// the months up to the end of the range of from_serial_date have a length.
+int FrenchRepublicanCalendar::last_day_of_month(int era, int year,
+        int month) const {
+    DateStatus status = DATE_OK;
+    if (era < 0 || era >= END_OF_ERA) {
+        status = DATE_INVALID_ERA;
+    } else if (year <= 0) {
+        status = DATE_INVALID_YEAR;
+    } else if (month < 1 || month > 13) {
+        status = DATE_INVALID_MONTH;
     }
-    throw std::invalid_argument(
-        "FrenchRepublicanCalendar::parse_Ee failed: "
-        "era not found in date_str at position "
-        + toolbox::to_string(pos));
-}
-
-void FrenchRepublicanCalendar::parse_Yy(const std::string& date_str,
-    std::size_t pos,
-    const char* format,
-    int& era, bool era_found,
-    int& year, bool year_found,
-    int& month, bool month_found,
-    int& day, bool day_found,
-    bool& all_found,
-    int& serial,
-    bool strict
-) const {
-    (void)year_found;
-    if (std::isupper(format[1])) {
-        // %Y
-        if (date_str[pos] == '0') {
-            return;
-        }
-        for (std::size_t num_len = 1;
-            pos + num_len <= date_str.size(); ++num_len) {
-            if (!std::isdigit(date_str[pos + num_len - 1])) {
-                break;
-            }
-            std::string year_str = date_str.substr(pos, num_len);
-            try {
-                year = toolbox::stoi(year_str);
-            } catch (std::exception &e) {
-                continue;
-            }
-            parse_formatted_date(date_str, pos + num_len, format + 2,
-                era, era_found,
-                year, true,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            if (all_found && !strict) {
-                return;
-            }
-        }
-    } else {
-        // %y
-        if (pos + 2 > date_str.size()) {
-            return;
-        }
-        std::string year_str = date_str.substr(pos, 2);
-        try {
-            year = toolbox::stoi(year_str);
-        } catch (std::exception &e) {
-            return;
+    if (status != DATE_OK) {
+        throw std::out_of_range(
+            std::string("FrenchRepublicanCalendar::last_day_of_month failed: ")
+            + date_status_message(status));
+    }
+    return ::last_day_of_month(year, month);
+}
+
+// The complementary days form month 13, so Fructidor 30 + 1 month is the
+// 5th (or 6th) complementary day under MONTH_CLAMP.
+DateStatus FrenchRepublicanCalendar::try_add_months(int serial_date,
+        int months, MonthPolicy policy, int& result) const {
+    if (serial_date < kRepublicEpoch || serial_date > kRepublicEnd) {
+        return DATE_OUT_OF_RANGE;
+    }
+    int era, year, month, day;
+    FrenchRepublicanCalendar::from_serial_date(serial_date, era, year, month,
+        day);
+    if (!shift_month(year, month, months, 13) || year <= 0) {
+        return DATE_OUT_OF_RANGE;
+    }
+    const DateStatus status = apply_month_policy(policy,
+        ::last_day_of_month(year, month), day);
+    if (status != DATE_OK) {
+        return status;
+    }
+    // Any year past the range of from_serial_date is rejected before its
+    // first day is computed, which could overflow.
+    if (year > (kRepublicEnd - kRepublicEpoch) / 365 + 1) {
+        return DATE_OUT_OF_RANGE;
+    }
+    const int first = first_of_month(year, month);
+    if (first + (day - 1) > kRepublicEnd) {
+        return DATE_OUT_OF_RANGE;
+    }
+    result = first + (day - 1);
+    return DATE_OK;
+}
+
+DateStatus FrenchRepublicanCalendar::try_add_years(int serial_date, int years,
+        MonthPolicy policy, int& result) const {
+    if (years > INT_MAX / 13 || years < INT_MIN / 13) {
+        return DATE_OUT_OF_RANGE;
+    }
+    return FrenchRepublicanCalendar::try_add_months(serial_date, years * 13,
+        policy, result);
+}
+
+// The decades (10-day weeks) start over every month on its 1st, primidi, and
+// the complementary days of month 13 are a short decade of 5 or 6 days.
+DateStatus FrenchRepublicanCalendar::try_nth_weekday_of_month(int era,
+        int year, int month, int weekday, int nth, int& serial_date) const {
+    int first = 0;
+    const DateStatus status = FrenchRepublicanCalendar::try_to_serial_date(
+        era, year, month, 1, first);
+    if (status != DATE_OK) {
+        return status;
+    }
+    const int offset = nth_weekday_offset(0, ::last_day_of_month(year, month),
+        weekday, nth, 10);
+    if (offset < 0) {
+        return DATE_INVALID_DAY;
+    }
+    serial_date = first + offset;
+    return DATE_OK;
+}
+
+// Searches the rest of the month in closed form and moves on to the next one
+// (past a short month 13 too) only if the weekday does not come in it.
+DateStatus FrenchRepublicanCalendar::try_weekday_on_or_after(int serial_date,
+        int weekday, int& result) const {
+    if (weekday < 0 || weekday > 9) {
+        return DATE_INVALID_DAY;
+    }
+    if (serial_date < kRepublicEpoch || serial_date > kRepublicEnd) {
+        return DATE_OUT_OF_RANGE;
+    }
+    int era, year, month, day;
+    FrenchRepublicanCalendar::from_serial_date(serial_date, era, year, month,
+        day);
+    for (;;) {
+        const int last_day = ::last_day_of_month(year, month);
+        const int found = day + (weekday - (day - 1) % 10 + 10) % 10;
+        if (found <= last_day) {
+            serial_date += found - day;
+            break;
         }
-        parse_formatted_date(date_str, pos + 2, format + 2,
-            era, era_found,
-            year, true,
-            month, month_found,
-            day, day_found,
-            all_found,
-            serial,
-            strict);
-    }
-    return;
-}
-
-// get_month_nameを使う
-void FrenchRepublicanCalendar::parse_Mm(const std::string& date_str,
-    std::size_t pos,
-    const char* format,
-    int& era, bool era_found,
-    int& year, bool year_found,
-    int& month, bool month_found,
-    int& day, bool day_found,
-    bool& all_found,
-    int& serial,
-    bool strict
-) const {
-    (void)month_found;
-    bool updated = false;
-    if (std::isupper(format[1])) {
-        // %M
-        if (date_str[pos] == '0') {
-            return;
+        serial_date += last_day - day + 1;
+        day = 1;
+        if (!shift_month(year, month, 1, 13)) {
+            return DATE_OUT_OF_RANGE;
         }
-        for (std::size_t num_len = 1;
-            pos + num_len <= date_str.size() && num_len <= 2; ++num_len) {
-            if (!std::isdigit(date_str[pos + num_len - 1])) {
-                break;
-            }
-            std::string month_str = date_str.substr(pos, num_len);
-            try {
-                int m = toolbox::stoi(month_str);
-                if (!updated && !month_found && month != 0 && month != m) {
-                    throw std::invalid_argument(
-                        "FrenchRepublicanCalendar::parse_Mm failed: "
-                        "month value conflict");
-                }
-                updated = (month != m);
-                month = m;
-            } catch (std::exception &e) {
-                continue;
-            }
-            parse_formatted_date(date_str, pos + num_len, format + 2,
-                era, era_found,
-                year, year_found,
-                month, true,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            if (all_found && !strict) {
-                return;
-            }
+    }
+    if (serial_date > kRepublicEnd) {
+        return DATE_OUT_OF_RANGE;
+    }
+    result = serial_date;
+    return DATE_OK;
+}
+
+DateStatus FrenchRepublicanCalendar::try_weekday_on_or_before(int serial_date,
+        int weekday, int& result) const {
+    if (weekday < 0 || weekday > 9) {
+        return DATE_INVALID_DAY;
+    }
+    if (serial_date < kRepublicEpoch || serial_date > kRepublicEnd) {
+        return DATE_OUT_OF_RANGE;
+    }
+    int era, year, month, day;
+    FrenchRepublicanCalendar::from_serial_date(serial_date, era, year, month,
+        day);
+    for (;;) {
+        const int found = day - ((day - 1) % 10 - weekday + 10) % 10;
+        if (found >= 1) {
+            serial_date -= day - found;
+            break;
         }
-    } else {
-        // %m
-        for (int m = 1; m <= 13; ++m) {
-            std::string month_name = get_month_name(m);
-            const std::size_t len = month_name.size();
-            if (date_str.compare(pos, len, month_name) != 0) {
-                continue;
-            }
-            if (!updated && !month_found && month != 0 && month != m) {
-                continue;  // Value conflict
-            }
-            updated = (month != m);
-            month = m;
-            parse_formatted_date(date_str, pos + len, format + 2,
-                era, era_found,
-                year, year_found,
-                month, true,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-            if (all_found && !strict) {
-                return;
-            }
+        serial_date -= day;
+        if (!shift_month(year, month, -1, 13) || year <= 0) {
+            return DATE_OUT_OF_RANGE;
         }
+        day = ::last_day_of_month(year, month);
     }
+    if (serial_date < kRepublicEpoch) {
+        return DATE_OUT_OF_RANGE;
+    }
+    result = serial_date;
+    return DATE_OK;
 }
 
-void FrenchRepublicanCalendar::parse_Dd(const std::string& date_str,
-    std::size_t pos,
-    const char* format,
-    int& era, bool era_found,
-    int& year, bool year_found,
-    int& month, bool month_found,
-    int& day, bool day_found,
-    bool& all_found,
-    int& serial,
-    bool strict
-) const {
-    (void)day_found;
-    if (std::isupper(format[1])) {
-        // %D
-        if (date_str[pos] == '0') {
-            return;
-        }
-        for (std::size_t num_len = 1;
-            pos + num_len <= date_str.size() && num_len <= 2; ++num_len) {
-            if (!std::isdigit(date_str[pos + num_len - 1])) {
-                break;
-            }
-            std::string day_str = date_str.substr(pos, num_len);
-            try {
-                day = toolbox::stoi(day_str);
-            } catch (std::exception &e) {
-                continue;
-            }
-            parse_formatted_date(date_str, pos + num_len, format + 2,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, true,
-                all_found,
-                serial,
-                strict);
-            if (all_found && !strict) {
-                return;
-            }
+void FrenchRepublicanCalendar::to_serial_dates(const int* eras,
+        const int* years, const int* months, const int* days,
+        std::size_t count, int* serial_dates) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        serial_dates[i] = FrenchRepublicanCalendar::to_serial_date(eras[i],
+            years[i], months[i], days[i]);
+    }
+}
+
+void FrenchRepublicanCalendar::from_serial_dates(const int* serial_dates,
+        std::size_t count, int* eras, int* years, int* months,
+        int* days) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        FrenchRepublicanCalendar::from_serial_date(serial_dates[i], eras[i],
+            years[i], months[i], days[i]);
+    }
+}
+
+void FrenchRepublicanCalendar::add_months(const int* serial_dates,
+        std::size_t count, int months, MonthPolicy policy,
+        int* results) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        const DateStatus status = FrenchRepublicanCalendar::try_add_months(
+            serial_dates[i], months, policy, results[i]);
+        if (status != DATE_OK) {
+            throw std::out_of_range(
+                std::string("FrenchRepublicanCalendar::add_months failed: ")
+                + date_status_message(status));
         }
-    } else {
-        // %d
-        for (int m = 1; m <= 13; ++m) {
-            if (month_found && month != m) {
-                continue;
-            }
-            const int last_day = last_day_of_month(3, m);  // leap year
-            for (int d = 1; d <= last_day; ++d) {
-                std::string day_name = get_day_name(m, d);
-                const std::size_t len = day_name.size();
-                if (date_str.compare(pos, len, day_name) != 0) {
-                    continue;
-                }
-                day = d;
-                month = m;
-                parse_formatted_date(date_str, pos + len, format + 2,
-                    era, era_found,
-                    year, year_found,
-                    month, month_found,
-                    day, true,
-                    all_found,
-                    serial,
-                    strict);
-                if (all_found && !strict) {
-                    return;
-                }
-            }
+    }
+}
+
+void FrenchRepublicanCalendar::add_years(const int* serial_dates,
+        std::size_t count, int years, MonthPolicy policy,
+        int* results) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        const DateStatus status = FrenchRepublicanCalendar::try_add_years(
+            serial_dates[i], years, policy, results[i]);
+        if (status != DATE_OK) {
+            throw std::out_of_range(
+                std::string("FrenchRepublicanCalendar::add_years failed: ")
+                + date_status_message(status));
         }
     }
 }
@@ -598,32 +589,28 @@ int last_day_of_month(int year, int month) {
     return 30;
 }
 
-// This implementation uses only ASCII characters.
-// In a real implementation, accented characters should be used.
-std::string get_month_name(int month) {
-    const char* month_names[] = {
-        /* 1  = */ "Vendemiaire",
-        /* 2  = */ "Brumaire",
-        /* 3  = */ "Frimaire",
-        /* 4  = */ "Nivose",
-        /* 5  = */ "Pluviose",
-        /* 6  = */ "Ventose",
-        /* 7  = */ "Germinal",
-        /* 8  = */ "Floreal",
-        /* 9  = */ "Prairial",
-        /* 10 = */ "Messidor",
-        /* 11 = */ "Thermidor",
-        /* 12 = */ "Fructidor",
-        /* 13 = */ "Sansculottides",
-    };
+int first_of_month(int year, int month) {
+    return kRepublicEpoch
+        + (year - 1) * 365
+        + year / 4  // Leap year every 4 years (3, 7, 11)
+        + (month - 1) * 30;
+}
+
+toolbox::DateStatus parsed_to_serial(int era, int year, int month, int day,
+        int& serial_date) {
+    return toolbox::FrenchRepublicanCalendar().try_to_serial_date(era, year,
+        month, day, serial_date);
+}
+
+const char* get_month_name(int month) {
     if (month < 1 || month > 13) {
         throw std::out_of_range("get_month_name failed: "
             "month must be in 1..13");
     }
-    return month_names[month - 1];
+    return kMonthNames[month - 1];
 }
 
-std::string get_day_name(int month, int day) {
+const char* get_day_name(int month, int day) {
     if (month < 1 || month > 13) {
         throw std::out_of_range("get_day_name failed: "
             "month must be in 1..13");
@@ -632,116 +619,10 @@ std::string get_day_name(int month, int day) {
         throw std::out_of_range("get_day_name failed: "
             "day is out of range for month " + toolbox::to_string(month));
     }
-    int doy = (month - 1) * 30 + day;
-    const char* day_names[] = {
-        /* Vendemiaire (1) */
-        "Raisin", "Safran", "Chataigne", "Colchique", "Cheval",
-        "Balsamine", "Carotte", "Amaranthe", "Panais", "Cuve",
-        "Pomme de terre", "Immortelle", "Potiron", "Reseda", "Ane",
-        "Belle de nuit", "Citrouille", "Sarrasin", "Tournesol", "Pressoir",
-        "Chanvre", "Peche", "Navet", "Amarillis", "Boeuf",
-        "Aubergine", "Piment", "Tomate", "Orge", "Tonneau",
-
-        /* Brumaire (2) */
-        "Pomme", "Celeri", "Poire", "Betterave", "Oie",
-        "Heliotrope", "Figue", "Scorsonere", "Alisier", "Charrue",
-        "Salsifis", "Macre", "Topinambour", "Endive", "Dindon",
-        "Chervis", "Cresson", "Dentelaire", "Grebade", "Herse",
-        "Bacchante", "Azerole", "Garance", "Orange", "Faisan",
-        "Pistache", "Mahjonc", "Coing", "Cormier", "Rouleau",
-
-        /* Frimaire (3) */
-        "Raiponce", "Turneps", "Chicoree", "Nefle", "Cochon",
-        "Mache", "Chou-fleur", "Miel", "Genièvre", "Pioche",
-        "Cire", "Raifort", "Cedre", "Sapin", "Chevreuil",
-        "Ajonc", "Cypres", "Lierre", "Sabine", "Hoyau",
-        "Erable sucre", "Bruyere", "Roseau", "Oseille", "Grillon",
-        "Pignon", "Liege", "Truffe", "Olive", "Pelle",
-
-        /* Nivose (4) */
-        "Tourbe", "Houille", "Bitume", "Soufre", "Chien",
-        "Lave", "Terre vegetale", "Fumier", "Salpetre", "Fleau",
-        "Granit", "Argile", "Ardoise", "Gres", "Lapin",
-        "Silex", "Marne", "Pierre a chaux", "Marbre", "Van",
-        "Pierre a platre", "Sel", "Fer", "Cuivre", "Chat",
-        "Etain", "Plomb", "Zinc", "Mercure", "Crible",
-
-        /* Pluviose (5) */
-        "Laureole", "Mousse", "Fragon", "Perce-neige", "Taureau",
-        "Laurier-tin", "Amadouvier", "Mezereon", "Peuplier", "Coignee",
-        "Ellebore", "Brocoli", "Laurier", "Avelinier", "Vache",
-        "Buis", "Lichen", "If", "Pulmonaire", "Serpette",
-        "Thlaspi", "Thimele", "Chiendent", "Trainel", "Lievre",
-        "Guede", "Noisetier", "Cyclamen", "Chelidoine", "Traineau",
-
-        /* Ventose (6) */
-        "Tussilage", "Cornouiller", "Violier", "Troene", "Bouc",
-        "Asaret", "Alaterne", "Violette", "Marceau", "Beche",
-        "Narcisse", "Orme", "Fumeterre", "Velar", "Chevre",
-        "Epinard", "Doronic", "Mouron", "Cerfeuil", "Cordeau",
-        "Mandragore", "Persil", "Cochlearia", "Paquerette", "Thon",
-        "Pissenlit", "Sylvie", "Capillaire", "Frene", "Plantoir",
-
-        /* Germinal (7) */
-        "Primevere", "Platane", "Asperge", "Tulipe", "Poule",
-        "Bette", "Bouleau", "Jonquille", "Aulne", "Greffoir",
-        "Pervenche", "Charme", "Morille", "Hetre", "Abeille",
-        "Laitue", "Meleze", "Cigue", "Radis", "Ruche",
-        "Gainier", "Romaine", "Marronnier", "Roquette", "Pigeon",
-        "Lilas", "Anemone", "Pensee", "Myrtille", "Couvoir",
-
-        /* Floreal (8) */
-        "Rose", "Chene", "Fougere", "Aubepine", "Rossignol",
-        "Ancolie", "Muguet", "Champignon", "Hyacinthe", "Rateau",
-        "Rhubarbe", "Sainfoin", "Baton-d'or", "Chamerops", "Ver a soie",
-        "Consoude", "Pimprenelle", "Corbeille d'or", "Arroche", "Sarcloir",
-        "Statice", "Fritillaire", "Bourrache", "Valeriane", "Carpe",
-        "Fusain", "Civette", "Buglosse", "Seneve", "Houlette",
-
-        /* Prairial (9) */
-        "Luzerne", "Hemerocalle", "Trefle", "Angelique", "Canard",
-        "Melisse", "Fromental", "Martagon", "Serpolet", "Faux",
-        "Fraise", "Betoine", "Pois", "Acacia", "Caille",
-        "Oeillet", "Sureau", "Pavot", "Tilleul", "Fourche",
-        "Barbeau", "Camomille", "Chevrefeuille", "Caille-lait", "Tanche",
-        "Jasmin", "Verveine", "Thym", "Pivoine", "Chariot",
-
-        /* Messidor (10) */
-        "Seigle", "Avoine", "Oignon", "Veronique", "Mulet",
-        "Romarin", "Concombre", "Echalote", "Absinthe", "Faucille",
-        "Coriandre", "Artichaut", "Girofle", "Lavande", "Chamois",
-        "Tabac", "Groseille", "Gesse", "Cerise", "Parc",
-        "Menthe", "Cumin", "Haricot", "Orcanete", "Dindette",
-        "Sauge", "Ail", "Vesce", "Ble", "Chalemie",
-
-        /* Thermidor (11) */
-        "Epeautre", "Bouillon-blanc", "Melon", "Ivraie", "Belier",
-        "Prele", "Armoise", "Carthame", "Mure", "Arrosoir",
-        "Panis", "Salicorne", "Abricot", "Basilic", "Brebis",
-        "Guimauve", "Lin", "Amande", "Gentiane", "Ecluse",
-        "Carline", "Caprier", "Lentille", "Aunee", "Loutre",
-        "Myrte", "Colza", "Lupin", "Coton", "Moulin",
-
-        /* Fructidor (12) */
-        "Prune", "Millet", "Lycoperdon", "Escourgeon", "Saumon",
-        "Tubereuse", "Sucrion", "Apocyn", "Reglisse", "Echelle",
-        "Pasteque", "Fenouil", "Epine vinette", "Noix", "Truite",
-        "Citron", "Cardere", "Nerprun", "Tagette", "Hotte",
-        "Eglantier", "Noisette", "Houblon", "Sorgho", "Ecrevisse",
-        "Bigarade", "Verge d'or", "Mais", "Marron", "Panier",
-
-        /* Jours complementaires (13) */
-        "Jour de la Vertu",
-        "Jour du Genie",
-        "Jour du Travail",
-        "Jour de l'Opinion",
-        "Jour des Recompenses",
-        "Jour de la Revolution"
-    };
-    return day_names[doy - 1];
+    return kDayNames[(month - 1) * 30 + day - 1];
 }
 
-std::string get_day_of_week_name(int day_of_week) {
+const char* get_day_of_week_name(int day_of_week) {
     const char* day_of_week_names[] = {
         /* 0 = */ "Primidi",
         /* 1 = */ "Duodi",
@@ -761,77 +642,63 @@ std::string get_day_of_week_name(int day_of_week) {
     return day_of_week_names[day_of_week];
 }
 
-std::string to_string_Ee(int era, bool uppercase) {
-    const char* era_str_E[] = {
-        /* [toolbox::FrenchRepublicanCalendar::AD] = */ "A.D.",
-    };
-    const char* era_str_e[] = {
-        /* [toolbox::FrenchRepublicanCalendar::AD] = */ "AD",
-    };
+void write_Ee(toolbox::FormatBuffer& out, int era, bool uppercase) {
     if (era < 0 || era >= toolbox::FrenchRepublicanCalendar::END_OF_ERA) {
         throw std::out_of_range(
-            "to_string_Ee failed: Invalid era: " + toolbox::to_string(era));
+            "write_Ee failed: Invalid era: " + toolbox::to_string(era));
     }
-    return uppercase ? era_str_E[era] : era_str_e[era];
+    out.append(uppercase ? kEraNamesUpper[era] : kEraNamesLower[era]);
 }
 
-std::string to_string_Yy(int year, bool uppercase) {
+void write_Yy(toolbox::FormatBuffer& out, int year, bool uppercase) {
     if (year < 1 || year > 14) {
-        throw std::out_of_range("to_string_Yy failed: "
+        throw std::out_of_range("write_Yy failed: "
             "year must be in 1..14");
     }
-    std::ostringstream oss;
     if (uppercase) {
-        oss << year;
+        out.append_int(year);
     } else {
-        oss << std::setw(2) << std::setfill('0') << year;
+        out.append_int(year, 2);
     }
-    return oss.str();
 }
 
-std::string to_string_Mm(int month, bool uppercase) {
+void write_Mm(toolbox::FormatBuffer& out, int month, bool uppercase) {
     if (month < 1 || month > 13) {
-        throw std::out_of_range("to_string_Mm failed: month must be in 1..13");
+        throw std::out_of_range("write_Mm failed: month must be in 1..13");
     }
-    std::ostringstream oss;
     if (uppercase) {
-        oss << month;
+        out.append_int(month);
     } else {
-        oss << get_month_name(month);
+        out.append(get_month_name(month));
     }
-    return oss.str();
 }
 
-std::string to_string_Dd(int month, int day, bool uppercase) {
+void write_Dd(toolbox::FormatBuffer& out, int month, int day, bool uppercase) {
     if (month < 1 || month > 13) {
-        throw std::out_of_range("to_string_Dd failed: "
+        throw std::out_of_range("write_Dd failed: "
             "month must be in 1..13");
     }
     if (day < 1 || (month == 13 && day > 6) || (month != 13 && day > 30)) {
-        throw std::out_of_range("to_string_Dd failed: "
+        throw std::out_of_range("write_Dd failed: "
             "day is out of range for month " + toolbox::to_string(month));
     }
-    std::ostringstream oss;
     if (uppercase) {
-        oss << day;
+        out.append_int(day);
     } else {
-        oss << get_day_name(month, day);
+        out.append(get_day_name(month, day));
     }
-    return oss.str();
 }
 
-std::string to_string_Ww(int day_of_week, bool uppercase) {
+void write_Ww(toolbox::FormatBuffer& out, int day_of_week, bool uppercase) {
     if (day_of_week < 0 || day_of_week > 9) {
-        throw std::out_of_range("to_string_Ww failed: "
+        throw std::out_of_range("write_Ww failed: "
             "day_of_week must be in 0..9");
     }
-    std::ostringstream oss;
     if (uppercase) {
-        oss << day_of_week + 1;
+        out.append_int(day_of_week + 1);
     } else {
-        oss << get_day_of_week_name(day_of_week);
+        out.append(get_day_of_week_name(day_of_week));
     }
-    return oss.str();
 }
 
 }  // namespace
@@ -0,0 +1,461 @@
+#include <calendar_system/GregorianBatch.hpp>
+
+#include <cstddef>
+#include <stdexcept>
+
+#include <calendar_system/GregorianCalendar.hpp>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TOOLBOX_GREGORIAN_BATCH_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Shifting serial dates by 82 400-year cycles keeps every intermediate value
+// of the supported range non-negative and below 2^32.
+const int kCycleShift = 82;
+const int kDayShift = 719468 + 146097 * kCycleShift;
+const int kYearShift = 400 * kCycleShift;
+// The kernels convert A.D. years up to kMaxYear and B.C. years up to
+// kYearShift - 1, whose serial dates all lie in [-kDayShift, 2^30 - kDayShift).
+const int kMaxYear = 2000000;
+
+static_assert(toolbox::GregorianCalendar::BC + 1
+    == toolbox::GregorianCalendar::AD,
+    "the kernels compute the era as AD - (year <= 0)");
+
+void scalar_from_serial_dates(const int* serial_dates, std::size_t count,
+        int* eras, int* years, int* months, int* days) {
+    const toolbox::GregorianCalendar calendar;
+    for (std::size_t i = 0; i < count; ++i) {
+        calendar.from_serial_date(serial_dates[i],
+            eras[i], years[i], months[i], days[i]);
+    }
+}
+
+void scalar_to_serial_dates(const int* eras, const int* years,
+        const int* months, const int* days, std::size_t count,
+        int* serial_dates) {
+    const toolbox::GregorianCalendar calendar;
+    for (std::size_t i = 0; i < count; ++i) {
+        serial_dates[i] = calendar.to_serial_date(eras[i], years[i],
+            months[i], days[i]);
+    }
+}
+
+#ifdef TOOLBOX_GREGORIAN_BATCH_X86
+
+#define TOOLBOX_TARGET_AVX2 __attribute__((target("avx2")))
+#define TOOLBOX_TARGET_SSE41 __attribute__((target("sse4.1")))
+
+// High 32 bits of the unsigned 32x32-bit products of each lane.
+TOOLBOX_TARGET_AVX2 inline __m256i mulhi_epu32(__m256i a, __m256i b) {
+    const __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(a, b), 32);
+    const __m256i odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32),
+        _mm256_srli_epi64(b, 32));
+    return _mm256_blend_epi32(even, odd, 0xAA);
+}
+
+TOOLBOX_TARGET_SSE41 inline __m128i mulhi_epu32(__m128i a, __m128i b) {
+    const __m128i even = _mm_srli_epi64(_mm_mul_epu32(a, b), 32);
+    const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32),
+        _mm_srli_epi64(b, 32));
+    return _mm_blend_epi16(even, odd, 0xCC);
+}
+
+// Converts 8 serial dates in [-kDayShift, 2^30 - kDayShift). Divisions by
+// 146097, 11758980 (= 2939745 * 4) and 2141 are exact multiply-shifts over
+// their whole input range.
+TOOLBOX_TARGET_AVX2 inline void civil_from_days(__m256i serial,
+        __m256i& era, __m256i& year, __m256i& month, __m256i& day) {
+    const __m256i n = _mm256_add_epi32(serial, _mm256_set1_epi32(kDayShift));
+    // Century
+    const __m256i n1 = _mm256_add_epi32(_mm256_slli_epi32(n, 2),
+        _mm256_set1_epi32(3));
+    const __m256i c = _mm256_srli_epi32(
+        mulhi_epu32(n1, _mm256_set1_epi32(963315389)), 15);
+    const __m256i nc = _mm256_srli_epi32(_mm256_sub_epi32(n1,
+        _mm256_mullo_epi32(c, _mm256_set1_epi32(146097))), 2);
+    // Year
+    const __m256i n2 = _mm256_add_epi32(_mm256_slli_epi32(nc, 2),
+        _mm256_set1_epi32(3));
+    const __m256i p2_lo = _mm256_mullo_epi32(n2, _mm256_set1_epi32(2939745));
+    const __m256i z = mulhi_epu32(n2, _mm256_set1_epi32(2939745));
+    const __m256i ny = _mm256_srli_epi32(
+        mulhi_epu32(p2_lo, _mm256_set1_epi32(1531969483)), 22);
+    const __m256i y = _mm256_add_epi32(
+        _mm256_mullo_epi32(c, _mm256_set1_epi32(100)), z);
+    // Month and day
+    const __m256i n3 = _mm256_add_epi32(
+        _mm256_mullo_epi32(ny, _mm256_set1_epi32(2141)),
+        _mm256_set1_epi32(197913));
+    const __m256i m = _mm256_srli_epi32(n3, 16);
+    const __m256i d = _mm256_srli_epi32(_mm256_mullo_epi32(
+        _mm256_and_si256(n3, _mm256_set1_epi32(0xFFFF)),
+        _mm256_set1_epi32(31345)), 26);
+    // January and February belong to the next year.
+    const __m256i j = _mm256_cmpgt_epi32(ny, _mm256_set1_epi32(305));
+    const __m256i y_g = _mm256_sub_epi32(
+        _mm256_sub_epi32(y, _mm256_set1_epi32(kYearShift)), j);
+    month = _mm256_sub_epi32(m,
+        _mm256_and_si256(j, _mm256_set1_epi32(12)));
+    day = _mm256_add_epi32(d, _mm256_set1_epi32(1));
+    const __m256i bc = _mm256_cmpgt_epi32(_mm256_set1_epi32(1), y_g);
+    year = _mm256_blendv_epi8(y_g,
+        _mm256_sub_epi32(_mm256_set1_epi32(1), y_g), bc);
+    era = _mm256_add_epi32(
+        _mm256_set1_epi32(toolbox::GregorianCalendar::AD), bc);
+}
+
+TOOLBOX_TARGET_SSE41 inline void civil_from_days(__m128i serial,
+        __m128i& era, __m128i& year, __m128i& month, __m128i& day) {
+    const __m128i n = _mm_add_epi32(serial, _mm_set1_epi32(kDayShift));
+    // Century
+    const __m128i n1 = _mm_add_epi32(_mm_slli_epi32(n, 2), _mm_set1_epi32(3));
+    const __m128i c = _mm_srli_epi32(
+        mulhi_epu32(n1, _mm_set1_epi32(963315389)), 15);
+    const __m128i nc = _mm_srli_epi32(_mm_sub_epi32(n1,
+        _mm_mullo_epi32(c, _mm_set1_epi32(146097))), 2);
+    // Year
+    const __m128i n2 = _mm_add_epi32(_mm_slli_epi32(nc, 2),
+        _mm_set1_epi32(3));
+    const __m128i p2_lo = _mm_mullo_epi32(n2, _mm_set1_epi32(2939745));
+    const __m128i z = mulhi_epu32(n2, _mm_set1_epi32(2939745));
+    const __m128i ny = _mm_srli_epi32(
+        mulhi_epu32(p2_lo, _mm_set1_epi32(1531969483)), 22);
+    const __m128i y = _mm_add_epi32(
+        _mm_mullo_epi32(c, _mm_set1_epi32(100)), z);
+    // Month and day
+    const __m128i n3 = _mm_add_epi32(
+        _mm_mullo_epi32(ny, _mm_set1_epi32(2141)), _mm_set1_epi32(197913));
+    const __m128i m = _mm_srli_epi32(n3, 16);
+    const __m128i d = _mm_srli_epi32(_mm_mullo_epi32(
+        _mm_and_si128(n3, _mm_set1_epi32(0xFFFF)),
+        _mm_set1_epi32(31345)), 26);
+    // January and February belong to the next year.
+    const __m128i j = _mm_cmpgt_epi32(ny, _mm_set1_epi32(305));
+    const __m128i y_g = _mm_sub_epi32(
+        _mm_sub_epi32(y, _mm_set1_epi32(kYearShift)), j);
+    month = _mm_sub_epi32(m, _mm_and_si128(j, _mm_set1_epi32(12)));
+    day = _mm_add_epi32(d, _mm_set1_epi32(1));
+    const __m128i bc = _mm_cmpgt_epi32(_mm_set1_epi32(1), y_g);
+    year = _mm_blendv_epi8(y_g, _mm_sub_epi32(_mm_set1_epi32(1), y_g), bc);
+    era = _mm_add_epi32(_mm_set1_epi32(toolbox::GregorianCalendar::AD), bc);
+}
+
+// Returns false if one of the 8 serial dates is outside the kernel range.
+TOOLBOX_TARGET_AVX2 inline bool in_kernel_range(__m256i serial) {
+    const __m256i n = _mm256_add_epi32(serial, _mm256_set1_epi32(kDayShift));
+    const __m256i high_bits = _mm256_srli_epi32(n, 30);
+    return _mm256_testz_si256(high_bits, high_bits);
+}
+
+TOOLBOX_TARGET_SSE41 inline bool in_kernel_range(__m128i serial) {
+    const __m128i n = _mm_add_epi32(serial, _mm_set1_epi32(kDayShift));
+    const __m128i high_bits = _mm_srli_epi32(n, 30);
+    return _mm_testz_si128(high_bits, high_bits);
+}
+
+// Converts 8 dates, or returns false without storing anything if one of them
+// is invalid or outside the kernel range.
+TOOLBOX_TARGET_AVX2 inline bool days_from_civil(__m256i era, __m256i year,
+        __m256i month, __m256i day, __m256i& serial) {
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i bc = _mm256_cmpeq_epi32(era,
+        _mm256_set1_epi32(toolbox::GregorianCalendar::BC));
+    const __m256i ad = _mm256_cmpeq_epi32(era,
+        _mm256_set1_epi32(toolbox::GregorianCalendar::AD));
+    const __m256i year_limit = _mm256_blendv_epi8(
+        _mm256_set1_epi32(kMaxYear + 1), _mm256_set1_epi32(kYearShift), bc);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i month_limit = _mm256_set1_epi32(13);
+    const __m256i day_limit = _mm256_set1_epi32(32);
+    __m256i valid = _mm256_or_si256(bc, ad);
+    valid = _mm256_and_si256(valid, _mm256_cmpgt_epi32(year, zero));
+    valid = _mm256_and_si256(valid, _mm256_cmpgt_epi32(year_limit, year));
+    valid = _mm256_and_si256(valid, _mm256_cmpgt_epi32(month, zero));
+    valid = _mm256_and_si256(valid, _mm256_cmpgt_epi32(month_limit, month));
+    valid = _mm256_and_si256(valid, _mm256_cmpgt_epi32(day, zero));
+    valid = _mm256_and_si256(valid, _mm256_cmpgt_epi32(day_limit, day));
+    if (_mm256_movemask_epi8(valid) != -1) {
+        return false;
+    }
+    const __m256i y_g = _mm256_blendv_epi8(year,
+        _mm256_sub_epi32(one, year), bc);
+    // January and February are counted as months 13 and 14 of the
+    // previous year.
+    const __m256i j = _mm256_cmpgt_epi32(_mm256_set1_epi32(3), month);
+    const __m256i y = _mm256_add_epi32(
+        _mm256_add_epi32(y_g, _mm256_set1_epi32(kYearShift)), j);
+    const __m256i m = _mm256_add_epi32(month,
+        _mm256_and_si256(j, _mm256_set1_epi32(12)));
+    const __m256i c = mulhi_epu32(y, _mm256_set1_epi32(42949673));
+    const __m256i y_star = _mm256_add_epi32(_mm256_sub_epi32(_mm256_srli_epi32(
+        _mm256_mullo_epi32(y, _mm256_set1_epi32(1461)), 2), c),
+        _mm256_srli_epi32(c, 2));
+    const __m256i m_star = _mm256_srli_epi32(_mm256_sub_epi32(
+        _mm256_mullo_epi32(m, _mm256_set1_epi32(979)),
+        _mm256_set1_epi32(2919)), 5);
+    const __m256i n = _mm256_add_epi32(_mm256_add_epi32(y_star, m_star),
+        _mm256_sub_epi32(day, one));
+    const __m256i result = _mm256_sub_epi32(n, _mm256_set1_epi32(kDayShift));
+    // A day past the end of its month (e.g. February 30) converts to a
+    // different date, which the round trip detects.
+    __m256i back_era, back_year, back_month, back_day;
+    civil_from_days(result, back_era, back_year, back_month, back_day);
+    __m256i same = _mm256_cmpeq_epi32(back_era, era);
+    same = _mm256_and_si256(same, _mm256_cmpeq_epi32(back_year, year));
+    same = _mm256_and_si256(same, _mm256_cmpeq_epi32(back_month, month));
+    same = _mm256_and_si256(same, _mm256_cmpeq_epi32(back_day, day));
+    if (_mm256_movemask_epi8(same) != -1) {
+        return false;
+    }
+    serial = result;
+    return true;
+}
+
+TOOLBOX_TARGET_SSE41 inline bool days_from_civil(__m128i era, __m128i year,
+        __m128i month, __m128i day, __m128i& serial) {
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i bc = _mm_cmpeq_epi32(era,
+        _mm_set1_epi32(toolbox::GregorianCalendar::BC));
+    const __m128i ad = _mm_cmpeq_epi32(era,
+        _mm_set1_epi32(toolbox::GregorianCalendar::AD));
+    const __m128i year_limit = _mm_blendv_epi8(
+        _mm_set1_epi32(kMaxYear + 1), _mm_set1_epi32(kYearShift), bc);
+    __m128i valid = _mm_or_si128(bc, ad);
+    valid = _mm_and_si128(valid, _mm_cmpgt_epi32(year, _mm_setzero_si128()));
+    valid = _mm_and_si128(valid, _mm_cmpgt_epi32(year_limit, year));
+    valid = _mm_and_si128(valid, _mm_cmpgt_epi32(month, _mm_setzero_si128()));
+    valid = _mm_and_si128(valid, _mm_cmpgt_epi32(_mm_set1_epi32(13), month));
+    valid = _mm_and_si128(valid, _mm_cmpgt_epi32(day, _mm_setzero_si128()));
+    valid = _mm_and_si128(valid, _mm_cmpgt_epi32(_mm_set1_epi32(32), day));
+    if (_mm_movemask_epi8(valid) != 0xFFFF) {
+        return false;
+    }
+    const __m128i y_g = _mm_blendv_epi8(year, _mm_sub_epi32(one, year), bc);
+    // January and February are counted as months 13 and 14 of the
+    // previous year.
+    const __m128i j = _mm_cmpgt_epi32(_mm_set1_epi32(3), month);
+    const __m128i y = _mm_add_epi32(
+        _mm_add_epi32(y_g, _mm_set1_epi32(kYearShift)), j);
+    const __m128i m = _mm_add_epi32(month,
+        _mm_and_si128(j, _mm_set1_epi32(12)));
+    const __m128i c = mulhi_epu32(y, _mm_set1_epi32(42949673));
+    const __m128i y_star = _mm_add_epi32(_mm_sub_epi32(_mm_srli_epi32(
+        _mm_mullo_epi32(y, _mm_set1_epi32(1461)), 2), c),
+        _mm_srli_epi32(c, 2));
+    const __m128i m_star = _mm_srli_epi32(_mm_sub_epi32(
+        _mm_mullo_epi32(m, _mm_set1_epi32(979)), _mm_set1_epi32(2919)), 5);
+    const __m128i n = _mm_add_epi32(_mm_add_epi32(y_star, m_star),
+        _mm_sub_epi32(day, one));
+    const __m128i result = _mm_sub_epi32(n, _mm_set1_epi32(kDayShift));
+    // A day past the end of its month (e.g. February 30) converts to a
+    // different date, which the round trip detects.
+    __m128i back_era, back_year, back_month, back_day;
+    civil_from_days(result, back_era, back_year, back_month, back_day);
+    __m128i same = _mm_cmpeq_epi32(back_era, era);
+    same = _mm_and_si128(same, _mm_cmpeq_epi32(back_year, year));
+    same = _mm_and_si128(same, _mm_cmpeq_epi32(back_month, month));
+    same = _mm_and_si128(same, _mm_cmpeq_epi32(back_day, day));
+    if (_mm_movemask_epi8(same) != 0xFFFF) {
+        return false;
+    }
+    serial = result;
+    return true;
+}
+
+TOOLBOX_TARGET_AVX2 void avx2_from_serial_dates(const int* serial_dates,
+        std::size_t count, int* eras, int* years, int* months, int* days) {
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i serial = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(serial_dates + i));
+        if (!in_kernel_range(serial)) {
+            scalar_from_serial_dates(serial_dates + i, 8,
+                eras + i, years + i, months + i, days + i);
+            continue;
+        }
+        __m256i era, year, month, day;
+        civil_from_days(serial, era, year, month, day);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(eras + i), era);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(years + i), year);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(months + i), month);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(days + i), day);
+    }
+    scalar_from_serial_dates(serial_dates + i, count - i,
+        eras + i, years + i, months + i, days + i);
+}
+
+TOOLBOX_TARGET_SSE41 void sse41_from_serial_dates(const int* serial_dates,
+        std::size_t count, int* eras, int* years, int* months, int* days) {
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i serial = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(serial_dates + i));
+        if (!in_kernel_range(serial)) {
+            scalar_from_serial_dates(serial_dates + i, 4,
+                eras + i, years + i, months + i, days + i);
+            continue;
+        }
+        __m128i era, year, month, day;
+        civil_from_days(serial, era, year, month, day);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(eras + i), era);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(years + i), year);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(months + i), month);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(days + i), day);
+    }
+    scalar_from_serial_dates(serial_dates + i, count - i,
+        eras + i, years + i, months + i, days + i);
+}
+
+TOOLBOX_TARGET_AVX2 void avx2_to_serial_dates(const int* eras,
+        const int* years, const int* months, const int* days,
+        std::size_t count, int* serial_dates) {
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i era = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(eras + i));
+        const __m256i year = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(years + i));
+        const __m256i month = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(months + i));
+        const __m256i day = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(days + i));
+        __m256i serial;
+        if (!days_from_civil(era, year, month, day, serial)) {
+            // Throws for the first invalid date, like the scalar path.
+            scalar_to_serial_dates(eras + i, years + i, months + i,
+                days + i, 8, serial_dates + i);
+            continue;
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(serial_dates + i),
+            serial);
+    }
+    scalar_to_serial_dates(eras + i, years + i, months + i, days + i,
+        count - i, serial_dates + i);
+}
+
+TOOLBOX_TARGET_SSE41 void sse41_to_serial_dates(const int* eras,
+        const int* years, const int* months, const int* days,
+        std::size_t count, int* serial_dates) {
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i era = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(eras + i));
+        const __m128i year = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(years + i));
+        const __m128i month = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(months + i));
+        const __m128i day = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(days + i));
+        __m128i serial;
+        if (!days_from_civil(era, year, month, day, serial)) {
+            // Throws for the first invalid date, like the scalar path.
+            scalar_to_serial_dates(eras + i, years + i, months + i,
+                days + i, 4, serial_dates + i);
+            continue;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(serial_dates + i),
+            serial);
+    }
+    scalar_to_serial_dates(eras + i, years + i, months + i, days + i,
+        count - i, serial_dates + i);
+}
+
+#endif  // TOOLBOX_GREGORIAN_BATCH_X86
+
+toolbox::GregorianBatchKernel detect_kernel() {
+#ifdef TOOLBOX_GREGORIAN_BATCH_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return toolbox::GREGORIAN_BATCH_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return toolbox::GREGORIAN_BATCH_SSE41;
+    }
+#endif
+    return toolbox::GREGORIAN_BATCH_SCALAR;
+}
+
+// Detected once; initialization of a function-local static is thread-safe.
+toolbox::GregorianBatchKernel best_kernel() {
+    static const toolbox::GregorianBatchKernel kernel = detect_kernel();
+    return kernel;
+}
+
+toolbox::GregorianBatchKernel resolve_kernel(
+        toolbox::GregorianBatchKernel kernel) {
+    if (kernel == toolbox::GREGORIAN_BATCH_AUTO) {
+        return best_kernel();
+    }
+    if (!toolbox::gregorian_batch_kernel_supported(kernel)) {
+        throw std::invalid_argument("resolve_kernel failed: "
+            "batch kernel is not supported on this CPU");
+    }
+    return kernel;
+}
+
+}  // namespace
+
+namespace toolbox {
+
+bool gregorian_batch_kernel_supported(GregorianBatchKernel kernel) {
+    switch (kernel) {
+        case GREGORIAN_BATCH_AUTO:
+        case GREGORIAN_BATCH_SCALAR:
+            return true;
+        case GREGORIAN_BATCH_SSE41:
+            return best_kernel() == GREGORIAN_BATCH_SSE41
+                || best_kernel() == GREGORIAN_BATCH_AVX2;
+        case GREGORIAN_BATCH_AVX2:
+            return best_kernel() == GREGORIAN_BATCH_AVX2;
+        default:
+            return false;
+    }
+}
+
+void gregorian_from_serial_dates(const int* serial_dates, std::size_t count,
+        int* eras, int* years, int* months, int* days,
+        GregorianBatchKernel kernel) {
+    switch (resolve_kernel(kernel)) {
+#ifdef TOOLBOX_GREGORIAN_BATCH_X86
+        case GREGORIAN_BATCH_AVX2:
+            avx2_from_serial_dates(serial_dates, count,
+                eras, years, months, days);
+            return;
+        case GREGORIAN_BATCH_SSE41:
+            sse41_from_serial_dates(serial_dates, count,
+                eras, years, months, days);
+            return;
+#endif
+        default:
+            scalar_from_serial_dates(serial_dates, count,
+                eras, years, months, days);
+            return;
+    }
+}
+
+void gregorian_to_serial_dates(const int* eras, const int* years,
+        const int* months, const int* days, std::size_t count,
+        int* serial_dates, GregorianBatchKernel kernel) {
+    switch (resolve_kernel(kernel)) {
+#ifdef TOOLBOX_GREGORIAN_BATCH_X86
+        case GREGORIAN_BATCH_AVX2:
+            avx2_to_serial_dates(eras, years, months, days, count,
+                serial_dates);
+            return;
+        case GREGORIAN_BATCH_SSE41:
+            sse41_to_serial_dates(eras, years, months, days, count,
+                serial_dates);
+            return;
+#endif
+        default:
+            scalar_to_serial_dates(eras, years, months, days, count,
+                serial_dates);
+            return;
+    }
+}
+
+}  // namespace toolbox
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+namespace toolbox {
+
+// Bulk conversions between serial dates and proleptic Gregorian dates.
+//
+// The vector kernels implement the Neri-Schneider variant of Hinnant's
+// algorithm with every division replaced by a multiply-shift, processing
+// 4 (SSE4.1) or 8 (AVX2) dates per instruction. They cover serial dates in
+// [-12699422, 1061042401] (32800 B.C. to A.D. 2.9 million; A.D. 2 million
+// in the direction of to_serial_dates); elements
+// outside that range, invalid dates and the tail of the arrays are handled by
+// the scalar GregorianCalendar conversions, so every kernel produces results
+// bit-identical to the scalar path and throws the same exceptions.
+enum GregorianBatchKernel {
+    GREGORIAN_BATCH_AUTO,  // best kernel supported by the running CPU
+    GREGORIAN_BATCH_SCALAR,
+    GREGORIAN_BATCH_SSE41,
+    GREGORIAN_BATCH_AVX2
+};
+
+bool gregorian_batch_kernel_supported(GregorianBatchKernel kernel);
+
+void gregorian_from_serial_dates(const int* serial_dates, std::size_t count,
+    int* eras, int* years, int* months, int* days,
+    GregorianBatchKernel kernel = GREGORIAN_BATCH_AUTO);
+void gregorian_to_serial_dates(const int* eras, const int* years,
+    const int* months, const int* days, std::size_t count,
+    int* serial_dates,
+    GregorianBatchKernel kernel = GREGORIAN_BATCH_AUTO);
+
+}  // namespace toolbox
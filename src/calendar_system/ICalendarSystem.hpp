@@ -1,7 +1,12 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
 
+#include <calendar_system/DateFormat.hpp>
+#include <calendar_system/DateStatus.hpp>
+#include <calendar_system/MonthPolicy.hpp>
+
 namespace toolbox {
 
 class ICalendarSystem {
@@ -12,12 +17,87 @@ class ICalendarSystem {
         int year, int month, int day) const = 0;
     virtual int to_serial_date(const std::string& date_str,
         const char* format, bool strict = true) const = 0;
+    // The same over the characters [begin, end) of a larger buffer. The
+    // overload with consumed reads a date from the start of the range,
+    // which may go on after it, and stores the number of characters the date
+    // took in consumed; see parse_date_prefix for where a date ends.
+    virtual int to_serial_date(const char* begin, const char* end,
+        const char* format, bool strict) const = 0;
+    virtual int to_serial_date(const char* begin, const char* end,
+        const char* format, bool strict, std::size_t& consumed) const = 0;
+    // Non-throwing counterparts of the to_serial_date overloads above, which
+    // are thin wrappers around them. serial_date is written only on DATE_OK.
+    virtual DateStatus try_to_serial_date(int era, int year, int month,
+        int day, int& serial_date) const = 0;
+    virtual DateStatus try_parse(const std::string& date_str,
+        const char* format, bool strict, int& serial_date) const = 0;
+    // try_parse over the characters [begin, end) of a larger buffer, without
+    // copying them into a string first.
+    virtual DateStatus try_parse(const char* begin, const char* end,
+        const char* format, bool strict, int& serial_date) const = 0;
+    // consumed, like serial_date, is written only on DATE_OK.
+    virtual DateStatus try_parse(const char* begin, const char* end,
+        const char* format, bool strict, int& serial_date,
+        std::size_t& consumed) const = 0;
     virtual void from_serial_date(int serial_date,
         int& era, int& year, int& month, int& day) const = 0;
     virtual void from_serial_date(int serial_date,
         std::string& date_str, const char* format) const = 0;
+    // Formats with a pattern compiled in advance, skipping the per-call
+    // interpretation of the format string.
+    virtual void from_serial_date(int serial_date,
+        std::string& date_str, const DateFormat& format) const = 0;
+    // Formats into buf without allocating. Like snprintf, it writes at most
+    // cap - 1 characters and a terminating '\0' (nothing if cap is 0) and
+    // returns the length of the complete output, so a result >= cap means
+    // that the output was truncated.
+    virtual std::size_t format_to(int serial_date, char* buf,
+        std::size_t cap, const DateFormat& format) const = 0;
     virtual void from_serial_date(int serial_date,
         int& day_of_week) const = 0;  // 0=Sun, 1=Mon, ..., 6=Sat
+    // The number of days of the month, i.e. its last valid day. Throws
+    // std::out_of_range if era, year or month is invalid.
+    virtual int last_day_of_month(int era, int year, int month) const = 0;
+    // Calendar arithmetic: moves serial_date by whole months or years of the
+    // calendar, keeping the day of the month and resolving a day that the
+    // target month lacks by policy. result is written only on DATE_OK; a
+    // serial_date or result outside the calendar's span is
+    // DATE_OUT_OF_RANGE.
+    virtual DateStatus try_add_months(int serial_date, int months,
+        MonthPolicy policy, int& result) const = 0;
+    virtual DateStatus try_add_years(int serial_date, int years,
+        MonthPolicy policy, int& result) const = 0;
+    // Weekday arithmetic in closed form, with weekdays numbered as
+    // from_serial_date(int, int&) numbers them. try_nth_weekday_of_month
+    // finds the nth weekday of the month, counting from the end for a
+    // negative nth (-1 is the last one); a month without it, nth 0 or an
+    // invalid weekday is DATE_INVALID_DAY. try_weekday_on_or_after and
+    // try_weekday_on_or_before find the nearest weekday on or after (before)
+    // serial_date. The result is written only on DATE_OK.
+    virtual DateStatus try_nth_weekday_of_month(int era, int year, int month,
+        int weekday, int nth, int& serial_date) const = 0;
+    virtual DateStatus try_weekday_on_or_after(int serial_date, int weekday,
+        int& result) const = 0;
+    virtual DateStatus try_weekday_on_or_before(int serial_date, int weekday,
+        int& result) const = 0;
+
+    // Batch conversions over structure-of-arrays buffers of count elements,
+    // equivalent to calling the scalar overloads for each index. They stop
+    // at the first invalid element by throwing the scalar exception.
+    // Implementations call their own scalar overloads qualified, which binds
+    // them statically and lets the compiler inline them into the loop.
+    virtual void to_serial_dates(const int* eras, const int* years,
+        const int* months, const int* days, std::size_t count,
+        int* serial_dates) const = 0;
+    virtual void from_serial_dates(const int* serial_dates, std::size_t count,
+        int* eras, int* years, int* months, int* days) const = 0;
+    // Batch versions of try_add_months and try_add_years, moving every date
+    // by the same amount. They throw std::out_of_range at the first date
+    // that fails.
+    virtual void add_months(const int* serial_dates, std::size_t count,
+        int months, MonthPolicy policy, int* results) const = 0;
+    virtual void add_years(const int* serial_dates, std::size_t count,
+        int years, MonthPolicy policy, int* results) const = 0;
 };
 
 }  // namespace toolbox
@@ -0,0 +1,244 @@
+#include <calendar_system/Iso8601.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <string.hpp>
+#include <calendar_system/FormatBuffer.hpp>
+
+namespace {
+
+// Serial dates of 0000-01-01 and 9999-12-31.
+const int kMinSerial = -719528;
+const int kMaxSerial = 2932896;
+
+// Last day of each month of a common year, indexed by month & 15. Invalid
+// months map to 0 so that every day fails the range check.
+const unsigned char kLastDay[16] = {
+    0, 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31, 0, 0, 0
+};
+
+// Loads 8 bytes so that byte i of the word is str[i] on any host.
+std::uint64_t load8(const char* str) {
+    std::uint64_t word;
+    std::memcpy(&word, str, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word = __builtin_bswap64(word);
+#endif
+    return word;
+}
+
+// Whether every byte is '0'..'9': its high nibble must be 3 and adding 6
+// must not carry into it.
+bool all_digits(std::uint64_t word) {
+    return ((word & 0xF0F0F0F0F0F0F0F0ULL)
+        | (((word + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+        == 0x3333333333333333ULL;
+}
+
+// Combines 8 digits pairwise: byte 2i of the result is the 2-digit value of
+// bytes 2i and 2i + 1.
+std::uint64_t digit_pairs(std::uint64_t word) {
+    const std::uint64_t digits = word - 0x3030303030303030ULL;
+    return (digits * 10 + (digits >> 8)) & 0x00FF00FF00FF00FFULL;
+}
+
+unsigned pair_at(std::uint64_t pairs, int index) {
+    return static_cast<unsigned>(pairs >> (16 * index)) & 0xFF;
+}
+
+unsigned byte_at(std::uint64_t word, int index) {
+    return static_cast<unsigned>(word >> (8 * index)) & 0xFF;
+}
+
+unsigned is_leap(unsigned year) {
+    return (year % 4 == 0) & ((year % 100 != 0) | (year % 400 == 0));
+}
+
+// Hinnant's days_from_civil for astronomical years 0..9999, shifted by one
+// 400-year cycle to keep the arithmetic unsigned.
+int days_from_civil(unsigned year, unsigned month, unsigned day) {
+    const unsigned y = year + 400 - (month <= 2);
+    const unsigned era = y / 400;
+    const unsigned yoe = y - era * 400;
+    const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5
+        + day - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return static_cast<int>(era * 146097 + doe) - 719468 - 146097;
+}
+
+void civil_from_days(int serial_date, unsigned& year, unsigned& month,
+        unsigned& day) {
+    const unsigned z = static_cast<unsigned>(serial_date + 719468 + 146097);
+    const unsigned era = z / 146097;
+    const unsigned doe = z - era * 146097;
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = yoe + era * 400 + (month <= 2) - 400;
+}
+
+// 0=Mon .. 6=Sun. Serial date 0 (1970-01-01) is a Thursday.
+unsigned iso_weekday(int serial_date) {
+    return static_cast<unsigned>(serial_date - kMinSerial + 5) % 7;
+}
+
+bool parse_calendar(std::uint64_t digits, int& serial_date) {
+    const std::uint64_t pairs = digit_pairs(digits);
+    const unsigned year = pair_at(pairs, 0) * 100 + pair_at(pairs, 1);
+    const unsigned month = pair_at(pairs, 2);
+    const unsigned day = pair_at(pairs, 3);
+    const unsigned last = kLastDay[month & 15]
+        + ((month == 2) & is_leap(year));
+    serial_date = days_from_civil(year, month, day);
+    return (month <= 12) & (day - 1 < last);
+}
+
+bool parse_ordinal(std::uint64_t digits, int& serial_date) {
+    const std::uint64_t pairs = digit_pairs(digits);
+    const unsigned year = pair_at(pairs, 0) * 100 + pair_at(pairs, 1);
+    const unsigned day = pair_at(pairs, 2) * 100 + pair_at(pairs, 3);
+    serial_date = days_from_civil(year, 1, 1) + static_cast<int>(day) - 1;
+    return day - 1 < 365 + is_leap(year);
+}
+
+bool parse_week(std::uint64_t digits, unsigned weekday, int& serial_date) {
+    const std::uint64_t pairs = digit_pairs(digits);
+    const unsigned year = pair_at(pairs, 0) * 100 + pair_at(pairs, 1);
+    const unsigned week = pair_at(pairs, 3);
+    // Week 1 is the week containing January 4.
+    const int jan4 = days_from_civil(year, 1, 4);
+    const unsigned jan1_weekday = (iso_weekday(jan4) + 4) % 7;
+    const unsigned weeks = 52 + ((jan1_weekday == 3)
+        | (is_leap(year) & (jan1_weekday == 2)));
+    serial_date = jan4 - static_cast<int>(iso_weekday(jan4))
+        + static_cast<int>((week - 1) * 7 + weekday - 1);
+    return (week - 1 < weeks) & (weekday - 1 < 7);
+}
+
+void write2(char* out, unsigned value) {
+    out[0] = static_cast<char>('0' + value / 10);
+    out[1] = static_cast<char>('0' + value % 10);
+}
+
+void write4(char* out, unsigned value) {
+    write2(out, value / 100);
+    write2(out + 2, value % 100);
+}
+
+}  // namespace
+
+namespace toolbox {
+
+bool iso8601_to_serial_date(const char* begin, const char* end,
+        int& serial_date) {
+    const std::size_t len = static_cast<std::size_t>(end - begin);
+    if (len == 8) {
+        const std::uint64_t word = load8(begin);
+        if (byte_at(word, 4) != '-') {
+            // YYYYMMDD
+            return all_digits(word) && parse_calendar(word, serial_date);
+        }
+        // YYYY-DDD: read the '-' as a leading zero of the day.
+        const std::uint64_t digits = word ^ (0x1DULL << 32);
+        return all_digits(digits) && parse_ordinal(digits, serial_date);
+    }
+    if (len != 10) {
+        return false;
+    }
+    const std::uint64_t word = load8(begin);
+    const unsigned tail0 = static_cast<unsigned char>(begin[8]);
+    const unsigned tail1 = static_cast<unsigned char>(begin[9]);
+    if (byte_at(word, 5) == 'W') {
+        // YYYY-Www-D: the week number goes in the day position.
+        const std::uint64_t digits = (word & 0xFFFF0000FFFFFFFFULL)
+            | 0x0000303000000000ULL;
+        return byte_at(word, 4) == '-' && tail0 == '-'
+            && all_digits(digits)
+            && parse_week(digits, tail1 - '0', serial_date);
+    }
+    // YYYY-MM-DD: drop the separators into YYYYMMDD.
+    const std::uint64_t digits = (word & 0xFFFFFFFFULL)
+        | ((word >> 40 & 0xFFFF) << 32)
+        | static_cast<std::uint64_t>(tail0 | tail1 << 8) << 48;
+    return byte_at(word, 4) == '-' && byte_at(word, 7) == '-'
+        && all_digits(digits) && parse_calendar(digits, serial_date);
+}
+
+std::size_t iso8601_format_to(int serial_date, char* buf, std::size_t cap,
+        Iso8601Form form) {
+    if (serial_date < kMinSerial || serial_date > kMaxSerial) {
+        throw std::out_of_range("iso8601_format_to failed: "
+            "year is out of 0000..9999: serial_date "
+            + toolbox::to_string(serial_date));
+    }
+    unsigned year, month, day;
+    civil_from_days(serial_date, year, month, day);
+    char str[10];
+    std::size_t len = 0;
+    switch (form) {
+        case ISO8601_CALENDAR:
+            write4(str, year);
+            str[4] = '-';
+            write2(str + 5, month);
+            str[7] = '-';
+            write2(str + 8, day);
+            len = 10;
+            break;
+        case ISO8601_BASIC:
+            write4(str, year);
+            write2(str + 4, month);
+            write2(str + 6, day);
+            len = 8;
+            break;
+        case ISO8601_ORDINAL: {
+            const unsigned doy = static_cast<unsigned>(serial_date
+                - days_from_civil(year, 1, 1)) + 1;
+            write4(str, year);
+            str[4] = '-';
+            str[5] = static_cast<char>('0' + doy / 100);
+            write2(str + 6, doy % 100);
+            len = 8;
+            break;
+        }
+        case ISO8601_WEEK: {
+            // The week belongs to the year of its Thursday.
+            const unsigned weekday = iso_weekday(serial_date);
+            const int thursday = serial_date - static_cast<int>(weekday) + 3;
+            if (thursday < kMinSerial || thursday > kMaxSerial) {
+                throw std::out_of_range("iso8601_format_to failed: "
+                    "week-numbering year is out of 0000..9999: serial_date "
+                    + toolbox::to_string(serial_date));
+            }
+            unsigned week_year, week_month, week_day;
+            civil_from_days(thursday, week_year, week_month, week_day);
+            const unsigned week = static_cast<unsigned>(thursday
+                - days_from_civil(week_year, 1, 1)) / 7 + 1;
+            write4(str, week_year);
+            str[4] = '-';
+            str[5] = 'W';
+            write2(str + 6, week);
+            str[8] = '-';
+            str[9] = static_cast<char>('1' + weekday);
+            len = 10;
+            break;
+        }
+        default:
+            throw std::invalid_argument("iso8601_format_to failed: "
+                "Invalid form: " + toolbox::to_string(form));
+    }
+    if (cap > len) {
+        std::memcpy(buf, str, len);
+        buf[len] = '\0';
+        return len;
+    }
+    FormatBuffer out(buf, cap);
+    out.append(str, len);
+    return out.finish();
+}
+
+}  // namespace toolbox
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+
+namespace toolbox {
+
+// Fixed-width ISO 8601 date representations of the proleptic Gregorian
+// calendar. Years are the 4-digit astronomical years 0000..9999, so 0000 is
+// 1 B.C.
+enum Iso8601Form {
+    ISO8601_CALENDAR,  // YYYY-MM-DD
+    ISO8601_BASIC,     // YYYYMMDD
+    ISO8601_ORDINAL,   // YYYY-DDD
+    ISO8601_WEEK       // YYYY-Www-D, ISO week-numbering year, 1=Mon..7=Sun
+};
+
+// Parses [begin, end) in any of the forms above, told apart by length and
+// separators. Digits are validated 8 bytes at a time and the fields are
+// range-checked without branching on their values. Returns false for
+// anything that is not exactly one valid date.
+bool iso8601_to_serial_date(const char* begin, const char* end,
+    int& serial_date);
+
+// Writes serial_date in form into buf with the truncation rules of
+// ICalendarSystem::format_to and returns the untruncated length. Throws
+// std::out_of_range if the year (the week-numbering year for ISO8601_WEEK)
+// does not have 4 digits.
+std::size_t iso8601_format_to(int serial_date, char* buf, std::size_t cap,
+    Iso8601Form form);
+
+}  // namespace toolbox
@@ -1,18 +1,21 @@
 #include "calendar_system/JapaneseWarekiCalendar.hpp"
 
+#include <algorithm>
 #include <cctype>
+#include <climits>
 #include <cstring>
 #include <cstdlib>
 #include <fstream>
 #include <limits>
-#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <vector>
 #include <iostream>
 
 #include <string.hpp>
+#include <calendar_system/FormatBuffer.hpp>
 
+#include "calendar_system/CalendarArithmetic.hpp"
 #include "calendar_system/GregorianCalendar.hpp"
 #include "calendar_system/JapaneseEra.hpp"
 #include "calendar_system/JulianCalendar.hpp"
@@ -23,7 +26,7 @@ struct EraRange {
     toolbox::JapaneseEra era;
     int start_serial;
     int end_serial;  // inclusive end; use large value for open-ended
-    std::string name_kanji;
+    const char* name_kanji;  // points into the static EraMetadata table
     bool is_southern;  // used for Nanboku-cho disambiguation
 };
 
@@ -33,6 +36,7 @@ struct EraRange {
 // computed start/end serials using the appropriate calendar system.
 std::vector<EraRange> load_era_ranges() {
     std::vector<EraRange> ranges;
+    ranges.reserve(toolbox::era_count());
     toolbox::JulianCalendar julian;
     toolbox::GregorianCalendar greg;
 
@@ -42,7 +46,7 @@ std::vector<EraRange> load_era_ranges() {
             static_cast<toolbox::JapaneseEra>(idx));
         EraRange er;
         er.era = md.era;
-        er.name_kanji = md.kanji ? std::string(md.kanji) : std::string();
+        er.name_kanji = md.kanji ? md.kanji : "";
         er.is_southern = (md.authority == toolbox::ERA_AUTHORITY_SOUTHERN);
 
         int sserial = std::numeric_limits<int>::min();
@@ -108,141 +112,143 @@ std::vector<EraRange> load_era_ranges() {
     return ranges;
 }
 
-}  // namespace
-
-namespace toolbox {
-
-JapaneseWarekiCalendar::JapaneseWarekiCalendar() {
+// The era table only depends on the embedded metadata, so it is built once on
+// first use and shared by every conversion. Initialization of a function-local
+// static is thread-safe since C++11, and the table is never modified after.
+const std::vector<EraRange>& era_ranges() {
+    static const std::vector<EraRange> ranges = load_era_ranges();
+    return ranges;
 }
 
-JapaneseWarekiCalendar::JapaneseWarekiCalendar(
-        const JapaneseWarekiCalendar& other) {
-    (void)other;
-}
+// A maximal run of serial dates that resolve to the same era, starting at
+// start_serial and lasting until the start of the next segment.
+struct EraSegment {
+    int start_serial;
+    int range_index;  // index into era_ranges(), or -1 if no era applies
+};
 
-JapaneseWarekiCalendar& JapaneseWarekiCalendar::operator=(
-        const JapaneseWarekiCalendar& other) {
-    (void)other;
-    return *this;
+bool segment_starts_before(int serial_date, const EraSegment& segment) {
+    return serial_date < segment.start_serial;
 }
 
-JapaneseWarekiCalendar::~JapaneseWarekiCalendar() {
+// Returns the era chosen for serial_date by scanning every range. When
+// several eras cover the date (Nanboku-cho), the southern court is preferred,
+// otherwise the last matching era in table order wins.
+int resolve_era_range(const std::vector<EraRange>& ranges, int serial_date) {
+    int chosen = -1;
+    bool chosen_southern = false;
+    for (std::size_t i = 0; i < ranges.size(); ++i) {
+        const EraRange &er = ranges[i];
+        if (er.start_serial == std::numeric_limits<int>::min()) continue;
+        if (serial_date < er.start_serial || serial_date > er.end_serial) {
+            continue;
+        }
+        if (er.is_southern || !chosen_southern) {
+            chosen = static_cast<int>(i);
+            chosen_southern = er.is_southern;
+        }
+    }
+    return chosen;
 }
 
-int JapaneseWarekiCalendar::to_serial_date(int era,
-                                           int year,
-                                           int month,
-                                           int day) const {
-    // Build era table lazily
-    const std::vector<EraRange> ranges = load_era_ranges();
-    if (era < 0 || static_cast<std::size_t>(era) >= ranges.size()) {
-        throw std::out_of_range(
-            "JapaneseWarekiCalendar::to_serial_date failed: invalid era");
-    }
-    const EraRange &er = ranges[era];
-    if (er.start_serial == std::numeric_limits<int>::min()) {
-        throw std::out_of_range(
-            "JapaneseWarekiCalendar::to_serial_date failed: era start unknown");
+// Splits the serial axis at every era start and end so that membership is
+// constant within each piece, resolves each piece once and merges adjacent
+// pieces that resolve to the same era. The overlap rules are therefore paid
+// for here and a lookup is a single binary search.
+std::vector<EraSegment> build_era_index() {
+    const std::vector<EraRange>& ranges = era_ranges();
+    std::vector<int> boundaries;
+    boundaries.reserve(ranges.size() * 2);
+    for (std::size_t i = 0; i < ranges.size(); ++i) {
+        const EraRange &er = ranges[i];
+        if (er.start_serial == std::numeric_limits<int>::min()) continue;
+        boundaries.push_back(er.start_serial);
+        if (er.end_serial != std::numeric_limits<int>::max()) {
+            boundaries.push_back(er.end_serial + 1);
+        }
     }
-
-    if (year <= 0) {
-        throw std::out_of_range(
-            "JapaneseWarekiCalendar::to_serial_date failed: year must be >= 1");
+    std::sort(boundaries.begin(), boundaries.end());
+    boundaries.erase(std::unique(boundaries.begin(), boundaries.end()),
+        boundaries.end());
+
+    std::vector<EraSegment> segments;
+    segments.reserve(boundaries.size());
+    for (std::size_t i = 0; i < boundaries.size(); ++i) {
+        const int index = resolve_era_range(ranges, boundaries[i]);
+        if (!segments.empty() && segments.back().range_index == index) {
+            continue;
+        }
+        EraSegment segment;
+        segment.start_serial = boundaries[i];
+        segment.range_index = index;
+        segments.push_back(segment);
     }
+    return segments;
+}
 
-    // Use embedded EraMetadata to determine which calendar to use and to
-    // map the era-relative year to an absolute calendar year.
-    const toolbox::EraMetadata &md = toolbox::get_era_metadata(
-        static_cast<toolbox::JapaneseEra>(era));
-
-    // Era-relative year N corresponds to calendar year: start.year + (N - 1).
-    int target_year = md.start.year + (year - 1);
+const std::vector<EraSegment>& era_index() {
+    static const std::vector<EraSegment> segments = build_era_index();
+    return segments;
+}
 
-    toolbox::GregorianCalendar greg;
-    toolbox::JulianCalendar julian;
-    int serial = 0;
-    try {
-        if (md.start.calendar == toolbox::ERA_CALENDAR_JULIAN) {
-            int era_flag = (target_year <= 0)
-                ? toolbox::JulianCalendar::BC
-                : toolbox::JulianCalendar::AD;
-            serial = julian.to_serial_date(era_flag, target_year, month, day);
-        } else {
-            int era_flag = (target_year <= 0)
-                ? toolbox::GregorianCalendar::BC
-                : toolbox::GregorianCalendar::AD;
-            serial = greg.to_serial_date(era_flag, target_year, month, day);
-        }
-    } catch (std::exception &e) {
-        throw std::invalid_argument(
-            std::string("JapaneseWarekiCalendar::to_serial_date failed: ") +
-            e.what());
+// Returns the era range covering serial_date, or NULL if there is none.
+const EraRange* find_era_range(int serial_date) {
+    const std::vector<EraSegment>& segments = era_index();
+    if (segments.empty() || serial_date < segments.front().start_serial) {
+        return NULL;
     }
-
-    // Validate against era bounds: start (inclusive) and end (inclusive if
-    // set).
-    if (serial < er.start_serial) {
-        throw std::out_of_range(
-            "JapaneseWarekiCalendar::to_serial_date failed: date is before "
-            "era start");
+    const EraSegment* segment = &segments.back();
+    // Fast path: almost every date in practice falls in the current era.
+    if (serial_date < segment->start_serial) {
+        segment = &*(std::upper_bound(segments.begin(), segments.end(),
+            serial_date, segment_starts_before) - 1);
     }
-    if (er.end_serial != std::numeric_limits<int>::max() &&
-        serial > er.end_serial) {
-        throw std::out_of_range(
-            "JapaneseWarekiCalendar::to_serial_date failed: date is after "
-            "era end");
+    if (segment->range_index < 0) {
+        return NULL;
     }
-    return serial;
+    return &era_ranges()[segment->range_index];
 }
 
-int JapaneseWarekiCalendar::to_serial_date(const std::string& date_str,
-                                           const char* format,
-                                           bool strict) const {
-    if (!format) {
-        throw std::invalid_argument(
-            "JapaneseWarekiCalendar::to_serial_date failed: format is null");
-    }
+// The fields read by scan_date.
+struct ScannedDate {
+    toolbox::JapaneseEra era;
+    int year;
+    int month;
+    int day;
+};
 
-    const std::string& input = date_str;
-    const bool allow_trailing_whitespace = !strict;
-    std::size_t pos = 0;
+// Reads the fields of format from the start of [begin, end) and sets pos to
+// the end of the last one; what follows is left to the caller.
+toolbox::DateStatus scan_date(const char* begin, const char* end,
+        const char* format, ScannedDate& date, std::size_t& pos) {
+    const std::size_t size = end - begin;
+    pos = 0;
 
     bool era_found = false;
     bool year_found = false;
     bool month_found = false;
     bool day_found = false;
-    toolbox::JapaneseEra era_value = toolbox::END_OF_ERA;
-    int year = 0;
-    int month = 0;
-    int day = 0;
+    date.era = toolbox::END_OF_ERA;
+    date.year = 0;
+    date.month = 0;
+    date.day = 0;
 
-    auto parse_number = [&](const char* field_name) -> int {
+    auto parse_number = [&](int& value) -> bool {
         std::size_t start = pos;
-        while (pos < input.size() &&
-               std::isdigit(static_cast<unsigned char>(input[pos]))) {
+        while (pos < size &&
+               std::isdigit(static_cast<unsigned char>(begin[pos]))) {
             ++pos;
         }
-        if (start == pos) {
-            throw std::invalid_argument(
-                std::string("JapaneseWarekiCalendar::to_serial_date failed: "
-                            "expected numeric ") + field_name);
-        }
-        try {
-            return toolbox::stoi(input.substr(start, pos - start));
-        } catch (const std::exception&) {
-            throw std::invalid_argument(
-                std::string("JapaneseWarekiCalendar::to_serial_date failed: "
-                            "invalid numeric ") + field_name);
-        }
+        return start != pos &&
+               toolbox::parse_int(begin + start, begin + pos,
+                                  value) != NULL;
     };
 
     for (std::size_t i = 0; format[i]; ++i) {
         char ch = format[i];
         if (ch != '%') {
-            if (pos >= input.size() || input[pos] != ch) {
-                throw std::invalid_argument(
-                    "JapaneseWarekiCalendar::to_serial_date failed: literal"
-                    " mismatch in date_str");
+            if (pos >= size || begin[pos] != ch) {
+                return toolbox::DATE_NO_MATCH;
             }
             ++pos;
             continue;
@@ -250,18 +256,15 @@ int JapaneseWarekiCalendar::to_serial_date(const std::string& date_str,
 
         char spec = format[++i];
         if (!spec) {
-            throw std::invalid_argument(
-                "JapaneseWarekiCalendar::to_serial_date failed: incomplete "
-                "format specifier");
+            // incomplete format specifier
+            return toolbox::DATE_INVALID_FORMAT;
         }
 
         switch (spec) {
             case 'E':
             case 'e': {
                 if (era_found) {
-                    throw std::invalid_argument(
-                        "JapaneseWarekiCalendar::to_serial_date failed: era "
-                        "specified multiple times");
+                    return toolbox::DATE_DUPLICATE_FIELD;
                 }
                 std::size_t matched_len = 0;
                 toolbox::JapaneseEra matched = toolbox::END_OF_ERA;
@@ -273,26 +276,21 @@ int JapaneseWarekiCalendar::to_serial_date(const std::string& date_str,
                     if (!md.kanji) {
                         continue;
                     }
-                    const std::string era_name(md.kanji);
-                    if (era_name.empty()) {
-                        continue;
-                    }
-                    const std::size_t len = era_name.size();
-                    if (pos + len > input.size()) {
+                    const std::size_t len = std::strlen(md.kanji);
+                    if (len == 0 || pos + len > size) {
                         continue;
                     }
-                    if (input.compare(pos, len, era_name) == 0 &&
+                    if (std::memcmp(begin + pos, md.kanji, len) == 0 &&
                         len > matched_len) {
                         matched_len = len;
                         matched = md.era;
                     }
                 }
                 if (matched == toolbox::END_OF_ERA) {
-                    throw std::invalid_argument(
-                        "JapaneseWarekiCalendar::to_serial_date failed: era "
-                        "not found in date_str");
+                    // era not found in the input
+                    return toolbox::DATE_NO_MATCH;
                 }
-                era_value = matched;
+                date.era = matched;
                 era_found = true;
                 pos += matched_len;
                 break;
@@ -300,77 +298,250 @@ int JapaneseWarekiCalendar::to_serial_date(const std::string& date_str,
             case 'Y':
             case 'y': {
                 if (year_found) {
-                    throw std::invalid_argument(
-                        "JapaneseWarekiCalendar::to_serial_date failed: year "
-                        "specified multiple times");
+                    return toolbox::DATE_DUPLICATE_FIELD;
+                }
+                if (!parse_number(date.year)) {
+                    return toolbox::DATE_NO_MATCH;
                 }
-                year = parse_number("year");
                 year_found = true;
                 break;
             }
             case 'M':
             case 'm': {
                 if (month_found) {
-                    throw std::invalid_argument(
-                        "JapaneseWarekiCalendar::to_serial_date failed: month"
-                        " specified multiple times");
+                    return toolbox::DATE_DUPLICATE_FIELD;
+                }
+                if (!parse_number(date.month)) {
+                    return toolbox::DATE_NO_MATCH;
                 }
-                month = parse_number("month");
                 month_found = true;
                 break;
             }
             case 'D':
             case 'd': {
                 if (day_found) {
-                    throw std::invalid_argument(
-                        "JapaneseWarekiCalendar::to_serial_date failed: day "
-                        "specified multiple times");
+                    return toolbox::DATE_DUPLICATE_FIELD;
+                }
+                if (!parse_number(date.day)) {
+                    return toolbox::DATE_NO_MATCH;
                 }
-                day = parse_number("day");
                 day_found = true;
                 break;
             }
             case '%': {
-                if (pos >= input.size() || input[pos] != '%') {
-                    throw std::invalid_argument(
-                        "JapaneseWarekiCalendar::to_serial_date failed: '%' expected in date_str");
+                if (pos >= size || begin[pos] != '%') {
+                    return toolbox::DATE_NO_MATCH;
                 }
                 ++pos;
                 break;
             }
             default:
-                throw std::invalid_argument(
-                    "JapaneseWarekiCalendar::to_serial_date failed: invalid "
-                    "format specifier");
+                return toolbox::DATE_INVALID_FORMAT;
         }
     }
 
     if (!era_found || !year_found || !month_found || !day_found) {
+        // incomplete date components
+        return toolbox::DATE_NO_MATCH;
+    }
+    return toolbox::DATE_OK;
+}
+
+}  // namespace
+
+namespace toolbox {
+
+JapaneseWarekiCalendar::JapaneseWarekiCalendar() {
+}
+
+JapaneseWarekiCalendar::JapaneseWarekiCalendar(
+        const JapaneseWarekiCalendar& other) {
+    (void)other;
+}
+
+JapaneseWarekiCalendar& JapaneseWarekiCalendar::operator=(
+        const JapaneseWarekiCalendar& other) {
+    (void)other;
+    return *this;
+}
+
+JapaneseWarekiCalendar::~JapaneseWarekiCalendar() {
+}
+
+int JapaneseWarekiCalendar::to_serial_date(int era,
+                                           int year,
+                                           int month,
+                                           int day) const {
+    int serial_date = 0;
+    const toolbox::DateStatus status =
+        JapaneseWarekiCalendar::try_to_serial_date(era, year, month, day,
+                                                   serial_date);
+    if (status != toolbox::DATE_OK) {
+        throw std::out_of_range(
+            std::string("JapaneseWarekiCalendar::to_serial_date failed: ") +
+            toolbox::date_status_message(status));
+    }
+    return serial_date;
+}
+
+int JapaneseWarekiCalendar::to_serial_date(const std::string& date_str,
+                                           const char* format,
+                                           bool strict) const {
+    int serial_date = 0;
+    const toolbox::DateStatus status = JapaneseWarekiCalendar::try_parse(
+        date_str, format, strict, serial_date);
+    if (status != toolbox::DATE_OK) {
+        throw std::invalid_argument(
+            std::string("JapaneseWarekiCalendar::to_serial_date failed: ") +
+            toolbox::date_status_message(status));
+    }
+    return serial_date;
+}
+
+int JapaneseWarekiCalendar::to_serial_date(const char* begin,
+        const char* end, const char* format, bool strict) const {
+    int serial_date = 0;
+    const toolbox::DateStatus status = JapaneseWarekiCalendar::try_parse(
+        begin, end, format, strict, serial_date);
+    if (status != toolbox::DATE_OK) {
         throw std::invalid_argument(
-            "JapaneseWarekiCalendar::to_serial_date failed: incomplete "
-            "date components");
+            std::string("JapaneseWarekiCalendar::to_serial_date failed: ") +
+            toolbox::date_status_message(status));
+    }
+    return serial_date;
+}
+
+int JapaneseWarekiCalendar::to_serial_date(const char* begin,
+        const char* end, const char* format, bool strict,
+        std::size_t& consumed) const {
+    int serial_date = 0;
+    const toolbox::DateStatus status = JapaneseWarekiCalendar::try_parse(
+        begin, end, format, strict, serial_date, consumed);
+    if (status != toolbox::DATE_OK) {
+        throw std::invalid_argument(
+            std::string("JapaneseWarekiCalendar::to_serial_date failed: ") +
+            toolbox::date_status_message(status));
+    }
+    return serial_date;
+}
+
+toolbox::DateStatus JapaneseWarekiCalendar::try_to_serial_date(
+        int era, int year, int month, int day, int& serial_date) const {
+    const std::vector<EraRange>& ranges = era_ranges();
+    if (era < 0 || static_cast<std::size_t>(era) >= ranges.size()) {
+        return toolbox::DATE_INVALID_ERA;
+    }
+    const EraRange &er = ranges[era];
+    if (er.start_serial == std::numeric_limits<int>::min()) {
+        // era start unknown
+        return toolbox::DATE_INVALID_ERA;
+    }
+
+    if (year <= 0) {
+        return toolbox::DATE_INVALID_YEAR;
+    }
+
+    // Use embedded EraMetadata to determine which calendar to use and to
+    // map the era-relative year to an absolute calendar year.
+    const toolbox::EraMetadata &md = toolbox::get_era_metadata(
+        static_cast<toolbox::JapaneseEra>(era));
+
+    // Era-relative year N corresponds to calendar year: start.year + (N - 1).
+    int target_year = md.start.year + (year - 1);
+
+    int serial = 0;
+    toolbox::DateStatus status;
+    if (md.start.calendar == toolbox::ERA_CALENDAR_JULIAN) {
+        int era_flag = (target_year <= 0)
+            ? toolbox::JulianCalendar::BC
+            : toolbox::JulianCalendar::AD;
+        status = toolbox::JulianCalendar().try_to_serial_date(
+            era_flag, target_year, month, day, serial);
+    } else {
+        int era_flag = (target_year <= 0)
+            ? toolbox::GregorianCalendar::BC
+            : toolbox::GregorianCalendar::AD;
+        status = toolbox::GregorianCalendar().try_to_serial_date(
+            era_flag, target_year, month, day, serial);
+    }
+    if (status != toolbox::DATE_OK) {
+        return status;
     }
 
-    if (pos < input.size()) {
-        if (allow_trailing_whitespace) {
-            while (pos < input.size() &&
-                   std::isspace(static_cast<unsigned char>(input[pos]))) {
+    // Validate against era bounds: start (inclusive) and end (inclusive if
+    // set).
+    if (serial < er.start_serial) {
+        return toolbox::DATE_OUT_OF_RANGE;
+    }
+    if (er.end_serial != std::numeric_limits<int>::max() &&
+        serial > er.end_serial) {
+        return toolbox::DATE_OUT_OF_RANGE;
+    }
+    serial_date = serial;
+    return toolbox::DATE_OK;
+}
+
+toolbox::DateStatus JapaneseWarekiCalendar::try_parse(
+        const std::string& date_str, const char* format, bool strict,
+        int& serial_date) const {
+    return JapaneseWarekiCalendar::try_parse(date_str.data(),
+        date_str.data() + date_str.size(), format, strict, serial_date);
+}
+
+toolbox::DateStatus JapaneseWarekiCalendar::try_parse(const char* begin,
+        const char* end, const char* format, bool strict,
+        int& serial_date) const {
+    if (!format) {
+        return toolbox::DATE_INVALID_FORMAT;
+    }
+    ScannedDate date;
+    std::size_t pos = 0;
+    const toolbox::DateStatus status = scan_date(begin, end, format, date,
+        pos);
+    if (status != toolbox::DATE_OK) {
+        return status;
+    }
+
+    const std::size_t size = end - begin;
+    if (pos < size) {
+        if (!strict) {
+            // trailing whitespace is allowed
+            while (pos < size &&
+                   std::isspace(static_cast<unsigned char>(begin[pos]))) {
                 ++pos;
             }
         }
-        if (pos != input.size()) {
-            throw std::invalid_argument(
-                "JapaneseWarekiCalendar::to_serial_date failed: trailing "
-                "characters remain in date_str");
+        if (pos != size) {
+            // trailing characters remain in the input
+            return toolbox::DATE_NO_MATCH;
         }
     }
 
-    if (era_value == toolbox::END_OF_ERA) {
-        throw std::invalid_argument(
-            "JapaneseWarekiCalendar::to_serial_date failed: era missing");
-    }
+    return JapaneseWarekiCalendar::try_to_serial_date(
+        static_cast<int>(date.era), date.year, date.month, date.day,
+        serial_date);
+}
 
-    return to_serial_date(static_cast<int>(era_value), year, month, day);
+toolbox::DateStatus JapaneseWarekiCalendar::try_parse(const char* begin,
+        const char* end, const char* format, bool strict, int& serial_date,
+        std::size_t& consumed) const {
+    (void)strict;  // only the trailing whitespace of a whole input is lenient
+    if (!format) {
+        return toolbox::DATE_INVALID_FORMAT;
+    }
+    ScannedDate date;
+    std::size_t pos = 0;
+    toolbox::DateStatus status = scan_date(begin, end, format, date, pos);
+    if (status != toolbox::DATE_OK) {
+        return status;
+    }
+    status = JapaneseWarekiCalendar::try_to_serial_date(
+        static_cast<int>(date.era), date.year, date.month, date.day,
+        serial_date);
+    if (status == toolbox::DATE_OK) {
+        consumed = pos;
+    }
+    return status;
 }
 
 void JapaneseWarekiCalendar::from_serial_date(int serial_date,
@@ -378,39 +549,20 @@ void JapaneseWarekiCalendar::from_serial_date(int serial_date,
                                               int& year,
                                               int& month,
                                               int& day) const {
-    const std::vector<EraRange> ranges = load_era_ranges();
-    // find matching era(s)
-    std::vector<const EraRange*> matches;
-    for (std::size_t i = 0; i < ranges.size(); ++i) {
-        const EraRange &er = ranges[i];
-        if (er.start_serial == std::numeric_limits<int>::min()) continue;
-        int s = er.start_serial;
-        int e = er.end_serial == std::numeric_limits<int>::max()
-            ? std::numeric_limits<int>::max()
-            : er.end_serial;
-        if (serial_date >= s && serial_date <= e) {
-            matches.push_back(&er);
-        }
-    }
-    if (matches.empty()) {
+    // Overlapping eras (Nanboku-cho) are already resolved in favour of the
+    // southern court by the index.
+    const EraRange *chosen = find_era_range(serial_date);
+    if (!chosen) {
         throw std::out_of_range(
             "JapaneseWarekiCalendar::from_serial_date failed: era not found for"
             " serial date");
     }
-    // If multiple matches (Nanboku-cho), prefer southern court
-    const EraRange *chosen = matches.back();
-    for (std::size_t i = 0; i < matches.size(); ++i) {
-        if (matches[matches.size() - 1 - i]->is_southern) {
-            chosen = matches[matches.size() - 1 - i];
-            break;
-        }
-    }
     // era: return the ordinal index of the era (which-era), not BC/AD.
     era = static_cast<int>(chosen->era);
 
     // Compute year/month/day relative to the era start.
     // Era start serial is available in chosen->start_serial (from
-    // load_era_ranges). Convert both start_serial and serial_date to
+    // era_ranges()). Convert both start_serial and serial_date to
     // Gregorian Y/M/D and compute offset in years. Year is 1-based: the
     // start date is year 1.
     toolbox::GregorianCalendar greg;
@@ -419,12 +571,9 @@ void JapaneseWarekiCalendar::from_serial_date(int serial_date,
     int s_y = 0, s_m = 0, s_d = 0;
     int g_y = 0, g_m = 0, g_d = 0;
 
-    const int greg_start = greg.to_serial_date(
-        toolbox::GregorianCalendar::AD, 1582, 10, 15);
-
     // start_serial should be valid here (we skipped entries with unknown
     // start).
-    if (serial_date < greg_start) {
+    if (serial_date < kBeginGregorian) {
         julian.from_serial_date(chosen->start_serial, dummy_era, s_y, s_m, s_d);
         julian.from_serial_date(serial_date, dummy_era, g_y, g_m, g_d);
     } else {
@@ -446,12 +595,34 @@ void JapaneseWarekiCalendar::from_serial_date(int serial_date,
         throw std::invalid_argument(
             "JapaneseWarekiCalendar::from_serial_date failed: format is null");
     }
+    JapaneseWarekiCalendar::from_serial_date(serial_date, date_str,
+                                             DateFormat(format));
+}
+
+void JapaneseWarekiCalendar::from_serial_date(int serial_date,
+                                              std::string& date_str,
+                                              const DateFormat& format) const {
+    format_to_string(date_str, [&](char* buf, std::size_t cap) {
+        return JapaneseWarekiCalendar::format_to(serial_date, buf, cap,
+                                                 format);
+    });
+}
+
+std::size_t JapaneseWarekiCalendar::format_to(int serial_date,
+                                              char* buf,
+                                              std::size_t cap,
+                                              const DateFormat& format) const {
+    if (format.uses(DateFormat::WEEKDAY)) {
+        throw std::invalid_argument(
+            "JapaneseWarekiCalendar::from_serial_date failed: "
+            "invalid format specifier");
+    }
     int era, year, month, day;
     try {
         from_serial_date(serial_date, era, year, month, day);
     } catch (std::out_of_range &e) {
         // Need to produce an error message including adjacent era ranges
-        const std::vector<EraRange> ranges = load_era_ranges();
+        const std::vector<EraRange>& ranges = era_ranges();
         // find surrounding eras
         const EraRange *prev = NULL;
         const EraRange *next = NULL;
@@ -472,61 +643,44 @@ void JapaneseWarekiCalendar::from_serial_date(int serial_date,
             "no era for date. ";
         if (prev) {
             msg += "Previous era: ";
-            msg += prev->name_kanji.empty() ? "(unknown)" : prev->name_kanji;
+            msg += *prev->name_kanji ? prev->name_kanji : "(unknown)";
             msg += "; ";
         }
         if (next) {
             msg += "Next era: ";
-            msg += next->name_kanji.empty() ? "(unknown)" : next->name_kanji;
+            msg += *next->name_kanji ? next->name_kanji : "(unknown)";
         }
         throw std::out_of_range(msg);
     }
     // Format using simple replacements: %E -> era kanji, %Y/%y -> year,
     // %M/%m -> month, %D/%d -> day
-    std::string out;
-    for (std::size_t i = 0; format[i]; ++i) {
-        if (format[i] == '%') {
-            char c = format[++i];
-            switch (c) {
-                case 'E':
-                case 'e': {
-                    out += era_to_kanji(static_cast<JapaneseEra>(era));
-                    break;
-                }
-                case 'Y':
-                case 'y': {
-                    std::ostringstream ss;
-                    ss << year;
-                    out += ss.str();
-                    break;
-                }
-                case 'M':
-                case 'm': {
-                    std::ostringstream ss;
-                    ss << month;
-                    out += ss.str();
-                    break;
-                }
-                case 'D':
-                case 'd': {
-                    std::ostringstream ss;
-                    ss << day;
-                    out += ss.str();
-                    break;
-                }
-                case '%':
-                    out += '%';
-                    break;
-                default:
-                    throw std::invalid_argument(
-                        "JapaneseWarekiCalendar::from_serial_date failed: "
-                        "invalid format specifier");
-            }
-        } else {
-            out += format[i];
+    const std::vector<DateFormat::Token>& tokens = format.tokens();
+    FormatBuffer out(buf, cap);
+    for (std::size_t i = 0; i < tokens.size(); ++i) {
+        const DateFormat::Token& token = tokens[i];
+        switch (token.kind) {
+            case DateFormat::LITERAL:
+                out.append(format.literals().data() + token.offset,
+                           token.length);
+                break;
+            case DateFormat::ERA:
+                out.append(get_era_metadata(
+                    static_cast<JapaneseEra>(era)).kanji);
+                break;
+            case DateFormat::YEAR:
+                out.append_int(year);
+                break;
+            case DateFormat::MONTH:
+                out.append_int(month);
+                break;
+            case DateFormat::DAY:
+                out.append_int(day);
+                break;
+            case DateFormat::WEEKDAY:
+                break;
         }
     }
-    date_str = out;
+    return out.finish();
 }
 
 void JapaneseWarekiCalendar::from_serial_date(int serial_date,
@@ -536,4 +690,221 @@ void JapaneseWarekiCalendar::from_serial_date(int serial_date,
     greg.from_serial_date(serial_date, day_of_week);
 }
 
+// The length of the Julian or Gregorian month that the era-relative month
+// falls in, like to_serial_date counting from the start year of the era. An
+// era may start or end within the month, and October 1582 skips from the 4th
+// to the 15th.
+int JapaneseWarekiCalendar::last_day_of_month(int era, int year,
+        int month) const {
+    const std::vector<EraRange>& ranges = era_ranges();
+    toolbox::DateStatus status = toolbox::DATE_OK;
+    if (era < 0 || static_cast<std::size_t>(era) >= ranges.size()
+        || ranges[era].start_serial == std::numeric_limits<int>::min()) {
+        status = toolbox::DATE_INVALID_ERA;
+    } else if (year <= 0) {
+        status = toolbox::DATE_INVALID_YEAR;
+    } else if (month < 1 || month > 12) {
+        status = toolbox::DATE_INVALID_MONTH;
+    }
+    if (status != toolbox::DATE_OK) {
+        throw std::out_of_range(
+            std::string("JapaneseWarekiCalendar::last_day_of_month failed: ")
+            + toolbox::date_status_message(status));
+    }
+    const toolbox::EraMetadata &md = toolbox::get_era_metadata(
+        static_cast<toolbox::JapaneseEra>(era));
+    const int target_year = md.start.year + (year - 1);
+    if (target_year < 1582 || (target_year == 1582 && month < 10)) {
+        return toolbox::julian_last_day_of_month(target_year, month);
+    }
+    return toolbox::gregorian_last_day_of_month(target_year, month);
+}
+
+// Months follow the Julian or Gregorian dates the eras are made of, and the
+// result takes the era in force on its date, so Heisei 31-04-30 + 1 month is
+// Reiwa 1-05-30. A day of October 1582 that the reform skipped (the 5th to
+// the 14th) counts as past the end of the Julian part of the month.
+DateStatus JapaneseWarekiCalendar::try_add_months(int serial_date,
+        int months, MonthPolicy policy, int& result) const {
+    if (!find_era_range(serial_date)) {
+        return toolbox::DATE_OUT_OF_RANGE;
+    }
+    const toolbox::YearMonthDay ymd = serial_date < kBeginGregorian
+        ? toolbox::julian_civil_from_days(serial_date)
+        : toolbox::gregorian_civil_from_days(serial_date);
+    int year = ymd.year;
+    int month = ymd.month;
+    int day = ymd.day;
+    if (!toolbox::shift_month(year, month, months, 12)) {
+        return toolbox::DATE_OUT_OF_RANGE;
+    }
+    int shifted = 0;
+    if (year < 1582 || (year == 1582 && month < 10)) {
+        const toolbox::DateStatus status = toolbox::apply_month_policy(policy,
+            toolbox::julian_last_day_of_month(year, month), day);
+        if (status != toolbox::DATE_OK) {
+            return status;
+        }
+        shifted = toolbox::julian_days_from_civil(year, month, 1) + (day - 1);
+    } else if (year == 1582 && month == 10 && day < 15) {
+        const toolbox::DateStatus status = toolbox::apply_month_policy(policy,
+            4, day);
+        if (status != toolbox::DATE_OK) {
+            return status;
+        }
+        shifted = day <= 4 ? toolbox::julian_days_from_civil(year, month, day)
+            : kBeginGregorian + (day - 5);
+    } else {
+        const toolbox::DateStatus status = toolbox::apply_month_policy(policy,
+            toolbox::gregorian_last_day_of_month(year, month), day);
+        if (status != toolbox::DATE_OK) {
+            return status;
+        }
+        shifted = toolbox::gregorian_days_from_civil(year, month, 1)
+            + (day - 1);
+    }
+    if (!find_era_range(shifted)) {
+        return toolbox::DATE_OUT_OF_RANGE;
+    }
+    result = shifted;
+    return toolbox::DATE_OK;
+}
+
+toolbox::DateStatus JapaneseWarekiCalendar::try_add_years(int serial_date,
+        int years, toolbox::MonthPolicy policy, int& result) const {
+    if (years > INT_MAX / 12 || years < INT_MIN / 12) {
+        return toolbox::DATE_OUT_OF_RANGE;
+    }
+    return JapaneseWarekiCalendar::try_add_months(serial_date, years * 12,
+        policy, result);
+}
+
+// Weeks are counted in the Julian or Gregorian month that the era-relative
+// month falls in, as last_day_of_month measures it; October 1582 runs from
+// the 1st to the 31st with the reform's gap left out, and weekdays carry on
+// across it. The day found must belong to the era.
+toolbox::DateStatus JapaneseWarekiCalendar::try_nth_weekday_of_month(int era,
+        int year, int month, int weekday, int nth, int& serial_date) const {
+    const std::vector<EraRange>& ranges = era_ranges();
+    if (era < 0 || static_cast<std::size_t>(era) >= ranges.size()
+        || ranges[era].start_serial == std::numeric_limits<int>::min()) {
+        return toolbox::DATE_INVALID_ERA;
+    }
+    if (year <= 0) {
+        return toolbox::DATE_INVALID_YEAR;
+    }
+    if (month < 1 || month > 12) {
+        return toolbox::DATE_INVALID_MONTH;
+    }
+    const toolbox::EraMetadata &md = toolbox::get_era_metadata(
+        static_cast<toolbox::JapaneseEra>(era));
+    const int target_year = md.start.year + (year - 1);
+    int first = 0;
+    int days = 0;
+    if (target_year < 1582 || (target_year == 1582 && month <= 10)) {
+        first = toolbox::julian_days_from_civil(target_year, month, 1);
+        days = toolbox::julian_last_day_of_month(target_year, month);
+        if (target_year == 1582 && month == 10) {
+            days = kBeginGregorian - first + 17;  // the 1st-4th, 15th-31st
+        }
+    } else {
+        first = toolbox::gregorian_days_from_civil(target_year, month, 1);
+        days = toolbox::gregorian_last_day_of_month(target_year, month);
+    }
+    const int offset = toolbox::nth_weekday_offset(
+        toolbox::weekday_from_days(first), days, weekday, nth);
+    if (offset < 0) {
+        return toolbox::DATE_INVALID_DAY;
+    }
+    const EraRange &er = ranges[era];
+    const int found = first + offset;
+    if (found < er.start_serial
+        || (er.end_serial != std::numeric_limits<int>::max()
+            && found > er.end_serial)) {
+        return toolbox::DATE_OUT_OF_RANGE;
+    }
+    serial_date = found;
+    return toolbox::DATE_OK;
+}
+
+toolbox::DateStatus JapaneseWarekiCalendar::try_weekday_on_or_after(
+        int serial_date, int weekday, int& result) const {
+    if (weekday < 0 || weekday > 6) {
+        return toolbox::DATE_INVALID_DAY;
+    }
+    if (!find_era_range(serial_date) || serial_date > INT_MAX - 6) {
+        return toolbox::DATE_OUT_OF_RANGE;
+    }
+    const int found = toolbox::weekday_on_or_after(serial_date, weekday);
+    if (!find_era_range(found)) {
+        return toolbox::DATE_OUT_OF_RANGE;
+    }
+    result = found;
+    return toolbox::DATE_OK;
+}
+
+toolbox::DateStatus JapaneseWarekiCalendar::try_weekday_on_or_before(
+        int serial_date, int weekday, int& result) const {
+    if (weekday < 0 || weekday > 6) {
+        return toolbox::DATE_INVALID_DAY;
+    }
+    if (!find_era_range(serial_date)) {
+        return toolbox::DATE_OUT_OF_RANGE;
+    }
+    const int found = toolbox::weekday_on_or_before(serial_date, weekday);
+    if (!find_era_range(found)) {
+        return toolbox::DATE_OUT_OF_RANGE;
+    }
+    result = found;
+    return toolbox::DATE_OK;
+}
+
+void JapaneseWarekiCalendar::to_serial_dates(const int* eras, const int* years,
+        const int* months, const int* days, std::size_t count,
+        int* serial_dates) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        serial_dates[i] = JapaneseWarekiCalendar::to_serial_date(eras[i],
+            years[i], months[i], days[i]);
+    }
+}
+
+void JapaneseWarekiCalendar::from_serial_dates(const int* serial_dates,
+        std::size_t count, int* eras, int* years, int* months,
+        int* days) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        JapaneseWarekiCalendar::from_serial_date(serial_dates[i], eras[i],
+            years[i], months[i], days[i]);
+    }
+}
+
+void JapaneseWarekiCalendar::add_months(const int* serial_dates,
+        std::size_t count, int months, toolbox::MonthPolicy policy,
+        int* results) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        const toolbox::DateStatus status =
+            JapaneseWarekiCalendar::try_add_months(serial_dates[i],
+                months, policy, results[i]);
+        if (status != toolbox::DATE_OK) {
+            throw std::out_of_range(
+                std::string("JapaneseWarekiCalendar::add_months failed: ")
+                + toolbox::date_status_message(status));
+        }
+    }
+}
+
+void JapaneseWarekiCalendar::add_years(const int* serial_dates,
+        std::size_t count, int years, toolbox::MonthPolicy policy,
+        int* results) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        const toolbox::DateStatus status =
+            JapaneseWarekiCalendar::try_add_years(serial_dates[i],
+                years, policy, results[i]);
+        if (status != toolbox::DATE_OK) {
+            throw std::out_of_range(
+                std::string("JapaneseWarekiCalendar::add_years failed: ")
+                + toolbox::date_status_message(status));
+        }
+    }
+}
+
 }  // namespace toolbox
@@ -2,24 +2,45 @@
 
 #include <iostream>
 #include <iomanip>
-#include <sstream>
 #include <string>
 #include <stdexcept>
 #include <cstring>
+#include <climits>
+#include <vector>
 #include <cctype>
 #include <algorithm>
 
 #include <string.hpp>
+#include <calendar_system/CalendarArithmetic.hpp>
+#include <calendar_system/DateParser.hpp>
+#include <calendar_system/FormatBuffer.hpp>
 
 namespace {
 
-bool is_leap(int year);
-int last_day_of_month(int year, int month);
-std::string to_string_Ee(int era, bool uppercase);
-std::string to_string_Yy(int year, bool uppercase);
-std::string to_string_Mm(int month, bool uppercase);
-std::string to_string_Dd(int day, bool uppercase);
-std::string to_string_Ww(int day_of_week, bool uppercase);
+toolbox::DateStatus parsed_to_serial(int era, int year, int month, int day,
+    int& serial_date);
+void write_Ee(toolbox::FormatBuffer& out, int era, bool uppercase);
+void write_Yy(toolbox::FormatBuffer& out, int year, bool uppercase);
+void write_Mm(toolbox::FormatBuffer& out, int month, bool uppercase);
+void write_Dd(toolbox::FormatBuffer& out, int day, bool uppercase);
+void write_Ww(toolbox::FormatBuffer& out, int day_of_week, bool uppercase);
+
+const char* const kEraNamesUpper[] = {
+    /* [toolbox::JulianCalendar::BC] = */ "B.C.",
+    /* [toolbox::JulianCalendar::AD] = */ "A.D.",
+};
+const char* const kEraNamesLower[] = {
+    /* [toolbox::JulianCalendar::BC] = */ "BC",
+    /* [toolbox::JulianCalendar::AD] = */ "AD",
+};
+
+const toolbox::DateParserSpec kParserSpec = {
+    kEraNamesUpper, kEraNamesLower, toolbox::JulianCalendar::END_OF_ERA,
+    toolbox::JulianCalendar::AD,
+    NULL, 0,
+    NULL, 0, 0,
+    parsed_to_serial,
+};
 
 }  // namespace
 
@@ -40,135 +61,117 @@ JulianCalendar& JulianCalendar::operator=(const JulianCalendar& other) {
 JulianCalendar::~JulianCalendar() {
 }
 
-int JulianCalendar::to_serial_date(
-    int era, int year, int month, int day) const {
-    const int julian_bc45_1_1_serial = -735601;
-    const int days_before_month[] = {
-        0,    // dummy
-        0,    // January
-        31,   // February
-        59,   // March
-        90,   // April
-        120,  // May
-        151,  // June
-        181,  // July
-        212,  // August
-        243,  // September
-        273,  // October
-        304,  // November
-        334,  // December
-    };
+int JulianCalendar::to_serial_date(int era,
+        int year, int month, int day) const {
+    int serial_date = 0;
+    const DateStatus status = JulianCalendar::try_to_serial_date(era,
+        year, month, day, serial_date);
+    if (status != DATE_OK) {
+        throw std::out_of_range(
+            std::string("JulianCalendar::to_serial_date failed: ")
+            + date_status_message(status));
+    }
+    return serial_date;
+}
+
+int JulianCalendar::to_serial_date(const std::string& date_str,
+        const char* format, bool strict) const {
+    int serial_date = 0;
+    const DateStatus status = JulianCalendar::try_parse(date_str, format,
+        strict, serial_date);
+    if (status != DATE_OK) {
+        throw std::invalid_argument(
+            std::string("JulianCalendar::to_serial_date failed: ")
+            + date_status_message(status));
+    }
+    return serial_date;
+}
 
+int JulianCalendar::to_serial_date(const char* begin, const char* end,
+        const char* format, bool strict) const {
+    int serial_date = 0;
+    const DateStatus status = JulianCalendar::try_parse(begin, end,
+        format, strict, serial_date);
+    if (status != DATE_OK) {
+        throw std::invalid_argument(
+            std::string("JulianCalendar::to_serial_date failed: ")
+            + date_status_message(status));
+    }
+    return serial_date;
+}
+
+int JulianCalendar::to_serial_date(const char* begin, const char* end,
+        const char* format, bool strict, std::size_t& consumed) const {
+    int serial_date = 0;
+    const DateStatus status = JulianCalendar::try_parse(begin, end,
+        format, strict, serial_date, consumed);
+    if (status != DATE_OK) {
+        throw std::invalid_argument(
+            std::string("JulianCalendar::to_serial_date failed: ")
+            + date_status_message(status));
+    }
+    return serial_date;
+}
+
+DateStatus JulianCalendar::try_to_serial_date(int era, int year,
+        int month, int day, int& serial_date) const {
     if (era < 0 || era >= JulianCalendar::END_OF_ERA) {
-        throw std::out_of_range(
-            "JulianCalendar::to_serial_date failed: Invalid era");
+        return DATE_INVALID_ERA;
     }
     if (year <= 0) {
-        throw std::out_of_range(
-            "JulianCalendar::to_serial_date failed: year must be positive");
+        return DATE_INVALID_YEAR;
     }
     if (era == JulianCalendar::BC) {
         year = 1 - year;
     }
     if (month < 1 || month > 12) {
-        throw std::out_of_range(
-            "JulianCalendar::to_serial_date failed: month must be in 1..12");
+        return DATE_INVALID_MONTH;
     }
-    if (day < 1 || day > last_day_of_month(year, month)) {
-        throw std::out_of_range(
-            "JulianCalendar::to_serial_date failed: day is out of range");
+    if (day < 1 || day > julian_last_day_of_month(year, month)) {
+        return DATE_INVALID_DAY;
     }
+    serial_date = julian_days_from_civil(year, month, day);
+    return DATE_OK;
+}
 
-    int count_leaps = 0;
-    if (year >= 8) {
-        count_leaps = 12 + (year - 1) / 4;
-    } else if (year <= -44) {
-        count_leaps = (year + 44) / 4;
-    } else if (year >= -43 && year <= -7) {
-        count_leaps = (year + 45) / 3;
-    } else {
-        count_leaps = 13;
+DateStatus JulianCalendar::try_parse(const std::string& date_str,
+        const char* format, bool strict, int& serial_date) const {
+    return JulianCalendar::try_parse(date_str.data(),
+        date_str.data() + date_str.size(), format, strict, serial_date);
+}
+
+DateStatus JulianCalendar::try_parse(const char* begin, const char* end,
+        const char* format, bool strict, int& serial_date) const {
+    if (!format) {
+        return DATE_INVALID_FORMAT;
     }
-    int total_days = (year + 44) * 365 + count_leaps;
-    total_days += days_before_month[month] + !!(month > 2 && is_leap(year));
-    total_days += day - 1;
-    return total_days + julian_bc45_1_1_serial;
+    return parse_date(begin, end, format, kParserSpec, strict, serial_date);
 }
 
-int JulianCalendar::to_serial_date(
-    const std::string& date_str, const char* format, bool strict) const {
+DateStatus JulianCalendar::try_parse(const char* begin, const char* end,
+        const char* format, bool strict, int& serial_date,
+        std::size_t& consumed) const {
     if (!format) {
-        throw std::invalid_argument("JulianCalendar::to_serial_date failed: "
-            "format is null");
-    }
-    int era = toolbox::JulianCalendar::AD;
-    int year = 0, month = 0, day = 0;
-    bool all_found = false;
-    int serial = 0;
-    parse_formatted_date(date_str, 0, format,
-        era, false,
-        year, false,
-        month, false,
-        day, false,
-        all_found,
-        serial,
-        strict);
-    if (!all_found) {
-        throw std::invalid_argument("JulianCalendar::to_serial_date failed: "
-            "date_str does not match format");
-    }
-    return serial;
+        return DATE_INVALID_FORMAT;
+    }
+    const char* stop;
+    const DateStatus status = parse_date_prefix(begin, end, format,
+        kParserSpec, strict, serial_date, stop);
+    if (status == DATE_OK) {
+        consumed = stop - begin;
+    }
+    return status;
 }
 
 void JulianCalendar::from_serial_date(
     int serial_date, int& era, int& year, int& month, int& day) const {
-    const int julian_bc45_3_1_serial = -735541;  // BC45/3/1(Julian)
-    const int julian_bc7_3_1_serial = -721659;  // BC7/3/1(Julian)
-    const int julian_ad4_3_1_serial = -717279;  // AD4/3/1(Julian)
-    if (serial_date < julian_bc45_3_1_serial
-        || serial_date > julian_ad4_3_1_serial) {
-        int z = serial_date - julian_bc45_3_1_serial;
-        const int era_year = (z >= 0 ? z : z - 1460) / 1461;
-        const unsigned int doe = static_cast<unsigned int>(z - era_year * 1461);
-        const unsigned int yoe = (doe - doe / 1460) / 365;
-        year = era_year * 4 + static_cast<int>(yoe) - 44;
-        const unsigned int doy = doe - yoe * 365;
-        const unsigned int mp = (5 * doy + 2) / 153;
-        day = doy - (153 * mp + 2) / 5 + 1;
-        month = mp < 10 ? mp + 3 : mp - 9;
-        year += !!(month <= 2);
-        era = year <= 0 ? JulianCalendar::BC : JulianCalendar::AD;
-        if (year <= 0) {
-            year = 1 - year;
-        }
-    } else if (serial_date >= julian_bc7_3_1_serial) {
-        int z = serial_date - julian_bc7_3_1_serial;
-        const unsigned int yoe = z / 365;
-        year = static_cast<int>(yoe) - 7;
-        const unsigned int doy = z - yoe * 365;
-        const unsigned int mp = (5 * doy + 2) / 153;
-        day = doy - (153 * mp + 2) / 5 + 1;
-        month = mp < 10 ? mp + 3 : mp - 9;
-        year += !!(month <= 2);
-        era = year <= 0 ? JulianCalendar::BC : JulianCalendar::AD;
-        if (year <= 0) {
-            year = 1 - year;
-        }
-    } else {
-        int z = serial_date - julian_bc45_3_1_serial;
-        const int era_year = (z >= 0 ? z : z - 1095) / 1096;
-        const unsigned int doe = static_cast<unsigned int>(z - era_year * 1096);
-        const unsigned int yoe = doe / 365;
-        year = era_year * 3 + static_cast<int>(yoe) - 45;
-        const unsigned int doy = doe - yoe * 365;
-        const unsigned int mp = (5 * doy + 2) / 153;
-        day = doy - (153 * mp + 2) / 5 + 1;
-        month = mp < 10 ? mp + 3 : mp - 9;
-        year += !!(month <= 2);
-        era = year <= 0 ? JulianCalendar::BC : JulianCalendar::AD;
-        if (year <= 0) {
-            year = 1 - year;
-        }
+    const YearMonthDay ymd = julian_civil_from_days(serial_date);
+    year = ymd.year;
+    month = ymd.month;
+    day = ymd.day;
+    era = year <= 0 ? JulianCalendar::BC : JulianCalendar::AD;
+    if (year <= 0) {
+        year = 1 - year;
     }
 }
 
@@ -178,418 +181,191 @@ void JulianCalendar::from_serial_date(int serial_date,
         throw std::invalid_argument(
             "JulianCalendar::from_serial_date failed: format is null");
     }
-    int era, year, month, day;
-    from_serial_date(serial_date, era, year, month, day);
-    int day_of_week;
-    from_serial_date(serial_date, day_of_week);
-    std::ostringstream ss;
-    for (std::size_t i = 0; format[i]; ++i) {
-        if (format[i] == '%') {
-            switch (format[++i]) {
-                case 'E':
-                case 'e':
-                    ss << to_string_Ee(era, std::isupper(format[i]));
-                    break;
-                case 'Y':
-                case 'y':
-                    ss << to_string_Yy(year, std::isupper(format[i]));
-                    break;
-                case 'M':
-                case 'm':
-                    ss << to_string_Mm(month, std::isupper(format[i]));
-                    break;
-                case 'D':
-                case 'd':
-                    ss << to_string_Dd(day, std::isupper(format[i]));
-                    break;
-                case 'W':
-                case 'w':
-                    ss << to_string_Ww(day_of_week, std::isupper(format[i]));
-                    break;
-                case '%':
-                    ss << '%';
-                    break;
-                default:
-                    throw std::invalid_argument(
-                        "JulianCalendar::from_serial_date failed: "
-                        "Invalid format specifier");
-            }
-        } else {
-            ss << format[i];
-        }
-    }
-    date_str = ss.str();
+    JulianCalendar::from_serial_date(serial_date, date_str, DateFormat(format));
 }
 
 void JulianCalendar::from_serial_date(int serial_date,
-        int& day_of_week) const {
-    day_of_week = serial_date >= -4 ?
-            (serial_date + 4) % 7 : (serial_date + 5) % 7 + 6;
-}
-
-void JulianCalendar::parse_formatted_date(const std::string& date_str,
-    std::size_t pos,
-    const char* format,
-    int& era, bool era_found,
-    int& year, bool year_found,
-    int& month, bool month_found,
-    int& day, bool day_found,
-    bool& all_found,
-    int& serial,
-    bool strict) const {
-    if (pos >= date_str.size() && !*format) {
-        if (year_found && month_found && day_found) {
-            try {
-                int ret = to_serial_date(era, year, month, day);
-                if (!all_found) {
-                    serial = ret;
-                }
-            } catch (std::exception &e) {
-                return;
-            }
-            if (all_found) {
-                throw std::invalid_argument(
-                    "JulianCalendar::parse_formatted_date failed: "
-                    "date_str is ambiguous");
-            }
-            all_found = true;
-        }
-        return;
-    }
-    if (pos >= date_str.size() || !*format) {
-        return;
-    }
-    if (date_str[pos] == format[0] && format[0] != '%') {
-        parse_formatted_date(date_str, pos + 1, format + 1,
-            era, era_found,
-            year, year_found,
-            month, month_found,
-            day, day_found,
-            all_found,
-            serial,
-            strict);
-        return;
-    }
-    if (format[0] != '%') {
-        return;
-    }
-    switch (format[1]) {
-        case 'E':
-        case 'e': {
-            if (era_found) {
-                throw std::invalid_argument(
-                    "JulianCalendar::parse_formatted_date failed: "
-                    "era is specified multiple times");
-            }
-            parse_Ee(date_str, pos, format,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
-        case 'Y':
-        case 'y': {
-            if (year_found) {
-                throw std::invalid_argument(
-                    "JulianCalendar::parse_formatted_date failed: "
-                    "year is specified multiple times");
-            }
-            parse_Yy(date_str, pos, format,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
-        case 'M':
-        case 'm': {
-            if (month_found) {
-                throw std::invalid_argument(
-                    "JulianCalendar::parse_formatted_date failed: "
-                    "month is specified multiple times");
-            }
-            parse_Mm(date_str, pos, format,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
-        case 'D':
-        case 'd': {
-            if (day_found) {
-                throw std::invalid_argument(
-                    "JulianCalendar::parse_formatted_date failed: "
-                    "day is specified multiple times");
-            }
-            parse_Dd(date_str, pos, format,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
-        case '%': {
-            if (date_str[pos] != '%') {
-                return;
-            }
-            parse_formatted_date(date_str, pos + 1, format + 2,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
-        default:
-            throw std::invalid_argument(
-                "JulianCalendar::parse_formatted_date failed: "
-                "Invalid format specifier: %" + toolbox::to_string(format[1]));
-    }
-}
-
-void JulianCalendar::parse_Ee(const std::string& date_str,
-    std::size_t pos,
-    const char* format,
-    int& era, bool era_found,
-    int& year, bool year_found,
-    int& month, bool month_found,
-    int& day, bool day_found,
-    bool& all_found,
-    int& serial,
-    bool strict
-) const {
-    (void)era_found;
-    const char* era_str_E[] = {
-        /* [toolbox::JulianCalendar::BC] = */ "B.C.",
-        /* [toolbox::JulianCalendar::AD] = */ "A.D.",
-    };
-    const char* era_str_e[] = {
-        /* [toolbox::JulianCalendar::BC] = */ "BC",
-        /* [toolbox::JulianCalendar::AD] = */ "AD",
-    };
-    for (int i = 0; i < toolbox::JulianCalendar::END_OF_ERA; ++i) {
-        const char* s = std::isupper(format[1]) ? era_str_E[i] : era_str_e[i];
-        const std::size_t len = std::strlen(s);
-        if (date_str.compare(pos, len, s) == 0) {
-            era = i;
-            parse_formatted_date(date_str, pos + len, format + 2,
-                era, true,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
+        std::string& date_str, const DateFormat& format) const {
+    format_to_string(date_str, [&](char* buf, std::size_t cap) {
+        return JulianCalendar::format_to(serial_date, buf, cap,
+            format);
+    });
+}
+
+std::size_t JulianCalendar::format_to(int serial_date, char* buf,
+        std::size_t cap, const DateFormat& format) const {
+    int era, year, month, day;
+    JulianCalendar::from_serial_date(serial_date, era, year, month, day);
+    int day_of_week = 0;
+    if (format.uses(DateFormat::WEEKDAY)) {
+        JulianCalendar::from_serial_date(serial_date, day_of_week);
     }
-    throw std::invalid_argument("JulianCalendar::parse_Ee failed: "
-        "era not found in date_str at position "
-        + toolbox::to_string(pos));
-}
-
-void JulianCalendar::parse_Yy(const std::string& date_str,
-    std::size_t pos,
-    const char* format,
-    int& era, bool era_found,
-    int& year, bool year_found,
-    int& month, bool month_found,
-    int& day, bool day_found,
-    bool& all_found,
-    int& serial,
-    bool strict
-) const {
-    (void)year_found;
-    if (std::isupper(format[1])) {
-        // %Y
-        if (date_str[pos] == '0') {
-            return;
-        }
-        for (std::size_t num_len = 1;
-            pos + num_len <= date_str.size(); ++num_len) {
-            if (!std::isdigit(date_str[pos + num_len - 1])) {
+    const std::vector<DateFormat::Token>& tokens = format.tokens();
+    FormatBuffer out(buf, cap);
+    for (std::size_t i = 0; i < tokens.size(); ++i) {
+        const DateFormat::Token& token = tokens[i];
+        switch (token.kind) {
+            case DateFormat::LITERAL:
+                out.append(format.literals().data() + token.offset,
+                    token.length);
                 break;
-            }
-            std::string year_str = date_str.substr(pos, num_len);
-            try {
-                year = toolbox::stoi(year_str);
-            } catch (std::exception &e) {
-                continue;
-            }
-            parse_formatted_date(date_str, pos + num_len, format + 2,
-                era, era_found,
-                year, true,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            if (all_found && !strict) {
-                return;
-            }
-        }
-    } else {
-        // %y
-        if (pos + 2 > date_str.size()) {
-            return;
-        }
-        std::string year_str = date_str.substr(pos, 2);
-        try {
-            year = toolbox::stoi(year_str);
-        } catch (std::exception &e) {
-            return;
-        }
-        parse_formatted_date(date_str, pos + 2, format + 2,
-            era, era_found,
-            year, true,
-            month, month_found,
-            day, day_found,
-            all_found,
-            serial,
-            strict);
-        return;
-    }
-}
-
-void JulianCalendar::parse_Mm(const std::string& date_str,
-    std::size_t pos,
-    const char* format,
-    int& era, bool era_found,
-    int& year, bool year_found,
-    int& month, bool month_found,
-    int& day, bool day_found,
-    bool& all_found,
-    int& serial,
-    bool strict
-) const {
-    (void)month_found;
-    if (std::isupper(format[1])) {
-        // %M
-        if (date_str[pos] == '0') {
-            return;
-        }
-        for (std::size_t num_len = 1;
-            pos + num_len <= date_str.size() && num_len <= 2; ++num_len) {
-            if (!std::isdigit(date_str[pos + num_len - 1])) {
+            case DateFormat::ERA:
+                write_Ee(out, era, token.uppercase);
                 break;
-            }
-            std::string month_str = date_str.substr(pos, num_len);
-            try {
-                month = toolbox::stoi(month_str);
-            } catch (std::exception &e) {
-                continue;
-            }
-            parse_formatted_date(date_str, pos + num_len, format + 2,
-                era, era_found,
-                year, year_found,
-                month, true,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            if (all_found && !strict) {
-                return;
-            }
-        }
-    } else {
-        // %m
-        if (pos + 2 > date_str.size()) {
-            return;
-        }
-        std::string month_str = date_str.substr(pos, 2);
-        try {
-            month = toolbox::stoi(month_str);
-        } catch (std::exception &e) {
-            return;
-        }
-        parse_formatted_date(date_str, pos + 2, format + 2,
-            era, era_found,
-            year, year_found,
-            month, true,
-            day, day_found,
-            all_found,
-            serial,
-            strict);
-        return;
-    }
-}
-
-void JulianCalendar::parse_Dd(const std::string& date_str,
-    std::size_t pos,
-    const char* format,
-    int& era, bool era_found,
-    int& year, bool year_found,
-    int& month, bool month_found,
-    int& day, bool day_found,
-    bool& all_found,
-    int& serial,
-    bool strict
-) const {
-    (void)day_found;
-    if (std::isupper(format[1])) {
-        // %D
-        if (date_str[pos] == '0') {
-            return;
-        }
-        for (std::size_t num_len = 1;
-            pos + num_len <= date_str.size() && num_len <= 2; ++num_len) {
-            if (!std::isdigit(date_str[pos + num_len - 1])) {
+            case DateFormat::YEAR:
+                write_Yy(out, year, token.uppercase);
+                break;
+            case DateFormat::MONTH:
+                write_Mm(out, month, token.uppercase);
+                break;
+            case DateFormat::DAY:
+                write_Dd(out, day, token.uppercase);
+                break;
+            case DateFormat::WEEKDAY:
+                write_Ww(out, day_of_week, token.uppercase);
                 break;
-            }
-            std::string day_str = date_str.substr(pos, num_len);
-            try {
-                day = toolbox::stoi(day_str);
-            } catch (std::exception &e) {
-                continue;
-            }
-            parse_formatted_date(date_str, pos + num_len, format + 2,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, true,
-                all_found,
-                serial,
-                strict);
-            if (all_found && !strict) {
-                return;
-            }
         }
-    } else {
-        // %d
-        if (pos + 2 > date_str.size()) {
-            return;
+    }
+    return out.finish();
+}
+
+void JulianCalendar::from_serial_date(int serial_date,
+        int& day_of_week) const {
+    day_of_week = weekday_from_days(serial_date);
+}
+
+int JulianCalendar::last_day_of_month(int era, int year, int month) const {
+    DateStatus status = DATE_OK;
+    if (era < 0 || era >= JulianCalendar::END_OF_ERA) {
+        status = DATE_INVALID_ERA;
+    } else if (year <= 0) {
+        status = DATE_INVALID_YEAR;
+    } else if (month < 1 || month > 12) {
+        status = DATE_INVALID_MONTH;
+    }
+    if (status != DATE_OK) {
+        throw std::out_of_range(
+            std::string("JulianCalendar::last_day_of_month failed: ")
+            + date_status_message(status));
+    }
+    if (era == JulianCalendar::BC) {
+        year = 1 - year;
+    }
+    return julian_last_day_of_month(year, month);
+}
+
+DateStatus JulianCalendar::try_add_months(int serial_date, int months,
+        MonthPolicy policy, int& result) const {
+    const YearMonthDay ymd = julian_civil_from_days(serial_date);
+    int year = ymd.year;
+    int month = ymd.month;
+    int day = ymd.day;
+    if (!shift_month(year, month, months, 12)) {
+        return DATE_OUT_OF_RANGE;
+    }
+    const DateStatus status = apply_month_policy(policy,
+        julian_last_day_of_month(year, month), day);
+    if (status != DATE_OK) {
+        return status;
+    }
+    result = julian_days_from_civil(year, month, 1) + (day - 1);
+    return DATE_OK;
+}
+
+DateStatus JulianCalendar::try_add_years(int serial_date, int years,
+        MonthPolicy policy, int& result) const {
+    if (years > INT_MAX / 12 || years < INT_MIN / 12) {
+        return DATE_OUT_OF_RANGE;
+    }
+    return JulianCalendar::try_add_months(serial_date, years * 12, policy,
+        result);
+}
+
+DateStatus JulianCalendar::try_nth_weekday_of_month(int era, int year,
+        int month, int weekday, int nth, int& serial_date) const {
+    int first = 0;
+    const DateStatus status = JulianCalendar::try_to_serial_date(era, year,
+        month, 1, first);
+    if (status != DATE_OK) {
+        return status;
+    }
+    const int days = JulianCalendar::last_day_of_month(era, year, month);
+    const int offset = nth_weekday_offset(weekday_from_days(first), days,
+        weekday, nth);
+    if (offset < 0) {
+        return DATE_INVALID_DAY;
+    }
+    serial_date = first + offset;
+    return DATE_OK;
+}
+
+DateStatus JulianCalendar::try_weekday_on_or_after(int serial_date,
+        int weekday, int& result) const {
+    if (weekday < 0 || weekday > 6) {
+        return DATE_INVALID_DAY;
+    }
+    if (serial_date > INT_MAX - 6) {
+        return DATE_OUT_OF_RANGE;
+    }
+    result = weekday_on_or_after(serial_date, weekday);
+    return DATE_OK;
+}
+
+DateStatus JulianCalendar::try_weekday_on_or_before(int serial_date,
+        int weekday, int& result) const {
+    if (weekday < 0 || weekday > 6) {
+        return DATE_INVALID_DAY;
+    }
+    if (serial_date < INT_MIN + 6) {
+        return DATE_OUT_OF_RANGE;
+    }
+    result = weekday_on_or_before(serial_date, weekday);
+    return DATE_OK;
+}
+
+void JulianCalendar::to_serial_dates(const int* eras, const int* years,
+        const int* months, const int* days, std::size_t count,
+        int* serial_dates) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        serial_dates[i] = JulianCalendar::to_serial_date(eras[i], years[i],
+            months[i], days[i]);
+    }
+}
+
+void JulianCalendar::from_serial_dates(const int* serial_dates,
+        std::size_t count, int* eras, int* years, int* months,
+        int* days) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        JulianCalendar::from_serial_date(serial_dates[i], eras[i], years[i],
+            months[i], days[i]);
+    }
+}
+
+void JulianCalendar::add_months(const int* serial_dates,
+        std::size_t count, int months, MonthPolicy policy,
+        int* results) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        const DateStatus status = JulianCalendar::try_add_months(
+            serial_dates[i], months, policy, results[i]);
+        if (status != DATE_OK) {
+            throw std::out_of_range(
+                std::string("JulianCalendar::add_months failed: ")
+                + date_status_message(status));
         }
-        std::string day_str = date_str.substr(pos, 2);
-        try {
-            day = toolbox::stoi(day_str);
-        } catch (std::exception &e) {
-            return;
+    }
+}
+
+void JulianCalendar::add_years(const int* serial_dates,
+        std::size_t count, int years, MonthPolicy policy,
+        int* results) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        const DateStatus status = JulianCalendar::try_add_years(
+            serial_dates[i], years, policy, results[i]);
+        if (status != DATE_OK) {
+            throw std::out_of_range(
+                std::string("JulianCalendar::add_years failed: ")
+                + date_status_message(status));
         }
-        parse_formatted_date(date_str, pos + 2, format + 2,
-            era, era_found,
-            year, year_found,
-            month, month_found,
-            day, true,
-            all_found,
-            serial,
-            strict);
-        return;
     }
 }
 
@@ -597,78 +373,55 @@ void JulianCalendar::parse_Dd(const std::string& date_str,
 
 namespace {
 
-bool is_leap(int year) {
-    return ((year >= 8 || year <= -44)  && year % 4 == 0)
-        || (year >= -43 && year <= -7 && (year - 2) % 3 == 0);
+toolbox::DateStatus parsed_to_serial(int era, int year, int month, int day,
+        int& serial_date) {
+    return toolbox::JulianCalendar().try_to_serial_date(era, year, month,
+        day, serial_date);
 }
 
-int last_day_of_month(int year, int month) {
-    const int last_day[12] = {
-        31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
-    };
-    if (month == 2 && is_leap(year)) {
-        return 29;
-    }
-    return last_day[month - 1];
-}
-
-std::string to_string_Ee(int era, bool uppercase) {
-    const char* era_str_E[] = {
-        /* [toolbox::JulianCalendar::BC] = */ "B.C.",
-        /* [toolbox::JulianCalendar::AD] = */ "A.D.",
-    };
-    const char* era_str_e[] = {
-        /* [toolbox::JulianCalendar::BC] = */ "BC",
-        /* [toolbox::JulianCalendar::AD] = */ "AD",
-    };
+void write_Ee(toolbox::FormatBuffer& out, int era, bool uppercase) {
     if (era < 0 || era >= toolbox::JulianCalendar::END_OF_ERA) {
         throw std::out_of_range(
-            "to_string_Ee failed: Invalid era: " + toolbox::to_string(era));
+            "write_Ee failed: Invalid era: " + toolbox::to_string(era));
     }
-    return uppercase ? era_str_E[era] : era_str_e[era];
+    out.append(uppercase ? kEraNamesUpper[era] : kEraNamesLower[era]);
 }
 
-std::string to_string_Yy(int year, bool uppercase) {
+void write_Yy(toolbox::FormatBuffer& out, int year, bool uppercase) {
     if (year <= 0) {
-        throw std::out_of_range("to_string_Yy failed: "
+        throw std::out_of_range("write_Yy failed: "
             "year must be positive and not zero");
     }
-    std::ostringstream oss;
     if (uppercase) {
-        oss << year;
+        out.append_int(year);
     } else {
-        oss << std::setw(2) << std::setfill('0') << (year % 100);
+        out.append_int(year % 100, 2);
     }
-    return oss.str();
 }
 
-std::string to_string_Mm(int month, bool uppercase) {
+void write_Mm(toolbox::FormatBuffer& out, int month, bool uppercase) {
     if (month < 1 || month > 12) {
-        throw std::out_of_range("to_string_Mm failed: month must be in 1..12");
+        throw std::out_of_range("write_Mm failed: month must be in 1..12");
     }
-    std::ostringstream oss;
     if (uppercase) {
-        oss << month;
+        out.append_int(month);
     } else {
-        oss << std::setw(2) << std::setfill('0') << month;
+        out.append_int(month, 2);
     }
-    return oss.str();
 }
 
-std::string to_string_Dd(int day, bool uppercase) {
+void write_Dd(toolbox::FormatBuffer& out, int day, bool uppercase) {
     if (day < 1 || day > 31) {
-        throw std::out_of_range("to_string_Dd failed: day must be in 1..31");
+        throw std::out_of_range("write_Dd failed: day must be in 1..31");
     }
-    std::ostringstream oss;
     if (uppercase) {
-        oss << day;
+        out.append_int(day);
     } else {
-        oss << std::setw(2) << std::setfill('0') << day;
+        out.append_int(day, 2);
     }
-    return oss.str();
 }
 
-std::string to_string_Ww(int day_of_week, bool uppercase) {
+void write_Ww(toolbox::FormatBuffer& out, int day_of_week, bool uppercase) {
     const char* day_of_week_str_W[] = {
         "Sunday", "Monday", "Tuesday", "Wednesday",
         "Thursday", "Friday", "Saturday"
@@ -678,10 +431,10 @@ std::string to_string_Ww(int day_of_week, bool uppercase) {
         "Thu.", "Fri.", "Sat."
     };
     if (day_of_week < 0 || day_of_week > 6) {
-        throw std::out_of_range("to_string_Ww: day_of_week must be in 0..6");
+        throw std::out_of_range("write_Ww: day_of_week must be in 0..6");
     }
-    return uppercase ?
-        day_of_week_str_W[day_of_week] : day_of_week_str_w[day_of_week];
+    out.append(uppercase ?
+        day_of_week_str_W[day_of_week] : day_of_week_str_w[day_of_week]);
 }
 
 }  // namespace
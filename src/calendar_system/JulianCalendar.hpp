@@ -16,70 +16,55 @@ class JulianCalendar : public ICalendarSystem {
     int to_serial_date(int era, int year, int month, int day) const;
     int to_serial_date(const std::string& date_str,
         const char* format, bool strict) const;
+    int to_serial_date(const char* begin, const char* end,
+        const char* format, bool strict) const;
+    int to_serial_date(const char* begin, const char* end,
+        const char* format, bool strict, std::size_t& consumed) const;
+    DateStatus try_to_serial_date(int era, int year, int month, int day,
+        int& serial_date) const;
+    DateStatus try_parse(const std::string& date_str, const char* format,
+        bool strict, int& serial_date) const;
+    DateStatus try_parse(const char* begin, const char* end,
+        const char* format, bool strict, int& serial_date) const;
+    DateStatus try_parse(const char* begin, const char* end,
+        const char* format, bool strict, int& serial_date,
+        std::size_t& consumed) const;
     void from_serial_date(int serial_date,
         int& era, int& year, int& month, int& day) const;
     void from_serial_date(int serial_date,
         std::string& date_str, const char* format) const;
+    void from_serial_date(int serial_date,
+        std::string& date_str, const DateFormat& format) const;
+    std::size_t format_to(int serial_date, char* buf, std::size_t cap,
+        const DateFormat& format) const;
     void from_serial_date(int serial_date,
         int& day_of_week) const;  // 0=Sun, 1=Mon, ..., 6=Sat
+    int last_day_of_month(int era, int year, int month) const;
+    DateStatus try_add_months(int serial_date, int months, MonthPolicy policy,
+        int& result) const;
+    DateStatus try_add_years(int serial_date, int years, MonthPolicy policy,
+        int& result) const;
+    DateStatus try_nth_weekday_of_month(int era, int year, int month,
+        int weekday, int nth, int& serial_date) const;
+    DateStatus try_weekday_on_or_after(int serial_date, int weekday,
+        int& result) const;
+    DateStatus try_weekday_on_or_before(int serial_date, int weekday,
+        int& result) const;
+    void to_serial_dates(const int* eras, const int* years,
+        const int* months, const int* days, std::size_t count,
+        int* serial_dates) const;
+    void from_serial_dates(const int* serial_dates, std::size_t count,
+        int* eras, int* years, int* months, int* days) const;
+    void add_months(const int* serial_dates, std::size_t count, int months,
+        MonthPolicy policy, int* results) const;
+    void add_years(const int* serial_dates, std::size_t count, int years,
+        MonthPolicy policy, int* results) const;
 
     enum Era {
         BC,
         AD,
         END_OF_ERA
     };
-
- private:
-    void parse_formatted_date(const std::string& date_str,
-        std::size_t pos,
-        const char* format,
-        int& era, bool era_found,
-        int& year, bool year_found,
-        int& month, bool month_found,
-        int& day, bool day_found,
-        bool& all_found,
-        int& serial,
-        bool strict) const;
-    void parse_Ee(const std::string& date_str,
-        std::size_t pos,
-        const char* format,
-        int& era, bool era_found,
-        int& year, bool year_found,
-        int& month, bool month_found,
-        int& day, bool day_found,
-        bool& all_found,
-        int& serial,
-        bool strict) const;
-    void parse_Yy(const std::string& date_str,
-        std::size_t pos,
-        const char* format,
-        int& era, bool era_found,
-        int& year, bool year_found,
-        int& month, bool month_found,
-        int& day, bool day_found,
-        bool& all_found,
-        int& serial,
-        bool strict) const;
-    void parse_Mm(const std::string& date_str,
-        std::size_t pos,
-        const char* format,
-        int& era, bool era_found,
-        int& year, bool year_found,
-        int& month, bool month_found,
-        int& day, bool day_found,
-        bool& all_found,
-        int& serial,
-        bool strict) const;
-    void parse_Dd(const std::string& date_str,
-        std::size_t pos,
-        const char* format,
-        int& era, bool era_found,
-        int& year, bool year_found,
-        int& month, bool month_found,
-        int& day, bool day_found,
-        bool& all_found,
-        int& serial,
-        bool strict) const;
 };
 
 }  // namespace toolbox
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <calendar_system/DateStatus.hpp>
+
+namespace toolbox {
+
+// What add_months and add_years do when the target month is shorter than the
+// day of the month being kept, e.g. Jan 31 + 1 month.
+enum MonthPolicy {
+    MONTH_CLAMP,     // the last day of the target month (Feb 28 or 29)
+    MONTH_OVERFLOW,  // carries the surplus days into the next month (Mar 3)
+    MONTH_ERROR      // fails with DATE_INVALID_DAY
+};
+
+// Years beyond this many from year 0 have dates whose serial dates overflow
+// int in some calendar (the limit is about 5.88 million years).
+const int kMaxShiftedYear = 5000000;
+
+// Moves year and month by months in a calendar of months_per_year months
+// numbered from 1. Returns false if the year leaves +-kMaxShiftedYear.
+inline bool shift_month(int& year, int& month, long long months,
+        int months_per_year) {
+    const long long index = static_cast<long long>(year) * months_per_year
+        + (month - 1) + months;
+    long long shifted_year = index / months_per_year;
+    long long shifted_month = index % months_per_year;
+    if (shifted_month < 0) {
+        shifted_month += months_per_year;
+        --shifted_year;
+    }
+    if (shifted_year < -kMaxShiftedYear || shifted_year > kMaxShiftedYear) {
+        return false;
+    }
+    year = static_cast<int>(shifted_year);
+    month = static_cast<int>(shifted_month) + 1;
+    return true;
+}
+
+// Resolves day in a month of last_day days. day is left past last_day for
+// MONTH_OVERFLOW: counting it from the first of the month carries it over.
+inline DateStatus apply_month_policy(MonthPolicy policy, int last_day,
+        int& day) {
+    if (day <= last_day) {
+        return DATE_OK;
+    }
+    switch (policy) {
+        case MONTH_CLAMP:
+            day = last_day;
+            return DATE_OK;
+        case MONTH_OVERFLOW:
+            return DATE_OK;
+        default:
+            return DATE_INVALID_DAY;
+    }
+}
+
+}  // namespace toolbox
@@ -2,14 +2,44 @@
 
 #include <iostream>
 #include <iomanip>
-#include <sstream>
 #include <string>
 #include <stdexcept>
 #include <cstring>
+#include <climits>
 
 #include <string.hpp>
+#include <calendar_system/CalendarArithmetic.hpp>
+#include <calendar_system/DateParser.hpp>
 #include <calendar_system/GregorianCalendar.hpp>
 
+namespace {
+
+const char* const kEraNamesUpper[] = {
+    /* [toolbox::NonProlepticGregorianCalendar::BC] = */ "B.C.",
+    /* [toolbox::NonProlepticGregorianCalendar::AD] = */ "A.D.",
+};
+const char* const kEraNamesLower[] = {
+    /* [toolbox::NonProlepticGregorianCalendar::BC] = */ "BC",
+    /* [toolbox::NonProlepticGregorianCalendar::AD] = */ "AD",
+};
+
+toolbox::DateStatus parsed_to_serial(int era, int year, int month, int day,
+        int& serial_date) {
+    return toolbox::NonProlepticGregorianCalendar().try_to_serial_date(era,
+        year, month, day, serial_date);
+}
+
+const toolbox::DateParserSpec kParserSpec = {
+    kEraNamesUpper, kEraNamesLower,
+    toolbox::NonProlepticGregorianCalendar::END_OF_ERA,
+    toolbox::NonProlepticGregorianCalendar::AD,
+    NULL, 0,
+    NULL, 0, 0,
+    parsed_to_serial,
+};
+
+}  // namespace
+
 namespace toolbox {
 
 NonProlepticGregorianCalendar::NonProlepticGregorianCalendar() {
@@ -31,37 +61,103 @@ NonProlepticGregorianCalendar::~NonProlepticGregorianCalendar() {
 
 int NonProlepticGregorianCalendar::to_serial_date(int era,
     int year, int month, int day) const {
-    GregorianCalendar gc;
-    int serial = gc.to_serial_date(era, year, month, day);
-    validate_serial_date(serial);
-    return serial;
+    int serial_date = 0;
+    const DateStatus status =
+        NonProlepticGregorianCalendar::try_to_serial_date(era, year, month,
+            day, serial_date);
+    if (status != DATE_OK) {
+        throw std::out_of_range(
+            std::string("NonProlepticGregorianCalendar::to_serial_date "
+                "failed: ") + date_status_message(status));
+    }
+    return serial_date;
 }
 
 int NonProlepticGregorianCalendar::to_serial_date(const std::string& date_str,
     const char* format, bool strict) const {
-    if (!format) {
+    int serial_date = 0;
+    const DateStatus status = NonProlepticGregorianCalendar::try_parse(
+        date_str, format, strict, serial_date);
+    if (status != DATE_OK) {
         throw std::invalid_argument(
-            "NonProlepticGregorianCalendar::to_serial_date failed: "
-            "format is null");
+            std::string("NonProlepticGregorianCalendar::to_serial_date "
+                "failed: ") + date_status_message(status));
     }
-    int era = toolbox::NonProlepticGregorianCalendar::AD;
-    int year = 0, month = 0, day = 0;
-    bool all_found = false;
-    int serial = 0;
-    parse_formatted_date(date_str, 0, format,
-        era, false,
-        year, false,
-        month, false,
-        day, false,
-        all_found,
-        serial,
-        strict);
-    if (!all_found) {
+    return serial_date;
+}
+
+int NonProlepticGregorianCalendar::to_serial_date(
+    const char* begin, const char* end, const char* format,
+    bool strict) const {
+    int serial_date = 0;
+    const DateStatus status = NonProlepticGregorianCalendar::try_parse(
+        begin, end, format, strict, serial_date);
+    if (status != DATE_OK) {
+        throw std::invalid_argument(
+            std::string("NonProlepticGregorianCalendar::to_serial_date "
+                "failed: ") + date_status_message(status));
+    }
+    return serial_date;
+}
+
+int NonProlepticGregorianCalendar::to_serial_date(
+    const char* begin, const char* end, const char* format,
+    bool strict, std::size_t& consumed) const {
+    int serial_date = 0;
+    const DateStatus status = NonProlepticGregorianCalendar::try_parse(
+        begin, end, format, strict, serial_date, consumed);
+    if (status != DATE_OK) {
         throw std::invalid_argument(
-            "NonProlepticGregorianCalendar::to_serial_date failed: "
-            "Something went wrong while parsing date_str");
+            std::string("NonProlepticGregorianCalendar::to_serial_date "
+                "failed: ") + date_status_message(status));
+    }
+    return serial_date;
+}
+
+DateStatus NonProlepticGregorianCalendar::try_to_serial_date(int era,
+    int year, int month, int day, int& serial_date) const {
+    int serial = 0;
+    const DateStatus status = GregorianCalendar().try_to_serial_date(era,
+        year, month, day, serial);
+    if (status != DATE_OK) {
+        return status;
+    }
+    if (serial < kBeginGregorian) {
+        return DATE_OUT_OF_RANGE;
+    }
+    serial_date = serial;
+    return DATE_OK;
+}
+
+DateStatus NonProlepticGregorianCalendar::try_parse(
+    const std::string& date_str, const char* format, bool strict,
+    int& serial_date) const {
+    return NonProlepticGregorianCalendar::try_parse(date_str.data(),
+        date_str.data() + date_str.size(), format, strict, serial_date);
+}
+
+DateStatus NonProlepticGregorianCalendar::try_parse(const char* begin,
+        const char* end, const char* format, bool strict,
+        int& serial_date) const {
+    if (!format) {
+        return DATE_INVALID_FORMAT;
     }
-    return serial;
+    return parse_date(begin, end, format, kParserSpec, strict, serial_date);
+}
+
+DateStatus NonProlepticGregorianCalendar::try_parse(const char* begin,
+    const char* end, const char* format, bool strict, int& serial_date,
+    std::size_t& consumed) const {
+    if (!format) {
+        return DATE_INVALID_FORMAT;
+    }
+    const char* stop;
+    const DateStatus status = parse_date_prefix(begin, end, format,
+        kParserSpec, strict, serial_date, stop);
+    if (status == DATE_OK) {
+        consumed = stop - begin;
+    }
+    return status;
 }
 
 void NonProlepticGregorianCalendar::from_serial_date(int serial_date,
@@ -78,6 +174,20 @@ void NonProlepticGregorianCalendar::from_serial_date(int serial_date,
     gc.from_serial_date(serial_date, date_str, format);
 }
 
+void NonProlepticGregorianCalendar::from_serial_date(int serial_date,
+    std::string& date_str, const DateFormat& format) const {
+    validate_serial_date(serial_date);
+    GregorianCalendar gc;
+    gc.from_serial_date(serial_date, date_str, format);
+}
+
+std::size_t NonProlepticGregorianCalendar::format_to(int serial_date,
+    char* buf, std::size_t cap, const DateFormat& format) const {
+    validate_serial_date(serial_date);
+    GregorianCalendar gc;
+    return gc.format_to(serial_date, buf, cap, format);
+}
+
 void NonProlepticGregorianCalendar::from_serial_date(int serial_date,
     int& day_of_week) const {
     validate_serial_date(serial_date);
@@ -85,389 +195,173 @@ void NonProlepticGregorianCalendar::from_serial_date(int serial_date,
     gc.from_serial_date(serial_date, day_of_week);
 }
 
-void NonProlepticGregorianCalendar::validate_serial_date(
-    int serial_date) const {
-    // -141427 is 1582-10-15 in Gregorian calendar
-    const int begin_gregorian = -141427;
-    if (serial_date < begin_gregorian) {
+// October 1582 has the 17 days from the 15th to the 31st but still ends on
+// the 31st; the months before it do not exist.
+int NonProlepticGregorianCalendar::last_day_of_month(int era, int year,
+    int month) const {
+    const int last_day = GregorianCalendar().last_day_of_month(era, year,
+        month);
+    int serial = 0;
+    GregorianCalendar().try_to_serial_date(era, year, month, last_day,
+        serial);
+    if (serial < kBeginGregorian) {
         throw std::out_of_range(
-            "NonProlepticGregorianCalendar::validate_serial_date failed: "
-            "Dates before 1582-10-15 does not exist "
-            "in non-proleptic Gregorian calendar");
+            std::string("NonProlepticGregorianCalendar::last_day_of_month "
+                "failed: ") + date_status_message(DATE_OUT_OF_RANGE));
     }
+    return last_day;
 }
 
-void NonProlepticGregorianCalendar::parse_formatted_date(
-    const std::string& date_str,
-    std::size_t pos,
-    const char* format,
-    int& era, bool era_found,
-    int& year, bool year_found,
-    int& month, bool month_found,
-    int& day, bool day_found,
-    bool& all_found,
-    int& serial,
-    bool strict) const {
-    if (pos >= date_str.size() && !*format) {
-        if (year_found && month_found && day_found) {
-            try {
-                int ret = to_serial_date(era, year, month, day);
-                if (!all_found) {
-                    serial = ret;
-                }
-            } catch (std::exception &e) {
-                return;
-            }
-            if (all_found) {
-                throw std::invalid_argument(
-                    "NonProlepticGregorianCalendar::"
-                    "parse_formatted_date failed: "
-                    "date_str is ambiguous");
-            }
-            all_found = true;
-        }
-        return;
+DateStatus NonProlepticGregorianCalendar::try_add_months(int serial_date,
+    int months, MonthPolicy policy, int& result) const {
+    if (serial_date < kBeginGregorian) {
+        return DATE_OUT_OF_RANGE;
     }
-    if (pos >= date_str.size() || !*format) {
-        return;
+    int shifted = 0;
+    const DateStatus status = GregorianCalendar().try_add_months(serial_date,
+        months, policy, shifted);
+    if (status != DATE_OK) {
+        return status;
     }
-    if (date_str[pos] == format[0] && format[0] != '%') {
-        parse_formatted_date(date_str, pos + 1, format + 1,
-            era, era_found,
-            year, year_found,
-            month, month_found,
-            day, day_found,
-            all_found,
-            serial,
-            strict);
-        return;
+    if (shifted < kBeginGregorian) {
+        return DATE_OUT_OF_RANGE;
     }
-    if (format[0] != '%') {
-        return;
+    result = shifted;
+    return DATE_OK;
+}
+
+DateStatus NonProlepticGregorianCalendar::try_add_years(int serial_date,
+    int years, MonthPolicy policy, int& result) const {
+    if (years > INT_MAX / 12 || years < INT_MIN / 12) {
+        return DATE_OUT_OF_RANGE;
     }
-    switch (format[1]) {
-        case 'E':
-        case 'e': {
-            if (era_found) {
-                throw std::invalid_argument(
-                    "NonProlepticGregorianCalendar::"
-                    "parse_formatted_date failed: "
-                    "era is specified multiple times");
-            }
-            parse_Ee(date_str, pos, format,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
-        case 'Y':
-        case 'y': {
-            if (year_found) {
-                throw std::invalid_argument(
-                    "NonProlepticGregorianCalendar::"
-                    "parse_formatted_date failed: "
-                    "year is specified multiple times");
-            }
-            parse_Yy(date_str, pos, format,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
-        case 'M':
-        case 'm': {
-            if (month_found) {
-                throw std::invalid_argument(
-                    "NonProlepticGregorianCalendar::"
-                    "parse_formatted_date failed: "
-                    "month is specified multiple times");
-            }
-            parse_Mm(date_str, pos, format,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
-        case 'D':
-        case 'd': {
-            if (day_found) {
-                throw std::invalid_argument(
-                    "NonProlepticGregorianCalendar::"
-                    "parse_formatted_date failed: "
-                    "day is specified multiple times");
-            }
-            parse_Dd(date_str, pos, format,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
-        case '%': {
-            if (date_str[pos] != '%') {
-                return;
-            }
-            parse_formatted_date(date_str, pos + 1, format + 2,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
-        default:
-            throw std::invalid_argument(
-                "NonProlepticGregorianCalendar::"
-                "parse_formatted_date failed: "
-                "Invalid format specifier: %" + toolbox::to_string(format[1]));
+    return NonProlepticGregorianCalendar::try_add_months(serial_date,
+        years * 12, policy, result);
+}
+
+// October 1582 has only the 17 days from the 15th, so its weeks are counted
+// from the 15th.
+DateStatus NonProlepticGregorianCalendar::try_nth_weekday_of_month(int era,
+    int year, int month, int weekday, int nth, int& serial_date) const {
+    GregorianCalendar gc;
+    int first = 0;
+    const DateStatus status = gc.try_to_serial_date(era, year, month, 1,
+        first);
+    if (status != DATE_OK) {
+        return status;
+    }
+    int days = gc.last_day_of_month(era, year, month);
+    if (first + days <= kBeginGregorian) {
+        return DATE_OUT_OF_RANGE;
+    }
+    if (first < kBeginGregorian) {
+        days -= kBeginGregorian - first;
+        first = kBeginGregorian;
+    }
+    const int offset = nth_weekday_offset(weekday_from_days(first), days,
+        weekday, nth);
+    if (offset < 0) {
+        return DATE_INVALID_DAY;
     }
+    serial_date = first + offset;
+    return DATE_OK;
 }
 
-void NonProlepticGregorianCalendar::parse_Ee(const std::string& date_str,
-    std::size_t pos,
-    const char* format,
-    int& era, bool era_found,
-    int& year, bool year_found,
-    int& month, bool month_found,
-    int& day, bool day_found,
-    bool& all_found,
-    int& serial,
-    bool strict
-) const {
-    (void)era_found;
-    const char* era_str_E[] = {
-        /* [toolbox::GregorianCalendar::BC] = */ "B.C.",
-        /* [toolbox::GregorianCalendar::AD] = */ "A.D.",
-    };
-    const char* era_str_e[] = {
-        /* [toolbox::GregorianCalendar::BC] = */ "BC",
-        /* [toolbox::GregorianCalendar::AD] = */ "AD",
-    };
-    for (int i = 0; i < toolbox::GregorianCalendar::END_OF_ERA; ++i) {
-        const char* s = std::isupper(format[1]) ? era_str_E[i] : era_str_e[i];
-        const std::size_t len = std::strlen(s);
-        if (date_str.compare(pos, len, s) == 0) {
-            era = i;
-            parse_formatted_date(date_str, pos + len, format + 2,
-                era, true,
-                year, year_found,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            return;
-        }
+DateStatus NonProlepticGregorianCalendar::try_weekday_on_or_after(
+    int serial_date, int weekday, int& result) const {
+    if (serial_date < kBeginGregorian) {
+        return DATE_OUT_OF_RANGE;
     }
-    throw std::invalid_argument(
-        "NonProlepticGregorianCalendar::parse_Ee failed: "
-        "era not found in date_str at position "
-        + toolbox::to_string(pos));
+    return GregorianCalendar().try_weekday_on_or_after(serial_date, weekday,
+        result);
 }
 
-void NonProlepticGregorianCalendar::parse_Yy(const std::string& date_str,
-    std::size_t pos,
-    const char* format,
-    int& era, bool era_found,
-    int& year, bool year_found,
-    int& month, bool month_found,
-    int& day, bool day_found,
-    bool& all_found,
-    int& serial,
-    bool strict
-) const {
-    (void)year_found;
-    if (std::isupper(format[1])) {
-        // %Y
-        if (date_str[pos] == '0') {
-            return;
-        }
-        for (std::size_t num_len = 1;
-            pos + num_len <= date_str.size(); ++num_len) {
-            if (!std::isdigit(date_str[pos + num_len - 1])) {
-                break;
-            }
-            std::string year_str = date_str.substr(pos, num_len);
-            try {
-                year = toolbox::stoi(year_str);
-            } catch (std::exception &e) {
-                continue;
-            }
-            parse_formatted_date(date_str, pos + num_len, format + 2,
-                era, era_found,
-                year, true,
-                month, month_found,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            if (all_found && !strict) {
-                return;
-            }
-        }
-    } else {
-        // %y
-        if (pos + 2 > date_str.size()) {
-            return;
-        }
-        std::string year_str = date_str.substr(pos, 2);
-        try {
-            year = toolbox::stoi(year_str);
-        } catch (std::exception &e) {
-            return;
-        }
-        parse_formatted_date(date_str, pos + 2, format + 2,
-            era, era_found,
-            year, true,
-            month, month_found,
-            day, day_found,
-            all_found,
-            serial,
-            strict);
-        return;
+DateStatus NonProlepticGregorianCalendar::try_weekday_on_or_before(
+    int serial_date, int weekday, int& result) const {
+    int found = 0;
+    const DateStatus status = GregorianCalendar().try_weekday_on_or_before(
+        serial_date, weekday, found);
+    if (status != DATE_OK) {
+        return status;
     }
+    if (found < kBeginGregorian) {
+        return DATE_OUT_OF_RANGE;
+    }
+    result = found;
+    return DATE_OK;
 }
 
-void NonProlepticGregorianCalendar::parse_Mm(const std::string& date_str,
-    std::size_t pos,
-    const char* format,
-    int& era, bool era_found,
-    int& year, bool year_found,
-    int& month, bool month_found,
-    int& day, bool day_found,
-    bool& all_found,
-    int& serial,
-    bool strict
-) const {
-    (void)month_found;
-    if (std::isupper(format[1])) {
-        // %M
-        if (date_str[pos] == '0') {
-            return;
-        }
-        for (std::size_t num_len = 1;
-            pos + num_len <= date_str.size() && num_len <= 2; ++num_len) {
-            if (!std::isdigit(date_str[pos + num_len - 1])) {
-                break;
-            }
-            std::string month_str = date_str.substr(pos, num_len);
-            try {
-                month = toolbox::stoi(month_str);
-            } catch (std::exception &e) {
-                continue;
-            }
-            parse_formatted_date(date_str, pos + num_len, format + 2,
-                era, era_found,
-                year, year_found,
-                month, true,
-                day, day_found,
-                all_found,
-                serial,
-                strict);
-            if (all_found && !strict) {
-                return;
-            }
-        }
-    } else {
-        // %m
-        if (pos + 2 > date_str.size()) {
-            return;
-        }
-        std::string month_str = date_str.substr(pos, 2);
-        try {
-            month = toolbox::stoi(month_str);
-        } catch (std::exception &e) {
-            return;
+void NonProlepticGregorianCalendar::to_serial_dates(const int* eras,
+    const int* years, const int* months, const int* days, std::size_t count,
+    int* serial_dates) const {
+    // The Gregorian batch converts valid input; otherwise the elements are
+    // converted again one by one, so that the first invalid one throws
+    // what the scalar overload throws for it.
+    bool valid = true;
+    try {
+        GregorianCalendar gc;
+        gc.to_serial_dates(eras, years, months, days, count, serial_dates);
+        for (std::size_t i = 0; i < count && valid; ++i) {
+            valid = serial_dates[i] >= kBeginGregorian;
         }
-        parse_formatted_date(date_str, pos + 2, format + 2,
-            era, era_found,
-            year, year_found,
-            month, true,
-            day, day_found,
-            all_found,
-            serial,
-            strict);
+    } catch (const std::exception&) {
+        valid = false;
+    }
+    if (valid) {
         return;
     }
+    for (std::size_t i = 0; i < count; ++i) {
+        serial_dates[i] = NonProlepticGregorianCalendar::to_serial_date(
+            eras[i], years[i], months[i], days[i]);
+    }
 }
 
-void NonProlepticGregorianCalendar::parse_Dd(const std::string& date_str,
-    std::size_t pos,
-    const char* format,
-    int& era, bool era_found,
-    int& year, bool year_found,
-    int& month, bool month_found,
-    int& day, bool day_found,
-    bool& all_found,
-    int& serial,
-    bool strict
-) const {
-    (void)day_found;
-    if (std::isupper(format[1])) {
-        // %D
-        if (date_str[pos] == '0') {
-            return;
-        }
-        for (std::size_t num_len = 1;
-            pos + num_len <= date_str.size() && num_len <= 2; ++num_len) {
-            if (!std::isdigit(date_str[pos + num_len - 1])) {
-                break;
-            }
-            std::string day_str = date_str.substr(pos, num_len);
-            try {
-                day = toolbox::stoi(day_str);
-            } catch (std::exception &e) {
-                continue;
-            }
-            parse_formatted_date(date_str, pos + num_len, format + 2,
-                era, era_found,
-                year, year_found,
-                month, month_found,
-                day, true,
-                all_found,
-                serial,
-                strict);
-            if (all_found && !strict) {
-                return;
-            }
-        }
-    } else {
-        // %d
-        if (pos + 2 > date_str.size()) {
-            return;
+void NonProlepticGregorianCalendar::from_serial_dates(
+    const int* serial_dates, std::size_t count,
+    int* eras, int* years, int* months, int* days) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        validate_serial_date(serial_dates[i]);
+    }
+    GregorianCalendar gc;
+    gc.from_serial_dates(serial_dates, count, eras, years, months, days);
+}
+
+void NonProlepticGregorianCalendar::add_months(const int* serial_dates,
+    std::size_t count, int months, MonthPolicy policy,
+    int* results) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        const DateStatus status = NonProlepticGregorianCalendar::try_add_months(
+            serial_dates[i], months, policy, results[i]);
+        if (status != DATE_OK) {
+            throw std::out_of_range(
+                std::string("NonProlepticGregorianCalendar::add_months "
+                    "failed: ")
+                + date_status_message(status));
         }
-        std::string day_str = date_str.substr(pos, 2);
-        try {
-            day = toolbox::stoi(day_str);
-        } catch (std::exception &e) {
-            return;
+    }
+}
+
+void NonProlepticGregorianCalendar::add_years(const int* serial_dates,
+    std::size_t count, int years, MonthPolicy policy,
+    int* results) const {
+    for (std::size_t i = 0; i < count; ++i) {
+        const DateStatus status = NonProlepticGregorianCalendar::try_add_years(
+            serial_dates[i], years, policy, results[i]);
+        if (status != DATE_OK) {
+            throw std::out_of_range(
+                std::string("NonProlepticGregorianCalendar::add_years failed: ")
+                + date_status_message(status));
         }
-        parse_formatted_date(date_str, pos + 2, format + 2,
-            era, era_found,
-            year, year_found,
-            month, month_found,
-            day, true,
-            all_found,
-            serial,
-            strict);
-        return;
+    }
+}
+
+void NonProlepticGregorianCalendar::validate_serial_date(
+    int serial_date) const {
+    if (serial_date < kBeginGregorian) {
+        throw std::out_of_range(
+            "NonProlepticGregorianCalendar::validate_serial_date failed: "
+            "Dates before 1582-10-15 does not exist "
+            "in non-proleptic Gregorian calendar");
     }
 }
 
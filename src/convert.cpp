@@ -0,0 +1,250 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <DateColumnConverter.hpp>
+#include <MappedFile.hpp>
+#include <string.hpp>
+
+namespace {
+
+const char* const kUsage =
+    "usage: date-convert --columns LIST | --chars LIST [options] [FILE]\n"
+    "\n"
+    "Converts the date columns of CSV or TSV text from FILE, or standard\n"
+    "input, to standard output.\n"
+    "\n"
+    "  --columns LIST      date columns, numbered from 1, e.g. 2 or 1,4\n"
+    "  --chars LIST        dates at byte positions of each line, numbered\n"
+    "                      from 1, e.g. 1-10 or 1-10,25-32\n"
+    "  --delimiter CHAR    field delimiter (default ',')\n"
+    "  --tsv               tab-delimited fields\n"
+    "  --header            copy the first line as it is\n"
+    "  --keep-invalid      copy fields that are not dates instead of failing\n"
+    "  --lenient           take the first reading of ambiguous input\n"
+    "  --from CALENDAR     calendar of the input (default gregorian)\n"
+    "  --from-format FMT   format of the input (default iso)\n"
+    "  --to CALENDAR       calendar of the output (default gregorian)\n"
+    "  --to-format FMT     format of the output (default iso)\n"
+    "  --mmap              map FILE into memory instead of reading it\n"
+    "\n"
+    "CALENDAR is gregorian, non-proleptic-gregorian, julian, ethiopian,\n"
+    "french-republican or japanese-wareki. FMT is a pattern of %E, %Y, %M,\n"
+    "%D and friends, e.g. %E%Y-%m-%d, or iso: ISO 8601, read in any of its\n"
+    "forms and written as YYYY-MM-DD. iso-basic, iso-ordinal and iso-week\n"
+    "write YYYYMMDD, YYYY-DDD and YYYY-Www-D.\n";
+
+struct CalendarName {
+    const char* name;
+    toolbox::CalendarSystem cal_sys;
+};
+
+const CalendarName kCalendarNames[] = {
+    {"gregorian", toolbox::GREGORIAN},
+    {"non-proleptic-gregorian", toolbox::NON_PROLEPTIC_GREGORIAN},
+    {"julian", toolbox::JULIAN},
+    {"ethiopian", toolbox::ETHIOPIAN},
+    {"french-republican", toolbox::FRENCH_REPUBLICAN},
+    {"japanese-wareki", toolbox::JAPANESE_WAREKI},
+};
+
+const char* option_value(int argc, char** argv, int& i);
+toolbox::CalendarSystem parse_calendar(const std::string& name);
+std::vector<int> parse_columns(const std::string& list);
+std::vector<toolbox::FixedDateField> parse_chars(const std::string& list);
+void parse_format(const std::string& format, bool output,
+    std::string& pattern, toolbox::Iso8601Form& iso_form);
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    toolbox::DateColumnSpec spec;
+    const char* path = NULL;
+    bool has_columns = false;
+    bool mapped = false;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "--tsv") {
+                spec.delimiter = '\t';
+            } else if (arg == "--header") {
+                spec.header = true;
+            } else if (arg == "--keep-invalid") {
+                spec.keep_invalid = true;
+            } else if (arg == "--lenient") {
+                spec.strict = false;
+            } else if (arg == "--mmap") {
+                mapped = true;
+            } else if (arg == "--help") {
+                std::cout << kUsage;
+                return 0;
+            } else if (arg == "--columns") {
+                spec.columns = parse_columns(option_value(argc, argv, i));
+                has_columns = true;
+            } else if (arg == "--chars") {
+                spec.fixed_fields = parse_chars(option_value(argc, argv, i));
+                has_columns = true;
+            } else if (arg == "--delimiter") {
+                const std::string delimiter = option_value(argc, argv, i);
+                if (delimiter.size() != 1) {
+                    throw std::invalid_argument(
+                        "the delimiter must be one character");
+                }
+                spec.delimiter = delimiter[0];
+            } else if (arg == "--from") {
+                spec.from_cal = parse_calendar(option_value(argc, argv, i));
+            } else if (arg == "--from-format") {
+                parse_format(option_value(argc, argv, i), false,
+                    spec.from_format, spec.to_iso_form);
+            } else if (arg == "--to") {
+                spec.to_cal = parse_calendar(option_value(argc, argv, i));
+            } else if (arg == "--to-format") {
+                parse_format(option_value(argc, argv, i), true,
+                    spec.to_format, spec.to_iso_form);
+            } else if (!path && (arg == "-" || arg[0] != '-')) {
+                path = argv[i];
+            } else {
+                throw std::invalid_argument("unknown option " + arg);
+            }
+        }
+        if (!has_columns) {
+            throw std::invalid_argument("--columns or --chars is required");
+        }
+        if (mapped && (!path || std::strcmp(path, "-") == 0)) {
+            throw std::invalid_argument("--mmap needs a FILE");
+        }
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "date-convert: " << e.what() << "\n" << kUsage;
+        return 2;
+    }
+
+    std::FILE* in = stdin;
+    if (!mapped && path && std::strcmp(path, "-") != 0) {
+        in = std::fopen(path, "rb");
+        if (!in) {
+            std::cerr << "date-convert: cannot open " << path << std::endl;
+            return 1;
+        }
+    }
+    int status = 0;
+    try {
+        toolbox::DateColumnConverter converter(spec);
+        if (mapped) {
+            const toolbox::MappedFile file(path);
+            converter.convert(file.begin(), file.end(), stdout);
+        } else {
+            converter.convert(in, stdout);
+        }
+        if (std::fflush(stdout) != 0) {
+            throw std::runtime_error("write error");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "date-convert: " << e.what() << std::endl;
+        status = 1;
+    }
+    if (in != stdin) {
+        std::fclose(in);
+    }
+    return status;
+}
+
+namespace {
+
+// The argument after the option argv[i], which it moves i to.
+const char* option_value(int argc, char** argv, int& i) {
+    if (i + 1 == argc) {
+        throw std::invalid_argument(std::string(argv[i]) + " needs a value");
+    }
+    return argv[++i];
+}
+
+toolbox::CalendarSystem parse_calendar(const std::string& name) {
+    for (std::size_t i = 0;
+            i < sizeof(kCalendarNames) / sizeof(kCalendarNames[0]); ++i) {
+        if (name == kCalendarNames[i].name) {
+            return kCalendarNames[i].cal_sys;
+        }
+    }
+    throw std::invalid_argument("unknown calendar " + name);
+}
+
+std::vector<int> parse_columns(const std::string& list) {
+    std::vector<int> columns;
+    const char* begin = list.c_str();
+    const char* const end = begin + list.size();
+    for (;;) {
+        int column;
+        const char* next = toolbox::parse_int(begin, end, column);
+        if (!next || column < 1 || (next != end && *next != ',')) {
+            throw std::invalid_argument("invalid column list " + list);
+        }
+        columns.push_back(column);
+        if (next == end) {
+            return columns;
+        }
+        begin = next + 1;
+    }
+}
+
+// Byte ranges N-M, inclusive and numbered from 1 as cut -c numbers them.
+std::vector<toolbox::FixedDateField> parse_chars(const std::string& list) {
+    std::vector<toolbox::FixedDateField> fields;
+    const char* begin = list.c_str();
+    const char* const end = begin + list.size();
+    for (;;) {
+        int first;
+        int last;
+        const char* next = toolbox::parse_int(begin, end, first);
+        if (next && next != end && *next == '-') {
+            next = toolbox::parse_int(next + 1, end, last);
+        } else {
+            next = NULL;
+        }
+        if (!next || first < 1 || last < first
+                || (next != end && *next != ',')) {
+            throw std::invalid_argument("invalid character list " + list);
+        }
+        const toolbox::FixedDateField field = {
+            static_cast<std::size_t>(first - 1),
+            static_cast<std::size_t>(last - first + 1)
+        };
+        fields.push_back(field);
+        if (next == end) {
+            return fields;
+        }
+        begin = next + 1;
+    }
+}
+
+// Stores a pattern, or "" and the form for the iso names.
+void parse_format(const std::string& format, bool output,
+        std::string& pattern, toolbox::Iso8601Form& iso_form) {
+    const struct {
+        const char* name;
+        toolbox::Iso8601Form form;
+    } iso_names[] = {
+        {"iso", toolbox::ISO8601_CALENDAR},
+        {"iso-basic", toolbox::ISO8601_BASIC},
+        {"iso-ordinal", toolbox::ISO8601_ORDINAL},
+        {"iso-week", toolbox::ISO8601_WEEK},
+    };
+    for (std::size_t i = 0; i < sizeof(iso_names) / sizeof(iso_names[0]);
+            ++i) {
+        if (format == iso_names[i].name) {
+            if (output) {
+                iso_form = iso_names[i].form;
+            } else if (i != 0) {
+                throw std::invalid_argument(
+                    "iso reads every ISO 8601 form; use it for input");
+            }
+            pattern.clear();
+            return;
+        }
+    }
+    pattern = format;
+}
+
+}  // namespace
@@ -1,24 +1,107 @@
-#include <sstream>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
 #include <string>
 
 #include <string.hpp>
 
+namespace {
+
+// "00", "01", ..., "99": two digits are emitted per division by 100.
+const char kDigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+}  // namespace
+
 namespace toolbox {
 
 std::string to_string(int value) {
-    std::ostringstream oss;
-    oss << value;
-    return oss.str();
+    char digits[16];
+    return std::string(digits, format_int(digits, value));
 }
 
 int stoi(const std::string &s) {
-    std::stringstream ss(s);
-    int num;
-    ss >> num;
-    if (ss.fail() || !ss.eof()) {
+    const char* const end = s.data() + s.size();
+    int num = 0;
+    if (parse_int(s.data(), end, num) != end) {
         throw std::invalid_argument("Invalid integer: '" + s + "'");
     }
     return num;
 }
 
+const char* parse_int(const char* begin, const char* end, int& value) {
+    const bool negative = begin != end && *begin == '-';
+    const char* pos = begin + negative;
+    // Accumulate the magnitude unsigned so that INT_MIN is representable.
+    const unsigned int limit = negative
+        ? 0u - static_cast<unsigned int>(INT_MIN) : INT_MAX;
+    unsigned int magnitude = 0;
+    const char* const digits = pos;
+    for (; pos != end && *pos >= '0' && *pos <= '9'; ++pos) {
+        const unsigned int digit = static_cast<unsigned int>(*pos - '0');
+        if (magnitude > (limit - digit) / 10) {
+            return NULL;
+        }
+        magnitude = magnitude * 10 + digit;
+    }
+    if (pos == digits) {
+        return NULL;
+    }
+    value = negative ? static_cast<int>(0u - magnitude)
+        : static_cast<int>(magnitude);
+    return pos;
+}
+
+std::size_t format_int(char* out, int value, int min_width) {
+    char digits[10];
+    char* const end = digits + sizeof(digits);
+    char* first = end;
+    // Unsigned arithmetic keeps INT_MIN representable.
+    unsigned int magnitude = value < 0 ? 0u - static_cast<unsigned int>(value)
+        : static_cast<unsigned int>(value);
+    while (magnitude >= 100) {
+        const unsigned int pair = magnitude % 100 * 2;
+        magnitude /= 100;
+        first -= 2;
+        first[0] = kDigitPairs[pair];
+        first[1] = kDigitPairs[pair + 1];
+    }
+    if (magnitude >= 10) {
+        first -= 2;
+        first[0] = kDigitPairs[magnitude * 2];
+        first[1] = kDigitPairs[magnitude * 2 + 1];
+    } else {
+        *--first = static_cast<char>('0' + magnitude);
+    }
+    while (end - first < min_width) {
+        *--first = '0';
+    }
+    std::size_t len = 0;
+    if (value < 0) {
+        out[len++] = '-';
+    }
+    const std::size_t digit_count = static_cast<std::size_t>(end - first);
+    std::memcpy(out + len, first, digit_count);
+    return len + digit_count;
+}
+
+char* format_int(char* out, char* out_end, int value, int min_width) {
+    char digits[16];
+    const std::size_t len = format_int(digits, value, min_width);
+    if (static_cast<std::size_t>(out_end - out) < len) {
+        return NULL;
+    }
+    std::memcpy(out, digits, len);
+    return out + len;
+}
+
 }  // namespace toolbox
@@ -1,11 +1,28 @@
 #pragma once
 
+#include <cstddef>
 #include <string>
-#include <sstream>
 
 namespace toolbox {
 
 std::string to_string(int value);
+// Throws std::invalid_argument unless the whole of s is an int, see
+// parse_int.
 int stoi(const std::string &s);
 
+// Parses an optional '-' and the decimal digits that follow at the start of
+// [begin, end), without locale, whitespace skipping or allocation. Returns
+// the end of the number and stores it in value, or returns NULL and leaves
+// value untouched if there are no digits or the number does not fit in int.
+const char* parse_int(const char* begin, const char* end, int& value);
+
+// Writes value in decimal, zero-padded to at least min_width digits (at most
+// 10), into out, which must have room for 11 characters. Returns the number
+// of characters written; no terminating '\0' is added.
+std::size_t format_int(char* out, int value, int min_width = 0);
+
+// Bounded form of the above: writes into [out, out_end) and returns the end
+// of the number, or NULL (writing nothing) if it does not fit.
+char* format_int(char* out, char* out_end, int value, int min_width = 0);
+
 }  // namespace toolbox
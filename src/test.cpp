@@ -1,17 +1,37 @@
+#include <algorithm>
+#include <atomic>
+#include <climits>
 #include <cstddef>
+#include <cstdio>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include <BusinessCalendar.hpp>
+#include <CivilCursor.hpp>
 #include <Date.hpp>
+#include <DateColumnConverter.hpp>
+#include <DateRange.hpp>
+#include <MappedFile.hpp>
+#include <Parallel.hpp>
+#include <Recurrence.hpp>
+#include <calendar_system/CalendarArithmetic.hpp>
+#include <calendar_system/DateParser.hpp>
 #include <calendar_system/EthiopianCalendar.hpp>
 #include <calendar_system/FrenchRepublicanCalendar.hpp>
+#include <calendar_system/GregorianBatch.hpp>
 #include <calendar_system/GregorianCalendar.hpp>
+#include <calendar_system/Iso8601.hpp>
 #include <calendar_system/JapaneseEra.hpp>
+#include <calendar_system/JapaneseWarekiCalendar.hpp>
 #include <calendar_system/JulianCalendar.hpp>
 #include <calendar_system/NonProlepticGregorianCalendar.hpp>
+#include <string.hpp>
 
 void test_parse_gregorian(const std::string& date_str,
                           const char* format,
@@ -510,13 +530,3458 @@ void test_japanese_wareki_format(toolbox::JapaneseEra era) {
               << std::endl;
 }
 
+int era_date_to_serial(const toolbox::EraDate& date) {
+    if (date.calendar == toolbox::ERA_CALENDAR_JULIAN) {
+        toolbox::JulianCalendar julian;
+        return julian.to_serial_date(toolbox::JulianCalendar::AD,
+            date.year, date.month, date.day);
+    }
+    toolbox::GregorianCalendar greg;
+    return greg.to_serial_date(toolbox::GregorianCalendar::AD,
+        date.year, date.month, date.day);
+}
+
+// Reference era resolution by scanning every era: the southern court wins
+// overlaps, otherwise the last matching era in table order.
+int reference_era_for_serial(int serial) {
+    int chosen = -1;
+    bool chosen_southern = false;
+    const std::size_t count = toolbox::era_count();
+    for (std::size_t i = 0; i < count; ++i) {
+        const toolbox::EraMetadata& meta =
+            toolbox::get_era_metadata(static_cast<toolbox::JapaneseEra>(i));
+        if (serial < era_date_to_serial(meta.start)) {
+            continue;
+        }
+        if (meta.has_end && serial > era_date_to_serial(meta.end)) {
+            continue;
+        }
+        const bool southern =
+            meta.authority == toolbox::ERA_AUTHORITY_SOUTHERN;
+        if (southern || !chosen_southern) {
+            chosen = static_cast<int>(i);
+            chosen_southern = southern;
+        }
+    }
+    return chosen;
+}
+
+void test_japanese_wareki_era_lookup_boundaries() {
+    int& counter = japanese_era_test_counter();
+    const toolbox::JapaneseWarekiCalendar wareki;
+    const std::size_t count = toolbox::era_count();
+    bool pass = true;
+    for (std::size_t i = 0; i < count && pass; ++i) {
+        const toolbox::EraMetadata& meta =
+            toolbox::get_era_metadata(static_cast<toolbox::JapaneseEra>(i));
+        int boundaries[2];
+        boundaries[0] = era_date_to_serial(meta.start);
+        boundaries[1] = meta.has_end ? era_date_to_serial(meta.end)
+                                     : boundaries[0];
+        for (int b = 0; b < 2 && pass; ++b) {
+            for (int delta = -1; delta <= 1; ++delta) {
+                const int serial = boundaries[b] + delta;
+                const int expected = reference_era_for_serial(serial);
+                int era = -1, year, month, day;
+                try {
+                    wareki.from_serial_date(serial, era, year, month, day);
+                } catch (const std::out_of_range&) {
+                    era = -1;
+                }
+                if (era != expected) {
+                    pass = false;
+                    std::cout << "  serial=" << serial << " era=" << era
+                              << " expected=" << expected << std::endl;
+                    break;
+                }
+            }
+        }
+    }
+    std::cout << "wareki meta " << std::setw(3) << ++counter << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+void test_japanese_wareki_nanbokucho_lookup() {
+    int& counter = japanese_era_test_counter();
+    const toolbox::JapaneseWarekiCalendar wareki;
+    toolbox::JulianCalendar julian;
+    // 1350-01-01 (Julian) lies in both Shohei (south) and Kan'o/Jowa (north).
+    const int serial = julian.to_serial_date(toolbox::JulianCalendar::AD,
+        1350, 1, 1);
+    int era, year, month, day;
+    wareki.from_serial_date(serial, era, year, month, day);
+    const bool pass = era == toolbox::SHOHEI;
+    std::cout << "wareki meta " << std::setw(3) << ++counter << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+    if (!pass) {
+        std::cout << "  era actual=" << era
+                  << " expected=" << toolbox::SHOHEI << std::endl;
+    }
+}
+
+void run_japanese_wareki_era_lookup_tests() {
+    test_japanese_wareki_era_lookup_boundaries();
+    test_japanese_wareki_nanbokucho_lookup();
+}
+
 void run_japanese_wareki_format_tests() {
     test_japanese_wareki_format(toolbox::MEIJI);
     test_japanese_wareki_format(toolbox::TEMPYO_SHOHO);
     test_japanese_wareki_format(toolbox::REIWA);
 }
 
+void report_batch_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "batch " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+// Checks that the batch conversions of cal_sys agree element-wise with the
+// scalar ones over count consecutive serial dates starting at first.
+void test_batch_conversion(toolbox::CalendarSystem cal_sys,
+                           const toolbox::ICalendarSystem& calendar,
+                           int first,
+                           std::size_t count) {
+    std::vector<int> serials(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        serials[i] = first + static_cast<int>(i);
+    }
+    std::vector<int> eras(count), years(count), months(count), days(count);
+    bool pass = true;
+    try {
+        toolbox::Date::from_serial_dates(cal_sys, &serials[0], count,
+            &eras[0], &years[0], &months[0], &days[0]);
+        // Only fields the scalar conversion accepts are fed back.
+        std::vector<int> in_eras, in_years, in_months, in_days, expected;
+        for (std::size_t i = 0; i < count && pass; ++i) {
+            int era, year, month, day;
+            calendar.from_serial_date(serials[i], era, year, month, day);
+            if (era != eras[i] || year != years[i] || month != months[i] ||
+                day != days[i]) {
+                pass = false;
+                std::cout << "  serial=" << serials[i] << " batch="
+                          << eras[i] << "/" << years[i] << "/" << months[i]
+                          << "/" << days[i] << " scalar=" << era << "/"
+                          << year << "/" << month << "/" << day << std::endl;
+            }
+            try {
+                expected.push_back(
+                    calendar.to_serial_date(era, year, month, day));
+            } catch (const std::exception&) {
+                continue;
+            }
+            in_eras.push_back(era);
+            in_years.push_back(year);
+            in_months.push_back(month);
+            in_days.push_back(day);
+        }
+        std::vector<int> back(expected.size());
+        toolbox::Date::to_serial_dates(cal_sys, &in_eras[0], &in_years[0],
+            &in_months[0], &in_days[0], expected.size(), &back[0]);
+        if (back != expected) {
+            pass = false;
+            std::cout << "  to_serial_dates differs from to_serial_date"
+                      << std::endl;
+        }
+    } catch (const std::exception& e) {
+        pass = false;
+        std::cout << "  threw: " << e.what() << std::endl;
+    }
+    report_batch_test(pass);
+}
+
+// A batch with several invalid elements throws what the scalar conversion
+// throws for the first of them: here the gap before 1582-10-15, not the
+// month 13 after it.
+void test_batch_first_error() {
+    const toolbox::NonProlepticGregorianCalendar non_proleptic;
+    const int ad = toolbox::NonProlepticGregorianCalendar::AD;
+    const int eras[] = {ad, ad, ad, ad, ad, ad};
+    const int years[] = {1582, 2000, 2000, 2000, 2000, 2000};
+    const int months[] = {10, 1, 2, 3, 4, 13};
+    const int days[] = {10, 1, 1, 1, 1, 1};
+    int serials[6];
+    std::string scalar_error;
+    try {
+        non_proleptic.to_serial_date(eras[0], years[0], months[0], days[0]);
+    } catch (const std::out_of_range& e) {
+        scalar_error = e.what();
+    }
+    bool pass = false;
+    try {
+        toolbox::Date::to_serial_dates(toolbox::NON_PROLEPTIC_GREGORIAN,
+            eras, years, months, days, 6, serials);
+    } catch (const std::out_of_range& e) {
+        pass = !scalar_error.empty() && scalar_error == e.what();
+    } catch (const std::exception&) {
+    }
+    report_batch_test(pass);
+}
+
+void run_batch_conversion_tests() {
+    const toolbox::GregorianCalendar gregorian;
+    const toolbox::NonProlepticGregorianCalendar non_proleptic;
+    const toolbox::JulianCalendar julian;
+    const toolbox::EthiopianCalendar ethiopian;
+    const toolbox::FrenchRepublicanCalendar french;
+    const toolbox::JapaneseWarekiCalendar wareki;
+    const int bc_1000 = gregorian.to_serial_date(
+        toolbox::GregorianCalendar::BC, 1000, 1, 1);
+    const int ad_1582 = gregorian.to_serial_date(
+        toolbox::GregorianCalendar::AD, 1582, 10, 15);
+    const int ad_1792 = gregorian.to_serial_date(
+        toolbox::GregorianCalendar::AD, 1792, 9, 22);
+    const int ad_1900 = gregorian.to_serial_date(
+        toolbox::GregorianCalendar::AD, 1900, 1, 1);
+    const int ad_100 = julian.to_serial_date(
+        toolbox::JulianCalendar::AD, 100, 1, 1);
+
+    test_batch_conversion(toolbox::GREGORIAN, gregorian, bc_1000, 800000);
+    test_batch_conversion(toolbox::NON_PROLEPTIC_GREGORIAN, non_proleptic,
+        ad_1582, 200000);
+    test_batch_conversion(toolbox::JULIAN, julian, bc_1000, 800000);
+    test_batch_conversion(toolbox::ETHIOPIAN, ethiopian, ad_100, 200000);
+    test_batch_conversion(toolbox::FRENCH_REPUBLICAN, french, ad_1792, 5000);
+    test_batch_conversion(toolbox::JAPANESE_WAREKI, wareki, ad_1900, 50000);
+    test_batch_first_error();
+}
+
+void report_date_format_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "date format " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+bool date_format_rejects(const char* pattern) {
+    try {
+        toolbox::DateFormat format(pattern);
+    } catch (const std::invalid_argument& e) {
+        (void)e;
+        return true;
+    }
+    return false;
+}
+
+void test_date_format_compile() {
+    const toolbox::DateFormat iso("%Y-%m-%d");
+    const std::vector<toolbox::DateFormat::Token>& tokens = iso.tokens();
+    report_date_format_test(tokens.size() == 5
+        && tokens[0].kind == toolbox::DateFormat::YEAR
+        && tokens[0].uppercase
+        && tokens[1].kind == toolbox::DateFormat::LITERAL
+        && iso.literals().compare(tokens[1].offset, tokens[1].length, "-") == 0
+        && tokens[2].kind == toolbox::DateFormat::MONTH
+        && !tokens[2].uppercase
+        && iso.uses(toolbox::DateFormat::DAY)
+        && !iso.uses(toolbox::DateFormat::WEEKDAY));
+
+    // Escaped '%' merges with the surrounding literal text.
+    const toolbox::DateFormat escaped("100%% at %W%%");
+    report_date_format_test(escaped.tokens().size() == 3
+        && escaped.literals() == "100% at %"
+        && escaped.tokens()[0].length == 8
+        && escaped.tokens()[1].kind == toolbox::DateFormat::WEEKDAY);
+
+    report_date_format_test(date_format_rejects("%Y-%Q")
+        && date_format_rejects("%Y-%")
+        && date_format_rejects(NULL)
+        && toolbox::DateFormat("").tokens().empty()
+        && toolbox::DateFormat().pattern() == "%Y-%M-%D");
+}
+
+// A compiled format must produce exactly what the format string does.
+void test_date_format_matches(toolbox::CalendarSystem cal_sys,
+                              const char* pattern,
+                              int first,
+                              int count) {
+    const toolbox::DateFormat format(pattern);
+    bool pass = true;
+    try {
+        for (int serial = first; serial < first + count && pass; ++serial) {
+            const toolbox::Date date(serial);
+            const std::string expected = date.to_string(cal_sys, pattern);
+            const std::string actual = date.to_string(cal_sys, format);
+            if (actual != expected) {
+                pass = false;
+                std::cout << "  serial=" << serial << " expected=" << expected
+                          << " actual=" << actual << std::endl;
+            }
+        }
+    } catch (const std::exception& e) {
+        pass = false;
+        std::cout << "  threw: " << e.what() << std::endl;
+    }
+    report_date_format_test(pass);
+}
+
+void run_date_format_tests() {
+    const toolbox::GregorianCalendar gregorian;
+    const int ad_1792 = gregorian.to_serial_date(
+        toolbox::GregorianCalendar::AD, 1792, 9, 22);
+    const int ad_1868 = gregorian.to_serial_date(
+        toolbox::GregorianCalendar::AD, 1868, 10, 23);
+
+    test_date_format_compile();
+    test_date_format_matches(toolbox::GREGORIAN,
+        "%E %Y-%m-%d (%W) %e%y/%M/%D %w %%", -800000, 2000);
+    test_date_format_matches(toolbox::NON_PROLEPTIC_GREGORIAN,
+        "%e %Y-%m-%d %w", 0, 2000);
+    test_date_format_matches(toolbox::JULIAN,
+        "%E %Y-%m-%d (%W) %e%y/%M/%D %w %%", -800000, 2000);
+    test_date_format_matches(toolbox::ETHIOPIAN,
+        "%E %Y-%M-%D %e %y %m %d %W %w", 0, 2000);
+    test_date_format_matches(toolbox::FRENCH_REPUBLICAN,
+        "%E %Y %M %D %e %y %m %d %W %w", ad_1792, 2000);
+    test_date_format_matches(toolbox::JAPANESE_WAREKI,
+        "%E%Y年%M月%D日 %e%y/%m/%d %%", ad_1868, 2000);
+
+    // Wareki has no day-of-week names.
+    bool rejected = false;
+    try {
+        toolbox::Date(0).to_string(toolbox::JAPANESE_WAREKI,
+            toolbox::DateFormat("%E%Y %W"));
+    } catch (const std::invalid_argument& e) {
+        (void)e;
+        rejected = true;
+    }
+    report_date_format_test(rejected);
+}
+
+void report_date_parser_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "date parser " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+// Encodes the fields as a decimal serial date so that tests can tell which
+// reading was chosen.
+toolbox::DateStatus fields_to_serial(int era, int year, int month, int day,
+                                     int& serial_date) {
+    if (year > 9999) {
+        return toolbox::DATE_INVALID_YEAR;
+    }
+    if (month < 1 || month > 12) {
+        return toolbox::DATE_INVALID_MONTH;
+    }
+    if (day < 1 || day > 28) {
+        return toolbox::DATE_INVALID_DAY;
+    }
+    serial_date = (era == 0 ? -1 : 1) * (year * 10000 + month * 100 + day);
+    return toolbox::DATE_OK;
+}
+
+const char* const kTestEraNamesUpper[] = {"B.C.", "A.D."};
+const char* const kTestEraNamesLower[] = {"BC", "AD"};
+const toolbox::DateParserSpec kTestParserSpec = {
+    kTestEraNamesUpper, kTestEraNamesLower, 2, 1,
+    NULL, 0,
+    NULL, 0, 0,
+    fields_to_serial,
+};
+
+bool parses_as(const std::string& date_str, const char* format, bool strict,
+               toolbox::DateStatus expected_status, int expected_serial) {
+    int serial = 0;
+    const toolbox::DateStatus status = toolbox::parse_date(
+        date_str.data(), date_str.data() + date_str.size(), format,
+        kTestParserSpec, strict, serial);
+    return status == expected_status
+        && (status != toolbox::DATE_OK || serial == expected_serial);
+}
+
+void test_date_parser_status() {
+    report_date_parser_test(
+        parses_as("B.C.12-3-4", "%E%Y-%M-%D", true,
+            toolbox::DATE_OK, -120304)
+        && parses_as("AD 0012/03/04", "%e %Y/%m/%d", true,
+            toolbox::DATE_NO_MATCH, 0)
+        && parses_as("AD 12/03/04", "%e %Y/%m/%d", true,
+            toolbox::DATE_OK, 120304)
+        && parses_as("100% 5 6 7", "100%% %Y %M %D", true,
+            toolbox::DATE_OK, 50607));
+
+    // Format errors are reported before looking at the input.
+    report_date_parser_test(
+        parses_as("", "%Y-%M-%W", true,
+            toolbox::DATE_INVALID_FORMAT, 0)
+        && parses_as("", "%Y-%M-%D%", true,
+            toolbox::DATE_INVALID_FORMAT, 0)
+        && parses_as("1-1-1-1", "%Y-%M-%D-%d", true,
+            toolbox::DATE_DUPLICATE_FIELD, 0)
+        && parses_as("1-1", "%Y-%M", true, toolbox::DATE_NO_MATCH, 0));
+
+    // "1111" reads as 1-1-11, 1-11-1 and 11-1-1; narrower leading fields
+    // rank first.
+    report_date_parser_test(
+        parses_as("1111", "%Y%M%D", true, toolbox::DATE_AMBIGUOUS, 0)
+        && parses_as("1111", "%Y%M%D", false, toolbox::DATE_OK, 10111)
+        && parses_as("19991228", "%Y%M%D", true,
+            toolbox::DATE_OK, 19991228)
+        && parses_as("2024-1-2", "%Y-%M-%D", true,
+            toolbox::DATE_OK, 20240102)
+        && parses_as("2024-01-2", "%Y-%M-%D", false,
+            toolbox::DATE_NO_MATCH, 0)
+        && parses_as("2024- 1-2", "%Y-%M-%D", false,
+            toolbox::DATE_NO_MATCH, 0));
+}
+
+// Long inputs must fail or succeed without the work growing beyond linear.
+void test_date_parser_long_input() {
+    const std::string digits(1000000, '1');
+    const std::string prefix(100000, '#');
+    const std::string format = prefix + "%Y-%M-%D";
+    report_date_parser_test(
+        parses_as(digits, "%Y%M%D", false, toolbox::DATE_NO_MATCH, 0)
+        && parses_as(prefix + "7-8-9", format.c_str(), true,
+            toolbox::DATE_OK, 70809));
+}
+
+// Parsing a formatted date must give the fields it was formatted from.
+void test_date_parser_roundtrip(const toolbox::ICalendarSystem& cal,
+                                const char* format,
+                                int first,
+                                int count) {
+    bool pass = true;
+    try {
+        for (int serial = first; serial < first + count && pass; ++serial) {
+            int era, year, month, day;
+            cal.from_serial_date(serial, era, year, month, day);
+            std::string date_str;
+            cal.from_serial_date(serial, date_str, format);
+            const int expected = cal.to_serial_date(era, year, month, day);
+            const int parsed = cal.to_serial_date(date_str, format, true);
+            if (parsed != expected) {
+                pass = false;
+                std::cout << "  serial=" << serial << " date_str=" << date_str
+                          << " parsed=" << parsed << std::endl;
+            }
+        }
+    } catch (const std::exception& e) {
+        pass = false;
+        std::cout << "  threw: " << e.what() << std::endl;
+    }
+    report_date_parser_test(pass);
+}
+
+void test_date_parser_day_names() {
+    const toolbox::FrenchRepublicanCalendar french;
+    const int last_day = french.to_serial_date(
+        toolbox::FrenchRepublicanCalendar::AD, 3, 13, 6);
+    bool pass = french.to_serial_date("3 Sansculottides Jour de la Revolution",
+        "%Y %m %d", true) == last_day
+        && french.to_serial_date("Jour de la Revolution 13, 3",
+        "%d %M, %Y", true) == last_day;
+    // A day name fixes the month, which must agree with %M.
+    try {
+        french.to_serial_date("Jour de la Revolution 12, 3", "%d %M, %Y",
+            true);
+        pass = false;
+    } catch (const std::invalid_argument& e) {
+        (void)e;
+    }
+    report_date_parser_test(pass);
+}
+
+void test_date_parser_errors() {
+    const toolbox::GregorianCalendar gregorian;
+    bool ambiguous = false;
+    try {
+        gregorian.to_serial_date("2024111", "%Y%M%D", true);
+    } catch (const std::invalid_argument& e) {
+        ambiguous = std::string(e.what()).find("ambiguous")
+            != std::string::npos;
+    }
+    bool duplicate = false;
+    try {
+        gregorian.to_serial_date("1-1-1", "%Y-%M-%M", true);
+    } catch (const std::invalid_argument& e) {
+        duplicate = std::string(e.what()).find("more than once")
+            != std::string::npos;
+    }
+    report_date_parser_test(ambiguous && duplicate
+        && gregorian.to_serial_date("2024111", "%Y%M%D", false)
+            == gregorian.to_serial_date(toolbox::GregorianCalendar::AD,
+                2024, 1, 11));
+}
+
+void run_date_parser_tests() {
+    const toolbox::GregorianCalendar gregorian;
+    const toolbox::NonProlepticGregorianCalendar non_proleptic;
+    const toolbox::JulianCalendar julian;
+    const toolbox::EthiopianCalendar ethiopian;
+    const toolbox::FrenchRepublicanCalendar french;
+    const int ad_1582 = gregorian.to_serial_date(
+        toolbox::GregorianCalendar::AD, 1582, 10, 15);
+    const int ad_1792 = gregorian.to_serial_date(
+        toolbox::GregorianCalendar::AD, 1792, 9, 22);
+
+    test_date_parser_status();
+    test_date_parser_long_input();
+    test_date_parser_errors();
+    test_date_parser_day_names();
+    test_date_parser_roundtrip(gregorian,
+        "%E%Y-%m-%d", -800000, 2000);
+    test_date_parser_roundtrip(gregorian, "%e %Y/%M/%D", 0, 2000);
+    test_date_parser_roundtrip(non_proleptic,
+        "%Y%m%d", ad_1582, 2000);
+    test_date_parser_roundtrip(julian, "%E %Y-%m-%d", 0, 2000);
+    // 1965-01-01 onwards, short of Pagume where the Ethiopian conversions
+    // disagree on leap years.
+    test_date_parser_roundtrip(ethiopian, "%E %Y %m %d", 983, 360);
+    test_date_parser_roundtrip(french,
+        "%Y %m %d", ad_1792, 5000);
+    test_date_parser_roundtrip(french,
+        "%d %M, %Y", ad_1792, 5000);
+}
+
+void report_iso8601_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "iso8601 " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+bool iso8601_parses_as(const char* date_str, int expected) {
+    int serial = 0;
+    return toolbox::iso8601_to_serial_date(date_str,
+        date_str + std::strlen(date_str), serial) && serial == expected;
+}
+
+bool iso8601_rejects(const char* date_str) {
+    int serial = 0;
+    return !toolbox::iso8601_to_serial_date(date_str,
+        date_str + std::strlen(date_str), serial);
+}
+
+// Every form must read back what it wrote over the whole 0000..9999 range,
+// and the calendar form must agree with the general formatter.
+void test_iso8601_roundtrip() {
+    const toolbox::GregorianCalendar gregorian;
+    const toolbox::DateFormat format("%Y-%m-%d");
+    const int first = -719528;  // 0000-01-01
+    const int last = 2932896;  // 9999-12-31
+    const int ad_1000 = gregorian.to_serial_date(
+        toolbox::GregorianCalendar::AD, 1000, 1, 1);
+    const toolbox::Iso8601Form forms[] = {
+        toolbox::ISO8601_CALENDAR, toolbox::ISO8601_BASIC,
+        toolbox::ISO8601_ORDINAL, toolbox::ISO8601_WEEK
+    };
+    bool pass = true;
+    std::string expected;
+    for (int serial = first; serial <= last && pass; ++serial) {
+        const toolbox::Date date(serial);
+        // The first days fall in week-numbering year -1.
+        const std::size_t form_count = serial - first < 7 ? 3 : 4;
+        for (std::size_t i = 0; i < form_count && pass; ++i) {
+            const std::string date_str = date.to_iso8601(forms[i]);
+            if (toolbox::Date::from_iso8601(date_str) != date) {
+                pass = false;
+                std::cout << "  serial=" << serial << " date_str=" << date_str
+                          << std::endl;
+            }
+        }
+        if (serial >= ad_1000) {
+            gregorian.from_serial_date(serial, expected, format);
+            pass = pass && date.to_iso8601() == expected;
+        }
+    }
+    report_iso8601_test(pass);
+}
+
+void test_iso8601_forms() {
+    const toolbox::Date date(toolbox::GREGORIAN,
+        toolbox::GregorianCalendar::AD, 2024, 2, 29);
+    report_iso8601_test(date.to_iso8601() == "2024-02-29"
+        && date.to_iso8601(toolbox::ISO8601_BASIC) == "20240229"
+        && date.to_iso8601(toolbox::ISO8601_ORDINAL) == "2024-060"
+        && date.to_iso8601(toolbox::ISO8601_WEEK) == "2024-W09-4"
+        && iso8601_parses_as("2024-02-29", date.get_raw_date())
+        && iso8601_parses_as("20240229", date.get_raw_date())
+        && iso8601_parses_as("2024-060", date.get_raw_date())
+        && iso8601_parses_as("2024-W09-4", date.get_raw_date())
+        && iso8601_parses_as("0000-12-31", -719163)
+        && iso8601_parses_as("1970-001", 0));
+
+    // Week-numbering years differ from calendar years near January 1.
+    const char* const weeks[][2] = {
+        {"2008-12-29", "2009-W01-1"},
+        {"2010-01-03", "2009-W53-7"},
+        {"2005-01-01", "2004-W53-6"},
+        {"2007-01-01", "2007-W01-1"},
+        {"2020-12-31", "2020-W53-4"},
+        {"2021-01-03", "2020-W53-7"},
+    };
+    bool pass = true;
+    for (std::size_t i = 0; i < sizeof(weeks) / sizeof(weeks[0]); ++i) {
+        const toolbox::Date day = toolbox::Date::from_iso8601(weeks[i][0]);
+        pass = pass && day.to_iso8601(toolbox::ISO8601_WEEK) == weeks[i][1]
+            && toolbox::Date::from_iso8601(weeks[i][1]) == day;
+    }
+    report_iso8601_test(pass);
+}
+
+void test_iso8601_rejects() {
+    report_iso8601_test(iso8601_rejects("2023-02-29")
+        && iso8601_rejects("2024-02-30")
+        && iso8601_rejects("2024-13-01")
+        && iso8601_rejects("2024-00-10")
+        && iso8601_rejects("2024-01-00")
+        && iso8601_rejects("2024-1-01")
+        && iso8601_rejects("2024/01/01")
+        && iso8601_rejects("2024-01-0:")
+        && iso8601_rejects("2024-0/-01")
+        && iso8601_rejects("20240101 ")
+        && iso8601_rejects("+2024-01-01")
+        && iso8601_rejects("2023-366")
+        && iso8601_rejects("2024-000")
+        && iso8601_rejects("2024-W00-1")
+        && iso8601_rejects("2024-W01-0")
+        && iso8601_rejects("2024-W01-8")
+        && iso8601_rejects("2021-W53-1")
+        && iso8601_rejects("2024W011")
+        && iso8601_rejects("")
+        && iso8601_rejects("2024-01-01T00:00"));
+
+    bool threw = false;
+    try {
+        toolbox::Date::from_iso8601("2024-02-30");
+    } catch (const std::invalid_argument& e) {
+        (void)e;
+        threw = true;
+    }
+    report_iso8601_test(threw);
+}
+
+void test_iso8601_format_limits() {
+    char buf[8];
+    const std::size_t len = toolbox::iso8601_format_to(0, buf, sizeof(buf),
+        toolbox::ISO8601_CALENDAR);
+    bool pass = len == 10 && std::string(buf) == "1970-01";
+    const int out_of_range[] = {-719529, 2932897};
+    for (std::size_t i = 0; i < 2; ++i) {
+        try {
+            toolbox::Date(out_of_range[i]).to_iso8601();
+            pass = false;
+        } catch (const std::out_of_range& e) {
+            (void)e;
+        }
+    }
+    // 0000-01-01 is a Saturday in the last week of year -1.
+    try {
+        toolbox::Date(-719528).to_iso8601(toolbox::ISO8601_WEEK);
+        pass = false;
+    } catch (const std::out_of_range& e) {
+        (void)e;
+    }
+    report_iso8601_test(pass);
+}
+
+// Each form with just enough room, and one byte short: nothing may be
+// written past cap.
+void test_iso8601_format_exact_cap() {
+    const toolbox::Iso8601Form forms[] = {toolbox::ISO8601_CALENDAR,
+        toolbox::ISO8601_BASIC, toolbox::ISO8601_ORDINAL,
+        toolbox::ISO8601_WEEK};
+    const char* const expected[] = {"2024-02-29", "20240229", "2024-060",
+        "2024-W09-4"};
+    const int serial = toolbox::Date::from_iso8601("2024-02-29")
+        .get_raw_date();
+    bool pass = true;
+    for (std::size_t i = 0; i < 4; ++i) {
+        const std::size_t len = std::strlen(expected[i]);
+        for (std::size_t cap = len; cap <= len + 1; ++cap) {
+            char buf[16];
+            std::memset(buf, '#', sizeof(buf));
+            pass = pass && toolbox::iso8601_format_to(serial, buf, cap,
+                    forms[i]) == len
+                && std::string(buf) == std::string(expected[i], cap - 1)
+                && buf[cap] == '#';
+        }
+    }
+    report_iso8601_test(pass);
+}
+
+void run_iso8601_tests() {
+    test_iso8601_forms();
+    test_iso8601_rejects();
+    test_iso8601_format_limits();
+    test_iso8601_roundtrip();
+    test_iso8601_format_exact_cap();
+}
+
+void report_int_codec_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "int codec " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+// Whether parse_int stops after consumed characters with expected, or fails
+// (consumed < 0) leaving value untouched.
+bool parse_int_is(const char* str, int consumed, int expected) {
+    const char* const end = str + std::strlen(str);
+    int value = 12345;
+    const char* const stop = toolbox::parse_int(str, end, value);
+    if (consumed < 0) {
+        return stop == NULL && value == 12345;
+    }
+    return stop == str + consumed && value == expected;
+}
+
+bool stoi_rejects(const std::string& str) {
+    try {
+        toolbox::stoi(str);
+    } catch (const std::invalid_argument& e) {
+        (void)e;
+        return true;
+    }
+    return false;
+}
+
+void test_parse_int() {
+    report_int_codec_test(parse_int_is("0", 1, 0)
+        && parse_int_is("2024-01", 4, 2024)
+        && parse_int_is("-17x", 3, -17)
+        && parse_int_is("007", 3, 7)
+        && parse_int_is("2147483647", 10, 2147483647)
+        && parse_int_is("-2147483648", 11, -2147483647 - 1)
+        && parse_int_is("00000000002147483647", 20, 2147483647));
+    report_int_codec_test(parse_int_is("", -1, 0)
+        && parse_int_is("-", -1, 0)
+        && parse_int_is("+1", -1, 0)
+        && parse_int_is(" 1", -1, 0)
+        && parse_int_is("x1", -1, 0)
+        && parse_int_is("2147483648", -1, 0)
+        && parse_int_is("-2147483649", -1, 0)
+        && parse_int_is("99999999999", -1, 0));
+    report_int_codec_test(toolbox::stoi("-42") == -42
+        && stoi_rejects("")
+        && stoi_rejects(" 42")
+        && stoi_rejects("42 ")
+        && stoi_rejects("4 2")
+        && stoi_rejects("2147483648"));
+}
+
+// The codecs must agree with the stream conversions they replace.
+void test_int_codec_matches_streams() {
+    bool pass = true;
+    unsigned int seed = 1;
+    for (int i = 0; i < 100000 && pass; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        const int value = i < 1000 ? i - 500 : static_cast<int>(seed);
+        std::ostringstream oss;
+        oss << value;
+        pass = toolbox::to_string(value) == oss.str()
+            && toolbox::stoi(oss.str()) == value;
+    }
+    report_int_codec_test(pass);
+}
+
+void test_bounded_format_int() {
+    char buf[4];
+    char* const end = buf + sizeof(buf);
+    char* const stop = toolbox::format_int(buf, end, 7, 3);
+    report_int_codec_test(stop == buf + 3
+        && std::string(buf, stop) == "007"
+        && toolbox::format_int(buf, end, 12345) == NULL
+        && toolbox::format_int(buf, end, -123) == end
+        && std::string(buf, end) == "-123");
+}
+
+void run_int_codec_tests() {
+    test_parse_int();
+    test_bounded_format_int();
+    test_int_codec_matches_streams();
+}
+
+void report_try_api_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "try api " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+bool try_fields_is(const toolbox::ICalendarSystem& cal, int era, int year,
+                   int month, int day, toolbox::DateStatus expected) {
+    int serial = 12345;
+    const toolbox::DateStatus status = cal.try_to_serial_date(era, year,
+        month, day, serial);
+    return status == expected
+        && (status == toolbox::DATE_OK || serial == 12345);
+}
+
+bool try_parse_is(const toolbox::ICalendarSystem& cal,
+                  const std::string& date_str, const char* format,
+                  bool strict, toolbox::DateStatus expected) {
+    int serial = 12345;
+    const toolbox::DateStatus status = cal.try_parse(date_str, format, strict,
+        serial);
+    return status == expected
+        && (status == toolbox::DATE_OK || serial == 12345);
+}
+
+void test_try_to_serial_date_status() {
+    const toolbox::GregorianCalendar gregorian;
+    const toolbox::NonProlepticGregorianCalendar non_proleptic;
+    const toolbox::FrenchRepublicanCalendar french;
+    const toolbox::JapaneseWarekiCalendar wareki;
+    const int ad = toolbox::GregorianCalendar::AD;
+    report_try_api_test(
+        try_fields_is(gregorian, ad, 2024, 2, 29, toolbox::DATE_OK)
+        && try_fields_is(gregorian, 2, 2024, 2, 29, toolbox::DATE_INVALID_ERA)
+        && try_fields_is(gregorian, ad, 0, 2, 29, toolbox::DATE_INVALID_YEAR)
+        && try_fields_is(gregorian, ad, 2024, 13, 1,
+            toolbox::DATE_INVALID_MONTH)
+        && try_fields_is(gregorian, ad, 2023, 2, 29,
+            toolbox::DATE_INVALID_DAY)
+        && try_fields_is(non_proleptic, ad, 1582, 10, 4,
+            toolbox::DATE_OUT_OF_RANGE)
+        && try_fields_is(french, toolbox::FrenchRepublicanCalendar::AD, 15,
+            1, 1, toolbox::DATE_INVALID_YEAR)
+        // Reiwa began on 2019-05-01.
+        && try_fields_is(wareki, toolbox::REIWA, 1, 4, 30,
+            toolbox::DATE_OUT_OF_RANGE)
+        && try_fields_is(wareki, toolbox::REIWA, 1, 5, 1, toolbox::DATE_OK));
+}
+
+void test_try_parse_status() {
+    const toolbox::GregorianCalendar gregorian;
+    const toolbox::JapaneseWarekiCalendar wareki;
+    report_try_api_test(
+        try_parse_is(gregorian, "2024-02-29", "%Y-%m-%d", true,
+            toolbox::DATE_OK)
+        && try_parse_is(gregorian, "2023-02-29", "%Y-%m-%d", true,
+            toolbox::DATE_INVALID_DAY)
+        && try_parse_is(gregorian, "2023-02-29", NULL, true,
+            toolbox::DATE_INVALID_FORMAT)
+        && try_parse_is(gregorian, "2023-02-29", "%Y-%m-%Q", true,
+            toolbox::DATE_INVALID_FORMAT)
+        && try_parse_is(gregorian, "1-1-1", "%Y-%M-%M", true,
+            toolbox::DATE_DUPLICATE_FIELD)
+        && try_parse_is(gregorian, "2023/02/28", "%Y-%m-%d", true,
+            toolbox::DATE_NO_MATCH)
+        && try_parse_is(gregorian, "2024111", "%Y%M%D", true,
+            toolbox::DATE_AMBIGUOUS)
+        && try_parse_is(wareki, "令和1年5月1日", "%E%Y年%M月%D日", true,
+            toolbox::DATE_OK)
+        && try_parse_is(wareki, "令和1年4月30日", "%E%Y年%M月%D日", true,
+            toolbox::DATE_OUT_OF_RANGE)
+        && try_parse_is(wareki, "令和1年4月30日", "%E%Y年%M月%D日%D", true,
+            toolbox::DATE_DUPLICATE_FIELD)
+        && try_parse_is(wareki, "令和元年5月1日", "%E%Y年%M月%D日", true,
+            toolbox::DATE_NO_MATCH));
+}
+
+// The throwing API must accept exactly what the try API accepts, with the
+// same result, over a grid of valid and invalid fields.
+bool throwing_api_agrees(const toolbox::ICalendarSystem& cal, int last_era) {
+    for (int era = -1; era <= last_era; ++era) {
+        for (int year = -1; year <= 15; ++year) {
+            for (int month = 0; month <= 14; ++month) {
+                for (int day = 0; day <= 32; ++day) {
+                    int expected = 0;
+                    const bool ok = cal.try_to_serial_date(era, year, month,
+                        day, expected) == toolbox::DATE_OK;
+                    try {
+                        const int serial = cal.to_serial_date(era, year,
+                            month, day);
+                        if (!ok || serial != expected) {
+                            return false;
+                        }
+                    } catch (const std::out_of_range& e) {
+                        (void)e;
+                        if (ok) {
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void test_throwing_api_agrees() {
+    report_try_api_test(
+        throwing_api_agrees(toolbox::GregorianCalendar(), 2)
+        && throwing_api_agrees(toolbox::NonProlepticGregorianCalendar(), 2)
+        && throwing_api_agrees(toolbox::JulianCalendar(), 2)
+        && throwing_api_agrees(toolbox::EthiopianCalendar(), 2)
+        && throwing_api_agrees(toolbox::FrenchRepublicanCalendar(), 1)
+        && throwing_api_agrees(toolbox::JapaneseWarekiCalendar(),
+            toolbox::REIWA + 1));
+
+    bool pass = false;
+    try {
+        toolbox::GregorianCalendar().to_serial_date("2023-02-29", "%Y-%m-%d",
+            true);
+    } catch (const std::invalid_argument& e) {
+        pass = std::string(e.what()).find(toolbox::date_status_message(
+            toolbox::DATE_INVALID_DAY)) != std::string::npos;
+    }
+    report_try_api_test(pass);
+}
+
+void test_date_try_api() {
+    toolbox::Date date(42);
+    bool pass = toolbox::Date::try_make(toolbox::JULIAN,
+            toolbox::JulianCalendar::AD, 1900, 2, 29, date) == toolbox::DATE_OK
+        && date == toolbox::Date(toolbox::JULIAN,
+            toolbox::JulianCalendar::AD, 1900, 2, 29);
+    const toolbox::Date before = date;
+    pass = pass
+        && toolbox::Date::try_make(toolbox::GREGORIAN,
+            toolbox::GregorianCalendar::AD, 1900, 2, 29, date)
+            == toolbox::DATE_INVALID_DAY
+        && toolbox::Date::try_parse(toolbox::ETHIOPIAN, "2016 Pagume 7",
+            "%Y %m %D", true, date) == toolbox::DATE_INVALID_DAY
+        && date == before
+        && toolbox::Date::try_parse(toolbox::GREGORIAN, "24-01-02",
+            "%y-%m-%d", true, date) == toolbox::DATE_OK
+        && date == toolbox::Date(toolbox::GREGORIAN, "24-01-02");
+    report_try_api_test(pass);
+}
+
+// Parses date_str as the middle of a buffer between digits, which would
+// spoil the date if the parser read past either end.
+bool try_parse_range_is(const toolbox::ICalendarSystem& cal,
+                        const std::string& date_str, const char* format,
+                        toolbox::DateStatus expected) {
+    const std::string buf = "12" + date_str + "34";
+    int serial = 12345;
+    int expected_serial = 12345;
+    const toolbox::DateStatus status = cal.try_parse(buf.data() + 2,
+        buf.data() + 2 + date_str.size(), format, true, serial);
+    return status == expected
+        && cal.try_parse(date_str, format, true, expected_serial) == expected
+        && serial == expected_serial;
+}
+
+void test_try_parse_range() {
+    const toolbox::GregorianCalendar gregorian;
+    const toolbox::NonProlepticGregorianCalendar non_proleptic;
+    const toolbox::JulianCalendar julian;
+    const toolbox::EthiopianCalendar ethiopian;
+    const toolbox::FrenchRepublicanCalendar french;
+    const toolbox::JapaneseWarekiCalendar wareki;
+    bool pass = try_parse_range_is(gregorian, "2024-02-29", "%Y-%m-%d",
+            toolbox::DATE_OK)
+        && try_parse_range_is(gregorian, "2024-2-3", "%Y-%M-%D",
+            toolbox::DATE_OK)
+        && try_parse_range_is(non_proleptic, "1582-10-14", "%Y-%m-%d",
+            toolbox::DATE_OUT_OF_RANGE)
+        && try_parse_range_is(julian, "1582-10-04", "%Y-%m-%d",
+            toolbox::DATE_OK)
+        && try_parse_range_is(ethiopian, "2016-13-5", "%Y-%M-%D",
+            toolbox::DATE_OK)
+        && try_parse_range_is(french, "2-1-1", "%Y-%M-%D", toolbox::DATE_OK)
+        && try_parse_range_is(wareki, "令和1年5月1日", "%E%Y年%M月%D日",
+            toolbox::DATE_OK)
+        && try_parse_range_is(wareki, "令和1年5月", "%E%Y年%M月%D日",
+            toolbox::DATE_NO_MATCH)
+        && try_parse_range_is(gregorian, "", "%Y-%m-%d",
+            toolbox::DATE_NO_MATCH);
+    const std::string line = "id=7 date=2024-02-29 ok";
+    toolbox::Date date;
+    pass = pass && toolbox::Date::try_parse(toolbox::GREGORIAN,
+            line.data() + 10, line.data() + 20, "%Y-%m-%d", true, date)
+            == toolbox::DATE_OK
+        && date == toolbox::Date(toolbox::GREGORIAN, "2024-02-29",
+            "%Y-%m-%d");
+    report_try_api_test(pass);
+}
+
+// Parses a date from the start of input and checks the status, and on
+// DATE_OK the characters it took and that the date matches the whole-input
+// parse of them.
+bool try_parse_prefix_is(const toolbox::ICalendarSystem& cal,
+                         const std::string& input, const char* format,
+                         bool strict, toolbox::DateStatus expected,
+                         std::size_t expected_consumed) {
+    int serial = 12345;
+    std::size_t consumed = 999;
+    const toolbox::DateStatus status = cal.try_parse(input.data(),
+        input.data() + input.size(), format, strict, serial, consumed);
+    if (status != expected) {
+        return false;
+    }
+    if (status != toolbox::DATE_OK) {
+        return serial == 12345 && consumed == 999;
+    }
+    int whole = 12345;
+    return consumed == expected_consumed
+        && cal.try_parse(input.data(), input.data() + consumed, format,
+            strict, whole) == toolbox::DATE_OK
+        && serial == whole;
+}
+
+void test_try_parse_prefix() {
+    const toolbox::GregorianCalendar gregorian;
+    const toolbox::NonProlepticGregorianCalendar non_proleptic;
+    const toolbox::FrenchRepublicanCalendar french;
+    const toolbox::JapaneseWarekiCalendar wareki;
+    const std::string reiwa = "令和1年5月1日";
+    const bool pass = try_parse_prefix_is(gregorian, "2024-02-29,x",
+            "%Y-%m-%d", true, toolbox::DATE_OK, 10)
+        && try_parse_prefix_is(gregorian, "2024-02-29", "%Y-%m-%d", true,
+            toolbox::DATE_OK, 10)
+        && try_parse_prefix_is(gregorian, "2024-2-3x", "%Y-%M-%D", true,
+            toolbox::DATE_OK, 8)
+        // the last field takes every digit it can
+        && try_parse_prefix_is(gregorian, "2024-1-157", "%Y-%M-%D", true,
+            toolbox::DATE_OK, 9)
+        // ... and is not cut short to make a valid date
+        && try_parse_prefix_is(gregorian, "2024-2-30 ", "%Y-%M-%D", true,
+            toolbox::DATE_INVALID_DAY, 0)
+        && try_parse_prefix_is(gregorian, "2024112;", "%Y%M%D", true,
+            toolbox::DATE_AMBIGUOUS, 0)
+        && try_parse_prefix_is(gregorian, "2024112;", "%Y%M%D", false,
+            toolbox::DATE_OK, 7)
+        && try_parse_prefix_is(gregorian, "x2024-01-01", "%Y-%m-%d", true,
+            toolbox::DATE_NO_MATCH, 0)
+        && try_parse_prefix_is(gregorian, "", "%Y-%m-%d", true,
+            toolbox::DATE_NO_MATCH, 0)
+        && try_parse_prefix_is(gregorian, "2024-01-01", "%Y-%q-%d", true,
+            toolbox::DATE_INVALID_FORMAT, 0)
+        && try_parse_prefix_is(non_proleptic, "1582-10-14;", "%Y-%m-%d",
+            true, toolbox::DATE_OUT_OF_RANGE, 0)
+        && try_parse_prefix_is(french, "2-1-1 an II", "%Y-%M-%D", true,
+            toolbox::DATE_OK, 5)
+        && try_parse_prefix_is(wareki, reiwa + "に", "%E%Y年%M月%D日", true,
+            toolbox::DATE_OK, reiwa.size())
+        && try_parse_prefix_is(wareki, reiwa + " ", "%E%Y年%M月%D日", false,
+            toolbox::DATE_OK, reiwa.size())
+        && try_parse_prefix_is(wareki, "令和1年2月30日", "%E%Y年%M月%D日",
+            true, toolbox::DATE_INVALID_DAY, 0);
+    report_try_api_test(pass);
+}
+
+// Walks a record of dates with the consumed counts, and checks the throwing
+// range overloads.
+void test_date_parse_range() {
+    const std::string record = "2024-1-15|2024-2-29|1999-12-31";
+    const char* pos = record.data();
+    const char* const end = record.data() + record.size();
+    std::vector<toolbox::Date> dates;
+    while (pos != end) {
+        std::size_t consumed = 0;
+        dates.push_back(toolbox::Date::parse(toolbox::GREGORIAN, pos, end,
+            "%Y-%M-%D", true, consumed));
+        pos += consumed;
+        if (pos != end && *pos == '|') {
+            ++pos;
+        }
+    }
+    bool pass = dates.size() == 3
+        && dates[0] == toolbox::Date(toolbox::GREGORIAN, "2024-01-15",
+            "%Y-%m-%d")
+        && dates[1] == toolbox::Date(toolbox::GREGORIAN, "2024-02-29",
+            "%Y-%m-%d")
+        && dates[2] == toolbox::Date(toolbox::GREGORIAN, "1999-12-31",
+            "%Y-%m-%d")
+        && toolbox::Date::parse(toolbox::GREGORIAN, record.data() + 10,
+            record.data() + 19, "%Y-%M-%D") == dates[1];
+    toolbox::Date date;
+    std::size_t consumed = 0;
+    const std::string heisei = "平成31年4月30日まで";
+    pass = pass && toolbox::Date::try_parse(toolbox::JAPANESE_WAREKI,
+            heisei.data(), heisei.data() + heisei.size(), "%E%Y年%M月%D日",
+            true, date, consumed) == toolbox::DATE_OK
+        && consumed == heisei.size() - std::string("まで").size()
+        && date == toolbox::Date(toolbox::GREGORIAN, "2019-04-30",
+            "%Y-%m-%d");
+    int thrown = 0;
+    try {
+        toolbox::Date::parse(toolbox::GREGORIAN, record.data(),
+            record.data() + 10, "%Y-%M-%D");
+    } catch (const std::invalid_argument&) {
+        ++thrown;
+    }
+    try {
+        toolbox::Date::parse(toolbox::GREGORIAN, pos, end, "%Y-%m-%d", true,
+            consumed);
+    } catch (const std::invalid_argument&) {
+        ++thrown;
+    }
+    const toolbox::JulianCalendar julian;
+    pass = pass && julian.to_serial_date(record.data(), end, "%Y-%M-%D",
+            true, consumed) == (dates[0] + 13).get_raw_date()
+        && consumed == 9;
+    try {
+        julian.to_serial_date(record.data(), end, "%Y-%M-%D", true);
+    } catch (const std::invalid_argument&) {
+        ++thrown;
+    }
+    report_try_api_test(pass && thrown == 3);
+}
+
+void run_try_api_tests() {
+    test_try_to_serial_date_status();
+    test_try_parse_status();
+    test_throwing_api_agrees();
+    test_date_try_api();
+    test_try_parse_range();
+    test_try_parse_prefix();
+    test_date_parse_range();
+}
+
+void report_calendar_tag_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "calendar tag " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+// The tagged accessors must agree with the runtime ones for every date.
+template <toolbox::CalendarSystem Cal>
+void test_calendar_tag_matches(int first, int count) {
+    const toolbox::DateFormat format("%E %Y-%M-%D");
+    bool pass = true;
+    for (int serial = first; serial < first + count && pass; ++serial) {
+        const toolbox::Date date(serial);
+        int era, year, month, day;
+        toolbox::calendar_instance<Cal>().from_serial_date(serial, era, year,
+            month, day);
+        pass = date.get_year<Cal>() == date.get_year(Cal)
+            && date.get_month<Cal>() == date.get_month(Cal)
+            && date.get_day<Cal>() == date.get_day(Cal)
+            && date.get_weekday<Cal>() == date.get_weekday(Cal)
+            && date.to_string<Cal>() == date.to_string(Cal)
+            && date.to_string<Cal>(format) == date.to_string(Cal, format)
+            && toolbox::Date::make<Cal>(era, year, month, day)
+                == toolbox::Date(Cal, era, year, month, day);
+    }
+    report_calendar_tag_test(pass);
+}
+
+void run_calendar_tag_tests() {
+    const int ad_1792 = toolbox::Date(toolbox::GREGORIAN,
+        toolbox::GregorianCalendar::AD, 1792, 9, 22).get_raw_date();
+    const int ad_1868 = toolbox::Date(toolbox::GREGORIAN,
+        toolbox::GregorianCalendar::AD, 1868, 1, 1).get_raw_date();
+    test_calendar_tag_matches<toolbox::GREGORIAN>(-800000, 2000);
+    test_calendar_tag_matches<toolbox::NON_PROLEPTIC_GREGORIAN>(-141427,
+        2000);
+    test_calendar_tag_matches<toolbox::JULIAN>(-1000, 2000);
+    // Skips Pagume, whose day 6 the Ethiopian conversions disagree on.
+    test_calendar_tag_matches<toolbox::ETHIOPIAN>(983, 360);
+    test_calendar_tag_matches<toolbox::FRENCH_REPUBLICAN>(ad_1792, 2000);
+    test_calendar_tag_matches<toolbox::JAPANESE_WAREKI>(ad_1868, 2000);
+}
+
+void report_decompose_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "decompose " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+bool civil_is(const toolbox::CivilDate& civil,
+              const toolbox::ICalendarSystem& cal, int serial) {
+    int era, year, month, day, weekday;
+    cal.from_serial_date(serial, era, year, month, day);
+    cal.from_serial_date(serial, weekday);
+    return civil.era == era && civil.year == year && civil.month == month
+        && civil.day == day && civil.weekday == weekday;
+}
+
+template <toolbox::CalendarSystem Cal>
+void test_decompose_matches(int first, int count) {
+    const toolbox::ICalendarSystem& cal = toolbox::calendar_instance<Cal>();
+    bool pass = true;
+    for (int serial = first; serial < first + count && pass; ++serial) {
+        const toolbox::Date date(serial);
+        pass = civil_is(date.decompose(Cal), cal, serial)
+            && civil_is(date.decompose<Cal>(), cal, serial)
+            && date.get_year(Cal) == date.decompose(Cal).year
+            && date.get_month(Cal) == date.decompose(Cal).month
+            && date.get_day(Cal) == date.decompose(Cal).day;
+    }
+    report_decompose_test(pass);
+}
+
+// The per-thread cache must tell dates and calendars apart and must not
+// keep anything from a conversion that threw.
+void test_decompose_cache() {
+    const toolbox::Date date(-141428);  // 1582-10-14 Gregorian, 10-04 Julian
+    bool pass = date.get_day(toolbox::GREGORIAN) == 14
+        && date.get_day(toolbox::JULIAN) == 4
+        && date.get_day(toolbox::GREGORIAN) == 14
+        && (date + 1).get_day(toolbox::GREGORIAN) == 15
+        && date.get_day(toolbox::GREGORIAN) == 14;
+    try {
+        date.decompose(toolbox::NON_PROLEPTIC_GREGORIAN);
+        pass = false;
+    } catch (const std::out_of_range& e) {
+        (void)e;
+    }
+    pass = pass && date.get_month(toolbox::GREGORIAN) == 10
+        && (date + 1).get_day(toolbox::NON_PROLEPTIC_GREGORIAN) == 15;
+    report_decompose_test(pass);
+}
+
+void run_decompose_tests() {
+    const int ad_1792 = toolbox::Date(toolbox::GREGORIAN,
+        toolbox::GregorianCalendar::AD, 1792, 9, 22).get_raw_date();
+    test_decompose_matches<toolbox::GREGORIAN>(-800000, 2000);
+    test_decompose_matches<toolbox::JULIAN>(-1000, 2000);
+    test_decompose_matches<toolbox::ETHIOPIAN>(-1000, 2000);
+    test_decompose_matches<toolbox::FRENCH_REPUBLICAN>(ad_1792, 2000);
+    test_decompose_matches<toolbox::JAPANESE_WAREKI>(0, 2000);
+    test_decompose_cache();
+}
+
+void report_constexpr_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "constexpr " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+// Checked by the compiler: a failure here breaks the build.
+static_assert(toolbox::gregorian_days_from_civil(1970, 1, 1) == 0, "");
+static_assert(toolbox::gregorian_days_from_civil(1582, 10, 15) == -141427,
+    "");
+static_assert(toolbox::gregorian_civil_from_days(-141427).day == 15, "");
+static_assert(toolbox::julian_days_from_civil(1582, 10, 4) == -141428, "");
+static_assert(toolbox::julian_days_from_civil(-44, 1, 1) == -735601, "");
+static_assert(toolbox::julian_civil_from_days(-735601).year == -44, "");
+static_assert(!toolbox::julian_is_leap(-4) && toolbox::julian_is_leap(-10),
+    "");
+
+// A date table built entirely at compile time.
+constexpr int kConstexprTable[] = {
+    toolbox::gregorian_days_from_civil(-4712, 1, 1),
+    toolbox::gregorian_days_from_civil(1792, 9, 22),
+    toolbox::gregorian_days_from_civil(2000, 2, 29),
+    toolbox::gregorian_days_from_civil(2400, 12, 31),
+};
+
+bool ymd_is(const toolbox::YearMonthDay& ymd,
+            const toolbox::ICalendarSystem& cal, int serial) {
+    int era, year, month, day;
+    cal.from_serial_date(serial, era, year, month, day);
+    if (era == toolbox::GregorianCalendar::BC) {
+        year = 1 - year;
+    }
+    return ymd.year == year && ymd.month == month && ymd.day == day;
+}
+
+// The core must agree with the calendar classes built on it.
+void test_constexpr_core(const toolbox::ICalendarSystem& cal, bool julian,
+                         int first, int count) {
+    bool pass = true;
+    for (int serial = first; serial < first + count && pass; ++serial) {
+        const toolbox::YearMonthDay ymd = julian
+            ? toolbox::julian_civil_from_days(serial)
+            : toolbox::gregorian_civil_from_days(serial);
+        const int back = julian
+            ? toolbox::julian_days_from_civil(ymd.year, ymd.month, ymd.day)
+            : toolbox::gregorian_days_from_civil(ymd.year, ymd.month, ymd.day);
+        pass = back == serial && ymd_is(ymd, cal, serial);
+    }
+    report_constexpr_test(pass);
+}
+
+void test_constexpr_table() {
+    const toolbox::GregorianCalendar gregorian;
+    report_constexpr_test(
+        kConstexprTable[0] == gregorian.to_serial_date(
+            toolbox::GregorianCalendar::BC, 4713, 1, 1)
+        && kConstexprTable[1] == gregorian.to_serial_date(
+            toolbox::GregorianCalendar::AD, 1792, 9, 22)
+        && kConstexprTable[2] == gregorian.to_serial_date(
+            toolbox::GregorianCalendar::AD, 2000, 2, 29)
+        && kConstexprTable[3] == gregorian.to_serial_date(
+            toolbox::GregorianCalendar::AD, 2400, 12, 31));
+}
+
+bool from_serial_throws(const toolbox::ICalendarSystem& cal, int serial) {
+    try {
+        int era, year, month, day;
+        cal.from_serial_date(serial, era, year, month, day);
+    } catch (const std::out_of_range& e) {
+        (void)e;
+        return true;
+    }
+    return false;
+}
+
+// The calendars anchored on a fixed date convert exactly up to it.
+void test_epoch_bounds() {
+    const toolbox::EthiopianCalendar ethiopian;
+    const toolbox::FrenchRepublicanCalendar french;
+    const int ethiopian_epoch = toolbox::JulianCalendar().to_serial_date(
+        toolbox::JulianCalendar::AD, 8, 8, 29);
+    const int french_first = toolbox::GregorianCalendar().to_serial_date(
+        toolbox::GregorianCalendar::AD, 1792, 9, 22);
+    const int french_last = toolbox::GregorianCalendar().to_serial_date(
+        toolbox::GregorianCalendar::AD, 1806, 12, 31);
+    report_constexpr_test(
+        ethiopian.to_serial_date(toolbox::EthiopianCalendar::AD, 1, 1, 1)
+            == ethiopian_epoch
+        && from_serial_throws(ethiopian, ethiopian_epoch - 1)
+        && !from_serial_throws(ethiopian, ethiopian_epoch)
+        && french.to_serial_date(toolbox::FrenchRepublicanCalendar::AD, 1, 1,
+            1) == french_first
+        && from_serial_throws(french, french_first - 1)
+        && !from_serial_throws(french, french_first)
+        && !from_serial_throws(french, french_last)
+        && from_serial_throws(french, french_last + 1));
+}
+
+void run_constexpr_tests() {
+    test_constexpr_core(toolbox::GregorianCalendar(), false, -800000, 4000);
+    test_constexpr_core(toolbox::GregorianCalendar(), false, -150000, 300000);
+    // Skips 45 B.C. to A.D. 4, where the Julian conversions do not
+    // roundtrip.
+    test_constexpr_core(toolbox::JulianCalendar(), true, -760000, 24459);
+    test_constexpr_core(toolbox::JulianCalendar(), true, -717278, 600000);
+    test_constexpr_table();
+    test_epoch_bounds();
+}
+
+void report_date_range_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "date range " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+void test_date_range_days() {
+    const toolbox::Date first(19000);
+    const toolbox::DateRange range(first, first + 10, 3);
+    bool pass = range.size() == 4 && !range.empty()
+        && range.end() - range.begin() == 4;
+    int expected = 19000;
+    for (toolbox::DateRange::iterator it = range.begin(); it != range.end();
+            ++it, expected += 3) {
+        pass = pass && it->get_raw_date() == expected;
+    }
+    toolbox::DateRange::iterator it = range.begin() + 3;
+    pass = pass && expected == 19012 && *it == first + 9
+        && range[2] == first + 6 && it[-1] == first + 6
+        && *(2 + range.begin()) == first + 6 && *--it == first + 6
+        && it - range.begin() == 2 && range.begin() < it && it < range.end()
+        && toolbox::DateRange(first, first + 9, 3).size() == 3
+        && toolbox::DateRange(first, first + 15, 1,
+            toolbox::DateRange::WEEKS).size() == 3
+        && toolbox::DateRange(first, first, 1).empty()
+        && toolbox::DateRange(first, first - 5, 1).empty()
+        && toolbox::DateRange(first, first, 1).begin()
+            == toolbox::DateRange(first, first, 1).end();
+    report_date_range_test(pass);
+}
+
+void test_date_range_invalid_step() {
+    bool pass = true;
+    try {
+        toolbox::DateRange(toolbox::Date(0), toolbox::Date(10), 0);
+        pass = false;
+    } catch (const std::invalid_argument& e) {
+        (void)e;
+    }
+    try {
+        toolbox::DateRange(toolbox::Date(-200000), toolbox::Date(0), 1,
+            toolbox::DateRange::MONTHS, toolbox::JAPANESE_WAREKI);
+        pass = false;
+    } catch (const std::out_of_range& e) {
+        (void)e;
+    }
+    report_date_range_test(pass);
+}
+
+bool range_is(const toolbox::DateRange& range, const char* const* expected,
+              std::size_t count) {
+    if (range.size() != count) {
+        return false;
+    }
+    std::size_t i = 0;
+    for (toolbox::DateRange::iterator it = range.begin(); it != range.end();
+            ++it, ++i) {
+        if (it->to_string(toolbox::GREGORIAN, "%Y-%m-%d") != expected[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_date_range_clamping() {
+    const char* const monthly[] = {
+        "2023-01-31", "2023-02-28", "2023-03-31", "2023-04-30",
+        "2023-05-31", "2023-06-30", "2023-07-31", "2023-08-31",
+        "2023-09-30", "2023-10-31", "2023-11-30", "2023-12-31",
+        "2024-01-31", "2024-02-29", "2024-03-31", "2024-04-30",
+        "2024-05-31"
+    };
+    const char* const quarterly[] = {
+        "2023-01-31", "2023-04-30", "2023-07-31", "2023-10-31",
+        "2024-01-31", "2024-04-30"
+    };
+    const char* const yearly[] = {
+        "2020-02-29", "2021-02-28", "2022-02-28", "2023-02-28",
+        "2024-02-29"
+    };
+    const toolbox::Date jan31(toolbox::GREGORIAN, "2023-01-31", "%Y-%m-%d");
+    const toolbox::Date jun1(toolbox::GREGORIAN, "2024-06-01", "%Y-%m-%d");
+    const toolbox::Date may31(toolbox::GREGORIAN, "2024-05-31", "%Y-%m-%d");
+    const toolbox::Date leap(toolbox::GREGORIAN, "2020-02-29", "%Y-%m-%d");
+    report_date_range_test(range_is(toolbox::DateRange(jan31, jun1, 1,
+            toolbox::DateRange::MONTHS), monthly, 17)
+        && range_is(toolbox::DateRange(jan31, may31, 1,
+            toolbox::DateRange::MONTHS), monthly, 16)
+        && range_is(toolbox::DateRange(jan31, jun1, 3,
+            toolbox::DateRange::MONTHS), quarterly, 6)
+        && range_is(toolbox::DateRange(leap, leap + 1462, 1,
+            toolbox::DateRange::YEARS), yearly, 5)
+        && range_is(toolbox::DateRange(leap, leap + 1461, 1,
+            toolbox::DateRange::YEARS), yearly, 4));
+}
+
+// Every element must be one step of months after the previous one, on the
+// day of first or the last day of a shorter month, and size() must stop
+// exactly before last. Wareki steps through Gregorian months.
+void test_date_range_months(toolbox::CalendarSystem cal_sys, int first,
+                            int last, int step) {
+    const toolbox::DateRange range(toolbox::Date(first), toolbox::Date(last),
+        step, toolbox::DateRange::MONTHS, cal_sys);
+    const toolbox::CalendarSystem month_cal =
+        cal_sys == toolbox::JAPANESE_WAREKI ? toolbox::GREGORIAN : cal_sys;
+    const bool has_bc = month_cal != toolbox::FRENCH_REPUBLICAN;
+    const int per_year = month_cal == toolbox::ETHIOPIAN
+        || month_cal == toolbox::FRENCH_REPUBLICAN ? 13 : 12;
+    const toolbox::CivilDate start = toolbox::Date(first).decompose(month_cal);
+    bool pass = range.size() > 0;
+    toolbox::CivilDate prev = start;
+    for (std::size_t i = 0; i < range.size() && pass; ++i) {
+        const toolbox::Date date = range[i];
+        const toolbox::CivilDate civil = date.decompose(month_cal);
+        const int year = has_bc && civil.era == 0 ? 1 - civil.year
+            : civil.year;
+        const int prev_year = has_bc && prev.era == 0 ? 1 - prev.year
+            : prev.year;
+        const int months = (year - prev_year) * per_year + civil.month
+            - prev.month;
+        pass = date.get_raw_date() < last
+            && (i == 0 ? months == 0 : months == step)
+            && (civil.day == start.day || (civil.day < start.day
+                && (date + 1).decompose(month_cal).day == 1))
+            && date.get_day(cal_sys) == civil.day;
+        prev = civil;
+    }
+    pass = pass && range[range.size()].get_raw_date() >= last;
+    report_date_range_test(pass);
+}
+
+// civil() must match a full conversion on every step.
+void test_date_range_civil(toolbox::CalendarSystem cal_sys, int first,
+                           int count, int step,
+                           toolbox::DateRange::Unit unit) {
+    const toolbox::DateRange range(toolbox::Date(first),
+        toolbox::Date(first + count), step, unit, cal_sys);
+    bool pass = range.size() > 0;
+    for (toolbox::DateRange::iterator it = range.begin();
+            it != range.end() && pass; ++it) {
+        const toolbox::CivilDate& civil = it.civil();
+        const toolbox::CivilDate expected = it->decompose(cal_sys);
+        pass = civil.era == expected.era && civil.year == expected.year
+            && civil.month == expected.month && civil.day == expected.day
+            && civil.weekday == expected.weekday;
+    }
+    report_date_range_test(pass);
+}
+
+void run_date_range_tests() {
+    const int ad_1582 = -141427;  // 1582-10-15
+    const int ad_1792 = toolbox::Date(toolbox::GREGORIAN,
+        toolbox::GregorianCalendar::AD, 1792, 9, 22).get_raw_date();
+    const int ad_1852 = toolbox::Date(toolbox::GREGORIAN,
+        toolbox::GregorianCalendar::AD, 1852, 1, 31).get_raw_date();
+    test_date_range_days();
+    test_date_range_invalid_step();
+    test_date_range_clamping();
+    test_date_range_months(toolbox::GREGORIAN, -720000, -700000, 1);
+    test_date_range_months(toolbox::GREGORIAN, -40, 30000, 5);
+    test_date_range_months(toolbox::NON_PROLEPTIC_GREGORIAN, ad_1582 + 16,
+        ad_1582 + 20000, 1);
+    test_date_range_months(toolbox::JULIAN, -29, 30000, 1);
+    // Three years whose Ethiopian conversions agree both ways.
+    test_date_range_months(toolbox::ETHIOPIAN, 1349, 2444, 1);
+    test_date_range_months(toolbox::FRENCH_REPUBLICAN, ad_1792 + 29,
+        ad_1792 + 5000, 2);
+    test_date_range_months(toolbox::JAPANESE_WAREKI, ad_1852, 0, 1);
+    test_date_range_civil(toolbox::GREGORIAN, -800, 3000, 1,
+        toolbox::DateRange::DAYS);
+    test_date_range_civil(toolbox::NON_PROLEPTIC_GREGORIAN, ad_1582, 3000, 1,
+        toolbox::DateRange::DAYS);
+    test_date_range_civil(toolbox::JULIAN, -800, 3000, 1,
+        toolbox::DateRange::DAYS);
+    test_date_range_civil(toolbox::ETHIOPIAN, -800, 3000, 1,
+        toolbox::DateRange::DAYS);
+    test_date_range_civil(toolbox::FRENCH_REPUBLICAN, ad_1792, 5000, 1,
+        toolbox::DateRange::DAYS);
+    // Crosses the Gregorian reform and the start of Meiji.
+    test_date_range_civil(toolbox::JAPANESE_WAREKI, ad_1582 - 400, 800, 1,
+        toolbox::DateRange::DAYS);
+    test_date_range_civil(toolbox::JAPANESE_WAREKI, ad_1852, 20000, 1,
+        toolbox::DateRange::DAYS);
+    test_date_range_civil(toolbox::GREGORIAN, -800, 3000, 3,
+        toolbox::DateRange::DAYS);
+    test_date_range_civil(toolbox::GREGORIAN, -800, 3000, 1,
+        toolbox::DateRange::WEEKS);
+    test_date_range_civil(toolbox::ETHIOPIAN, -800, 3000, 1,
+        toolbox::DateRange::MONTHS);
+}
+
+void report_civil_cursor_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "civil cursor " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+bool last_day_throws(const toolbox::ICalendarSystem& cal, int era, int year,
+                     int month) {
+    try {
+        cal.last_day_of_month(era, year, month);
+    } catch (const std::out_of_range& e) {
+        (void)e;
+        return true;
+    }
+    return false;
+}
+
+void test_last_day_of_month() {
+    const toolbox::GregorianCalendar greg;
+    const toolbox::JulianCalendar julian;
+    const toolbox::NonProlepticGregorianCalendar non_proleptic;
+    const toolbox::EthiopianCalendar ethiopian;
+    const toolbox::FrenchRepublicanCalendar french;
+    const toolbox::JapaneseWarekiCalendar wareki;
+    const int ad = toolbox::GregorianCalendar::AD;
+    const int bc = toolbox::GregorianCalendar::BC;
+    const toolbox::CivilDate reiwa2 = toolbox::Date(toolbox::GREGORIAN,
+        ad, 2020, 2, 1).decompose(toolbox::JAPANESE_WAREKI);
+    const bool pass = greg.last_day_of_month(ad, 2024, 2) == 29
+        && greg.last_day_of_month(ad, 1900, 2) == 28
+        && greg.last_day_of_month(bc, 1, 2) == 29
+        && greg.last_day_of_month(ad, 2023, 12) == 31
+        && julian.last_day_of_month(ad, 1900, 2) == 29
+        && non_proleptic.last_day_of_month(ad, 1582, 10) == 31
+        && ethiopian.last_day_of_month(toolbox::EthiopianCalendar::AD, 2015,
+            13) == 6
+        && ethiopian.last_day_of_month(toolbox::EthiopianCalendar::AD, 2016,
+            13) == 5
+        && french.last_day_of_month(toolbox::FrenchRepublicanCalendar::AD, 3,
+            13) == 6
+        && french.last_day_of_month(toolbox::FrenchRepublicanCalendar::AD, 3,
+            12) == 30
+        && wareki.last_day_of_month(reiwa2.era, reiwa2.year, 2) == 29
+        && last_day_throws(greg, ad, 2024, 13)
+        && last_day_throws(greg, ad, 0, 1)
+        && last_day_throws(julian, 2, 2024, 1)
+        && last_day_throws(non_proleptic, ad, 1582, 9)
+        && last_day_throws(ethiopian, toolbox::EthiopianCalendar::AD, 2015,
+            14)
+        && last_day_throws(french, toolbox::FrenchRepublicanCalendar::AD, 0,
+            1)
+        && last_day_throws(wareki, -1, 1, 1);
+    report_civil_cursor_test(pass);
+}
+
+// Every date reached by ++, or by += step, must match a full conversion.
+template <toolbox::CalendarSystem Cal>
+void test_civil_cursor_matches(int first, int count, int step) {
+    toolbox::CivilCursor<Cal> cursor((toolbox::Date(first)));
+    bool pass = true;
+    for (int serial = first; serial < first + count && pass;
+            serial += step) {
+        const toolbox::CivilDate& civil = cursor.civil();
+        const toolbox::CivilDate expected
+            = toolbox::Date(serial).decompose<Cal>();
+        pass = cursor.date().get_raw_date() == serial
+            && civil.era == expected.era && civil.year == expected.year
+            && civil.month == expected.month && civil.day == expected.day
+            && civil.weekday == expected.weekday;
+        if (step == 1) {
+            ++cursor;
+        } else {
+            cursor += step;
+        }
+    }
+    report_civil_cursor_test(pass);
+}
+
+void test_civil_cursor_seek() {
+    toolbox::CivilCursor<toolbox::GREGORIAN> cursor(toolbox::Date(19000));
+    cursor += 100;
+    cursor += -365;
+    bool pass = cursor.date() == toolbox::Date(18735)
+        && cursor.civil().day == toolbox::Date(18735).get_day<
+            toolbox::GREGORIAN>();
+    cursor.seek(toolbox::Date(0));
+    ++cursor;
+    pass = pass && cursor.civil().year == 1970 && cursor.civil().month == 1
+        && cursor.civil().day == 2 && cursor.civil().weekday == 5;
+    toolbox::CivilCursor<toolbox::GREGORIAN> copy(cursor);
+    ++copy;
+    cursor = copy;
+    pass = pass && cursor.civil().day == 3;
+    try {
+        toolbox::CivilCursor<toolbox::NON_PROLEPTIC_GREGORIAN> early(
+            toolbox::Date(-141428));
+        pass = false;
+    } catch (const std::out_of_range& e) {
+        (void)e;
+    }
+    report_civil_cursor_test(pass);
+}
+
+void run_civil_cursor_tests() {
+    const int ad_1582 = -141427;  // 1582-10-15
+    const int ad_1792 = toolbox::Date(toolbox::GREGORIAN,
+        toolbox::GregorianCalendar::AD, 1792, 9, 22).get_raw_date();
+    const int ad_1806_end = toolbox::Date(toolbox::GREGORIAN,
+        toolbox::GregorianCalendar::AD, 1806, 12, 31).get_raw_date();
+    const int ad_1330 = toolbox::julian_days_from_civil(1330, 1, 1);
+    const int ad_1852 = toolbox::Date(toolbox::GREGORIAN,
+        toolbox::GregorianCalendar::AD, 1852, 1, 1).get_raw_date();
+    test_last_day_of_month();
+    test_civil_cursor_seek();
+    // Crosses 1 B.C. to A.D. 1.
+    test_civil_cursor_matches<toolbox::GREGORIAN>(-721000, 4000, 1);
+    test_civil_cursor_matches<toolbox::GREGORIAN>(-800, 150000, 1);
+    test_civil_cursor_matches<toolbox::GREGORIAN>(-800, 150000, 7);
+    test_civil_cursor_matches<toolbox::GREGORIAN>(-800, 150000, 45);
+    test_civil_cursor_matches<toolbox::GREGORIAN>(-800, 150000, 1000);
+    test_civil_cursor_matches<toolbox::NON_PROLEPTIC_GREGORIAN>(ad_1582,
+        20000, 1);
+    // Skips 45 B.C. to A.D. 4, which the Julian conversions disagree on.
+    test_civil_cursor_matches<toolbox::JULIAN>(-760000, 24000, 1);
+    test_civil_cursor_matches<toolbox::JULIAN>(-717278, 20000, 1);
+    test_civil_cursor_matches<toolbox::JULIAN>(-717278, 20000, 31);
+    // Skips Pagume, whose day 6 the Ethiopian conversions disagree on.
+    test_civil_cursor_matches<toolbox::ETHIOPIAN>(983, 360, 1);
+    test_civil_cursor_matches<toolbox::ETHIOPIAN>(983, 360, 11);
+    test_civil_cursor_matches<toolbox::FRENCH_REPUBLICAN>(ad_1792,
+        ad_1806_end - ad_1792 + 1, 1);
+    test_civil_cursor_matches<toolbox::FRENCH_REPUBLICAN>(ad_1792,
+        ad_1806_end - ad_1792 + 1, 13);
+    // The Nanboku-cho courts, the Gregorian reform and eras starting
+    // within months (Heisei began on 1989-01-08).
+    test_civil_cursor_matches<toolbox::JAPANESE_WAREKI>(ad_1330, 25000, 1);
+    test_civil_cursor_matches<toolbox::JAPANESE_WAREKI>(ad_1582 - 400, 800,
+        1);
+    test_civil_cursor_matches<toolbox::JAPANESE_WAREKI>(ad_1852, 65000, 1);
+    test_civil_cursor_matches<toolbox::JAPANESE_WAREKI>(ad_1852, 65000, 17);
+}
+
+void report_add_months_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "add months " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+toolbox::Date gregorian_date(int year, int month, int day) {
+    return toolbox::Date(toolbox::GREGORIAN, toolbox::GregorianCalendar::AD,
+        year, month, day);
+}
+
+bool add_months_throws(const toolbox::Date& date,
+                       toolbox::CalendarSystem cal_sys, int months,
+                       toolbox::MonthPolicy policy) {
+    try {
+        date.add_months(cal_sys, months, policy);
+    } catch (const std::out_of_range& e) {
+        (void)e;
+        return true;
+    }
+    return false;
+}
+
+void test_add_months_gregorian() {
+    const toolbox::CalendarSystem g = toolbox::GREGORIAN;
+    const toolbox::Date jan31 = gregorian_date(2024, 1, 31);
+    const toolbox::Date feb29 = gregorian_date(2024, 2, 29);
+    const toolbox::CivilDate bc = gregorian_date(1, 1, 15).add_months(g, -1)
+        .decompose(g);
+    const bool pass = jan31.add_months(g, 1) == feb29
+        && jan31.add_months(g, 1, toolbox::MONTH_OVERFLOW)
+            == gregorian_date(2024, 3, 2)
+        && add_months_throws(jan31, g, 1, toolbox::MONTH_ERROR)
+        && jan31.add_months(g, 2, toolbox::MONTH_ERROR)
+            == gregorian_date(2024, 3, 31)
+        && jan31.add_months(g, 13) == gregorian_date(2025, 2, 28)
+        && gregorian_date(2024, 3, 31).add_months(g, -1) == feb29
+        && jan31.add_months(g, 0) == jan31
+        && feb29.add_years(g, 1) == gregorian_date(2025, 2, 28)
+        && feb29.add_years(g, 1, toolbox::MONTH_OVERFLOW)
+            == gregorian_date(2025, 3, 1)
+        && feb29.add_years(g, -4) == gregorian_date(2020, 2, 29)
+        && bc.era == toolbox::GregorianCalendar::BC && bc.year == 1
+        && bc.month == 12 && bc.day == 15
+        && add_months_throws(jan31, g, 2147483647, toolbox::MONTH_CLAMP);
+    report_add_months_test(pass);
+}
+
+// Follows the definition: the same day in the month months later, or the
+// policy's answer if that month is too short.
+template <toolbox::CalendarSystem Cal>
+toolbox::Date expected_add_months(const toolbox::Date& date, int months,
+                                  toolbox::MonthPolicy policy) {
+    const int months_per_year = toolbox::CalendarTraits<Cal>::months_per_year;
+    const int bc_era = toolbox::CalendarTraits<Cal>::bc_era;
+    const toolbox::CivilDate civil = date.decompose<Cal>();
+    const int first_year = civil.era == bc_era ? 1 - civil.year : civil.year;
+    const int index = first_year * months_per_year + civil.month - 1 + months;
+    const int year = index >= 0 ? index / months_per_year
+        : -((-index - 1) / months_per_year) - 1;
+    const int month = index - year * months_per_year + 1;
+    int era = civil.era;
+    int era_year = year;
+    if (bc_era >= 0) {
+        era = year <= 0 ? bc_era : bc_era + 1;
+        era_year = year <= 0 ? 1 - year : year;
+    }
+    const int last_day = toolbox::calendar_instance<Cal>().last_day_of_month(
+        era, era_year, month);
+    int day = civil.day;
+    if (day > last_day && policy == toolbox::MONTH_CLAMP) {
+        day = last_day;
+    }
+    return toolbox::Date::make<Cal>(era, era_year, month, 1) + (day - 1);
+}
+
+template <toolbox::CalendarSystem Cal>
+void test_add_months_matches(int first, int count, int step) {
+    const int months_per_year = toolbox::CalendarTraits<Cal>::months_per_year;
+    bool pass = true;
+    for (int serial = first; serial < first + count && pass;
+            serial += step) {
+        const toolbox::Date date(serial);
+        const int months = (serial % 40 + 40) % 40 - 20;
+        pass = date.add_months(Cal, months)
+                == expected_add_months<Cal>(date, months,
+                    toolbox::MONTH_CLAMP)
+            && date.add_months(Cal, months, toolbox::MONTH_OVERFLOW)
+                == expected_add_months<Cal>(date, months,
+                    toolbox::MONTH_OVERFLOW)
+            && date.add_years(Cal, months / 7)
+                == date.add_months(Cal, months / 7 * months_per_year);
+    }
+    report_add_months_test(pass);
+}
+
+// The 13th month of the Ethiopian and French Republican calendars holds the
+// 5 or 6 epagomenal days.
+void test_add_months_13th_month() {
+    const toolbox::CalendarSystem e = toolbox::ETHIOPIAN;
+    const toolbox::CalendarSystem f = toolbox::FRENCH_REPUBLICAN;
+    const int ad = toolbox::EthiopianCalendar::AD;
+    const int an = toolbox::FrenchRepublicanCalendar::AD;
+    const toolbox::Date nehase30(e, ad, 2015, 12, 30);
+    const toolbox::Date fructidor30(f, an, 2, 12, 30);
+    const bool pass = nehase30.add_months(e, 1) == toolbox::Date(e, ad, 2015,
+            13, 6)
+        && toolbox::Date(e, ad, 2014, 12, 30).add_months(e, 1)
+            == toolbox::Date(e, ad, 2014, 13, 5)
+        && toolbox::Date(e, ad, 2014, 12, 30).add_months(e, 1,
+            toolbox::MONTH_OVERFLOW) == toolbox::Date(e, ad, 2015, 1, 25)
+        && nehase30.add_years(e, 1) == toolbox::Date(e, ad, 2016, 12, 30)
+        && fructidor30.add_months(f, 1) == toolbox::Date(f, an, 2, 13, 5)
+        && toolbox::Date(f, an, 3, 12, 30).add_months(f, 1)
+            == toolbox::Date(f, an, 3, 13, 6)
+        && fructidor30.add_months(f, 2) == toolbox::Date(f, an, 3, 1, 30)
+        && !add_months_throws(fructidor30, f, 2, toolbox::MONTH_ERROR)
+        && add_months_throws(fructidor30, f, 1, toolbox::MONTH_ERROR)
+        && add_months_throws(toolbox::Date(f, an, 14, 1, 1), f, 17,
+            toolbox::MONTH_CLAMP)
+        && add_months_throws(toolbox::Date(f, an, 1, 1, 1), f, -1,
+            toolbox::MONTH_CLAMP);
+    report_add_months_test(pass);
+}
+
+// Year 15 lies past the dates to_serial_date accepts, but from_serial_date
+// still converts it up to 31 December 1806.
+void test_add_months_last_year() {
+    const toolbox::CalendarSystem f = toolbox::FRENCH_REPUBLICAN;
+    const toolbox::Date oct1 = gregorian_date(1806, 10, 1);
+    const toolbox::CivilDate back = oct1.add_months(f, -1).decompose(f);
+    const toolbox::CivilDate last = gregorian_date(1806, 9, 23)
+        .add_months(f, 3).decompose(f);
+    const bool pass = oct1.get_year(f) == 15
+        && oct1.add_months(f, 0) == oct1
+        && back.year == 14 && back.month == 13 && back.day == 5
+        && last.year == 15 && last.month == 4 && last.day == 1
+        && oct1.add_months(f, 3) == gregorian_date(1806, 12, 30)
+        && add_months_throws(oct1, f, 4, toolbox::MONTH_CLAMP);
+    report_add_months_test(pass);
+}
+
+void test_add_months_wareki() {
+    const toolbox::CalendarSystem w = toolbox::JAPANESE_WAREKI;
+    const toolbox::Date heisei31 = gregorian_date(2019, 4, 30);
+    const toolbox::CivilDate reiwa1 = heisei31.add_months(w, 1).decompose(w);
+    const toolbox::CivilDate heisei1 = gregorian_date(1989, 1, 7)
+        .add_months(w, 1).decompose(w);
+    // Julian 1582-09-10 + 1 month lands in the days the reform skipped.
+    const toolbox::Date sep10(toolbox::JULIAN, toolbox::JulianCalendar::AD,
+        1582, 9, 10);
+    const bool pass = reiwa1.era == toolbox::REIWA && reiwa1.year == 1
+        && reiwa1.month == 5 && reiwa1.day == 30
+        && heisei1.era == toolbox::HEISEI && heisei1.year == 1
+        && heisei1.month == 2 && heisei1.day == 7
+        && gregorian_date(2024, 1, 31).add_months(w, 1)
+            == gregorian_date(2024, 2, 29)
+        && sep10.add_months(w, 1).get_raw_date() == -141428
+        && sep10.add_months(w, 1, toolbox::MONTH_OVERFLOW)
+            == gregorian_date(1582, 10, 20)
+        && add_months_throws(sep10, w, 1, toolbox::MONTH_ERROR)
+        && sep10.add_months(w, 2) == gregorian_date(1582, 11, 10)
+        && sep10.add_months(w, -1) == toolbox::Date(toolbox::JULIAN,
+            toolbox::JulianCalendar::AD, 1582, 8, 10);
+    report_add_months_test(pass);
+}
+
+void test_add_months_non_proleptic() {
+    const toolbox::CalendarSystem n = toolbox::NON_PROLEPTIC_GREGORIAN;
+    const toolbox::Date nov15 = gregorian_date(1582, 11, 15);
+    const bool pass = nov15.add_months(n, -1) == gregorian_date(1582, 10, 15)
+        && add_months_throws(nov15, n, -2, toolbox::MONTH_CLAMP)
+        && add_months_throws(gregorian_date(1582, 11, 14), n, -1,
+            toolbox::MONTH_CLAMP)
+        && add_months_throws(gregorian_date(1582, 10, 14), n, 1,
+            toolbox::MONTH_CLAMP);
+    report_add_months_test(pass);
+}
+
+void test_add_months_batch() {
+    const int count = 1000;
+    std::vector<int> serials(count);
+    std::vector<int> results(count);
+    for (int i = 0; i < count; ++i) {
+        serials[i] = 19000 + i * 3;
+    }
+    toolbox::Date::add_months(toolbox::GREGORIAN, &serials[0], count, 7,
+        toolbox::MONTH_CLAMP, &results[0]);
+    bool pass = true;
+    for (int i = 0; i < count && pass; ++i) {
+        pass = results[i] == toolbox::Date(serials[i]).add_months(
+            toolbox::GREGORIAN, 7).get_raw_date();
+    }
+    toolbox::Date::add_years(toolbox::ETHIOPIAN, &serials[0], count, 2,
+        toolbox::MONTH_OVERFLOW, &results[0]);
+    for (int i = 0; i < count && pass; ++i) {
+        pass = results[i] == toolbox::Date(serials[i]).add_years(
+            toolbox::ETHIOPIAN, 2, toolbox::MONTH_OVERFLOW).get_raw_date();
+    }
+    // Stops at the first date whose day the target month lacks.
+    serials[5] = gregorian_date(2024, 1, 31).get_raw_date();
+    try {
+        toolbox::Date::add_months(toolbox::GREGORIAN, &serials[0], count, 1,
+            toolbox::MONTH_ERROR, &results[0]);
+        pass = false;
+    } catch (const std::out_of_range& e) {
+        (void)e;
+    }
+    report_add_months_test(pass);
+}
+
+void run_add_months_tests() {
+    const int ad_1582 = -141427;  // 1582-10-15
+    const int ad_1792 = gregorian_date(1792, 9, 22).get_raw_date();
+    test_add_months_gregorian();
+    test_add_months_matches<toolbox::GREGORIAN>(-740000, 50000, 7);
+    test_add_months_matches<toolbox::GREGORIAN>(-1000, 30000, 1);
+    test_add_months_matches<toolbox::NON_PROLEPTIC_GREGORIAN>(ad_1582 + 1200,
+        30000, 3);
+    // Skips 45 B.C. to A.D. 4, which the Julian conversions disagree on.
+    test_add_months_matches<toolbox::JULIAN>(-717278 + 1200, 30000, 3);
+    // Skips Pagume, whose day 6 the Ethiopian conversions disagree on.
+    test_add_months_matches<toolbox::ETHIOPIAN>(983, 360, 1);
+    test_add_months_matches<toolbox::FRENCH_REPUBLICAN>(ad_1792 + 1200,
+        3000, 1);
+    test_add_months_13th_month();
+    test_add_months_last_year();
+    test_add_months_wareki();
+    test_add_months_non_proleptic();
+    test_add_months_batch();
+}
+
+void report_business_calendar_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "business calendar " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+bool business_calendar_throws(const toolbox::BusinessCalendar& calendar,
+                              const toolbox::Date& date, int days) {
+    try {
+        calendar.add_business_days(date, days);
+    } catch (const std::out_of_range& e) {
+        (void)e;
+        return true;
+    }
+    return false;
+}
+
+void test_business_calendar_weekends() {
+    const toolbox::BusinessCalendar calendar(gregorian_date(2024, 1, 1),
+        gregorian_date(2025, 1, 1));
+    const toolbox::Date fri = gregorian_date(2024, 3, 1);
+    const toolbox::Date sat = gregorian_date(2024, 3, 2);
+    const toolbox::Date mon = gregorian_date(2024, 3, 4);
+    const bool pass = calendar.is_business_day(fri)
+        && !calendar.is_business_day(sat)
+        && calendar.next_business_day(fri) == mon
+        && calendar.next_business_day(sat) == mon
+        && calendar.previous_business_day(mon) == fri
+        && calendar.add_business_days(sat, 0) == mon
+        && calendar.add_business_days(fri, 0) == fri
+        && calendar.add_business_days(fri, 1) == mon
+        && calendar.add_business_days(mon, -1) == fri
+        && calendar.add_business_days(fri, 5) == gregorian_date(2024, 3, 8)
+        && calendar.business_days_between(calendar.first(),
+            calendar.last()) == 262
+        && calendar.business_days_between(mon, fri) == -1
+        && calendar.business_days_between(fri, fri) == 0
+        && calendar.add_business_days(calendar.first(), 261)
+            == gregorian_date(2024, 12, 31)
+        && business_calendar_throws(calendar, calendar.first(), 262)
+        && business_calendar_throws(calendar, calendar.first(), -1);
+    report_business_calendar_test(pass);
+}
+
+// National holidays of Japan in 2024 without the substitute holidays:
+// fixed dates and the "Happy Monday" ones.
+void test_business_calendar_japan() {
+    const toolbox::CalendarSystem g = toolbox::GREGORIAN;
+    toolbox::BusinessCalendar tokyo(gregorian_date(2024, 1, 1),
+        gregorian_date(2025, 1, 1));
+    const int fixed[][2] = {
+        {1, 1}, {2, 11}, {2, 23}, {3, 20}, {4, 29}, {5, 3}, {5, 4}, {5, 5},
+        {8, 11}, {9, 22}, {11, 3}, {11, 23}
+    };
+    for (std::size_t i = 0; i < sizeof(fixed) / sizeof(fixed[0]); ++i) {
+        tokyo.add_annual_holiday(g, fixed[i][0], fixed[i][1]);
+    }
+    tokyo.add_nth_weekday_holiday(g, 1, 1, 2);
+    tokyo.add_nth_weekday_holiday(g, 7, 1, 3);
+    tokyo.add_nth_weekday_holiday(g, 9, 1, 3);
+    tokyo.add_nth_weekday_holiday(g, 10, 1, 2);
+    // T+2 from Friday, January 5 skips the weekend and Coming of Age Day.
+    const bool pass = !tokyo.is_business_day(gregorian_date(2024, 1, 8))
+        && !tokyo.is_business_day(gregorian_date(2024, 7, 15))
+        && !tokyo.is_business_day(gregorian_date(2024, 9, 16))
+        && !tokyo.is_business_day(gregorian_date(2024, 10, 14))
+        && tokyo.is_business_day(gregorian_date(2024, 10, 7))
+        && !tokyo.is_business_day(gregorian_date(2024, 3, 20))
+        && tokyo.add_business_days(gregorian_date(2024, 1, 5), 2)
+            == gregorian_date(2024, 1, 10)
+        && tokyo.previous_business_day(gregorian_date(2024, 5, 6))
+            == gregorian_date(2024, 5, 2)
+        && tokyo.business_days_between(tokyo.first(), tokyo.last())
+            == 262 - 5 - 4;
+    report_business_calendar_test(pass);
+}
+
+void test_business_calendar_last_weekday() {
+    toolbox::BusinessCalendar calendar(gregorian_date(2023, 1, 1),
+        gregorian_date(2025, 1, 1), 0);
+    calendar.add_nth_weekday_holiday(toolbox::GREGORIAN, 5, 1, -1);
+    calendar.add_nth_weekday_holiday(toolbox::GREGORIAN, 2, 4, -2);
+    const bool pass = !calendar.is_business_day(gregorian_date(2024, 5, 27))
+        && !calendar.is_business_day(gregorian_date(2023, 5, 29))
+        && calendar.is_business_day(gregorian_date(2024, 5, 20))
+        && !calendar.is_business_day(gregorian_date(2024, 2, 22))
+        && !calendar.is_business_day(gregorian_date(2023, 2, 16))
+        && calendar.business_days_between(calendar.first(),
+            calendar.last()) == 731 - 4;
+    report_business_calendar_test(pass);
+}
+
+// Meskerem 1 (Enkutatash), Meskerem 17 (Meskel) and Tahsas 29 (Genna) by
+// Ethiopian dates, within the years the Ethiopian conversions agree on.
+void test_business_calendar_ethiopian() {
+    const toolbox::CalendarSystem e = toolbox::ETHIOPIAN;
+    toolbox::BusinessCalendar addis(toolbox::Date(1400),
+        toolbox::Date(2400));
+    addis.add_annual_holiday(e, 1, 1);
+    addis.add_annual_holiday(e, 1, 17);
+    addis.add_annual_holiday(e, 4, 29);
+    bool pass = !addis.is_business_day(gregorian_date(1975, 1, 7))
+        && addis.is_business_day(gregorian_date(1975, 1, 8));
+    for (int serial = 1400; serial < 2400 && pass; ++serial) {
+        const toolbox::Date date(serial);
+        const toolbox::CivilDate civil = date.decompose(e);
+        const bool holiday = (civil.month == 1
+                && (civil.day == 1 || civil.day == 17))
+            || (civil.month == 4 && civil.day == 29);
+        const bool weekend = civil.weekday == 0 || civil.weekday == 6;
+        pass = addis.is_business_day(date) == !(holiday || weekend);
+    }
+    report_business_calendar_test(pass);
+}
+
+// The French Republican weekday of a décadi is 9; Vendémiaire has three.
+// Year III is a leap year of 366 days.
+void test_business_calendar_french() {
+    const toolbox::CalendarSystem f = toolbox::FRENCH_REPUBLICAN;
+    const int an = toolbox::FrenchRepublicanCalendar::AD;
+    toolbox::BusinessCalendar paris(toolbox::Date(f, an, 3, 1, 1),
+        toolbox::Date(f, an, 4, 1, 1), 0);
+    paris.add_nth_weekday_holiday(f, 1, 9, 1);
+    paris.add_nth_weekday_holiday(f, 1, 9, -1);
+    const bool pass = !paris.is_business_day(toolbox::Date(f, an, 3, 1, 10))
+        && paris.is_business_day(toolbox::Date(f, an, 3, 1, 20))
+        && !paris.is_business_day(toolbox::Date(f, an, 3, 1, 30))
+        && paris.business_days_between(paris.first(), paris.last())
+            == 366 - 2;
+    report_business_calendar_test(pass);
+}
+
+// Compares the word-wise counting and skipping with a day-by-day walk over
+// irregular holidays.
+void test_business_calendar_matches() {
+    const toolbox::Date first = gregorian_date(2000, 1, 1);
+    const int size = 3653;
+    toolbox::BusinessCalendar calendar(first, first + size);
+    for (int i = 0; i < size; ++i) {
+        if ((i * 7919) % 29 == 0) {
+            calendar.add_holiday(first + i);
+        }
+    }
+    std::vector<bool> open(size);
+    std::vector<int> before(size + 1, 0);  // business days before index
+    for (int i = 0; i < size; ++i) {
+        open[i] = calendar.is_business_day(first + i);
+        before[i + 1] = before[i] + (open[i] ? 1 : 0);
+    }
+    bool pass = true;
+    for (int i = 0; i <= size && pass; i += 37) {
+        for (int j = 0; j <= size && pass; j += 41) {
+            pass = calendar.business_days_between(first + i, first + j)
+                == before[j] - before[i];
+        }
+    }
+    for (int i = 0; i < size && pass; i += 5) {
+        for (int days = -150; days <= 150 && pass; days += 13) {
+            int k = i;
+            if (days == 0) {
+                while (k < size && !open[k]) {
+                    ++k;
+                }
+            }
+            for (int rest = days; rest > 0 && k < size; ) {
+                if (++k < size && open[k]) {
+                    --rest;
+                }
+            }
+            for (int rest = -days; rest > 0 && k >= 0; ) {
+                if (--k >= 0 && open[k]) {
+                    --rest;
+                }
+            }
+            if (k < 0 || k >= size) {
+                pass = business_calendar_throws(calendar, first + i, days);
+            } else {
+                pass = calendar.add_business_days(first + i, days)
+                    == first + k;
+            }
+        }
+    }
+    report_business_calendar_test(pass);
+}
+
+void test_business_calendar_errors() {
+    toolbox::BusinessCalendar calendar(gregorian_date(2024, 1, 1),
+        gregorian_date(2024, 1, 6));
+    int thrown = 0;
+    try {
+        calendar.add_holiday(gregorian_date(2024, 1, 6));
+    } catch (const std::out_of_range& e) {
+        (void)e;
+        ++thrown;
+    }
+    try {
+        calendar.next_business_day(gregorian_date(2024, 1, 5));
+    } catch (const std::out_of_range& e) {
+        (void)e;
+        ++thrown;
+    }
+    try {
+        calendar.add_nth_weekday_holiday(toolbox::GREGORIAN, 1, 1, 0);
+    } catch (const std::invalid_argument& e) {
+        (void)e;
+        ++thrown;
+    }
+    try {
+        toolbox::BusinessCalendar reversed(gregorian_date(2024, 1, 6),
+            gregorian_date(2024, 1, 1));
+    } catch (const std::invalid_argument& e) {
+        (void)e;
+        ++thrown;
+    }
+    // An empty calendar has no business days but still counts nothing.
+    const toolbox::BusinessCalendar empty(gregorian_date(2024, 1, 1),
+        gregorian_date(2024, 1, 1));
+    const bool pass = thrown == 4 && !empty.contains(empty.first())
+        && empty.business_days_between(empty.first(), empty.last()) == 0
+        && calendar.business_days_between(calendar.first(),
+            calendar.last()) == 5;
+    report_business_calendar_test(pass);
+}
+
+void run_business_calendar_tests() {
+    test_business_calendar_weekends();
+    test_business_calendar_japan();
+    test_business_calendar_last_weekday();
+    test_business_calendar_ethiopian();
+    test_business_calendar_french();
+    test_business_calendar_matches();
+    test_business_calendar_errors();
+}
+
+void report_recurrence_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "recurrence " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+// Whether the rule expands from start into the Gregorian dates of expected
+// (year, month, day triples) and then ends.
+bool recurrence_is(const toolbox::Date& start,
+                   const toolbox::RecurrenceRule& rule,
+                   const int (*expected)[3], std::size_t count) {
+    toolbox::Recurrence recurrence(start, rule);
+    for (std::size_t i = 0; i < count; ++i) {
+        toolbox::Date date;
+        if (!recurrence.next(date) || date != gregorian_date(expected[i][0],
+                expected[i][1], expected[i][2])) {
+            return false;
+        }
+    }
+    toolbox::Date date;
+    return !recurrence.next(date);
+}
+
+toolbox::RecurrenceRule weekday_rule(toolbox::RecurrenceRule::Frequency
+                                         frequency,
+                                     int weekday, int nth) {
+    toolbox::RecurrenceRule rule(frequency);
+    const toolbox::WeekdayNth entry = {weekday, nth};
+    rule.by_weekday.push_back(entry);
+    return rule;
+}
+
+void test_recurrence_monthly() {
+    toolbox::RecurrenceRule last_friday = weekday_rule(
+        toolbox::RecurrenceRule::MONTHLY, 5, -1);
+    last_friday.until = gregorian_date(2024, 6, 28);
+    const int last_fridays[][3] = {
+        {2024, 1, 26}, {2024, 2, 23}, {2024, 3, 29}, {2024, 4, 26},
+        {2024, 5, 31}, {2024, 6, 28}
+    };
+    toolbox::RecurrenceRule second_tuesday = weekday_rule(
+        toolbox::RecurrenceRule::MONTHLY, 2, 2);
+    second_tuesday.count = 3;
+    const int second_tuesdays[][3] = {
+        {2024, 1, 9}, {2024, 2, 13}, {2024, 3, 12}
+    };
+    // The 31st skips shorter months; -1 is the last day of each month.
+    toolbox::RecurrenceRule day31(toolbox::RecurrenceRule::MONTHLY);
+    day31.count = 4;
+    const int days31[][3] = {
+        {2024, 1, 31}, {2024, 3, 31}, {2024, 5, 31}, {2024, 7, 31}
+    };
+    toolbox::RecurrenceRule month_end(toolbox::RecurrenceRule::MONTHLY);
+    month_end.by_month_day.push_back(-1);
+    month_end.interval = 2;
+    month_end.count = 3;
+    const int month_ends[][3] = {
+        {2024, 1, 31}, {2024, 3, 31}, {2024, 5, 31}
+    };
+    // The last weekday of each month.
+    toolbox::RecurrenceRule last_weekday(toolbox::RecurrenceRule::MONTHLY);
+    for (int weekday = 1; weekday <= 5; ++weekday) {
+        const toolbox::WeekdayNth entry = {weekday, 0};
+        last_weekday.by_weekday.push_back(entry);
+    }
+    last_weekday.by_set_pos.push_back(-1);
+    last_weekday.count = 4;
+    const int last_weekdays[][3] = {
+        {2024, 8, 30}, {2024, 9, 30}, {2024, 10, 31}, {2024, 11, 29}
+    };
+    const bool pass = recurrence_is(gregorian_date(2024, 1, 1), last_friday,
+            last_fridays, 6)
+        && recurrence_is(gregorian_date(2024, 1, 1), second_tuesday,
+            second_tuesdays, 3)
+        && recurrence_is(gregorian_date(2024, 1, 31), day31, days31, 4)
+        && recurrence_is(gregorian_date(2024, 1, 15), month_end,
+            month_ends, 3)
+        && recurrence_is(gregorian_date(2024, 8, 15), last_weekday,
+            last_weekdays, 4);
+    report_recurrence_test(pass);
+}
+
+void test_recurrence_weekly_daily() {
+    toolbox::RecurrenceRule biweekly = weekday_rule(
+        toolbox::RecurrenceRule::WEEKLY, 2, 0);
+    const toolbox::WeekdayNth thursday = {4, 0};
+    biweekly.by_weekday.push_back(thursday);
+    biweekly.interval = 2;
+    biweekly.count = 6;
+    const int biweekly_dates[][3] = {
+        {2024, 1, 4}, {2024, 1, 16}, {2024, 1, 18}, {2024, 1, 30},
+        {2024, 2, 1}, {2024, 2, 13}
+    };
+    // Weekly from a Wednesday keeps Wednesdays.
+    toolbox::RecurrenceRule weekly(toolbox::RecurrenceRule::WEEKLY);
+    weekly.until = gregorian_date(2024, 1, 24);
+    const int weekly_dates[][3] = {
+        {2024, 1, 3}, {2024, 1, 10}, {2024, 1, 17}, {2024, 1, 24}
+    };
+    // Every third day in February only.
+    toolbox::RecurrenceRule daily(toolbox::RecurrenceRule::DAILY);
+    daily.interval = 3;
+    daily.by_month.push_back(2);
+    daily.until = gregorian_date(2025, 2, 5);
+    const int daily_dates[][3] = {
+        {2024, 2, 3}, {2024, 2, 6}, {2024, 2, 9}, {2024, 2, 12},
+        {2024, 2, 15}, {2024, 2, 18}, {2024, 2, 21}, {2024, 2, 24},
+        {2024, 2, 27}, {2025, 2, 3}
+    };
+    const bool pass = recurrence_is(gregorian_date(2024, 1, 3), biweekly,
+            biweekly_dates, 6)
+        && recurrence_is(gregorian_date(2024, 1, 3), weekly, weekly_dates, 4)
+        && recurrence_is(gregorian_date(2024, 1, 1), daily, daily_dates, 10);
+    report_recurrence_test(pass);
+}
+
+void test_recurrence_yearly() {
+    // Thanksgiving, the 20th Monday of the year and February 29.
+    toolbox::RecurrenceRule thanksgiving = weekday_rule(
+        toolbox::RecurrenceRule::YEARLY, 4, 4);
+    thanksgiving.by_month.push_back(11);
+    thanksgiving.count = 3;
+    const int thanksgivings[][3] = {
+        {2024, 11, 28}, {2025, 11, 27}, {2026, 11, 26}
+    };
+    toolbox::RecurrenceRule monday20 = weekday_rule(
+        toolbox::RecurrenceRule::YEARLY, 1, 20);
+    monday20.count = 2;
+    const int mondays20[][3] = {{2024, 5, 13}, {2025, 5, 19}};
+    toolbox::RecurrenceRule leap_day(toolbox::RecurrenceRule::YEARLY);
+    leap_day.until = gregorian_date(2105, 1, 1);
+    const int leap_days[][3] = {
+        {2096, 2, 29}, {2104, 2, 29}
+    };
+    // Yearly on the first and the 15th of March and September.
+    toolbox::RecurrenceRule twice(toolbox::RecurrenceRule::YEARLY);
+    twice.by_month.push_back(3);
+    twice.by_month.push_back(9);
+    twice.by_month_day.push_back(1);
+    twice.by_month_day.push_back(15);
+    twice.count = 5;
+    const int twice_dates[][3] = {
+        {2024, 3, 15}, {2024, 9, 1}, {2024, 9, 15}, {2025, 3, 1},
+        {2025, 3, 15}
+    };
+    const bool pass = recurrence_is(gregorian_date(2024, 1, 1), thanksgiving,
+            thanksgivings, 3)
+        && recurrence_is(gregorian_date(2024, 1, 1), monday20, mondays20, 2)
+        && recurrence_is(gregorian_date(2096, 2, 29), leap_day, leap_days, 2)
+        && recurrence_is(gregorian_date(2024, 3, 2), twice, twice_dates, 5);
+    report_recurrence_test(pass);
+}
+
+// The first of every Ethiopian month, the 13th month (Pagume) included, and
+// every French Republican décadi.
+void test_recurrence_calendars() {
+    toolbox::RecurrenceRule ethiopian(toolbox::RecurrenceRule::MONTHLY,
+        toolbox::ETHIOPIAN);
+    ethiopian.by_month_day.push_back(1);
+    toolbox::Recurrence firsts(toolbox::Date(1400), ethiopian);
+    bool pass = true;
+    toolbox::Date date;
+    toolbox::CivilDate previous = {0, 0, 0, 0, 0};
+    for (int i = 0; i < 26 && pass; ++i) {
+        pass = firsts.next(date);
+        const toolbox::CivilDate civil = date.decompose(toolbox::ETHIOPIAN);
+        pass = pass && civil.day == 1 && (i == 0
+            || civil.month == previous.month % 13 + 1);
+        previous = civil;
+    }
+    const toolbox::CalendarSystem f = toolbox::FRENCH_REPUBLICAN;
+    const int an = toolbox::FrenchRepublicanCalendar::AD;
+    toolbox::RecurrenceRule decadi = weekday_rule(
+        toolbox::RecurrenceRule::MONTHLY, 9, 0);
+    decadi.cal_sys = f;
+    toolbox::Recurrence decadis(toolbox::Date(f, an, 3, 1, 1), decadi);
+    for (int i = 0; i < 36 && pass; ++i) {
+        pass = decadis.next(date)
+            && date == toolbox::Date(f, an, 3, i / 3 + 1, i % 3 * 10 + 10);
+    }
+    // Until the end of the calendar in year XIV; the 13th months are too
+    // short for a décadi.
+    std::vector<toolbox::Date> all;
+    decadis.reset();
+    decadis.expand(toolbox::Date(INT_MAX), all);
+    pass = pass && all.size() == 12 * 12 * 3
+        && all.back() == toolbox::Date(f, an, 14, 12, 30);
+    // The wareki month of the Reiwa era change.
+    toolbox::RecurrenceRule wareki(toolbox::RecurrenceRule::MONTHLY,
+        toolbox::JAPANESE_WAREKI);
+    toolbox::Recurrence thirtieths(gregorian_date(2019, 3, 30), wareki);
+    for (int month = 3; month <= 6 && pass; ++month) {
+        pass = thirtieths.next(date) && date == gregorian_date(2019, month,
+            30);
+    }
+    report_recurrence_test(pass);
+}
+
+// Compares the nth weekdays of each month with their definition: the nth
+// from the start is on days 7(n - 1) + 1..7n, the nth from the end has n - 1
+// more after it in its month.
+void test_recurrence_matches() {
+    const toolbox::Date first = gregorian_date(1999, 12, 1);
+    const toolbox::Date last = gregorian_date(2031, 1, 1);
+    bool pass = true;
+    std::vector<toolbox::Date> dates;
+    dates.reserve(512);
+    for (int weekday = 0; weekday < 7 && pass; ++weekday) {
+        for (int nth = -5; nth <= 5 && pass; ++nth) {
+            toolbox::Recurrence recurrence(first, weekday_rule(
+                toolbox::RecurrenceRule::MONTHLY, weekday, nth));
+            dates.clear();
+            recurrence.expand(last, dates);
+            std::size_t k = 0;
+            for (toolbox::Date date = first; date < last && pass; ++date) {
+                const toolbox::CivilDate civil = date.decompose(
+                    toolbox::GREGORIAN);
+                const int days = toolbox::Date::last_day_of_month(
+                    toolbox::GREGORIAN, civil.era, civil.year, civil.month);
+                const bool expected = civil.weekday == weekday && (nth == 0
+                    || (nth > 0 && (civil.day - 1) / 7 == nth - 1)
+                    || (nth < 0 && (days - civil.day) / 7 == -nth - 1));
+                if (expected) {
+                    pass = k < dates.size() && dates[k++] == date;
+                }
+            }
+            pass = pass && k == dates.size();
+        }
+    }
+    // The generator, the buffer and the vector agree.
+    toolbox::RecurrenceRule rule = weekday_rule(
+        toolbox::RecurrenceRule::YEARLY, 3, 0);
+    rule.by_month_day.push_back(13);
+    rule.by_month_day.push_back(-13);
+    rule.count = 200;
+    toolbox::Recurrence one(first, rule);
+    toolbox::Recurrence many(first, rule);
+    toolbox::Date buffer[7];
+    std::size_t total = 0;
+    for (std::size_t size = many.next(buffer, 7); size > 0 && pass;
+            size = many.next(buffer, 7)) {
+        for (std::size_t i = 0; i < size && pass; ++i) {
+            toolbox::Date date;
+            pass = one.next(date) && date == buffer[i];
+        }
+        total += size;
+    }
+    pass = pass && total == 200;
+    report_recurrence_test(pass);
+}
+
+bool recurrence_rule_throws(const toolbox::RecurrenceRule& rule) {
+    try {
+        toolbox::Recurrence recurrence(gregorian_date(2024, 1, 1), rule);
+    } catch (const std::invalid_argument& e) {
+        (void)e;
+        return true;
+    }
+    return false;
+}
+
+void test_recurrence_errors() {
+    toolbox::RecurrenceRule zero(toolbox::RecurrenceRule::DAILY);
+    zero.interval = 0;
+    toolbox::RecurrenceRule month(toolbox::RecurrenceRule::MONTHLY);
+    month.by_month.push_back(13);
+    toolbox::RecurrenceRule day(toolbox::RecurrenceRule::MONTHLY);
+    day.by_month_day.push_back(0);
+    toolbox::RecurrenceRule set_pos(toolbox::RecurrenceRule::MONTHLY);
+    set_pos.by_set_pos.push_back(0);
+    // February 30 never comes: the expansion ends instead of looping.
+    toolbox::RecurrenceRule never(toolbox::RecurrenceRule::YEARLY);
+    never.by_month.push_back(2);
+    never.by_month_day.push_back(30);
+    toolbox::Recurrence recurrence(gregorian_date(2024, 1, 1), never);
+    toolbox::Date date;
+    const bool pass = recurrence_rule_throws(zero)
+        && recurrence_rule_throws(month) && recurrence_rule_throws(day)
+        && recurrence_rule_throws(set_pos)
+        && recurrence_rule_throws(weekday_rule(
+            toolbox::RecurrenceRule::WEEKLY, 1, 1))
+        && recurrence_rule_throws(weekday_rule(
+            toolbox::RecurrenceRule::MONTHLY, 7, 0))
+        && !recurrence.next(date);
+    report_recurrence_test(pass);
+}
+
+// A by_set_pos beyond every period selects nothing, which ends the
+// expansion after 400 years like a date that never comes.
+void test_recurrence_empty_set_pos() {
+    toolbox::RecurrenceRule daily(toolbox::RecurrenceRule::DAILY);
+    daily.by_set_pos.push_back(2);
+    toolbox::RecurrenceRule monday = weekday_rule(
+        toolbox::RecurrenceRule::MONTHLY, 1, 0);
+    monday.by_set_pos.push_back(10);
+    toolbox::Recurrence daily_recurrence(gregorian_date(2024, 1, 1), daily);
+    toolbox::Recurrence monday_recurrence(gregorian_date(2024, 1, 1),
+        monday);
+    toolbox::Date date;
+    report_recurrence_test(!daily_recurrence.next(date)
+        && !monday_recurrence.next(date));
+}
+
+void run_recurrence_tests() {
+    test_recurrence_monthly();
+    test_recurrence_weekly_daily();
+    test_recurrence_yearly();
+    test_recurrence_calendars();
+    test_recurrence_matches();
+    test_recurrence_errors();
+    test_recurrence_empty_set_pos();
+}
+
+void report_format_to_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "format to " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+bool format_int_is(int value, int min_width, const char* expected) {
+    char out[16];
+    const std::size_t len = toolbox::format_int(out, value, min_width);
+    return std::string(out, len) == expected;
+}
+
+void test_format_int() {
+    report_format_to_test(format_int_is(0, 0, "0")
+        && format_int_is(7, 2, "07")
+        && format_int_is(42, 2, "42")
+        && format_int_is(5, 4, "0005")
+        && format_int_is(2024, 4, "2024")
+        && format_int_is(123456, 2, "123456")
+        && format_int_is(-5, 2, "-05")
+        && format_int_is(2147483647, 0, "2147483647")
+        && format_int_is(-2147483647 - 1, 0, "-2147483648"));
+}
+
+void test_format_to_truncation() {
+    const toolbox::Date date(toolbox::GREGORIAN,
+        toolbox::GregorianCalendar::AD, 2024, 1, 2);
+    const toolbox::DateFormat format("%Y-%m-%d");
+    char buf[16];
+
+    // cap 0 only measures
+    buf[0] = 'x';
+    bool pass = date.format_to(buf, 0, toolbox::GREGORIAN, format) == 10
+        && buf[0] == 'x';
+    // Truncated output is still terminated
+    pass = pass && date.format_to(buf, 5, toolbox::GREGORIAN, format) == 10
+        && std::string(buf) == "2024";
+    // Exactly enough room
+    pass = pass && date.format_to(buf, 11, toolbox::GREGORIAN, format) == 10
+        && std::string(buf) == "2024-01-02";
+    report_format_to_test(pass);
+
+    // Output longer than the stack buffer of to_string
+    const std::string long_literal(200, '.');
+    const toolbox::DateFormat long_format((long_literal + "%Y").c_str());
+    report_format_to_test(
+        date.to_string(toolbox::GREGORIAN, long_format)
+            == long_literal + "2024");
+}
+
+// format_to must write exactly what to_string returns.
+void test_format_to_matches(toolbox::CalendarSystem cal_sys,
+                            const char* pattern,
+                            int first,
+                            int count) {
+    const toolbox::DateFormat format(pattern);
+    bool pass = true;
+    try {
+        char buf[256];
+        for (int serial = first; serial < first + count && pass; ++serial) {
+            const toolbox::Date date(serial);
+            const std::string expected = date.to_string(cal_sys, pattern);
+            const std::size_t len = date.format_to(buf, sizeof(buf), cal_sys,
+                format);
+            if (len != expected.size() || expected != buf) {
+                pass = false;
+                std::cout << "  serial=" << serial << " expected=" << expected
+                          << " actual=" << buf << std::endl;
+            }
+        }
+    } catch (const std::exception& e) {
+        pass = false;
+        std::cout << "  threw: " << e.what() << std::endl;
+    }
+    report_format_to_test(pass);
+}
+
+void run_format_to_tests() {
+    const toolbox::GregorianCalendar gregorian;
+    const int ad_1792 = gregorian.to_serial_date(
+        toolbox::GregorianCalendar::AD, 1792, 9, 22);
+    const int ad_1868 = gregorian.to_serial_date(
+        toolbox::GregorianCalendar::AD, 1868, 10, 23);
+
+    test_format_int();
+    test_format_to_truncation();
+    test_format_to_matches(toolbox::GREGORIAN,
+        "%E %Y-%m-%d (%W) %e%y/%M/%D %w", -800000, 2000);
+    test_format_to_matches(toolbox::NON_PROLEPTIC_GREGORIAN,
+        "%Y-%m-%d", 0, 2000);
+    test_format_to_matches(toolbox::JULIAN,
+        "%E %Y-%m-%d (%W) %e%y/%M/%D %w", -800000, 2000);
+    test_format_to_matches(toolbox::ETHIOPIAN,
+        "%E %Y-%M-%D %e %y %m %d %W %w", 0, 2000);
+    test_format_to_matches(toolbox::FRENCH_REPUBLICAN,
+        "%E %Y %M %D %e %y %m %d %W %w", ad_1792, 2000);
+    test_format_to_matches(toolbox::JAPANESE_WAREKI,
+        "%E%Y年%M月%D日", ad_1868, 2000);
+}
+
+// Checks one Gregorian batch kernel against the scalar conversions on the
+// given serial dates, including a round trip back through to_serial_dates.
+bool check_gregorian_kernel(toolbox::GregorianBatchKernel kernel,
+                            const std::vector<int>& serials) {
+    const toolbox::GregorianCalendar gregorian;
+    const std::size_t count = serials.size();
+    std::vector<int> eras(count), years(count), months(count), days(count);
+    std::vector<int> back(count);
+    toolbox::gregorian_from_serial_dates(&serials[0], count,
+        &eras[0], &years[0], &months[0], &days[0], kernel);
+    for (std::size_t i = 0; i < count; ++i) {
+        int era, year, month, day;
+        gregorian.from_serial_date(serials[i], era, year, month, day);
+        if (era != eras[i] || year != years[i] || month != months[i] ||
+            day != days[i]) {
+            std::cout << "  serial=" << serials[i] << " kernel="
+                      << eras[i] << "/" << years[i] << "/" << months[i]
+                      << "/" << days[i] << " scalar=" << era << "/"
+                      << year << "/" << month << "/" << day << std::endl;
+            return false;
+        }
+    }
+    toolbox::gregorian_to_serial_dates(&eras[0], &years[0], &months[0],
+        &days[0], count, &back[0], kernel);
+    if (back != serials) {
+        std::cout << "  to_serial_dates differs from to_serial_date"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// An invalid date inside a vector block must throw exactly like the scalar
+// conversion does.
+bool check_gregorian_kernel_rejects(toolbox::GregorianBatchKernel kernel,
+                                    int era, int year, int month, int day) {
+    std::vector<int> eras(19, toolbox::GregorianCalendar::AD);
+    std::vector<int> years(19, 2024), months(19, 2), days(19, 28);
+    std::vector<int> serials(19);
+    eras[9] = era;
+    years[9] = year;
+    months[9] = month;
+    days[9] = day;
+    try {
+        toolbox::gregorian_to_serial_dates(&eras[0], &years[0], &months[0],
+            &days[0], eras.size(), &serials[0], kernel);
+    } catch (const std::out_of_range& e) {
+        (void)e;
+        return true;
+    }
+    return false;
+}
+
+void test_gregorian_kernel(toolbox::GregorianBatchKernel kernel) {
+    static int test_num = 0;
+    const int kernel_min = -12699422;
+    const int kernel_max = 1061042401;
+    std::vector<int> serials;
+    // Every day from about 770 to 10180
+    for (int serial = -1000000; serial < 3000000; ++serial) {
+        serials.push_back(serial);
+    }
+    // The whole kernel range, with a stride coprime to the cycle lengths
+    for (int serial = kernel_min - 1000; serial < kernel_max + 1000;
+            serial += 9973) {
+        serials.push_back(serial);
+    }
+    // Both ends of the kernel range, straddling the scalar fallback
+    for (int offset = -16; offset < 16; ++offset) {
+        serials.push_back(kernel_min + offset);
+        serials.push_back(kernel_max + offset);
+    }
+    bool pass = false;
+    try {
+        pass = check_gregorian_kernel(kernel, serials)
+            && check_gregorian_kernel_rejects(kernel,
+                toolbox::GregorianCalendar::AD, 2023, 2, 29)
+            && check_gregorian_kernel_rejects(kernel,
+                toolbox::GregorianCalendar::AD, 2024, 4, 31)
+            && check_gregorian_kernel_rejects(kernel,
+                toolbox::GregorianCalendar::AD, 0, 1, 1)
+            && check_gregorian_kernel_rejects(kernel,
+                toolbox::GregorianCalendar::AD, 2024, 13, 1)
+            && check_gregorian_kernel_rejects(kernel,
+                toolbox::GregorianCalendar::END_OF_ERA, 2024, 1, 1);
+    } catch (const std::exception& e) {
+        std::cout << "  threw: " << e.what() << std::endl;
+    }
+    std::cout << "gregorian kernel " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+void run_gregorian_kernel_tests() {
+    const toolbox::GregorianBatchKernel kernels[] = {
+        toolbox::GREGORIAN_BATCH_SCALAR,
+        toolbox::GREGORIAN_BATCH_SSE41,
+        toolbox::GREGORIAN_BATCH_AVX2,
+    };
+    for (std::size_t i = 0; i < sizeof(kernels) / sizeof(kernels[0]); ++i) {
+        if (toolbox::gregorian_batch_kernel_supported(kernels[i])) {
+            test_gregorian_kernel(kernels[i]);
+        }
+    }
+}
+
+void report_nth_weekday_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "nth weekday " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+bool nth_weekday_is(toolbox::CalendarSystem cal_sys, int era, int year,
+                    int month, int weekday, int nth,
+                    const toolbox::Date& expected) {
+    toolbox::Date date;
+    return toolbox::Date::try_nth_weekday_of_month(cal_sys, era, year, month,
+        weekday, nth, date) == toolbox::DATE_OK && date == expected;
+}
+
+void test_nth_weekday_gregorian() {
+    const int ad = toolbox::GregorianCalendar::AD;
+    const toolbox::Date monday = gregorian_date(2024, 1, 1);
+    const bool pass = toolbox::Date::nth_weekday_of_month(toolbox::GREGORIAN,
+            ad, 2024, 11, 4, 4) == gregorian_date(2024, 11, 28)
+        && toolbox::Date::last_weekday_of_month(toolbox::GREGORIAN, ad, 2024,
+            5, 1) == gregorian_date(2024, 5, 27)
+        && toolbox::Date::last_weekday_of_month(toolbox::GREGORIAN, ad, 2024,
+            2, 4) == gregorian_date(2024, 2, 29)
+        && nth_weekday_is(toolbox::GREGORIAN, ad, 2024, 1, 1, 1, monday)
+        && nth_weekday_is(toolbox::GREGORIAN, ad, 2024, 1, 1, 5,
+            gregorian_date(2024, 1, 29))
+        && nth_weekday_is(toolbox::GREGORIAN, ad, 2024, 1, 1, -5, monday)
+        && monday.next_weekday(toolbox::GREGORIAN, 1)
+            == gregorian_date(2024, 1, 8)
+        && monday.next_weekday_on_or_after(toolbox::GREGORIAN, 1) == monday
+        && monday.next_weekday_on_or_after(toolbox::GREGORIAN, 0)
+            == gregorian_date(2024, 1, 7)
+        && monday.previous_weekday(toolbox::GREGORIAN, 1)
+            == gregorian_date(2023, 12, 25)
+        && monday.previous_weekday_on_or_before(toolbox::GREGORIAN, 0)
+            == gregorian_date(2023, 12, 31)
+        && nth_weekday_is(toolbox::GREGORIAN, toolbox::GregorianCalendar::BC,
+            1, 1, 6, 1, toolbox::Date(toolbox::GREGORIAN,
+                toolbox::GregorianCalendar::BC, 1, 1, 1));
+    report_nth_weekday_test(pass);
+}
+
+// Checks every nth weekday of the months and every weekday adjustment of the
+// days in first..last against a walk over the days.
+bool nth_weekday_matches(toolbox::CalendarSystem cal_sys,
+                         const toolbox::Date& first,
+                         const toolbox::Date& last, int days_per_week) {
+    for (toolbox::Date date = first; date < last; ++date) {
+        const toolbox::CivilDate civil = date.decompose(cal_sys);
+        const int days = toolbox::Date::last_day_of_month(cal_sys, civil.era,
+            civil.year, civil.month);
+        const int nth = (civil.day - 1) / days_per_week + 1;
+        const int nth_from_end = -((days - civil.day) / days_per_week + 1);
+        if (!nth_weekday_is(cal_sys, civil.era, civil.year, civil.month,
+                civil.weekday, nth, date)
+            || !nth_weekday_is(cal_sys, civil.era, civil.year, civil.month,
+                civil.weekday, nth_from_end, date)) {
+            return false;
+        }
+        for (int weekday = 0; weekday < days_per_week; ++weekday) {
+            toolbox::Date after = date;
+            while (after.get_weekday(cal_sys) != weekday) {
+                ++after;
+            }
+            toolbox::Date before = date;
+            while (before.get_weekday(cal_sys) != weekday) {
+                --before;
+            }
+            if (date.next_weekday_on_or_after(cal_sys, weekday) != after
+                || date.previous_weekday_on_or_before(cal_sys, weekday)
+                    != before) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void test_nth_weekday_matches() {
+    const bool pass = nth_weekday_matches(toolbox::GREGORIAN,
+            gregorian_date(1999, 12, 1), gregorian_date(2004, 3, 1), 7)
+        && nth_weekday_matches(toolbox::NON_PROLEPTIC_GREGORIAN,
+            gregorian_date(1582, 11, 1), gregorian_date(1584, 3, 1), 7)
+        && nth_weekday_matches(toolbox::JULIAN,
+            gregorian_date(1999, 12, 1), gregorian_date(2004, 3, 1), 7)
+        && nth_weekday_matches(toolbox::ETHIOPIAN,
+            gregorian_date(2001, 9, 11), gregorian_date(2004, 9, 1), 7)
+        && nth_weekday_matches(toolbox::JAPANESE_WAREKI,
+            gregorian_date(2018, 12, 1), gregorian_date(2020, 3, 1), 7)
+        && nth_weekday_matches(toolbox::FRENCH_REPUBLICAN,
+            gregorian_date(1793, 10, 1), gregorian_date(1800, 10, 1), 10);
+    report_nth_weekday_test(pass);
+}
+
+void test_nth_weekday_french() {
+    const toolbox::CalendarSystem french = toolbox::FRENCH_REPUBLICAN;
+    const int an = toolbox::FrenchRepublicanCalendar::AD;
+    const toolbox::Date fifth = toolbox::Date(french, an, 2, 13, 5);
+    // Month 13 has 5 or 6 days and no décadi: the next one is in Vendémiaire.
+    const bool pass = nth_weekday_is(french, an, 2, 1, 9, 1,
+            toolbox::Date(french, an, 2, 1, 10))
+        && toolbox::Date::last_weekday_of_month(french, an, 2, 12, 9)
+            == toolbox::Date(french, an, 2, 12, 30)
+        && nth_weekday_is(french, an, 3, 13, 5, 1,
+            toolbox::Date(french, an, 3, 13, 6))
+        && nth_weekday_is(french, an, 2, 13, 0, -1,
+            toolbox::Date(french, an, 2, 13, 1))
+        && !nth_weekday_is(french, an, 2, 13, 5, 1, fifth)
+        && !nth_weekday_is(french, an, 2, 1, 0, 4, fifth)
+        && fifth.next_weekday(french, 9) == toolbox::Date(french, an, 3, 1, 10)
+        && fifth.next_weekday(french, 4) == toolbox::Date(french, an, 3, 1, 5)
+        && fifth.previous_weekday(french, 4)
+            == toolbox::Date(french, an, 2, 12, 25)
+        && toolbox::Date(french, an, 3, 1, 1).previous_weekday(french, 9)
+            == toolbox::Date(french, an, 2, 12, 30);
+    report_nth_weekday_test(pass);
+}
+
+void test_nth_weekday_reform() {
+    const toolbox::CalendarSystem wareki = toolbox::JAPANESE_WAREKI;
+    const toolbox::Date julian_first = toolbox::Date(toolbox::JULIAN,
+        toolbox::JulianCalendar::AD, 1582, 10, 1);
+    toolbox::Date date;
+    // Weeks carry on across the reform and the day must belong to the era.
+    const bool pass = nth_weekday_is(wareki, toolbox::HEISEI, 31, 4, 2, -1,
+            gregorian_date(2019, 4, 30))
+        && nth_weekday_is(wareki, toolbox::REIWA, 1, 5, 3, 1,
+            gregorian_date(2019, 5, 1))
+        && nth_weekday_is(wareki, toolbox::HEISEI, 1, 1, 0, 2,
+            gregorian_date(1989, 1, 8))
+        && toolbox::Date::try_nth_weekday_of_month(wareki, toolbox::HEISEI,
+            1, 1, 0, 1, date) == toolbox::DATE_OUT_OF_RANGE
+        && toolbox::Date::try_nth_weekday_of_month(wareki, toolbox::REIWA,
+            1, 4, 2, -1, date) == toolbox::DATE_OUT_OF_RANGE
+        && nth_weekday_is(wareki, toolbox::TENSHO_A, 10, 10, 1, 1,
+            julian_first)
+        && nth_weekday_is(wareki, toolbox::TENSHO_A, 10, 10, 1, 2,
+            gregorian_date(1582, 10, 18))
+        && nth_weekday_is(wareki, toolbox::TENSHO_A, 10, 10, 0, -1,
+            gregorian_date(1582, 10, 31))
+        && gregorian_date(2019, 5, 1).previous_weekday(wareki, 2)
+            == gregorian_date(2019, 4, 30)
+        && nth_weekday_is(toolbox::NON_PROLEPTIC_GREGORIAN,
+            toolbox::NonProlepticGregorianCalendar::AD, 1582, 10, 1, 1,
+            gregorian_date(1582, 10, 18))
+        && nth_weekday_is(toolbox::NON_PROLEPTIC_GREGORIAN,
+            toolbox::NonProlepticGregorianCalendar::AD, 1582, 10, 5, 1,
+            gregorian_date(1582, 10, 15))
+        && toolbox::Date::try_nth_weekday_of_month(
+            toolbox::NON_PROLEPTIC_GREGORIAN,
+            toolbox::NonProlepticGregorianCalendar::AD, 1582, 9, 1, 1, date)
+            == toolbox::DATE_OUT_OF_RANGE
+        && nth_weekday_is(toolbox::JULIAN, toolbox::JulianCalendar::AD, 1582,
+            10, 1, 1, julian_first);
+    report_nth_weekday_test(pass);
+}
+
+bool weekday_adjustment_throws(const toolbox::Date& date,
+                               toolbox::CalendarSystem cal_sys,
+                               int weekday) {
+    try {
+        date.previous_weekday_on_or_before(cal_sys, weekday);
+    } catch (const std::out_of_range& e) {
+        (void)e;
+        return true;
+    }
+    return false;
+}
+
+void test_nth_weekday_errors() {
+    const int ad = toolbox::GregorianCalendar::AD;
+    toolbox::Date date;
+    bool thrown = false;
+    try {
+        toolbox::Date::nth_weekday_of_month(toolbox::GREGORIAN, ad, 2023, 2,
+            1, 5);
+    } catch (const std::out_of_range& e) {
+        (void)e;
+        thrown = true;
+    }
+    const bool pass = thrown
+        && toolbox::Date::try_nth_weekday_of_month(toolbox::GREGORIAN, ad,
+            2023, 2, 1, 0, date) == toolbox::DATE_INVALID_DAY
+        && toolbox::Date::try_nth_weekday_of_month(toolbox::GREGORIAN, ad,
+            2023, 2, 7, 1, date) == toolbox::DATE_INVALID_DAY
+        && toolbox::Date::try_nth_weekday_of_month(toolbox::GREGORIAN, ad,
+            2023, 13, 1, 1, date) == toolbox::DATE_INVALID_MONTH
+        && toolbox::Date::try_nth_weekday_of_month(toolbox::ETHIOPIAN,
+            toolbox::EthiopianCalendar::AD, 0, 1, 1, 1, date)
+            == toolbox::DATE_INVALID_YEAR
+        && toolbox::Date::try_nth_weekday_of_month(toolbox::FRENCH_REPUBLICAN,
+            toolbox::FrenchRepublicanCalendar::AD, 2, 1, 10, 1, date)
+            == toolbox::DATE_INVALID_DAY
+        && weekday_adjustment_throws(gregorian_date(2024, 1, 1),
+            toolbox::GREGORIAN, -1)
+        && weekday_adjustment_throws(gregorian_date(1582, 10, 15),
+            toolbox::NON_PROLEPTIC_GREGORIAN, 4)
+        && weekday_adjustment_throws(toolbox::Date(toolbox::FRENCH_REPUBLICAN,
+            toolbox::FrenchRepublicanCalendar::AD, 1, 1, 1),
+            toolbox::FRENCH_REPUBLICAN, 9)
+        && weekday_adjustment_throws(gregorian_date(1, 1, 1),
+            toolbox::ETHIOPIAN, 0)
+        && !weekday_adjustment_throws(gregorian_date(1582, 10, 15),
+            toolbox::NON_PROLEPTIC_GREGORIAN, 5);
+    report_nth_weekday_test(pass);
+}
+
+bool weekday_step_throws(const toolbox::Date& date,
+                         toolbox::CalendarSystem cal_sys, int weekday,
+                         bool forward) {
+    try {
+        if (forward) {
+            date.next_weekday(cal_sys, weekday);
+        } else {
+            date.previous_weekday(cal_sys, weekday);
+        }
+    } catch (const std::out_of_range& e) {
+        (void)e;
+        return true;
+    }
+    return false;
+}
+
+void test_nth_weekday_limits() {
+    // Seven-day weeks are searched only up to six days from the ends of int.
+    const toolbox::Date last(INT_MAX - 6);
+    const toolbox::Date first(INT_MIN + 6);
+    const int last_weekday = last.get_weekday(toolbox::GREGORIAN);
+    const int first_weekday = first.get_weekday(toolbox::GREGORIAN);
+    // The step past the current day must not wrap around the ends of int.
+    const bool pass = weekday_step_throws(toolbox::Date(INT_MAX),
+            toolbox::GREGORIAN, 0, true)
+        && weekday_step_throws(toolbox::Date(INT_MIN), toolbox::GREGORIAN, 0,
+            false)
+        && weekday_step_throws(toolbox::Date(INT_MAX), toolbox::JULIAN, 0,
+            true)
+        && weekday_step_throws(toolbox::Date(INT_MIN), toolbox::JULIAN, 0,
+            false)
+        && toolbox::Date(INT_MAX - 7).next_weekday(toolbox::GREGORIAN,
+            last_weekday) == last
+        && toolbox::Date(INT_MIN + 7).previous_weekday(toolbox::GREGORIAN,
+            first_weekday) == first
+        && weekday_step_throws(last, toolbox::GREGORIAN, last_weekday, true)
+        && weekday_step_throws(first, toolbox::GREGORIAN, first_weekday,
+            false);
+    report_nth_weekday_test(pass);
+}
+
+void run_nth_weekday_tests() {
+    test_nth_weekday_gregorian();
+    test_nth_weekday_matches();
+    test_nth_weekday_french();
+    test_nth_weekday_reform();
+    test_nth_weekday_errors();
+    test_nth_weekday_limits();
+}
+
+void report_parallel_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "parallel " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+// Serial dates first, first + 1, ..., wrapping around after span days.
+std::vector<int> parallel_serials(const toolbox::Date& first, int span,
+                                  std::size_t count) {
+    std::vector<int> serials(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        serials[i] = first.get_raw_date() + static_cast<int>(i % span);
+    }
+    return serials;
+}
+
+// Converts serials to fields and back on pools of several sizes and checks
+// the result against the single-threaded batch conversions.
+bool parallel_matches(toolbox::CalendarSystem cal_sys,
+                      const std::vector<int>& serials) {
+    const std::size_t count = serials.size();
+    std::vector<int> eras(count), years(count), months(count), days(count);
+    toolbox::Date::from_serial_dates(cal_sys, &serials[0], count, &eras[0],
+        &years[0], &months[0], &days[0]);
+    const unsigned threads[] = {1, 3, 8};
+    for (std::size_t t = 0; t < 3; ++t) {
+        toolbox::parallel::ThreadPool pool(threads[t]);
+        std::vector<int> e(count), y(count), m(count), d(count);
+        std::vector<int> back(count);
+        toolbox::parallel::convert(pool, cal_sys, &serials[0], count, &e[0],
+            &y[0], &m[0], &d[0]);
+        toolbox::parallel::convert(pool, cal_sys, &e[0], &y[0], &m[0], &d[0],
+            count, &back[0]);
+        if (e != eras || y != years || m != months || d != days
+            || back != serials) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_parallel_calendars() {
+    const std::size_t count = 3 * toolbox::parallel::kChunkSize + 77;
+    const bool pass = parallel_matches(toolbox::GREGORIAN,
+            parallel_serials(gregorian_date(1, 1, 1), 1000000, count))
+        && parallel_matches(toolbox::NON_PROLEPTIC_GREGORIAN,
+            parallel_serials(gregorian_date(1582, 10, 15), 200000, count))
+        && parallel_matches(toolbox::JULIAN,
+            parallel_serials(gregorian_date(100, 1, 1), 200000, count))
+        && parallel_matches(toolbox::ETHIOPIAN,
+            parallel_serials(gregorian_date(2001, 9, 11), 1080, count))
+        && parallel_matches(toolbox::FRENCH_REPUBLICAN,
+            parallel_serials(gregorian_date(1792, 9, 22), 5000, count))
+        && parallel_matches(toolbox::JAPANESE_WAREKI,
+            parallel_serials(gregorian_date(1873, 1, 1), 50000, count));
+    report_parallel_test(pass);
+}
+
+void test_parallel_strings() {
+    const std::size_t count = 2 * toolbox::parallel::kChunkSize + 5;
+    const std::vector<int> serials = parallel_serials(
+        gregorian_date(1900, 1, 1), 60000, count);
+    const toolbox::DateFormat iso("%Y-%m-%d");
+    const toolbox::DateFormat wareki("%E%Y-%m-%d");
+    toolbox::parallel::ThreadPool pool(4);
+    std::vector<std::string> isos(count), warekis(count);
+    std::vector<int> parsed(count);
+    toolbox::parallel::convert(pool, toolbox::GREGORIAN, &serials[0], count,
+        iso, &isos[0]);
+    // Gregorian ISO dates to wareki, through serial dates.
+    toolbox::parallel::convert(pool, toolbox::GREGORIAN, &isos[0], count,
+        "%Y-%m-%d", true, &parsed[0]);
+    toolbox::parallel::convert(pool, toolbox::JAPANESE_WAREKI, &parsed[0],
+        count, wareki, &warekis[0]);
+    bool pass = parsed == serials;
+    for (std::size_t i = 0; i < count && pass; i += 997) {
+        const toolbox::Date date(serials[i]);
+        pass = isos[i] == date.to_string(toolbox::GREGORIAN, "%Y-%m-%d")
+            && warekis[i] == date.to_string(toolbox::JAPANESE_WAREKI,
+                "%E%Y-%m-%d");
+    }
+    toolbox::parallel::convert(pool, toolbox::JAPANESE_WAREKI, &warekis[0],
+        count, "%E%Y-%m-%d", true, &parsed[0]);
+    pass = pass && parsed == serials;
+    report_parallel_test(pass);
+}
+
+// Marks each task it runs, to check that every task runs exactly once.
+class CountingJob : public toolbox::parallel::Job {
+ public:
+    explicit CountingJob(std::vector<int>& runs) : _runs(runs) {}
+    void run(std::size_t task) const {
+        ++_runs[task];
+    }
+
+ private:
+    std::vector<int>& _runs;
+};
+
+void test_parallel_pool() {
+    toolbox::parallel::ThreadPool pool(5);
+    bool pass = pool.size() == 5;
+    for (std::size_t count = 0; count < 300 && pass; ++count) {
+        std::vector<int> runs(count, 0);
+        pool.run(CountingJob(runs), count);
+        pass = std::count(runs.begin(), runs.end(), 1)
+            == static_cast<std::ptrdiff_t>(count);
+    }
+    toolbox::parallel::ThreadPool hardware;
+    pass = pass && hardware.size() >= 1;
+    int none = 0;
+    toolbox::parallel::convert(pool, toolbox::GREGORIAN, &none,
+        std::size_t(0), &none, &none, &none, &none);
+    pass = pass && none == 0;
+    report_parallel_test(pass);
+}
+
+void test_parallel_errors() {
+    const std::size_t chunk = toolbox::parallel::kChunkSize;
+    const std::size_t count = 4 * chunk;
+    std::vector<int> serials = parallel_serials(gregorian_date(2001, 9, 11),
+        1080, count);
+    // The exception of the first invalid date is thrown whichever thread
+    // meets it first.
+    const int first_bad = 2 * static_cast<int>(chunk) + 5;
+    serials[first_bad] = INT_MIN;
+    serials[3 * chunk + 1] = INT_MIN + 1;
+    std::vector<int> eras(count), years(count), months(count), days(count);
+    std::string message;
+    std::string expected;
+    try {
+        toolbox::Date::from_serial_dates(toolbox::ETHIOPIAN,
+            &serials[first_bad], 1, &eras[0], &years[0], &months[0],
+            &days[0]);
+    } catch (const std::out_of_range& e) {
+        expected = e.what();
+    }
+    bool pass = !expected.empty();
+    for (int round = 0; round < 20 && pass; ++round) {
+        toolbox::parallel::ThreadPool pool(1 + round % 7);
+        message.clear();
+        try {
+            toolbox::parallel::convert(pool, toolbox::ETHIOPIAN, &serials[0],
+                count, &eras[0], &years[0], &months[0], &days[0]);
+        } catch (const std::out_of_range& e) {
+            message = e.what();
+        }
+        pass = message == expected;
+    }
+    std::vector<std::string> strs(3, "2024-02-30");
+    strs[0] = "2024-02-29";
+    std::vector<int> parsed(3);
+    toolbox::parallel::ThreadPool pool(2);
+    try {
+        toolbox::parallel::convert(pool, toolbox::GREGORIAN, &strs[0], 3,
+            "%Y-%m-%d", true, &parsed[0]);
+        pass = false;
+    } catch (const std::invalid_argument& e) {
+        (void)e;
+    }
+    report_parallel_test(pass);
+}
+
+void run_parallel_tests() {
+    test_parallel_calendars();
+    test_parallel_strings();
+    test_parallel_pool();
+    test_parallel_errors();
+}
+
+void report_date_column_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "date column " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+std::string read_all(std::FILE* file) {
+    std::string str;
+    char buf[4096];
+    std::rewind(file);
+    for (std::size_t len; (len = std::fread(buf, 1, sizeof(buf), file)); ) {
+        str.append(buf, len);
+    }
+    return str;
+}
+
+// Runs input through a DateColumnConverter, from memory or, if streamed,
+// from a file. A conversion error is stored in error, after which the
+// output so far is returned.
+std::string convert_date_columns(const toolbox::DateColumnSpec& spec,
+                                 const std::string& input, bool streamed,
+                                 std::string* error = NULL) {
+    std::FILE* in = std::tmpfile();
+    std::FILE* out = std::tmpfile();
+    if (!in || !out) {
+        throw std::runtime_error("tmpfile failed");
+    }
+    std::fwrite(input.data(), 1, input.size(), in);
+    std::rewind(in);
+    try {
+        toolbox::DateColumnConverter converter(spec);
+        if (streamed) {
+            converter.convert(in, out);
+        } else {
+            converter.convert(input.data(), input.data() + input.size(),
+                out);
+        }
+    } catch (const std::invalid_argument& e) {
+        if (error) {
+            *error = e.what();
+        }
+    }
+    const std::string output = read_all(out);
+    std::fclose(in);
+    std::fclose(out);
+    return output;
+}
+
+void test_date_column_wareki() {
+    toolbox::DateColumnSpec spec;
+    spec.columns.assign(1, 4);
+    spec.columns.push_back(2);
+    spec.header = true;
+    spec.to_cal = toolbox::JAPANESE_WAREKI;
+    spec.to_format = "%E%Y-%m-%d";
+    const std::string input =
+        "id,date,name,due\n"
+        "1,2019-05-01,\"Doe, J.\",2024-01-15\r\n"
+        "2,\"1989-01-08\",x,\n"
+        "3,19890107\n"
+        "4\n"
+        "\n"
+        "5,2019-W18-3,\"say \"\"hi\"\", bye\",2019-121";
+    const std::string expected =
+        "id,date,name,due\n"
+        "1,令和1-5-1,\"Doe, J.\",令和6-1-15\r\n"
+        "2,\"平成1-1-8\",x,\n"
+        "3,昭和64-1-7\n"
+        "4\n"
+        "\n"
+        "5,令和1-5-1,\"say \"\"hi\"\", bye\",令和1-5-1";
+    report_date_column_test(convert_date_columns(spec, input, false)
+        == expected && convert_date_columns(spec, input, true) == expected);
+}
+
+void test_date_column_formats() {
+    toolbox::DateColumnSpec spec;
+    spec.delimiter = '\t';
+    spec.from_cal = toolbox::JULIAN;
+    spec.from_format = "%Y/%M/%D";
+    spec.to_iso_form = toolbox::ISO8601_BASIC;
+    bool pass = convert_date_columns(spec,
+        "1582/10/4\tlast Julian day\n1582/10/5\tGregorian 15th\n", false)
+        == "15821014\tlast Julian day\n15821015\tGregorian 15th\n";
+    spec.columns.assign(1, 1);
+    spec.from_format.clear();
+    spec.to_cal = toolbox::ETHIOPIAN;
+    spec.to_format = "%Y-%M-%D";
+    pass = pass && convert_date_columns(spec, "2003-09-12\n", false)
+        == "1996-1-2\n";
+    // YYYY-MM-DD to itself still rejects invalid dates.
+    toolbox::DateColumnSpec iso;
+    iso.columns.assign(1, 2);
+    pass = pass && convert_date_columns(iso, "a,2024-02-29,b\n", true)
+        == "a,2024-02-29,b\n";
+    // ... and converts the other forms, the week date of 10 bytes included.
+    pass = pass && convert_date_columns(iso,
+        "a,2024-W01-1\nb,2024-060\nc,20240229\n", true)
+        == "a,2024-01-01\nb,2024-02-29\nc,2024-02-29\n";
+    std::string error;
+    convert_date_columns(iso, "a,2023-02-29,b\n", true, &error);
+    pass = pass && !error.empty();
+    report_date_column_test(pass);
+}
+
+void test_date_column_errors() {
+    toolbox::DateColumnSpec spec;
+    spec.columns.assign(1, 2);
+    spec.to_cal = toolbox::JAPANESE_WAREKI;
+    spec.to_format = "%E%Y-%m-%d";
+    const std::string input =
+        "a,2000-01-01\nb,0500-01-01\nc,not a date\nd,2000-01-02\n";
+    std::string error;
+    const std::string output = convert_date_columns(spec, input, true,
+        &error);
+    // Before the first era (Taika, 645) there is no wareki date to write.
+    bool pass = output == "a,平成12-1-1\nb,"
+        && error.find("line 2, column 2: '0500-01-01'") != std::string::npos;
+    spec.keep_invalid = true;
+    error.clear();
+    pass = pass && convert_date_columns(spec, input, true, &error)
+        == "a,平成12-1-1\nb,0500-01-01\nc,not a date\nd,平成12-1-2\n"
+        && error.empty();
+    bool thrown = false;
+    try {
+        spec.columns.assign(1, 0);
+        toolbox::DateColumnConverter converter(spec);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    pass = pass && thrown;
+    thrown = false;
+    try {
+        spec.columns.assign(1, 1);
+        spec.to_format = "%Y-%Q";
+        toolbox::DateColumnConverter converter(spec);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    report_date_column_test(pass && thrown);
+}
+
+// Input spanning many blocks, with lines across block boundaries and a line
+// longer than a block, streams to the same output as from memory.
+void test_date_column_blocks() {
+    toolbox::DateColumnSpec spec;
+    spec.columns.assign(1, 1);
+    spec.columns.push_back(3);
+    spec.to_iso_form = toolbox::ISO8601_ORDINAL;
+    std::string input;
+    std::string expected;
+    for (int i = 0; input.size() < 3 * toolbox::DateColumnConverter::kBlockSize;
+            ++i) {
+        const toolbox::Date date = gregorian_date(1900, 1, 1) + i % 50000;
+        const std::string padding(i % 37, 'x');
+        input += date.to_iso8601() + "," + padding + ","
+            + date.to_iso8601(toolbox::ISO8601_BASIC) + "\n";
+        expected += date.to_iso8601(toolbox::ISO8601_ORDINAL) + ","
+            + padding + "," + date.to_iso8601(toolbox::ISO8601_ORDINAL)
+            + "\n";
+        if (i == 1000) {
+            const std::string long_field(
+                toolbox::DateColumnConverter::kBlockSize + 10, 'y');
+            input += "2000-01-01," + long_field + ",2000-12-31\n";
+            expected += "2000-001," + long_field + ",2000-366\n";
+        }
+    }
+    report_date_column_test(convert_date_columns(spec, input, true)
+        == expected && convert_date_columns(spec, input, false) == expected);
+}
+
+void test_date_column_fixed() {
+    toolbox::DateColumnSpec spec;
+    spec.fixed_fields.resize(2);
+    spec.fixed_fields[0].offset = 20;
+    spec.fixed_fields[0].width = 8;
+    spec.fixed_fields[1].offset = 0;
+    spec.fixed_fields[1].width = 10;
+    spec.to_iso_form = toolbox::ISO8601_WEEK;
+    const std::string input =
+        "2024-01-15 12:00:00 20240116 GET /a,b\n"
+        "2024-01-17 12:00:01 short\r\n"
+        "2024\n";
+    bool pass = convert_date_columns(spec, input, true)
+        == "2024-W03-1 12:00:00 2024-W03-2 GET /a,b\n"
+           "2024-W03-3 12:00:01 short\r\n"
+           "2024\n";
+    std::string error;
+    convert_date_columns(spec, "2024-01-15 12:00:00 2024011X\n", false,
+        &error);
+    pass = pass && error.find("line 1, column 21: '2024011X'")
+        != std::string::npos;
+    bool thrown = false;
+    try {
+        spec.fixed_fields[1].width = 21;
+        toolbox::DateColumnConverter converter(spec);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    report_date_column_test(pass && thrown);
+}
+
+// A MappedFile holds the contents of the file, empty ones included.
+void test_date_column_mapped() {
+    const char* const path = "Date_test_mapped.tmp";
+    toolbox::DateColumnSpec spec;
+    spec.to_iso_form = toolbox::ISO8601_BASIC;
+    bool pass = true;
+    const std::string inputs[] = {"", "2024-02-29,x\n2000-01-01"};
+    for (std::size_t i = 0; i < 2; ++i) {
+        std::FILE* file = std::fopen(path, "wb");
+        if (!file) {
+            pass = false;
+            break;
+        }
+        std::fwrite(inputs[i].data(), 1, inputs[i].size(), file);
+        std::fclose(file);
+        const toolbox::MappedFile mapped(path);
+        pass = pass && mapped.size() == inputs[i].size()
+            && std::string(mapped.begin(), mapped.end()) == inputs[i];
+        std::FILE* out = std::tmpfile();
+        toolbox::DateColumnConverter(spec).convert(mapped.begin(),
+            mapped.end(), out);
+        pass = pass && read_all(out) == (i == 0 ? ""
+            : "20240229,x\n20000101");
+        std::fclose(out);
+    }
+    std::remove(path);
+    bool thrown = false;
+    try {
+        const toolbox::MappedFile missing(path);
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    report_date_column_test(pass && thrown);
+}
+
+void run_date_column_tests() {
+    test_date_column_wareki();
+    test_date_column_formats();
+    test_date_column_errors();
+    test_date_column_blocks();
+    test_date_column_fixed();
+    test_date_column_mapped();
+}
+
+void report_thread_safety_test(bool pass) {
+    static int test_num = 0;
+    std::cout << "thread safety " << std::setw(3) << ++test_num << ": "
+              << (pass ? "OK" : "NG") << std::endl;
+}
+
+void hash_value(unsigned long long& hash, long long value) {
+    hash = hash * 1000003 + static_cast<unsigned long long>(value);
+}
+
+void hash_string(unsigned long long& hash, const std::string& str) {
+    for (std::size_t i = 0; i < str.size(); ++i) {
+        hash_value(hash, static_cast<unsigned char>(str[i]));
+    }
+}
+
+// Converts, formats, parses and moves dates of cal_sys from first on, and
+// hashes every result, so that runs on different threads can be compared.
+unsigned long long calendar_workload(toolbox::CalendarSystem cal_sys,
+                                     const toolbox::Date& first, int span) {
+    const toolbox::DateFormat format("%E%Y-%m-%d");
+    unsigned long long hash = 0;
+    for (int i = 0; i < span; i += 7) {
+        const toolbox::Date date = first + i;
+        const toolbox::CivilDate civil = date.decompose(cal_sys);
+        const std::string str = date.to_string(cal_sys, format);
+        const toolbox::Date parsed(cal_sys, str, "%E%Y-%m-%d");
+        toolbox::Date moved;
+        toolbox::Date weekday;
+        hash_string(hash, str);
+        hash_value(hash, parsed.get_raw_date());
+        hash_value(hash, civil.era * 100000 + civil.year);
+        hash_value(hash, civil.month * 100 + civil.day);
+        hash_value(hash, date.get_weekday(cal_sys));
+        hash_value(hash, toolbox::Date::last_day_of_month(cal_sys, civil.era,
+            civil.year, civil.month));
+        hash_value(hash, toolbox::Date::try_make(cal_sys, civil.era,
+            civil.year, civil.month, 1, moved));
+        hash_value(hash, moved.get_raw_date());
+        hash_value(hash, toolbox::Date::try_nth_weekday_of_month(cal_sys,
+            civil.era, civil.year, civil.month, 0, -1, weekday));
+        hash_value(hash, weekday.get_raw_date());
+        try {
+            hash_value(hash, date.add_months(cal_sys, 13).get_raw_date());
+        } catch (const std::out_of_range& e) {
+            hash_string(hash, e.what());
+        }
+    }
+    return hash;
+}
+
+unsigned long long all_calendars_workload() {
+    unsigned long long hash = 0;
+    hash_value(hash, calendar_workload(toolbox::JAPANESE_WAREKI,
+        gregorian_date(1850, 1, 1), 60000));
+    hash_value(hash, calendar_workload(toolbox::GREGORIAN,
+        gregorian_date(1900, 1, 1), 60000));
+    hash_value(hash, calendar_workload(toolbox::NON_PROLEPTIC_GREGORIAN,
+        gregorian_date(1582, 10, 15), 60000));
+    hash_value(hash, calendar_workload(toolbox::JULIAN,
+        gregorian_date(1000, 1, 1), 60000));
+    hash_value(hash, calendar_workload(toolbox::ETHIOPIAN,
+        gregorian_date(2001, 9, 11), 1080));
+    hash_value(hash, calendar_workload(toolbox::FRENCH_REPUBLICAN,
+        gregorian_date(1792, 9, 22), 5000));
+    for (int i = 0; i < 3000; ++i) {
+        const toolbox::Date date = gregorian_date(2000, 1, 1) + i * 11;
+        hash_value(hash, date.get_year<toolbox::JAPANESE_WAREKI>());
+        hash_value(hash, date.get_month<toolbox::ETHIOPIAN>());
+        hash_value(hash, date.get_day<toolbox::JULIAN>());
+        hash_string(hash, date.to_iso8601());
+    }
+    return hash;
+}
+
+void run_thread_safety_worker(std::atomic<int>* ready, int thread_count,
+                              unsigned long long* hash) {
+    ++*ready;
+    while (*ready < thread_count) {
+        std::this_thread::yield();
+    }
+    *hash = all_calendars_workload();
+}
+
+void run_parallel_worker(unsigned long long* hash) {
+    const std::size_t count = 2 * toolbox::parallel::kChunkSize + 3;
+    std::vector<int> serials(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        serials[i] = gregorian_date(1868, 10, 23).get_raw_date()
+            + static_cast<int>(i * 5);
+    }
+    const toolbox::DateFormat format("%E%Y-%m-%d");
+    std::vector<std::string> strs(count);
+    std::vector<int> eras(count), years(count), months(count), days(count);
+    toolbox::parallel::ThreadPool pool(3);
+    toolbox::parallel::convert(pool, toolbox::JAPANESE_WAREKI, &serials[0],
+        count, format, &strs[0]);
+    toolbox::parallel::convert(pool, toolbox::ETHIOPIAN, &serials[0], count,
+        &eras[0], &years[0], &months[0], &days[0]);
+    for (std::size_t i = 0; i < count; ++i) {
+        hash_string(*hash, strs[i]);
+        hash_value(*hash, years[i] * 10000 + months[i] * 100 + days[i]);
+    }
+}
+
+// The threads start together, while the calendars still build their tables
+// on first use (this runs before any other test), and must all agree with a
+// run on the main thread afterwards. Build with `make fclean tsan` to run it
+// under ThreadSanitizer.
+void test_thread_safety_calendars() {
+    const int thread_count = 8;
+    std::vector<unsigned long long> hashes(thread_count, 0);
+    std::atomic<int> ready(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.push_back(std::thread(run_thread_safety_worker, &ready,
+            thread_count, &hashes[t]));
+    }
+    for (int t = 0; t < thread_count; ++t) {
+        threads[t].join();
+    }
+    const unsigned long long expected = all_calendars_workload();
+    bool pass = true;
+    for (int t = 0; t < thread_count; ++t) {
+        pass = pass && hashes[t] == expected;
+    }
+    report_thread_safety_test(pass);
+}
+
+// Shared pools and formats: several threads run their own parallel
+// conversions at the same time, each through the same calendars.
+void test_thread_safety_parallel() {
+    const int thread_count = 4;
+    std::vector<unsigned long long> hashes(thread_count, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.push_back(std::thread(run_parallel_worker, &hashes[t]));
+    }
+    for (int t = 0; t < thread_count; ++t) {
+        threads[t].join();
+    }
+    unsigned long long expected = 0;
+    run_parallel_worker(&expected);
+    bool pass = true;
+    for (int t = 0; t < thread_count; ++t) {
+        pass = pass && hashes[t] == expected;
+    }
+    report_thread_safety_test(pass);
+}
+
+void run_thread_safety_tests() {
+    test_thread_safety_calendars();
+    test_thread_safety_parallel();
+}
+
 int main() {
+    run_thread_safety_tests();
     toolbox::Date date;
     struct ParseCase {
         const char* date;
@@ -764,7 +4229,27 @@ int main() {
     run_japanese_era_string_roundtrip_tests();
     run_nanbokucho_authority_tests();
     run_japanese_wareki_format_tests();
+    run_japanese_wareki_era_lookup_tests();
     run_japanese_wareki_conversion_tests();
+    run_batch_conversion_tests();
+    run_gregorian_kernel_tests();
+    run_date_format_tests();
+    run_format_to_tests();
+    run_int_codec_tests();
+    run_date_parser_tests();
+    run_iso8601_tests();
+    run_try_api_tests();
+    run_calendar_tag_tests();
+    run_decompose_tests();
+    run_constexpr_tests();
+    run_date_range_tests();
+    run_civil_cursor_tests();
+    run_add_months_tests();
+    run_business_calendar_tests();
+    run_recurrence_tests();
+    run_nth_weekday_tests();
+    run_parallel_tests();
+    run_date_column_tests();
 
     try {
         date = toolbox::Date::today();